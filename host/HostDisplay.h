@@ -0,0 +1,47 @@
+// =============================================================
+//  HostDisplay.h – ST7789V displej pro host build (Linux)
+//
+//  LGFX_ST7789V_Pico2W.h s -DACU_HOST vloží tuto třídu místo
+//  Panel_ST7789 + Bus_SPI. LGFX je tu obyčejný 320×240 RGB565
+//  sprite z LovyanGFX – screeny do něj kreslí stejným kódem
+//  jako na desku, host_main.cpp ho pak uloží jako PNG.
+//
+//  pushImageDMA() (Render::push) se počítá – dmaPixels/dmaCalls
+//  jsou pixely, které by šly po SPI přes DMA. Buffer spritu je
+//  RGB565 big-endian (swap565_t), stejně jako data pro panel.
+// =============================================================
+#pragma once
+#include <LovyanGFX.hpp>
+
+#define HOST_TFT_W  320
+#define HOST_TFT_H  240
+
+class LGFX : public lgfx::LGFX_Sprite {
+public:
+    LGFX() : lgfx::LGFX_Sprite() {}
+
+    bool init() {
+        setColorDepth(16);
+        return createSprite(HOST_TFT_W, HOST_TFT_H) != nullptr;
+    }
+
+    // Buffer je už v orientaci panelu po setRotation(1)
+    void setRotation(uint8_t) {}
+    void setBrightness(uint8_t b) { brightness = b; }
+    void initDMA() {}
+
+    // Render::_pushRect() – spočítej a vykresli synchronně
+    template <typename T>
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const T* data) {
+        dmaPixels += (uint32_t)w * h;
+        dmaCalls++;
+        pushImage(x, y, w, h, data);
+    }
+
+    // RGB565 big-endian, řádky po HOST_TFT_W
+    const uint16_t* frame() const { return (const uint16_t*)getBuffer(); }
+
+    uint32_t dmaPixels  = 0;
+    uint32_t dmaCalls   = 0;
+    uint8_t  brightness = 255;
+};
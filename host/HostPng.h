@@ -0,0 +1,104 @@
+// =============================================================
+//  HostPng.h – zápis RGB565 snímku do PNG (host build)
+//
+//  Bez zlib: IDAT je deflate s nekomprimovanými bloky (stored),
+//  CRC32 a Adler-32 počítané tady. 320×240 RGB8 ≈ 231 KB –
+//  pro vizuální regresi (diff snímků) velikost nevadí.
+//
+//  Vstup: buffer LGFX (HostDisplay.h) – RGB565 big-endian.
+// =============================================================
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+namespace HostPng {
+
+    static uint32_t _crcTable[256];
+
+    static void _crcInit() {
+        if (_crcTable[1]) return;
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            _crcTable[n] = c;
+        }
+    }
+
+    static uint32_t _crc(uint32_t crc, const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; i++) crc = _crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    static void _be32(std::vector<uint8_t>& v, uint32_t x) {
+        v.push_back(x >> 24); v.push_back(x >> 16); v.push_back(x >> 8); v.push_back(x);
+    }
+
+    static void _chunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> buf;
+        _be32(buf, (uint32_t)data.size());
+        buf.insert(buf.end(), type, type + 4);
+        buf.insert(buf.end(), data.begin(), data.end());
+        uint32_t crc = _crc(0xFFFFFFFFu, buf.data() + 4, buf.size() - 4) ^ 0xFFFFFFFFu;
+        _be32(buf, crc);
+        fwrite(buf.data(), 1, buf.size(), f);
+    }
+
+    // ---------------------------------------------------------
+    //  Ulož w×h RGB565 (big-endian) jako PNG – false = chyba zápisu
+    // ---------------------------------------------------------
+    bool write(const char* path, const uint16_t* px, int w, int h) {
+        _crcInit();
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+
+        static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(sig, 1, 8, f);
+
+        std::vector<uint8_t> ihdr;
+        _be32(ihdr, w);
+        _be32(ihdr, h);
+        ihdr.push_back(8);      // bitů na kanál
+        ihdr.push_back(2);      // RGB
+        ihdr.push_back(0);      // deflate
+        ihdr.push_back(0);      // filtry
+        ihdr.push_back(0);      // bez prokládání
+        _chunk(f, "IHDR", ihdr);
+
+        // Řádky: filtr 0 + RGB8
+        std::vector<uint8_t> raw;
+        raw.reserve((size_t)h * (1 + w * 3));
+        for (int y = 0; y < h; y++) {
+            raw.push_back(0);
+            for (int x = 0; x < w; x++) {
+                uint16_t v = px[y * w + x];
+                v = (uint16_t)((v >> 8) | (v << 8));    // swap565 → RGB565
+                uint8_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+                raw.push_back((r << 3) | (r >> 2));
+                raw.push_back((g << 2) | (g >> 4));
+                raw.push_back((b << 3) | (b >> 2));
+            }
+        }
+
+        // zlib: hlavička, stored bloky po max 65535 B, Adler-32
+        std::vector<uint8_t> z = { 0x78, 0x01 };
+        size_t pos = 0;
+        do {
+            size_t   n    = raw.size() - pos < 65535 ? raw.size() - pos : 65535;
+            bool     last = pos + n == raw.size();
+            z.push_back(last ? 1 : 0);
+            z.push_back(n & 0xFF);  z.push_back(n >> 8);
+            z.push_back(~n & 0xFF); z.push_back((~n >> 8) & 0xFF);
+            z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+            pos += n;
+        } while (pos < raw.size());
+        uint32_t a = 1, b = 0;
+        for (uint8_t c : raw) { a = (a + c) % 65521; b = (b + a) % 65521; }
+        _be32(z, (b << 16) | a);
+        _chunk(f, "IDAT", z);
+
+        _chunk(f, "IEND", {});
+        return fclose(f) == 0;
+    }
+
+} // namespace HostPng
@@ -0,0 +1,395 @@
+// =============================================================
+//  host_main.cpp – UI ACU RP bez desky (pio run -e host)
+//
+//  Screeny kreslí stejným kódem (main_ui_loop.h) do 320×240
+//  RGB565 spritu v RAM (HostDisplay.h). Skript dodá SolarData
+//  a stisky switche, host ukládá PNG snímky pro vizuální regresi
+//  a měří čas draw()/update() a množství odeslaných pixelů.
+//
+//  Spuštění:
+//    .pio/build/host/program [-v] [-o adresář] skript.txt
+//      -v   výpis Serial (logy firmwaru) na stderr
+//      -o   kam ukládat PNG (výchozí ".")
+//
+//  Příkazy skriptu (řádek = příkaz, # = komentář):
+//    screen MAIN|MENU|SETTING|...   přepni screen (jako z menu)
+//    data pv=3200 load=800 grid=-1500 bat=-900 soc=64
+//         l1=.. l2=.. l3=.. status=2 online=1    SolarData z "měniče"
+//    relay 3 on|off|heat            stav relé zásobníku (1–10)
+//    time 2026-06-01 12:00          nastav hodiny (záhlaví)
+//    press DOWN [držet_ms]          stisk 5-way switche
+//    wait 1000                      nech UI běžet [ms simulovaného času]
+//    snap jmeno                     ulož snímek jmeno.png
+//    bench 50                       50× draw() a update() aktuálního screenu
+//    export on|off                  USB export běží (Log::muted); při off
+//                                   chyba, pokud mezitím něco psalo na Serial
+//
+//  Čas je simulovaný (host/include/Arduino.h) – snímky jsou
+//  deterministické. Časy v reportu jsou skutečný čas CPU hostu:
+//  vhodné pro srovnání screenů a změn, ne jako čas na RP2350.
+//
+//  Pixely:
+//    dma px  – pushImageDMA() z Render::push (sprity, dirty-recty)
+//    chg px  – pixely displeje, které se snímkem změnily (sprite
+//              i přímé kreslení na tft; dolní mez přenosu po SPI)
+// =============================================================
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "LGFX_ST7789V_Pico2W.h"
+#include "HW_Config.h"
+#include "Config.h"
+#include "FM24CL64.h"
+#include "RelayBank.h"
+#include "PCF85063A.h"
+#include "TimeService.h"
+#include "FiveWaySwitch.h"
+#include "Theme.h"
+#include "ScreenManager.h"
+#include "SolarData.h"
+#include "BoilerConfig.h"
+#include "main_ui_loop.h"
+#include "HostPng.h"
+#include "Log.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define HOST_LOOP_IDLE_MS   10      // jako LOOP_IDLE_MS v main.cpp
+#define HOST_PRESS_MS       80      // výchozí délka stisku
+
+// =============================================================
+//  Globální stav – jako v main.cpp (bez tasků a sítě)
+// =============================================================
+const Theme*  gTheme     = &THEME_DARK;
+PCF85063A     gRTC;
+FM24CL64      gFRAM;
+RelayBank     gRelays;
+FiveWaySwitch gSwitch;
+
+volatile bool gWifiSta   = false;
+volatile bool gWifiAp    = false;
+volatile bool gNtpOk     = false;
+volatile bool gNtpResync = false;
+bool          gFramOk    = false;
+
+// =============================================================
+//  Měření per screen
+// =============================================================
+struct HostStats {
+    uint32_t frames;        // snímky ze skriptu (uiLoop s výstupem)
+    uint64_t us;
+    uint32_t maxUs;
+    uint64_t dmaPx;
+    uint64_t chgPx;
+    uint32_t benchN;        // bench: opakování
+    uint64_t drawUs, updUs;
+    uint64_t drawPx, updPx; // bench: dma px
+};
+
+static HostStats             _stats[RENDER_SCREENS] = {};
+static std::vector<uint16_t> _prev;          // displej po minulém snímku
+static std::string           _outDir = ".";
+static uint32_t              _lastMinute = 0;
+
+static const char* const _screenNames[RENDER_SCREENS] = {
+    "BOOT", "LOGO", "MAIN", "MENU", "HISTORY", "DIAGNOSTIC", "SETTING",
+    "PASSWORD", "UDP", "CONTROL", "DISCOVERY", "BOILER_DETAIL",
+    "NETWORK", "SERIAL", "INVERTER", "MQTT", "TREND"
+};
+
+static uint64_t _hostUs() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Kolik pixelů displeje se od minula změnilo (a zapamatuj stav)
+static uint32_t _diffFrame() {
+    const uint16_t* fb = tft.frame();
+    uint32_t n = 0;
+    for (size_t i = 0; i < _prev.size(); i++) {
+        if (fb[i] != _prev[i]) { n++; _prev[i] = fb[i]; }
+    }
+    return n;
+}
+
+// =============================================================
+//  Jeden průchod UI smyčky + měření
+// =============================================================
+static void _step(uint32_t maxWaitMs) {
+    // TimeService bez RTC minuty nehlásí – záhlaví budí host
+    uint32_t minute = TimeService::now() / 60;
+    if (minute != _lastMinute) {
+        _lastMinute = minute;
+        UiEvents::post(UI_EV_MINUTE);
+    }
+
+    uint32_t dma0 = tft.dmaPixels;
+    uint64_t t0   = _hostUs();
+    uiLoop(maxWaitMs);
+    uint32_t us   = (uint32_t)(_hostUs() - t0);
+    uint32_t dma  = tft.dmaPixels - dma0;
+    uint32_t chg  = _diffFrame();
+    if (!dma && !chg) return;
+
+    HostStats& s = _stats[ScreenManager::current() % RENDER_SCREENS];
+    s.frames++;
+    s.us    += us;
+    s.maxUs  = max(s.maxUs, us);
+    s.dmaPx += dma;
+    s.chgPx += chg;
+}
+
+// Nech UI běžet ms simulovaného času
+static void _run(uint32_t ms) {
+    uint32_t end = millis() + ms;
+    do {
+        uint32_t before = millis();
+        uint32_t left   = (int32_t)(end - before) > 0 ? end - before : 0;
+        _step(min(left, (uint32_t)HOST_LOOP_IDLE_MS));
+        if (millis() == before) delay(1);      // uiLoop nespal (needDraw, FRAM)
+    } while ((int32_t)(end - millis()) > 0);
+}
+
+// =============================================================
+//  Příkazy skriptu
+// =============================================================
+static Screen _screenByName(const char* name) {
+    for (uint8_t i = 0; i < RENDER_SCREENS; i++) {
+        if (strcasecmp(name, _screenNames[i]) == 0) return (Screen)i;
+    }
+    return SCREEN_NONE;
+}
+
+static int _pinByName(const char* name) {
+    if (!strcasecmp(name, "UP"))     return PIN_SW_UP;
+    if (!strcasecmp(name, "DOWN"))   return PIN_SW_DOWN;
+    if (!strcasecmp(name, "LEFT"))   return PIN_SW_LEFT;
+    if (!strcasecmp(name, "RIGHT"))  return PIN_SW_RIGHT;
+    if (!strcasecmp(name, "CENTER")) return PIN_SW_CENTER;
+    return -1;
+}
+
+// data klíč=hodnota ... – nezmíněná pole zůstávají
+static void _cmdData(char* args) {
+    static InverterData inv = {};
+    inv.valid  = true;
+    inv.status = inv.status ? inv.status : 2;
+    for (char* tok = strtok(args, " \t"); tok; tok = strtok(nullptr, " \t")) {
+        char* eq = strchr(tok, '=');
+        if (!eq) continue;
+        *eq = 0;
+        long v = strtol(eq + 1, nullptr, 10);
+        if      (!strcmp(tok, "pv"))     inv.powerPV      = v;
+        else if (!strcmp(tok, "load"))   inv.powerLoad    = v;
+        else if (!strcmp(tok, "grid"))   inv.powerGrid    = v;
+        else if (!strcmp(tok, "bat"))    inv.powerBattery = v;
+        else if (!strcmp(tok, "soc"))    inv.soc          = v;
+        else if (!strcmp(tok, "soh"))    inv.soh          = v;
+        else if (!strcmp(tok, "l1"))     inv.phaseL1      = v;
+        else if (!strcmp(tok, "l2"))     inv.phaseL2      = v;
+        else if (!strcmp(tok, "l3"))     inv.phaseL3      = v;
+        else if (!strcmp(tok, "epv"))    inv.energyPvToday   = v;
+        else if (!strcmp(tok, "ebuy"))   inv.energyGridToday = v;
+        else if (!strcmp(tok, "esell"))  inv.energySoldToday = v;
+        else if (!strcmp(tok, "status")) inv.status       = v;
+        else if (!strcmp(tok, "online")) inv.valid        = v != 0;
+        else fprintf(stderr, "[HOST] data: neznámé pole '%s'\n", tok);
+    }
+    inv.lastUpdateMs = millis();
+    SolarModel::updateFromInverter(inv);
+    TrendLog::feed(inv);
+}
+
+static void _cmdRelay(int idx, const char* state) {
+    static bool on[BOILER_MAX_COUNT] = {}, heat[BOILER_MAX_COUNT] = {};
+    if (idx < 1 || idx > BOILER_MAX_COUNT) return;
+    on[idx - 1]   = strcmp(state, "off") != 0;
+    heat[idx - 1] = strcmp(state, "heat") == 0;
+
+    // Stejná cesta jako Boiler task – dávka, commit, ověření
+    gRelays.beginBatch();
+    gRelays.setRelay(idx - 1, on[idx - 1]);
+    gRelays.commit();
+    gRelays.printStatus();
+    SolarModel::updateRelays(on, heat);
+}
+
+// Export přes USB: Serial nese datový proud, jakýkoli jiný
+// výstup (render, relé, switch, screeny) by rozbil rámce
+static uint32_t _exportBytes = 0;
+
+static bool _cmdExport(const char* state) {
+    if (!strcmp(state, "on")) {
+        Log::muted   = true;
+        _exportBytes = HostIo::serialBytes;
+        return true;
+    }
+    Log::muted = false;
+    uint32_t leaked = HostIo::serialBytes - _exportBytes;
+    if (leaked) {
+        fprintf(stderr, "[HOST] export: %u B výpisu na Serial během exportu\n",
+            (unsigned)leaked);
+        return false;
+    }
+    return true;
+}
+
+static void _cmdTime(const char* date, const char* hm) {
+    DateTime dt = {};
+    int Y = 2000, M = 1, D = 1, h = 0, m = 0;
+    sscanf(date, "%d-%d-%d", &Y, &M, &D);
+    if (hm) sscanf(hm, "%d:%d", &h, &m);
+    dt.year   = Y;
+    dt.month  = M;
+    dt.day    = D;
+    dt.hour   = h;
+    dt.minute = m;
+    TimeService::_setBase(dateTimeToSecs(dt), time_us_64());
+    TimeService::_valid = true;
+}
+
+static void _cmdPress(int pin, uint32_t holdMs) {
+    HostIo::setPin(pin, LOW);
+    _run(holdMs);
+    HostIo::setPin(pin, HIGH);
+    _run(SW_DEBOUNCE_MS + 10);              // další stisk až po debounce
+}
+
+static void _cmdSnap(const char* name) {
+    std::string path = _outDir + "/" + name + ".png";
+    if (!HostPng::write(path.c_str(), tft.frame(), HOST_TFT_W, HOST_TFT_H))
+        fprintf(stderr, "[HOST] snap: zápis %s selhal\n", path.c_str());
+}
+
+// Opakovaný draw() / update() aktuálního screenu
+static void _cmdBench(uint32_t n) {
+    Screen     cur = ScreenManager::current();
+    HostStats& s   = _stats[cur % RENDER_SCREENS];
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t dma0 = tft.dmaPixels;
+        uint64_t t0   = _hostUs();
+        _refreshState();
+        _drawCurrent();
+        uint32_t us   = (uint32_t)(_hostUs() - t0);
+        Render::endFrame(cur, us);          // bajty snímku patří tomuto screenu
+        s.drawUs += us;
+        s.drawPx += tft.dmaPixels - dma0;
+
+        dma0 = tft.dmaPixels;
+        t0   = _hostUs();
+        _refreshState();
+        _updateCurrent();
+        us   = (uint32_t)(_hostUs() - t0);
+        Render::endFrame(cur, us);
+        s.updUs += us;
+        s.updPx += tft.dmaPixels - dma0;
+    }
+    s.benchN += n;
+    _diffFrame();
+}
+
+static bool _exec(char* line, int lineNo) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = 0;
+    char* cmd = strtok(line, " \t\r\n");
+    if (!cmd) return true;
+    char* a1 = strtok(nullptr, " \t\r\n");
+    char* a2 = strtok(nullptr, "\r\n");
+
+    if (!strcmp(cmd, "screen") && a1) {
+        Screen s = _screenByName(a1);
+        if (s == SCREEN_NONE) goto bad;
+        _doSwitch(s);
+        _run(HOST_LOOP_IDLE_MS);
+    } else if (!strcmp(cmd, "data")) {
+        std::string args = std::string(a1 ? a1 : "") + " " + (a2 ? a2 : "");
+        _cmdData(&args[0]);
+        _run(HOST_LOOP_IDLE_MS);
+    } else if (!strcmp(cmd, "relay") && a1 && a2) {
+        _cmdRelay(atoi(a1), a2);
+        _run(HOST_LOOP_IDLE_MS);
+    } else if (!strcmp(cmd, "time") && a1) {
+        _cmdTime(a1, a2);
+        _run(HOST_LOOP_IDLE_MS);
+    } else if (!strcmp(cmd, "press") && a1) {
+        int pin = _pinByName(a1);
+        if (pin < 0) goto bad;
+        _cmdPress(pin, a2 ? atoi(a2) : HOST_PRESS_MS);
+    } else if (!strcmp(cmd, "wait") && a1) {
+        _run(atoi(a1));
+    } else if (!strcmp(cmd, "snap") && a1) {
+        _cmdSnap(a1);
+    } else if (!strcmp(cmd, "bench") && a1) {
+        _cmdBench(atoi(a1));
+    } else if (!strcmp(cmd, "export") && a1) {
+        if (!_cmdExport(a1)) return false;
+    } else {
+        goto bad;
+    }
+    return true;
+
+bad:
+    fprintf(stderr, "[HOST] řádek %d: neznámý příkaz '%s'\n", lineNo, cmd);
+    return false;
+}
+
+// =============================================================
+//  Report
+// =============================================================
+static void _report() {
+    printf("\n%-14s %6s %8s %8s %9s %9s | %5s %9s %9s %9s %9s\n",
+        "screen", "frames", "avg us", "max us", "dma px/f", "chg px/f",
+        "bench", "draw us", "upd us", "draw px", "upd px");
+    for (uint8_t i = 0; i < RENDER_SCREENS; i++) {
+        const HostStats& s = _stats[i];
+        if (!s.frames && !s.benchN) continue;
+        uint32_t f = s.frames ? s.frames : 1;
+        uint32_t b = s.benchN ? s.benchN : 1;
+        printf("%-14s %6u %8llu %8u %9llu %9llu | %5u %9llu %9llu %9llu %9llu\n",
+            _screenNames[i], s.frames,
+            (unsigned long long)(s.us / f), s.maxUs,
+            (unsigned long long)(s.dmaPx / f), (unsigned long long)(s.chgPx / f),
+            s.benchN,
+            (unsigned long long)(s.drawUs / b), (unsigned long long)(s.updUs / b),
+            (unsigned long long)(s.drawPx / b), (unsigned long long)(s.updPx / b));
+    }
+}
+
+// =============================================================
+//  main()
+// =============================================================
+int main(int argc, char** argv) {
+    const char* script = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if      (!strcmp(argv[i], "-v"))              HostIo::verbose = true;
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) _outDir = argv[++i];
+        else script = argv[i];
+    }
+    FILE* f = script ? fopen(script, "r") : stdin;
+    if (!f) {
+        fprintf(stderr, "[HOST] skript %s nelze otevřít\n", script);
+        return 2;
+    }
+
+    // Setup jako main.cpp – periferie na I2C se hlásí jako chybějící
+    tft.init();
+    tft.setRotation(1);
+    ConfigManager::loadDefaults();
+    gTheme = THEMES[gConfig.themeIndex];
+    gSwitch.begin();
+    SolarModel::begin();
+    TrendLog::begin();
+    uiSetup();
+    _prev.assign(tft.frame(), tft.frame() + HOST_TFT_W * HOST_TFT_H);
+
+    char line[256];
+    int  lineNo = 0, errors = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!_exec(line, ++lineNo)) errors++;
+    }
+    if (f != stdin) fclose(f);
+
+    _report();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+// =============================================================
+//  Arduino.h – náhrada arduino-pico jádra pro host build (Linux)
+//
+//  Jen to, co používají hlavičky UI (main_ui_loop.h a screeny).
+//  Čas je simulovaný: millis()/micros() běží jen přes delay(),
+//  vTaskDelay() a timeout fronty (xQueueReceive) – běh skriptu
+//  je tak deterministický a PNG snímky se mezi běhy neliší.
+//
+//  Piny: HostIo::setPin() změní úroveň a zavolá ISR zaregistrovanou
+//  přes attachInterrupt() – skript tak "mačká" 5-way switch.
+// =============================================================
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define FALLING         2
+#define RISING          3
+#define CHANGE          4
+
+#define SERIAL_8N1      0x06
+#define SERIAL_8N2      0x0E
+#define SERIAL_8E1      0x07
+#define SERIAL_8E2      0x0F
+#define SERIAL_8O1      0x05
+#define SERIAL_8O2      0x0D
+#define SERIAL_7N1      0x04
+#define SERIAL_7N2      0x0C
+#define SERIAL_7E1      0x03
+#define SERIAL_7E2      0x0B
+#define SERIAL_7O1      0x01
+#define SERIAL_7O2      0x09
+
+#define bitRead(v, b)       (((v) >> (b)) & 1)
+#define bitWrite(v, b, x)   ((x) ? ((v) |= (1UL << (b))) : ((v) &= ~(1UL << (b))))
+
+template<class T, class A, class B>
+inline T constrain(T x, A a, B b) { return x < a ? a : (x > b ? b : x); }
+using std::min;
+using std::max;
+
+// =============================================================
+//  Simulovaný čas
+// =============================================================
+namespace HostClock {
+    inline uint64_t us = 0;
+    inline void advanceUs(uint64_t d) { us += d; }
+    inline void advanceMs(uint32_t ms) { us += (uint64_t)ms * 1000; }
+}
+
+inline uint32_t millis()                   { return (uint32_t)(HostClock::us / 1000); }
+inline uint32_t micros()                   { return (uint32_t)HostClock::us; }
+inline void     delay(uint32_t ms)         { HostClock::advanceMs(ms); }
+inline void     delayMicroseconds(uint32_t u) { HostClock::advanceUs(u); }
+inline void     yield()                    {}
+inline void     noInterrupts()             {}
+inline void     interrupts()               {}
+inline uint64_t time_us_64()               { return HostClock::us; }
+inline uint32_t time_us_32()               { return (uint32_t)HostClock::us; }
+
+// =============================================================
+//  GPIO – klid HIGH (externí pull-upy), ISR na hranu
+// =============================================================
+#define HOST_PINS   48
+
+namespace HostIo {
+    inline bool  low[HOST_PINS]           = {};
+    inline void (*isr[HOST_PINS])()       = {};
+    inline bool  verbose                  = false;   // Serial → stderr
+    inline uint32_t serialBytes           = 0;       // bajty zapsané na Serial*
+
+    inline void setPin(int pin, int level) {
+        if (pin < 0 || pin >= HOST_PINS) return;
+        bool l = (level == LOW);
+        if (l == low[pin]) return;
+        low[pin] = l;
+        if (isr[pin]) isr[pin]();
+    }
+}
+
+inline void pinMode(int, int) {}
+inline int  digitalRead(int pin) {
+    return (pin >= 0 && pin < HOST_PINS && HostIo::low[pin]) ? LOW : HIGH;
+}
+inline void digitalWrite(int pin, int level)   { HostIo::setPin(pin, level); }
+inline int  digitalPinToInterrupt(int pin)     { return pin; }
+inline void attachInterrupt(int pin, void (*fn)(), int) {
+    if (pin >= 0 && pin < HOST_PINS) HostIo::isr[pin] = fn;
+}
+inline void detachInterrupt(int pin) {
+    if (pin >= 0 && pin < HOST_PINS) HostIo::isr[pin] = nullptr;
+}
+
+// =============================================================
+//  String / Print / Serial
+// =============================================================
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    explicit String(int v)           : _s(std::to_string(v)) {}
+    explicit String(unsigned v)      : _s(std::to_string(v)) {}
+    explicit String(long v)          : _s(std::to_string(v)) {}
+    explicit String(unsigned long v) : _s(std::to_string(v)) {}
+    explicit String(unsigned char v) : _s(std::to_string(v)) {}
+    String& operator+=(const char* o)   { _s += o; return *this; }
+    String& operator+=(const String& o) { _s += o._s; return *this; }
+    bool operator==(const char* o) const { return _s == o; }
+    const char* c_str() const { return _s.c_str(); }
+    size_t length() const     { return _s.size(); }
+private:
+    std::string _s;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) {
+        for (size_t i = 0; i < n; i++) write(b[i]);
+        return n;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t write(int c)         { return write((uint8_t)c); }
+    size_t write(unsigned c)    { return write((uint8_t)c); }
+
+    size_t print(const char* s)     { return write(s); }
+    size_t print(const String& s)   { return write(s.c_str()); }
+    size_t print(char c)            { return write((uint8_t)c); }
+    size_t print(int v)             { return printf("%d", v); }
+    size_t print(unsigned v)        { return printf("%u", v); }
+    size_t print(long v)            { return printf("%ld", v); }
+    size_t print(unsigned long v)   { return printf("%lu", v); }
+    size_t print(double v)          { return printf("%.2f", v); }
+    size_t println(const char* s = "") { return print(s) + write("\n"); }
+    size_t println(const String& s) { return print(s) + write("\n"); }
+    size_t println(int v)           { return print(v) + write("\n"); }
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list a;
+        va_start(a, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, a);
+        va_end(a);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+
+    virtual void flush() {}
+    virtual int  availableForWrite() { return 0; }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read()      { return -1; }
+    virtual int peek()      { return -1; }
+    size_t readBytes(uint8_t*, size_t) { return 0; }
+    void   setTimeout(uint32_t) {}
+};
+
+// Logy firmwaru jdou na stderr jen s HostIo::verbose – stdout
+// patří výstupu hostu (report měření)
+class HardwareSerial : public Stream {
+public:
+    void begin(uint32_t, uint32_t = 0) {}
+    void end() {}
+    void setTX(int) {}
+    void setRX(int) {}
+    operator bool() const { return true; }
+    using Print::write;
+    size_t write(uint8_t c) override {
+        HostIo::serialBytes++;
+        if (HostIo::verbose) fputc(c, stderr);
+        return 1;
+    }
+    size_t write(const uint8_t* b, size_t n) override {
+        HostIo::serialBytes += n;
+        if (HostIo::verbose) fwrite(b, 1, n, stderr);
+        return n;
+    }
+    int availableForWrite() override { return 256; }
+};
+
+inline HardwareSerial Serial;
+inline HardwareSerial Serial1;
+inline HardwareSerial Serial2;
+
+// =============================================================
+//  IPAddress
+// =============================================================
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _a{a, b, c, d} {}
+    IPAddress(uint32_t v) { memcpy(_a, &v, 4); }
+    uint8_t operator[](int i) const { return _a[i & 3]; }
+    operator uint32_t() const { uint32_t v; memcpy(&v, _a, 4); return v; }
+    bool isSet() const { return (uint32_t)*this != 0; }
+    String toString() const {
+        char b[16];
+        snprintf(b, sizeof(b), "%u.%u.%u.%u", _a[0], _a[1], _a[2], _a[3]);
+        return String(b);
+    }
+private:
+    uint8_t _a[4] = {};
+};
+
+// =============================================================
+//  rp2040 – jen pro výpisy
+// =============================================================
+struct RP2040 {
+    uint32_t getFreeHeap()  { return 256 * 1024; }
+    uint32_t getTotalHeap() { return 512 * 1024; }
+    uint32_t getUsedHeap()  { return getTotalHeap() - getFreeHeap(); }
+    void     reboot()       { exit(0); }
+};
+inline RP2040 rp2040;
@@ -0,0 +1,26 @@
+// =============================================================
+//  FreeRTOS.h – host build: jednovláknová náhrada
+//
+//  Host nespouští tasky (Modbus, Boiler) – data dodává skript
+//  přes SolarModel. Fronty a mutexy jsou skutečné jen natolik,
+//  aby UiEvents a SolarModel fungovaly v jednom vlákně.
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void*    TaskHandle_t;
+typedef void*    SemaphoreHandle_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define portMAX_DELAY           0xFFFFFFFFu
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(x)        ((TickType_t)(x))
+#define portYIELD_FROM_ISR(x)   (void)(x)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
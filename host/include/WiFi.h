@@ -0,0 +1,23 @@
+// =============================================================
+//  WiFi.h – host build: WiFi nikdy nepřipojená
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define WL_CONNECTED        3
+#define WL_DISCONNECTED     6
+
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+
+struct WiFiClass {
+    void      mode(WiFiMode_t) {}
+    int       status() { return WL_DISCONNECTED; }
+    int       begin(const char*, const char*) { return WL_DISCONNECTED; }
+    void      disconnect() {}
+    IPAddress localIP()   { return IPAddress(); }
+    IPAddress softAPIP()  { return IPAddress(); }
+    int       hostByName(const char*, IPAddress&, int = 5000) { return 0; }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,16 @@
+// =============================================================
+//  WiFiClient.h – host build: klient bez spojení
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+class WiFiClient : public Stream {
+public:
+    operator bool() { return false; }
+    bool connected() { return false; }
+    bool connect(IPAddress, uint16_t) { return false; }
+    void setNoDelay(bool) {}
+    void stop() {}
+    using Print::write;
+    size_t write(uint8_t) override { return 1; }
+};
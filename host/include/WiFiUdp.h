@@ -0,0 +1,21 @@
+// =============================================================
+//  WiFiUdp.h – host build: UDP nic nepošle ani nepřijme
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+class WiFiUDP : public Stream {
+public:
+    uint8_t  begin(uint16_t) { return 0; }
+    void     stop() {}
+    int      beginPacket(IPAddress, uint16_t) { return 0; }
+    int      endPacket() { return 0; }
+    int      parsePacket() { return 0; }
+    using Stream::read;
+    int      read(uint8_t*, size_t) { return 0; }
+    using Print::write;
+    size_t   write(uint8_t) override { return 1; }
+    IPAddress remoteIP() { return IPAddress(); }
+    uint16_t remotePort() { return 0; }
+    void     flush() override {}
+};
@@ -0,0 +1,26 @@
+// =============================================================
+//  Wire.h – host build: prázdná I2C sběrnice
+//
+//  Každá adresa odpoví NACK – FRAM, RTC i MCP23017 se hlásí
+//  jako nepřipojené a UI jede na defaults (gConfig).
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+    void begin() {}
+    void setSDA(int) {}
+    void setSCL(int) {}
+    void setClock(uint32_t) {}
+    void beginTransmission(int) {}
+    uint8_t endTransmission(bool = true) { return 2; }      // NACK adresy
+    size_t requestFrom(int, size_t, bool = true) { return 0; }
+    using Print::write;
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t n) override { return n; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,11 @@
+// =============================================================
+//  hardware/watchdog.h – host build: watchdog bez účinku
+// =============================================================
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+inline void watchdog_enable(uint32_t, bool) {}
+inline void watchdog_update() {}
+inline bool watchdog_caused_reboot() { return false; }
+inline void watchdog_reboot(uint32_t, uint32_t, uint32_t) { exit(0); }
@@ -0,0 +1,21 @@
+// =============================================================
+//  lwip/dns.h – host build: DNS nikdy neodpoví
+// =============================================================
+#pragma once
+#include <stdint.h>
+
+typedef int8_t err_t;
+#define ERR_OK          0
+#define ERR_INPROGRESS  -5
+#define ERR_ARG         -16
+
+struct ip4_addr_t { uint32_t addr; };
+typedef ip4_addr_t ip_addr_t;
+#define ip_2_ip4(a)          (a)
+#define ip4_addr_get_u32(a)  ((a)->addr)
+
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* addr, void* arg);
+
+inline err_t dns_gethostbyname(const char*, ip_addr_t*, dns_found_callback, void*) {
+    return ERR_ARG;
+}
@@ -0,0 +1,49 @@
+// =============================================================
+//  queue.h – host build: FIFO fronta bez vláken
+//
+//  xQueueReceive() na prázdné frontě "prospí" timeout – posune
+//  simulovaný čas (HostClock) a vrátí pdFALSE. UI smyčka tak
+//  na hostu běží stejným tempem jako na desce.
+// =============================================================
+#pragma once
+#include <FreeRTOS.h>
+#include <deque>
+#include <vector>
+
+struct HostQueue {
+    UBaseType_t                       len;
+    UBaseType_t                       itemSize;
+    std::deque<std::vector<uint8_t>>  items;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t itemSize) {
+    return new HostQueue{len, itemSize, {}};
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t) {
+    if (!q || q->items.size() >= q->len) return pdFALSE;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+    if (!q) return pdFALSE;
+    if (q->items.empty()) {
+        if (ticks != portMAX_DELAY) HostClock::advanceMs(ticks * portTICK_PERIOD_MS);
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    return q ? (UBaseType_t)q->items.size() : 0;
+}
@@ -0,0 +1,10 @@
+// =============================================================
+//  semphr.h – host build: mutex bez vláken vždy volný
+// =============================================================
+#pragma once
+#include <FreeRTOS.h>
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()  { static int m; return &m; }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { static int b; return &b; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t)             { return pdTRUE; }
@@ -0,0 +1,16 @@
+// =============================================================
+//  task.h – host build: tasky se nespouští, delay posune čas
+// =============================================================
+#pragma once
+#include <FreeRTOS.h>
+
+typedef void (*TaskFunction_t)(void*);
+
+inline BaseType_t xTaskCreate(TaskFunction_t, const char*, uint32_t, void*,
+                              UBaseType_t, TaskHandle_t*) { return pdPASS; }
+inline TickType_t xTaskGetTickCount()      { return millis(); }
+inline void       vTaskDelay(TickType_t t) { HostClock::advanceMs(t); }
+inline void       vTaskDelayUntil(TickType_t* last, TickType_t inc) {
+    *last += inc;
+    if ((int32_t)(*last - millis()) > 0) HostClock::advanceMs(*last - millis());
+}
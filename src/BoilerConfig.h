@@ -14,11 +14,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
-
-// =============================================================
-//  Maximální počet zásobníků
-// =============================================================
-#define BOILER_MAX_COUNT    10
+#include "HW_Config.h"      // BOILER_MAX_COUNT
 
 // =============================================================
 //  Stavový automat zásobníku
@@ -95,8 +91,21 @@ struct BoilerConfig {
     uint8_t  timeStart;          // hodina začátku povoleného ohřevu (0–23)
     uint8_t  timeEnd;            // hodina konce povoleného ohřevu (0–23)
 
+    // --- Relé (viz RelayBank.h, ModbusRelays.h) ---
+    // relaySlave == 0 → lokální relé MCP23017 (index zásobníku)
+    // relaySlave 1–32 → Modbus RTU reléová deska na RS485
+    uint8_t  relaySlave;         // slave ID reléové desky, 0 = MCP23017
+    uint8_t  relayCoil;          // cívka na desce (0–15)
+
+    // --- Denní cíl (viz BoilerController – dohřev k termínu) ---
+    // Nedodá-li solár do termínu dailyTargetWh, dohřeje se ze sítě
+    // v nejpozdější chvíli, kdy to příkonem ještě stihne.
+    uint16_t dailyTargetWh;      // denní minimum energie [Wh], 0 = bez cíle
+    uint8_t  deadlineHour;       // termín cíle [h] (1–23, 0 = půlnoc);
+                                 // z verze 1 bez cíle → výchozí 17
+
     // --- Rezerva do 48B celkem ---
-    uint8_t  reserved[22];
+    uint8_t  reserved[17];
 
     // Výchozí hodnoty
     BoilerConfig() :
@@ -106,7 +115,11 @@ struct BoilerConfig {
         enabled(false),
         allowedGridW(0),
         timeStart(0),
-        timeEnd(0)
+        timeEnd(0),
+        relaySlave(0),
+        relayCoil(0),
+        dailyTargetWh(0),
+        deadlineHour(17)
     {
         memset(label,    0, sizeof(label));
         memset(reserved, 0, sizeof(reserved));
@@ -127,6 +140,11 @@ struct BoilerConfig {
             return hour >= timeStart || hour < timeEnd;
         }
     }
+
+    // Termín denního cíle [s od půlnoci]
+    uint32_t deadlineSecOfDay() const {
+        return (uint32_t)(deadlineHour ? deadlineHour : 24) * 3600UL;
+    }
 };
 static_assert(sizeof(BoilerConfig) == 48, "BoilerConfig must be 48 bytes");
 
@@ -191,7 +209,7 @@ static_assert(sizeof(BoilerDayStats) == 8, "BoilerDayStats must be 8 bytes");
 struct BoilerSystem {
 
     // --- Základní ---
-    uint8_t  numBoilers;             // počet aktivních zásobníků (1–10)
+    uint8_t  numBoilers;             // počet aktivních zásobníků (1–BOILER_MAX_COUNT)
 
     // --- Comfort timer ---
     // Zabraňuje rychlému cvakání relé – nájemníci nic neslyší
@@ -217,8 +235,9 @@ struct BoilerSystem {
     uint16_t recheckIntervalMin;     // jak často testovat plný zásobník [min],
                                      // výchozí 45
                                      // Každý zásobník má vlastní timer rozložený
-                                     // v čase: T + recheckInterval + (idx * 2 min)
-    uint16_t recheckDurationSec;     // jak dlouho držet relé při testu [s], výchozí 10
+                                     // v čase: T + recheckInterval + hash(idx) mod 10 min
+    uint16_t recheckDurationSec;     // max. doba držení relé při testu [s], výchozí 10
+                                     // (sekvenční test rozhodne obvykle po ~4 s)
 
     // --- Solární práhy ---
     uint16_t solarMinSurplusW;       // rezerva nad příkon zásobníku [W], výchozí 200
@@ -242,7 +261,17 @@ struct BoilerSystem {
     uint8_t  hdoStart2, hdoEnd2;     // odpolední tarif (výchozí 13:00–15:00)
     float    hdoThresholdKwh;        // práh průměru FVE pro blokování HDO [kWh/den]
     uint8_t  hdoAdaptiveDays;        // počet dní pro průměr FVE, výchozí 7
-    bool     hdoTopupEnable;         // dohřev ze sítě v topup okně
+    bool     hdoTopupEnable;         // dohřev ze sítě (k termínu cíle / v okně)
+    uint8_t  topupMarginMin;         // rezerva nejpozdějšího startu dohřevu [min],
+                                     // výchozí 30 (soft-start, nepřesný příkon)
+
+    // --- Odhad příkonu z provozu ---
+    bool     autoPowerUpdate;        // true = powerW se opraví podle hran relé
+                                     // (výchozí false – jen příznak změny)
+
+    // --- Dohřev v pevném okně (verze 4) ---
+    // Zásobníky bez denního cíle (dailyTargetWh = 0) dohřívá
+    // ADAPTIVE režim ze sítě v okně jako před zavedením cílů
     uint8_t  hdoTopupStart;          // dohřev od [h], výchozí 17
     uint8_t  hdoTopupEnd;            // dohřev do [h], výchozí 19
 
@@ -267,6 +296,8 @@ struct BoilerSystem {
         hdoThresholdKwh(8.0f),
         hdoAdaptiveDays(7),
         hdoTopupEnable(true),
+        topupMarginMin(30),
+        autoPowerUpdate(false),
         hdoTopupStart(17),
         hdoTopupEnd(19)
     {}
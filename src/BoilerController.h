@@ -6,28 +6,62 @@
 //  Závislosti:
 //    BoilerConfig.h  – datové struktury
 //    SolarData.h     – aktuální data z měniče (thread-safe přes SolarModel)
-//    MCP23017.h      – ovládání relé
-//    PCF85063A.h     – čas pro HDO okna a časová razítka
+//    RelayBank.h     – ovládání relé (1 … MCP_CHIP_COUNT desek MCP23017)
+//    TimeService.h   – čas pro HDO okna (bez I2C čtení RTC)
 //
-//  Globální instance: BoilerController gBoilers(gConfig_boilers, gMCP, gRTC)
+//  Globální instance: BoilerController gBoilers(gConfig_boilers, gRelays)
 //  Spustit jako součást Inverter tasku (Core 1) nebo samostatný task.
 //
 //  Logika:
 //    - Sleduje přeток každé fáze L1/L2/L3 samostatně (asymetrická FVE)
-//    - Round-robin výběr zásobníku (nejdéle neohřívaný má přednost)
+//    - Přidělení přetoku fáze: každý tick vybere z IDLE zásobníků
+//      množinu, jejíž příkon nejlépe vyplní přetok (knapsack),
+//      při shodě nejdéle neohřívané (viz _allocateSurplus)
+//    - Denní cíl energie s termínem (BoilerConfig.dailyTargetWh):
+//      přetok dostanou nejdřív zásobníky s nesplněným cílem
+//      podle nejbližšího termínu (EDF), chybějící energii
+//      dohřeje v HDO před termínem, dohřev ze sítě v dražším
+//      tarifu začne až v nejpozdější chvíli, kdy to příkonem
+//      stihne a HDO okna do termínu nestačí (_mustTopup)
 //    - Comfort timer (min. on/off čas, switch delay mezi sepnutími)
 //    - Detekce plného zásobníku ze změny fáze (2 potvrzovací měření)
-//    - Recheck STANDBY zásobníků v rozložených intervalech
+//    - Recheck STANDBY zásobníků v rozložených intervalech, po
+//      naučení až když model ztrát odhadne ochlazení (BoilerThermal.h)
 //    - HDO logika: ALWAYS / NEVER / ADAPTIVE
 //    - Zombie detektor s konfigurovatelným limitem
 //    - Soft-start: zásobníky se sepínají s mezerou switchDelaySec
+//    - Odhad příkonu a fáze z běžných hran relé (_trackEdges) –
+//      průběžný průměr/rozptyl, příznak změny proti Discovery,
+//      volitelně automatická oprava powerW (autoPowerUpdate)
+//    - Relé se za tick sbírají do jedné dávky (na každou změněnou
+//      desku MCP23017 jeden zápis OLATA/B + ověření zpětným čtením)
+//    - Zásobníky, které jen čekají na termín (STANDBY do rechecku,
+//      SLOT_DONE, COOLDOWN, FORCED_OFF), jsou zaparkované
+//      v TimerHeap (64bit monoMs) – tick je zpracuje až po
+//      vypršení termínu (viz _syncTimers / _armTimer)
+//
+//  Škálování (BOILER_MAX_COUNT až 64):
+//    BoilerConfig/BoilerRuntime zůstávají pole struktur – je to
+//    formát bloků v FRAM. Pro průchody v ticku drží controller
+//    bitové masky (připravené, fáze, stav) a kopii fáze/příkonu
+//    v samostatných polích. tick() prochází jen připravené
+//    zásobníky, volný výkon jen HEATING a round-robin (HDO)
+//    porovná pořadí ohřevu s minimem fáze (počítá se jednou za
+//    tick, ne pro každý IDLE zásobník znovu).
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "BoilerConfig.h"
 #include "SolarData.h"
-#include "MCP23017.h"
-#include "PCF85063A.h"
+#include "RelayBank.h"
+#include "TimeService.h"
+#include "FramMap.h"
+#include "BoilerThermal.h"
+#include "RunningStats.h"
+#include "TimerHeap.h"
+
+extern volatile uint32_t gBoilerCfgGen;     // Config.h – změna bloku 5/6
 
 // Počet potvrzovacích měření pro detekci plného zásobníku
 #define BOILER_FULL_CONFIRM_COUNT   2
@@ -35,6 +69,23 @@
 // Minimální delta fáze pro detekci odběru zásobníku při rechecku [W]
 #define BOILER_RECHECK_MIN_DELTA    200
 
+// Šum fáze (kolísání FVE / odběru mezi ticky) [W] – měří se
+// z rozdílů po sobě jdoucích ticků bez hran relé (_trackJitter),
+// tohle je počáteční hodnota a MIN spodní mez
+#define BOILER_RECHECK_SIGMA_W      250
+#define BOILER_JITTER_MIN_W         50
+// Průměrování rozptylu šumu – váha nového vzorku 1/N (~1 min)
+#define BOILER_JITTER_AVG_N         32
+// Jeden rozdíl se do odhadu započte nejvýš takový [W]
+// (sepnutá rychlovarná konvice nemá odhad rozhodit na minuty)
+#define BOILER_JITTER_CLIP_W        1500
+// Recheck – rozhodovací bod SPRT v % příkonu (jako dřív pevný
+// práh): H1 = powerW, H0 = (2·PCT − 100) % powerW
+#define BOILER_RECHECK_ACCEPT_PCT   80
+// Rozložení rechecků – posun termínu o hash(idx) v tomto okně [ms],
+// aby se zásobníky neprobouzely současně (nezávisí na počtu)
+#define BOILER_RECHECK_JITTER_MS    600000UL
+
 // Tolerance detekce plného zásobníku – pod tuto hodnotu = termostat vypnul [W]
 #define BOILER_FULL_THRESHOLD_W     200
 
@@ -44,12 +95,48 @@
 // Maximální odchylka PV a Load při detekci plného zásobníku [W]
 #define BOILER_CONTEXT_TOLERANCE_W  500
 
+// Přidělení přetoku (_allocateSurplus)
+// Krok příkonu v knapsacku [W] – Discovery zaokrouhluje na 50 W
+#define BOILER_ALLOC_UNIT_W         50
+// Max. přetok jedné fáze v knapsacku [kroků] – 600 × 50 W = 30 kW
+#define BOILER_ALLOC_MAX_UNITS      600
+// Váha vyplněného kroku proti férovosti – součet pořadí ≤ 63·64/2
+#define BOILER_ALLOC_FAIR_SCALE     2048
+// Zásobník sepnutý před méně než … [ms] ještě nemusí být v měření fáze
+#define BOILER_ALLOC_SETTLE_MS      (2UL * BOILER_TICK_MS)
+// Přednost nesplněného denního cíle – víc než jakékoli vyplnění přetoku
+#define BOILER_ALLOC_EDF_BONUS      ((int64_t)(BOILER_ALLOC_MAX_UNITS + 1) * BOILER_ALLOC_FAIR_SCALE)
+
+// Denní cíl – energie se ukládá do FRAM po 100 Wh, nejvýš 1× za 5 min
+#define BOILER_ENERGY_SAVE_MS       300000UL
+
+// Odhad příkonu z hran relé (_trackEdges)
+// Vzorků před vyhodnocením změny
+#define BOILER_EST_MIN_SAMPLES      5
+// Změna příkonu proti powerW [%] – menší odchylka = šum měření
+#define BOILER_EST_DRIFT_PCT        10
+
+// Bitová maska zásobníků – bit i = zásobník i
+#if BOILER_MAX_COUNT <= 32
+typedef uint32_t BoilerMask;
+#else
+typedef uint64_t BoilerMask;
+#endif
+static_assert(BOILER_MAX_COUNT <= 64, "BoilerMask má max. 64 bitů");
+
+#define BOILER_BIT(i)               ((BoilerMask)1 << (i))
+#define BOILER_STATE_COUNT          (BOILER_ALARM + 1)
+
+// Nejstarší čas obnovený ze snapshotu [s] – delší odstup se ořízne
+// (rozdíly millis() musí zůstat pod ~24 dní kvůli přetečení)
+#define BOILER_RT_MAX_AGE_S         (7UL * 86400UL)
+
 // =============================================================
 //  Interní provozní data zásobníku (RAM, ne FRAM)
 // =============================================================
 struct BoilerInternal {
     // Základna fáze před sepnutím (pro detekci odběru)
-    int32_t  phaseBaseline;          // průměr fáze před sepnutím relé [W]
+    int32_t  phaseBaseline;          // volný výkon fáze (freeW) před sepnutím [W]
     int32_t  pvBaseline;             // powerPV před sepnutím [W]
     int32_t  loadBaseline;           // powerLoad před sepnutím [W]
 
@@ -57,13 +144,21 @@ struct BoilerInternal {
     uint8_t  fullConfirmCount;       // kolikrát po sobě delta < FULL_THRESHOLD
 
     // Recheck timer
-    uint32_t recheckScheduledAt;     // millis() kdy provést recheck (0 = neplánováno)
+    uint64_t recheckScheduledAt;     // monoMs() kdy provést recheck (0 = neplánováno)
     bool     recheckActive;          // právě probíhá recheck test
     int32_t  recheckBaseline;        // fáze před sepnutím při rechecku
+    uint32_t recheckStartMs;         // millis() sepnutí relé při rechecku
+    Sprt     recheckTest;            // sekvenční test odběr / plný
 
     // Timestamp vstupu do HEATING pro výpočet onTime
     uint32_t heatingStartMs;
 
+    // Dohřev ze sítě k termínu denního cíle – PENDING/HEATING
+    // nehlídá přetok, vypne se po splnění cíle nebo v termínu
+    bool     gridTopup;
+    // Ohřev k dennímu cíli v HDO (gridTopup + konec s nízkým tarifem)
+    bool     hdoHeat;
+
     // Timestamp posledního sepnutí na této fázi (sdíleno přes controller)
     // – uloženo v BoilerRuntime.lastOffAt
 
@@ -75,30 +170,61 @@ struct BoilerInternal {
         recheckScheduledAt(0),
         recheckActive(false),
         recheckBaseline(0),
-        heatingStartMs(0)
+        recheckStartMs(0),
+        heatingStartMs(0),
+        gridTopup(false),
+        hdoHeat(false)
     {}
 };
 
 // =============================================================
 //  BoilerController
 // =============================================================
+// =============================================================
+//  Odhad příkonu a fáze zásobníku z běžného provozu (RAM)
+// =============================================================
+struct BoilerPowerEst {
+    RunningStats w;              // změna fáze při hraně [W]
+    uint8_t      votes[3];       // fáze s největší změnou (L1–L3)
+    bool         powerDrift;     // odhad nesedí s BoilerConfig.powerW
+    bool         phaseDrift;     // hrany se měří na jiné fázi
+
+    BoilerPowerEst() : votes{0, 0, 0}, powerDrift(false), phaseDrift(false) {}
+
+    // Fáze s nejvíc hlasy 1–3 (0 = žádný vzorek)
+    uint8_t phase() const {
+        uint8_t k = 0;
+        for (uint8_t j = 1; j < 3; j++) if (votes[j] > votes[k]) k = j;
+        return votes[k] ? k + 1 : 0;
+    }
+};
+
 class BoilerController {
 public:
     BoilerController(const BoilerSystem& sys,
                      BoilerConfig*       configs,    // pole BOILER_MAX_COUNT
                      BoilerRuntime*      runtimes,   // pole BOILER_MAX_COUNT
-                     MCP23017&           mcp,
-                     PCF85063A&          rtc)
+                     RelayBank&          mcp)
         : _sys(sys)
         , _cfg(configs)
         , _rt(runtimes)
         , _mcp(mcp)
-        , _rtc(rtc)
     {
         memset(_internal, 0, sizeof(_internal));
         memset(_lastSwitchOnMs, 0, sizeof(_lastSwitchOnMs));
         memset(_phaseLoadWh, 0, sizeof(_phaseLoadWh));
         memset(_phaseSolarWh, 0, sizeof(_phaseSolarWh));
+        memset(_phaseIdx, 0, sizeof(_phaseIdx));
+        memset(_powerW, 0, sizeof(_powerW));
+        memset(_stateMask, 0, sizeof(_stateMask));
+        memset(_phaseMask, 0, sizeof(_phaseMask));
+        memset(_energyWs, 0, sizeof(_energyWs));
+        memset(_probePh, 0, sizeof(_probePh));
+        memset(_jitPrev, 0, sizeof(_jitPrev));
+        for (uint8_t j = 0; j < 3; j++) {
+            _jitVar[j] = (float)BOILER_RECHECK_SIGMA_W * BOILER_RECHECK_SIGMA_W;
+        }
+        memset(_timerState, 0xFF, sizeof(_timerState));
     }
 
     // ---------------------------------------------------------
@@ -111,28 +237,43 @@ public:
         }
 
         // Obnov stav relé podle uloženého runtime stavu (přežití restartu)
+        _mono        = monoMs();
+        uint32_t now = (uint32_t)_mono;
+        _cfgGen      = gBoilerCfgGen;
+        _syncMasks();
+        _mcp.beginBatch();
         for (uint8_t i = 0; i < _sys.numBoilers; i++) {
             // Po restartu vždy bezpečný stav – všechna relé vypnuta
             // Runtime stav obnoví jen pro STANDBY/DONE zásobníky
             bool relayState = false;
-            if (_rt[i].state == BOILER_HEATING) {
-                // Byl v HEATING při restartu – přejdi do IDLE, bezpečněji
-                _rt[i].state = BOILER_IDLE;
-                Serial.printf("[BC] Byt %u: restart z HEATING → IDLE\n", i + 1);
+            switch (_rt[i].state) {
+                case BOILER_HEATING:
+                case BOILER_FORCED_OFF:
+                    // Relé bylo sepnuté – restart ho vypnul → respektuj minOffTime
+                    LOGF("[BC] Byt %u: restart z %s → COOLDOWN\n",
+                        i + 1, boilerStateName(_rt[i].state));
+                    _rt[i].lastOffAt = now;
+                    _changeState(i, BOILER_COOLDOWN, now);
+                    break;
+                case BOILER_PENDING:
+                    _changeState(i, BOILER_IDLE, now);
+                    break;
+                default:
+                    break;
             }
             _mcp.setRelay(i, relayState);
         }
+        _mcp.commit();
 
-        // Naplánuj rechecky pro STANDBY zásobníky
-        uint32_t now = millis();
+        // Naplánuj rechecky pro STANDBY zásobníky (pokud nejsou ze snapshotu)
         for (uint8_t i = 0; i < _sys.numBoilers; i++) {
-            if (_rt[i].state == BOILER_STANDBY) {
+            if (_rt[i].state == BOILER_STANDBY && _internal[i].recheckScheduledAt == 0) {
                 _scheduleRecheck(i, now);
-                Serial.printf("[BC] Byt %u: obnoveno STANDBY, recheck naplánován\n", i + 1);
+                LOGF("[BC] Byt %u: obnoveno STANDBY, recheck naplánován\n", i + 1);
             }
         }
 
-        Serial.printf("[BC] Init OK – %u zásobníků, HDO=%s, sezóna=%s\n",
+        LOGF("[BC] Init OK – %u zásobníků, HDO=%s, sezóna=%s\n",
             _sys.numBoilers,
             hdoModeName(_sys.hdoMode),
             _sys.seasonWinter ? "ZIMA" : "LÉTO");
@@ -145,29 +286,69 @@ public:
     void tick(const SolarData& d) {
         if (!d.valid) return;  // žádná data z měniče – nedělej nic
 
-        uint32_t now     = millis();
-        DateTime dt      = _rtc.getTime();
+        _mono            = monoMs();
+        uint32_t now     = (uint32_t)_mono;   // = millis()
+        DateTime dt      = TimeService::local();
         bool     hdoLow  = _getHDO(dt);  // true = nízký tarif (HDO aktivní)
 
+        // Masky jen po uložení konfigurace z UI nebo resetBoiler() –
+        // přechody stavů v ticku je udržují _changeState()
+        uint32_t gen = gBoilerCfgGen;
+        if (gen != _cfgGen || _masksDirty) {
+            _cfgGen     = gen;
+            _masksDirty = false;
+            _syncMasks();
+        }
+
+        // Termíny: přepočet po změně mimo tick, prošlé → zpracovat
+        _syncTimers(now);
+
+        // Nový den → denní cíle začínají od nuly
+        if (dt.day != _energyDay) {
+            if (_energyDay) {
+                memset(_energyWs, 0, sizeof(_energyWs));
+                _rtDirty = true;
+            }
+            _energyDay = dt.day;
+        }
+
+        // Hrany relé mimo tick (reset, UI) nemají základnu měření
+        if (_edgeMask) {
+            _probeIdx   = 0xFF;
+            _lastEdgeMs = now;
+        }
+        _edgeMask = 0;
+
         // Aktuální volný výkon na každé fázi (bez příkonu sepnutých zásobníků)
         int32_t freeW[3];
         _calcFreepower(d, freeW);
 
-        // Projdi všechny zásobníky
-        for (uint8_t i = 0; i < _sys.numBoilers; i++) {
-            if (!_cfg[i].isReady()) continue;
+        // Změny relé celého ticku → jedna I2C transakce na konci
+        _mcp.beginBatch();
 
-            uint8_t  ph  = _cfg[i].phase - 1;  // index fáze 0/1/2
-            int32_t  phW = d.phaseL1 * (ph == 0) +
-                           d.phaseL2 * (ph == 1) +
-                           d.phaseL3 * (ph == 2);
+        // Přetok fází → PENDING pro vybrané IDLE zásobníky
+        const int32_t phaseW[3] = { d.phaseL1, d.phaseL2, d.phaseL3 };
+        _allocateSurplus(phaseW, freeW, d, dt, now);
 
-            _tickBoiler(i, phW, freeW[ph], d, dt, hdoLow, now);
+        // Projdi připravené zásobníky (ALARM čeká na reset, zaparkované
+        // na termín čekají v _timers – přeskoč)
+        for (BoilerMask m = _readyMask & ~_stateMask[BOILER_ALARM] & ~_waitMask; m; ) {
+            uint8_t i  = _popBit(m);
+            uint8_t ph = _phaseIdx[i];         // index fáze 0/1/2
+            _tickBoiler(i, phaseW[ph], freeW[ph], d, dt, hdoLow, now);
+            _armTimer(i, now);
         }
 
-        // Aktualizuj statistiky ohřevu
+        // Aktualizuj statistiky ohřevu a energii denních cílů
         _updateStats(d, now);
 
+        // Šum fází a odhad příkonu z hran relé (měření před zápisem dávky)
+        _trackJitter(d, now);
+        _trackEdges(d, now);
+
+        // Zapiš relé a ověř piny (nesouhlas = alarm v SolarData)
+        _mcp.commit();
+
         // Exportuj stav relé do SolarModel
         _exportRelayState();
     }
@@ -180,7 +361,10 @@ public:
         _setRelay(idx, false);
         _rt[idx].state = BOILER_IDLE;
         _internal[idx] = BoilerInternal();
-        Serial.printf("[BC] Byt %u: manuální reset → IDLE\n", idx + 1);
+        _thermal[idx].breakCycle();
+        _rtDirty       = true;
+        _masksDirty    = true;
+        LOGF("[BC] Byt %u: manuální reset → IDLE\n", idx + 1);
     }
 
     // ---------------------------------------------------------
@@ -191,31 +375,165 @@ public:
         return _rt[idx].state;
     }
 
+    // Dodáno dnes [Wh] – pro denní cíl (dailyTargetWh)
+    uint32_t energyTodayWh(uint8_t idx) const {
+        if (idx >= BOILER_MAX_COUNT) return 0;
+        return _energyWs[idx] / 3600UL;
+    }
+
+    // ---------------------------------------------------------
+    //  Persistence BoilerRuntime (Blok 7) – viz WarmStart.h
+    //
+    //  _changeState() jen nastaví příznak; zápis do FRAM dělá
+    //  Core 0 (FramWriter smí jen UI smyčka).
+    // ---------------------------------------------------------
+    bool takeRuntimeDirty() {
+        if (!_rtDirty) return false;
+        _rtDirty = false;
+        return true;
+    }
+
+    // Automatická oprava powerW z Boiler tasku (Core 1) – BoilerConfig
+    // zapisuje jen Core 0: loop() sem přenese navržené příkony a při
+    // true uloží blok 6 (saveAsync zvýší gBoilerCfgGen → tick přepočte
+    // kopie _powerW)
+    bool applyPowerUpdates() {
+        if (!_cfgDirty) return false;
+        _cfgDirty = false;
+        bool changed = false;
+        for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
+            uint16_t w = _newPowerW[i];
+            if (!w) continue;
+            _newPowerW[i] = 0;
+            if (w == _cfg[i].powerW) continue;
+            _cfg[i].powerW = w;
+            changed = true;
+        }
+        if (changed) gBoilerCfgGen++;
+        return changed;
+    }
+
+    // Odhad příkonu a fáze z hran relé (pro diagnostiku)
+    const BoilerPowerEst& powerEstimate(uint8_t idx) const {
+        return _est[idx < BOILER_MAX_COUNT ? idx : 0];
+    }
+
+    // millis() → RTC sekundy; nowSecs = aktuální čas RTC
+    void exportRuntime(FramBoilerRt* out, uint32_t nowSecs) const {
+        uint32_t nowMs = millis();
+        auto toSecs = [&](uint32_t ms) -> uint32_t {
+            uint32_t age = (nowMs - ms) / 1000UL;
+            return age < nowSecs ? nowSecs - age : 1;
+        };
+        for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
+            const BoilerRuntime&  rt = _rt[i];
+            const BoilerInternal& bi = _internal[i];
+            FramBoilerRt& f  = out[i];
+            f.state          = rt.state;
+            f.recheckIndex   = rt.recheckIndex;
+            f.slotFull       = rt.slotFull;
+            uint32_t hwh     = _energyWs[i] / 360000UL;
+            f.energyHWh      = hwh > 255 ? 255 : (uint8_t)hwh;
+            f.lastHeatedAt   = rt.lastHeatedAt ? toSecs(rt.lastHeatedAt) : _heatedSecs[i];
+            f.lastOffAt      = rt.lastOffAt    ? toSecs(rt.lastOffAt)    : 0;
+            f.stateEnteredAt = toSecs(rt.stateEnteredAt);
+            f.recheckDueAt   = 0;
+            if (bi.recheckScheduledAt != 0) {
+                int64_t left = (int64_t)(bi.recheckScheduledAt - monoMs()) / 1000;
+                f.recheckDueAt = nowSecs + (left > 0 ? (uint32_t)left : 0);
+            }
+        }
+    }
+
+    // RTC sekundy → millis(); volej PŘED begin()
+    // timeValid = false → stavy se obnoví, časovače začnou znovu
+    void importRuntime(const FramBoilerRt* in, uint32_t nowSecs, bool timeValid) {
+        uint32_t nowMs = millis();
+        auto toMs = [&](uint32_t secs) -> uint32_t {
+            uint32_t age = 0;               // čas neznámý → časovač běží znovu
+            if (timeValid) {
+                age = (secs < nowSecs) ? nowSecs - secs : 0;
+                if (!secs || age > BOILER_RT_MAX_AGE_S) age = BOILER_RT_MAX_AGE_S;
+            }
+            return nowMs - age * 1000UL;    // přetečení nevadí – porovnává se rozdíl
+        };
+        for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
+            const FramBoilerRt& f = in[i];
+            if (f.state > BOILER_ALARM) continue;
+            BoilerRuntime& rt = _rt[i];
+            rt.state          = (BoilerState)f.state;
+            rt.recheckIndex   = f.recheckIndex;
+            rt.slotFull       = f.slotFull != 0;
+            rt.lastOffAt      = toMs(f.lastOffAt);
+            rt.stateEnteredAt = toMs(f.stateEnteredAt);
+            if (f.recheckDueAt) {
+                uint32_t left = (timeValid && f.recheckDueAt > nowSecs)
+                              ? f.recheckDueAt - nowSecs : 0;
+                _internal[i].recheckScheduledAt = monoMs() + left * 1000ULL + 1;
+            }
+            // Energie dne platí, jen když stav změnil dnes (lokální epocha
+            // → den = secs / 86400); jinak je ze včerejška → od nuly
+            _energyWs[i] = (timeValid && f.stateEnteredAt / 86400UL == nowSecs / 86400UL)
+                         ? (uint32_t)f.energyHWh * 360000UL : 0;
+        }
+        if (timeValid) _energyDay = secsToDateTime(nowSecs).day;
+
+        // lastHeatedAt (millis) by šel před startem do záporu → zůstane
+        // 0 = "od startu neohříván" a čas ze snapshotu drží _heatedSecs;
+        // pořadí pro round-robin obojí spojí v _heatKey()
+        for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
+            _rt[i].lastHeatedAt = 0;
+            _heatedSecs[i]      = in[i].state > BOILER_ALARM ? 0 : in[i].lastHeatedAt;
+        }
+        LOGLN("[BC] Runtime obnoven ze snapshotu");
+    }
+
     // ---------------------------------------------------------
     //  Debug výpis všech zásobníků na Serial
     // ---------------------------------------------------------
     void printStatus() const {
-        Serial.println("[BC] --- Stav zásobníků ---");
+        LOGLN("[BC] --- Stav zásobníků ---");
         for (uint8_t i = 0; i < _sys.numBoilers; i++) {
-            Serial.printf("  Byt %2u  L%u  %4uW  %-10s  lastHeat=%lus ago\n",
+            char heat[24];
+            if (_rt[i].lastHeatedAt) {
+                snprintf(heat, sizeof(heat), "%lus ago",
+                    (unsigned long)((millis() - _rt[i].lastHeatedAt) / 1000UL));
+            } else {
+                snprintf(heat, sizeof(heat), "%s", _heatedSecs[i] ? "před startem" : "nikdy");
+            }
+            LOGF("  Byt %2u  L%u  %4uW  %-10s  lastHeat=%s\n",
                 i + 1,
                 _cfg[i].phase,
                 _cfg[i].powerW,
                 boilerStateName(_rt[i].state),
-                (millis() - _rt[i].lastHeatedAt) / 1000UL);
+                heat);
+            const BoilerThermal& th = _thermal[i];
+            if (th.trained()) {
+                LOGF("          model: práh %u Wh, ztráta %u/%u/%u/%u/%u/%u W\n",
+                    th.acceptWh, th.lossW[0], th.lossW[1], th.lossW[2],
+                    th.lossW[3], th.lossW[4], th.lossW[5]);
+            }
+            const BoilerPowerEst& e = _est[i];
+            if (e.w.n) {
+                LOGF("          odhad: L%u %.0f W ±%.0f (n=%u)%s\n",
+                    e.phase(), e.w.mean(), e.w.stddev(), e.w.n,
+                    (e.powerDrift || e.phaseDrift) ? " ZMĚNA" : "");
+            }
         }
-        Serial.println("[BC] -----------------------");
+        LOGLN("[BC] -----------------------");
     }
 
 private:
     const BoilerSystem& _sys;
     BoilerConfig*       _cfg;
     BoilerRuntime*      _rt;
-    MCP23017&           _mcp;
-    PCF85063A&          _rtc;
+    RelayBank&          _mcp;
 
     BoilerInternal      _internal[BOILER_MAX_COUNT];
 
+    // Runtime změněn od posledního uložení (čte Core 0)
+    volatile bool       _rtDirty = false;
+
     // Timestamp posledního sepnutí relé na každé fázi (pro switchDelaySec)
     uint32_t _lastSwitchOnMs[3];
 
@@ -226,6 +544,98 @@ private:
     // Datum posledního flush statistik (pro detekci nového dne)
     uint8_t  _lastStatsDay = 0;
 
+    // Denní cíl – dodaná energie dnes [Ws] (HEATING × powerW)
+    uint32_t _energyWs[BOILER_MAX_COUNT];
+    uint8_t  _energyDay    = 0;                    // den v měsíci (0 = neznámý)
+    uint32_t _lastTickMs   = 0;
+    uint32_t _energySaveMs = 0;
+
+    // Model ztrát pro plánování rechecku (jen RAM)
+    BoilerThermal _thermal[BOILER_MAX_COUNT];
+
+    // Odhad příkonu z hran relé (viz _trackEdges)
+    BoilerPowerEst _est[BOILER_MAX_COUNT];
+    BoilerMask     _relayMask = 0;                 // naposledy zapsaný stav relé
+    BoilerMask     _edgeMask  = 0;                 // relé změněná v tomto ticku
+    volatile bool  _cfgDirty  = false;             // _newPowerW čeká na Core 0
+    volatile uint16_t _newPowerW[BOILER_MAX_COUNT] = {};  // navržený powerW, 0 = nic
+    uint8_t        _probeIdx  = 0xFF;              // měřená hrana (0xFF = žádná)
+    bool           _probeOn   = false;
+    uint32_t       _probeAtMs = 0;
+    int32_t        _probePh[3];                    // fáze před hranou
+    int32_t        _probePV   = 0;
+    int32_t        _probeLoad = 0;
+
+    // Šum fází pro recheck (viz _trackJitter)
+    float          _jitVar[3];                     // rozptyl vzorku fáze [W²]
+    int32_t        _jitPrev[3];                    // fáze minulého ticku
+    bool           _jitPrevOk = false;             // minulý tick bez hran
+    uint32_t       _lastEdgeMs = 0;                // poslední hrana relé
+
+    // Termíny zaparkovaných zásobníků (viz _syncTimers)
+    TimerHeap<BOILER_MAX_COUNT> _timers;
+    uint64_t   _mono       = 0;                    // monoMs() aktuálního ticku
+    BoilerMask _waitMask   = 0;                    // zaparkované – tick přeskočí
+    uint8_t    _timerState[BOILER_MAX_COUNT];      // stav, pro který je termín
+    uint64_t   _timerKey   = 0;                    // minOn/minOff/slotCooldown
+
+    // --- Průchody v ticku (viz _syncMasks) ---
+    uint32_t   _cfgGen     = 0;                    // gBoilerCfgGen posledního přepočtu
+    volatile bool _masksDirty = false;             // resetBoiler() mimo tick
+    uint8_t    _phaseIdx[BOILER_MAX_COUNT];        // fáze 0–2 (kopie _cfg)
+    uint16_t   _powerW[BOILER_MAX_COUNT];          // příkon [W] (kopie _cfg)
+    BoilerMask _activeMask = 0;                    // i < numBoilers
+    BoilerMask _readyMask  = 0;                    // aktivní a isReady()
+    BoilerMask _phaseMask[3];                      // připravené na fázi L1–L3
+    BoilerMask _stateMask[BOILER_STATE_COUNT];     // aktivní ve stavu
+
+    // Round-robin – nejmenší _heatKey() IDLE zásobníků na fázi
+    uint64_t   _rrMin[3]   = {};
+    uint32_t   _heatedSecs[BOILER_MAX_COUNT] = {}; // lastHeatedAt ze snapshotu [s RTC],
+                                                   // platí dokud lastHeatedAt == 0
+    uint8_t    _rrValid    = 0;                    // bit ph = _rrMin[ph] platné
+
+    // Přidělení přetoku (viz _allocateSurplus)
+    BoilerMask _allocMask   = 0;                   // PENDING z přetoku
+    BoilerMask _surplusMask = 0;                   // IDLE, kterým přetok stačí
+    int64_t    _kValue[BOILER_ALLOC_MAX_UNITS + 1];
+    BoilerMask _kSet[BOILER_ALLOC_MAX_UNITS + 1];
+
+    // Index nejnižšího bitu + jeho smazání
+    static uint8_t _popBit(BoilerMask& m) {
+        uint8_t i = (uint8_t)__builtin_ctzll((unsigned long long)m);
+        m &= m - 1;
+        return i;
+    }
+
+    // ---------------------------------------------------------
+    //  Přepočti masky a kopie fáze/příkonu z _cfg/_rt
+    //  O(n) – volá begin() (po importRuntime()) a tick() jen když
+    //  UI uložilo blok 5/6 (gBoilerCfgGen) nebo resetBoiler()
+    //  zapsal stav přímo.
+    // ---------------------------------------------------------
+    void _syncMasks() {
+        uint8_t n = _sys.numBoilers < BOILER_MAX_COUNT ? _sys.numBoilers : BOILER_MAX_COUNT;
+        _activeMask = 0;
+        _readyMask  = 0;
+        memset(_phaseMask, 0, sizeof(_phaseMask));
+        memset(_stateMask, 0, sizeof(_stateMask));
+
+        for (uint8_t i = 0; i < n; i++) {
+            BoilerMask bit = BOILER_BIT(i);
+            _phaseIdx[i] = (uint8_t)(_cfg[i].phase - 1);
+            _powerW[i]   = _cfg[i].powerW;
+            _activeMask |= bit;
+            if (_rt[i].state < BOILER_STATE_COUNT) _stateMask[_rt[i].state] |= bit;
+            if (_cfg[i].isReady()) {
+                _readyMask |= bit;
+                _phaseMask[_phaseIdx[i]] |= bit;
+            }
+        }
+        _rrValid    = 0;
+        _allocMask &= _stateMask[BOILER_PENDING];
+    }
+
     // ---------------------------------------------------------
     //  Výpočet volného výkonu na každé fázi
     //  = aktuální fáze mínus příkon všech HEATING zásobníků na té fázi
@@ -235,11 +645,10 @@ private:
         freeW[1] = d.phaseL2;
         freeW[2] = d.phaseL3;
 
-        for (uint8_t i = 0; i < _sys.numBoilers; i++) {
-            if (_rt[i].state == BOILER_HEATING) {
-                uint8_t ph = _cfg[i].phase - 1;
-                freeW[ph] += _cfg[i].powerW;  // odečti příkon (přičti k přetoku)
-            }
+        for (BoilerMask m = _stateMask[BOILER_HEATING]; m; ) {
+            uint8_t i  = _popBit(m);
+            uint8_t ph = _phaseIdx[i];
+            if (ph < 3) freeW[ph] += _powerW[i];  // odečti příkon (přičti k přetoku)
         }
     }
 
@@ -264,17 +673,17 @@ private:
 
             // -------------------------------------------------
             case BOILER_PENDING:
-                _statePending(idx, cfg, rt, bi, freeW, ph, now);
+                _statePending(idx, cfg, rt, bi, freeW, ph, hdoLow, now);
                 break;
 
             // -------------------------------------------------
             case BOILER_HEATING:
-                _stateHeating(idx, cfg, rt, bi, phW, d, now);
+                _stateHeating(idx, cfg, rt, bi, phW, freeW, d, dt, hdoLow, now);
                 break;
 
             // -------------------------------------------------
             case BOILER_STANDBY:
-                _stateStandby(idx, cfg, rt, bi, phW, freeW, d, hdoLow, now);
+                _stateStandby(idx, cfg, rt, bi, phW, freeW, d, now);
                 break;
 
             // -------------------------------------------------
@@ -306,6 +715,35 @@ private:
                     BoilerInternal& bi, int32_t freeW, const SolarData& d,
                     const DateTime& dt, bool hdoLow, uint32_t now) {
 
+        // --- Denní cíl: nejpozdější start dohřevu ze sítě ---
+        // Záruka cíle má přednost před SOC i časovým oknem
+        if (_mustTopup(idx, dt)) {
+            if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
+            bi.phaseBaseline = freeW;
+            bi.pvBaseline    = d.powerPV;
+            bi.loadBaseline  = d.powerLoad;
+            _changeState(idx, BOILER_PENDING, now);
+            bi.gridTopup     = true;
+            LOGF("[BC] Byt %u: dohřev k termínu %u h (chybí %lu Wh)\n",
+                idx + 1, cfg.deadlineHour, _deficitWh(idx));
+            return;
+        }
+
+        // --- Denní cíl v HDO: levný tarif před termínem ---
+        // Také záruka cíle (bez SOC a okna), _mustTopup s HDO počítá
+        if (hdoLow && _deficitWh(idx) && _hdoAllowed() && _secsToDeadline(idx, dt) > 0) {
+            if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
+            bi.phaseBaseline = freeW;
+            bi.pvBaseline    = d.powerPV;
+            bi.loadBaseline  = d.powerLoad;
+            _changeState(idx, BOILER_PENDING, now);
+            bi.gridTopup     = true;
+            bi.hdoHeat       = true;
+            LOGF("[BC] Byt %u: HDO ohřev k cíli (chybí %lu Wh)\n",
+                idx + 1, _deficitWh(idx));
+            return;
+        }
+
         // Kontrola SOC baterie
         if (d.soc < _sys.minSocForBoilers) return;
 
@@ -313,27 +751,29 @@ private:
         if (!cfg.isInTimeWindow(dt.hour)) return;
 
         // --- Solární režim ---
-        if (hasSufficientPower(freeW, cfg, _sys)) {
-            // Zkontroluj minOffTime
-            if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
+        // Do PENDING posílá _allocateSurplus(); zásobník, kterému přetok
+        // stačí, ale nebyl vybrán, čeká na další tick (ne na HDO)
+        if (_surplusMask & BOILER_BIT(idx)) return;
 
-            // Zkontroluj switchDelaySec na této fázi
-            uint8_t ph = cfg.phase - 1;
-            if (now - _lastSwitchOnMs[ph] < (uint32_t)_sys.switchDelaySec * 1000UL) return;
+        // Zásobník s denním cílem bere ze sítě jen chybějící energii
+        // (HDO / dohřev k termínu výše), po splnění cíle už ne
+        if (cfg.dailyTargetWh) return;
 
-            // Je to zásobník s nejstarším lastHeatedAt na této fázi?
+        // --- HDO režim (záloha / zimní provoz) ---
+        if (hdoLow && _hdoAllowed()) {
+            if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
             if (!_isRoundRobinTurn(idx)) return;
 
-            // Vše OK → přejdi do PENDING
-            bi.phaseBaseline  = freeW;
-            bi.pvBaseline     = d.powerPV;
-            bi.loadBaseline   = d.powerLoad;
+            bi.phaseBaseline = freeW;
+            bi.pvBaseline    = d.powerPV;
+            bi.loadBaseline  = d.powerLoad;
             _changeState(idx, BOILER_PENDING, now);
             return;
         }
 
-        // --- HDO režim (záloha / zimní provoz) ---
-        if (hdoLow && _sys.hdoMode != HDO_NEVER && !_shouldBlockHDO()) {
+        // --- Dohřev ze sítě v pevném okně (ADAPTIVE, bez denního cíle) ---
+        if (_sys.hdoMode == HDO_ADAPTIVE && _sys.hdoTopupEnable &&
+            dt.hour >= _sys.hdoTopupStart && dt.hour < _sys.hdoTopupEnd) {
             if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
             if (!_isRoundRobinTurn(idx)) return;
 
@@ -341,20 +781,6 @@ private:
             bi.pvBaseline    = d.powerPV;
             bi.loadBaseline  = d.powerLoad;
             _changeState(idx, BOILER_PENDING, now);
-            return;
-        }
-
-        // --- HDO dohřev ze sítě (ADAPTIVE režim, topup okno) ---
-        if (_sys.hdoMode == HDO_ADAPTIVE && _sys.hdoTopupEnable) {
-            if (dt.hour >= _sys.hdoTopupStart && dt.hour < _sys.hdoTopupEnd) {
-                if (now - rt.lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) return;
-                if (!_isRoundRobinTurn(idx)) return;
-
-                bi.phaseBaseline = freeW;
-                bi.pvBaseline    = d.powerPV;
-                bi.loadBaseline  = d.powerLoad;
-                _changeState(idx, BOILER_PENDING, now);
-            }
         }
     }
 
@@ -363,10 +789,15 @@ private:
     // ---------------------------------------------------------
     void _statePending(uint8_t idx, BoilerConfig& cfg, BoilerRuntime& rt,
                        BoilerInternal& bi, int32_t freeW, uint8_t ph,
-                       uint32_t now) {
+                       bool hdoLow, uint32_t now) {
 
-        // Výkon mezitím klesl → zpět do IDLE
-        if (!hasSufficientPower(freeW, cfg, _sys)) {
+        // Výkon mezitím klesl → zpět do IDLE (dohřev k termínu nečeká na výkon)
+        if (!bi.gridTopup && !hasSufficientPower(freeW, cfg, _sys)) {
+            _changeState(idx, BOILER_IDLE, now);
+            return;
+        }
+        // HDO skončilo před sepnutím → IDLE rozhodne znovu
+        if (bi.hdoHeat && !hdoLow) {
             _changeState(idx, BOILER_IDLE, now);
             return;
         }
@@ -380,7 +811,7 @@ private:
         bi.heatingStartMs    = now;
         bi.fullConfirmCount  = 0;
         _changeState(idx, BOILER_HEATING, now);
-        Serial.printf("[BC] Byt %u: sepnuto (L%u, %uW, freeW=%ld)\n",
+        LOGF("[BC] Byt %u: sepnuto (L%u, %uW, freeW=%ld)\n",
             idx + 1, cfg.phase, cfg.powerW, freeW);
     }
 
@@ -388,23 +819,51 @@ private:
     //  HEATING – zásobník se ohřívá
     // ---------------------------------------------------------
     void _stateHeating(uint8_t idx, BoilerConfig& cfg, BoilerRuntime& rt,
-                       BoilerInternal& bi, int32_t phW, const SolarData& d,
+                       BoilerInternal& bi, int32_t phW, int32_t freeW,
+                       const SolarData& d, const DateTime& dt, bool hdoLow,
                        uint32_t now) {
 
         uint32_t onTimeMs  = now - bi.heatingStartMs;
         uint32_t onTimeSec = onTimeMs / 1000UL;
 
+        // --- Dohřev k termínu – cíl splněn nebo termín prošel ---
+        if (bi.gridTopup && (!_deficitWh(idx) || _secsToDeadline(idx, dt) <= 0)) {
+            _setRelay(idx, false);
+            rt.lastOffAt = now;
+            _changeState(idx, BOILER_COOLDOWN, now);
+            LOGF("[BC] Byt %u: dohřev k termínu ukončen (%lu/%u Wh)\n",
+                idx + 1, energyTodayWh(idx), cfg.dailyTargetWh);
+            return;
+        }
+
+        // --- HDO ohřev k cíli – nízký tarif skončil ---
+        // Zbytek se nestihne v dalším HDO → pokračuje jako dohřev
+        if (bi.hdoHeat && !hdoLow) {
+            bi.hdoHeat = false;
+            if (!_mustTopup(idx, dt)) {
+                _setRelay(idx, false);
+                rt.lastOffAt = now;
+                _changeState(idx, BOILER_COOLDOWN, now);
+                LOGF("[BC] Byt %u: konec HDO, cíl počká (%lu/%u Wh)\n",
+                    idx + 1, energyTodayWh(idx), cfg.dailyTargetWh);
+                return;
+            }
+            LOGF("[BC] Byt %u: konec HDO → dohřev k termínu %u h\n",
+                idx + 1, cfg.deadlineHour);
+        }
+
         // --- Slot timeout – rotační ohřev ---
         // Pokud slotDurationMin > 0, zásobník po vypršení slotu uvolní místo
         // dalšímu v round-robin pořadí (i když ještě není plný).
-        if (_sys.slotDurationMin > 0 &&
+        // Dohřev k termínu slot nepřeruší – zbývá jen nezbytný čas.
+        if (_sys.slotDurationMin > 0 && !bi.gridTopup &&
             onTimeSec >= (uint32_t)_sys.slotDurationMin * 60UL) {
             _setRelay(idx, false);
             rt.lastOffAt    = now;
             rt.lastHeatedAt = now;   // aktualizuj pro round-robin
             rt.slotFull     = false; // slot vypršel, ne termostat
             _changeState(idx, BOILER_SLOT_DONE, now);
-            Serial.printf("[BC] Byt %u: slot %u min vypršel → SLOT_DONE\n",
+            LOGF("[BC] Byt %u: slot %u min vypršel → SLOT_DONE\n",
                 idx + 1, _sys.slotDurationMin);
             return;
         }
@@ -413,7 +872,7 @@ private:
         if (onTimeSec > (uint32_t)_sys.maxHeatTimeMin * 60UL) {
             _setRelay(idx, false);
             _changeState(idx, BOILER_ALARM, now);
-            Serial.printf("[BC] Byt %u: ALARM – zombie detektor (%u min)\n",
+            LOGF("[BC] Byt %u: ALARM – zombie detektor (%u min)\n",
                 idx + 1, _sys.maxHeatTimeMin);
             return;
         }
@@ -421,7 +880,11 @@ private:
         // --- Detekce plného zásobníku (termostat vypnul) ---
         // Počkej 30s od sepnutí než začneme detekovat
         if (onTimeMs > 30000UL) {
-            int32_t delta = phW - bi.phaseBaseline;
+            // Odběr zásobníku = pokles volného výkonu fáze proti
+            // základně. Základna je freeW (jiné HEATING zásobníky už
+            // přičtené), proto i teď freeW bez vlastního příkonu –
+            // surová fáze by v deltě nesla příkon ostatních.
+            int32_t delta = phaseDrawW(bi.phaseBaseline, freeW - (int32_t)_powerW[idx]);
 
             // Je delta malá (zásobník neodebírá) a kontext stabilní?
             if (delta < BOILER_FULL_THRESHOLD_W &&
@@ -435,9 +898,11 @@ private:
                     _setRelay(idx, false);
                     rt.lastHeatedAt = millis();  // pro round-robin
                     rt.slotFull     = true;      // plný přes termostat
+                    _targetMet(idx);
+                    _thermal[idx].onFull(now, _secOfDay(dt));
                     _scheduleRecheck(idx, now);
                     _changeState(idx, BOILER_STANDBY, now);
-                    Serial.printf("[BC] Byt %u: plný → STANDBY (delta=%ld W)\n",
+                    LOGF("[BC] Byt %u: plný → STANDBY (delta=%ld W)\n",
                         idx + 1, delta);
                     return;
                 }
@@ -447,18 +912,25 @@ private:
         }
 
         // --- Výkon klesl (odběr překročil povolený limit) ---
-        if (powerDropped(phW, cfg)) {
+        // Nestihl by cíl → zůstane sepnutý jako dohřev k termínu
+        if (!bi.gridTopup && powerDropped(phW, cfg) && _mustTopup(idx, dt)) {
+            bi.gridTopup = true;
+            LOGF("[BC] Byt %u: výkon klesl → dohřev k termínu %u h\n",
+                idx + 1, cfg.deadlineHour);
+            return;
+        }
+        if (!bi.gridTopup && powerDropped(phW, cfg)) {
             if (onTimeSec >= _sys.minOnTimeSec) {
                 // Byl sepnut dostatečně dlouho → normální vypnutí
                 _setRelay(idx, false);
                 rt.lastOffAt = now;
                 _changeState(idx, BOILER_COOLDOWN, now);
-                Serial.printf("[BC] Byt %u: výkon klesl → COOLDOWN (byl on %lus)\n",
+                LOGF("[BC] Byt %u: výkon klesl → COOLDOWN (byl on %lus)\n",
                     idx + 1, onTimeSec);
             } else {
                 // Příliš brzy – musíme počkat na minOnTime
                 _changeState(idx, BOILER_FORCED_OFF, now);
-                Serial.printf("[BC] Byt %u: výkon klesl, čekám na minOnTime "
+                LOGF("[BC] Byt %u: výkon klesl, čekám na minOnTime "
                               "(%lus/%us)\n",
                     idx + 1, onTimeSec, _sys.minOnTimeSec);
             }
@@ -470,13 +942,7 @@ private:
     // ---------------------------------------------------------
     void _stateStandby(uint8_t idx, BoilerConfig& cfg, BoilerRuntime& rt,
                        BoilerInternal& bi, int32_t phW, int32_t freeW,
-                       const SolarData& d, bool hdoLow, uint32_t now) {
-
-        // --- HDO dohřev – zásobník se mohl ochladit ---
-        if (hdoLow && _sys.hdoMode != HDO_NEVER && !_shouldBlockHDO()) {
-            // V HDO noci dohřej i STANDBY zásobníky pokud se ochladily
-            // (bude ověřeno recheckem)
-        }
+                       const SolarData& d, uint32_t now) {
 
         // --- Pravidelný recheck ---
         if (bi.recheckScheduledAt == 0) {
@@ -484,30 +950,52 @@ private:
             return;
         }
 
-        if (now < bi.recheckScheduledAt) return;  // ještě není čas
+        if (_mono < bi.recheckScheduledAt) return;  // ještě není čas
 
         if (!bi.recheckActive) {
             // Zahaj recheck – krátce sepni relé a změř baseline
-            bi.recheckBaseline = phW;
+            // (průměr s minulým tickem bez hran – chyba základny je
+            // společná všem vzorkům testu, víc ji nezmenší čekání)
+            uint8_t ph = _phaseIdx[idx];
+            bi.recheckBaseline = (_jitPrevOk && ph < 3) ? (phW + _jitPrev[ph]) / 2 : phW;
+            bi.recheckStartMs  = now;
+            float p = (float)cfg.powerW;
+            bi.recheckTest.begin(p * (2 * BOILER_RECHECK_ACCEPT_PCT - 100) / 100.0f, p,
+                                 _recheckSigma(ph));
             _setRelay(idx, true);
             bi.recheckActive = true;
-            Serial.printf("[BC] Byt %u: recheck zahájen\n", idx + 1);
+            LOGF("[BC] Byt %u: recheck zahájen\n", idx + 1);
             return;
         }
 
-        // Recheck probíhá – čekáme recheckDurationSec
-        uint32_t recheckElapsed = now - bi.recheckScheduledAt;
-        if (recheckElapsed < (uint32_t)_sys.recheckDurationSec * 1000UL) return;
+        // Recheck probíhá – po ustálení každý tick jeden vzorek poklesu
+        // fáze do SPRT (60 % / plný příkon, rozhodovací bod 80 % jako
+        // dřív pevný práh, σ z naměřeného šumu fáze). Zřetelný výsledek
+        // ukončí test po 2 vzorcích, zašuměný ho prodlouží nejvýš na
+        // recheckDurationSec.
+        uint32_t recheckElapsed = now - bi.recheckStartMs;
+        if (recheckElapsed < BOILER_ALLOC_SETTLE_MS) return;
+
+        int32_t delta    = phaseDrawW(bi.recheckBaseline, phW);
+        int8_t  decision = bi.recheckTest.add((float)delta);
+        if (decision == 0) {
+            if (recheckElapsed < (uint32_t)_sys.recheckDurationSec * 1000UL) return;
+            decision = bi.recheckTest.decide();
+        }
 
         // Vyhodnoť recheck
         _setRelay(idx, false);
         bi.recheckActive = false;
 
-        int32_t delta = phW - bi.recheckBaseline;
+        LOGF("[BC] Byt %u: recheck delta=%ld W po %lu s, %u vzorků "
+             "(σ %.0f W, LLR %.1f)\n",
+            idx + 1, delta, recheckElapsed / 1000UL, bi.recheckTest.n,
+            _recheckSigma(_phaseIdx[idx]), bi.recheckTest.llr);
 
-        Serial.printf("[BC] Byt %u: recheck delta=%ld W\n", idx + 1, delta);
+        bool accepted = decision > 0;
+        _thermal[idx].onRecheck(accepted, now);
 
-        if (delta >= (int32_t)(cfg.powerW * 80 / 100)) {
+        if (accepted) {
             // Zásobník se ochladil – termostat naskoč il
             if (hasSufficientPower(freeW, cfg, _sys)) {
                 // Je dostatek výkonu → rovnou dohřívat
@@ -519,21 +1007,22 @@ private:
                 _setRelay(idx, true);
                 rt.lastOffAt = 0;  // reset cooldown timeru
                 _changeState(idx, BOILER_HEATING, now);
-                Serial.printf("[BC] Byt %u: ochladil + výkon OK → HEATING\n",
+                LOGF("[BC] Byt %u: ochladil + výkon OK → HEATING\n",
                     idx + 1);
             } else {
                 // Výkon nestačí → IDLE, čeká na výkon
                 rt.lastOffAt = now;
                 _changeState(idx, BOILER_IDLE, now);
-                Serial.printf("[BC] Byt %u: ochladil, výkon nestačí → IDLE\n",
+                LOGF("[BC] Byt %u: ochladil, výkon nestačí → IDLE\n",
                     idx + 1);
             }
         } else {
             // Zásobník stále plný – naplánuj další recheck
-            _scheduleRecheck(idx, now);
-            Serial.printf("[BC] Byt %u: stále plný → STANDBY (další recheck "
-                          "za %u min)\n",
-                idx + 1, _sys.recheckIntervalMin);
+            _targetMet(idx);
+            uint32_t inMs = _scheduleRecheck(idx, now);
+            LOGF("[BC] Byt %u: stále plný → STANDBY (další recheck "
+                          "za %lu min%s)\n",
+                idx + 1, inMs / 60000UL, _thermal[idx].trained() ? ", model" : "");
         }
     }
 
@@ -549,7 +1038,7 @@ private:
             // Cooldown vypršel → zpět do IDLE, round-robin ho zařadí
             // do fronty podle lastHeatedAt (nastaveno při přechodu do SLOT_DONE)
             _changeState(idx, BOILER_IDLE, now);
-            Serial.printf("[BC] Byt %u: SLOT_DONE cooldown → IDLE\n", idx + 1);
+            LOGF("[BC] Byt %u: SLOT_DONE cooldown → IDLE\n", idx + 1);
         }
     }
 
@@ -571,40 +1060,370 @@ private:
             _setRelay(idx, false);
             rt.lastOffAt = now;
             _changeState(idx, BOILER_COOLDOWN, now);
-            Serial.printf("[BC] Byt %u: FORCED_OFF → COOLDOWN\n", idx + 1);
+            LOGF("[BC] Byt %u: FORCED_OFF → COOLDOWN\n", idx + 1);
         }
     }
 
     // ---------------------------------------------------------
-    //  Round-robin výběr – je toto zásobník s nejstarším lastHeatedAt
-    //  na dané fázi? (mezi zásobníky ve stavu IDLE)
+    //  Přidělení přetoku fáze – IDLE → PENDING (solární režim)
+    //
+    //  Rozpočet fáze = skutečný přetok (sepnuté zásobníky už
+    //  odebírají) mínus zásobníky sepnuté před < SETTLE_MS (měření
+    //  je ještě nemusí obsahovat) mínus už přidělené PENDING.
+    //  Když přetok klesne pod PENDING, nejmladší se vrátí do IDLE.
+    //
+    //  Kandidáti: IDLE, SOC, časové okno, minOffTime a samotným
+    //  by přetok stačil. Z nich _knapsack() vybere množinu, která
+    //  se vejde, dostane nejvíc nesplněných denních cílů (EDF)
+    //  a vyplní nejvíc přetoku. Soft-start zůstává
+    //  v PENDING – vybrané sepne postupně po switchDelaySec.
     // ---------------------------------------------------------
-    bool _isRoundRobinTurn(uint8_t idx) const {
-        uint8_t ph = _cfg[idx].phase;
+    void _allocateSurplus(const int32_t phaseW[3], const int32_t freeW[3],
+                          const SolarData& d, const DateTime& dt, uint32_t now) {
+        _surplusMask = 0;
+        const int32_t reserve = _sys.solarMinSurplusW;
+
+        for (uint8_t ph = 0; ph < 3; ph++) {
+            int32_t budget = phaseW[ph];
+            for (BoilerMask m = _phaseMask[ph] & _stateMask[BOILER_HEATING]; m; ) {
+                uint8_t i = _popBit(m);
+                if (now - _internal[i].heatingStartMs < BOILER_ALLOC_SETTLE_MS) budget -= _powerW[i];
+            }
 
-        for (uint8_t i = 0; i < _sys.numBoilers; i++) {
-            if (i == idx) continue;
-            if (_cfg[i].phase != ph) continue;
-            if (!_cfg[i].isReady()) continue;
-            if (_rt[i].state != BOILER_IDLE) continue;
+            // Přidělené PENDING – musí se vejít i po poklesu přetoku
+            BoilerMask pend     = _phaseMask[ph] & _stateMask[BOILER_PENDING] & _allocMask;
+            int32_t    pendW    = 0;
+            uint16_t   pendGrid = UINT16_MAX;      // nejmenší allowedGridW přidělených
+            while (pend) {
+                uint8_t youngest = 0xFF;
+                pendW    = 0;
+                pendGrid = UINT16_MAX;
+                for (BoilerMask m = pend; m; ) {
+                    uint8_t i = _popBit(m);
+                    pendW += _powerW[i];
+                    if (_cfg[i].allowedGridW < pendGrid) pendGrid = _cfg[i].allowedGridW;
+                    if (youngest == 0xFF || _heatKey(i) > _heatKey(youngest)) youngest = i;
+                }
+                if (pendW - (int32_t)pendGrid + reserve < budget) break;
+                pend &= ~BOILER_BIT(youngest);
+                _changeState(youngest, BOILER_IDLE, now);
+                LOGF("[BC] Byt %u: přetok klesl → PENDING zrušen\n", youngest + 1);
+                pendW    = 0;
+                pendGrid = UINT16_MAX;
+            }
+            int32_t availW = budget - pendW;
+
+            BoilerMask cand = 0;
+            if (d.soc >= _sys.minSocForBoilers) {
+                for (BoilerMask m = _phaseMask[ph] & _stateMask[BOILER_IDLE]; m; ) {
+                    uint8_t i = _popBit(m);
+                    if (!_cfg[i].isInTimeWindow(dt.hour)) continue;
+                    if (!hasSufficientPower(availW, _cfg[i], _sys)) continue;
+                    _surplusMask |= BOILER_BIT(i);
+                    if (now - _rt[i].lastOffAt < (uint32_t)_sys.minOffTimeSec * 1000UL) continue;
+                    cand |= BOILER_BIT(i);
+                }
+            }
+            if (!cand) continue;
+
+            BoilerMask pick  = _knapsack(cand, availW, pendGrid, dt);
+            uint32_t   pickW = 0;
+            for (BoilerMask m = pick; m; ) {
+                uint8_t         i  = _popBit(m);
+                BoilerInternal& bi = _internal[i];
+                bi.phaseBaseline = freeW[ph];
+                bi.pvBaseline    = d.powerPV;
+                bi.loadBaseline  = d.powerLoad;
+                bi.gridTopup     = false;
+                bi.hdoHeat       = false;
+                _changeState(i, BOILER_PENDING, now);
+                _allocMask |= BOILER_BIT(i);
+                pickW += _powerW[i];
+            }
+            if (pick) {
+                LOGF("[BC] L%u: přetok %ld W → přiděleno %lu W\n",
+                    ph + 1, availW, pickW);
+            }
+        }
+    }
 
-            // Pokud jiný IDLE zásobník na stejné fázi byl ohříván dávněji
-            // (= má menší timestamp) → není náš tah
-            if (_rt[i].lastHeatedAt < _rt[idx].lastHeatedAt) return false;
+    // ---------------------------------------------------------
+    //  0/1 knapsack nad kandidáty jedné fáze
+    //
+    //  Množina S se vejde, když (jako hasSufficientPower):
+    //    Σ powerW − min(allowedGridW) + solarMinSurplusW < availW
+    //  Minimum allowedGridW se prochází přes jeho možné hodnoty t
+    //  (zpravidla jediná): pro každé t jen zásobníky s ≥ t,
+    //  kapacita availW + t − rezerva. gridCap = minimum PENDING.
+    //
+    //  Hodnota zásobníku = kroky příkonu × FAIR_SCALE + pořadí
+    //  (nejvyšší n−1) → přednost má vyplnění přetoku, při shodě
+    //  pořadí. Pořadí: nesplněný denní cíl podle termínu (EDF),
+    //  pak nejdéle neohřívané. Nesplněný cíl navíc přidá
+    //  EDF_BONUS × (1 + pořadí mezi nesplněnými) – víc než celý
+    //  přetok, takže dřív dostanou přetok zásobníky s bližším
+    //  termínem. Příkon se zaokrouhlí nahoru na UNIT_W, kapacita dolů.
+    // ---------------------------------------------------------
+    BoilerMask _knapsack(BoilerMask cand, int32_t availW, uint16_t gridCap,
+                         const DateTime& dt) {
+        uint8_t  idx[BOILER_MAX_COUNT];
+        uint16_t units[BOILER_MAX_COUNT];
+        int64_t  value[BOILER_MAX_COUNT];
+        int32_t  left[BOILER_MAX_COUNT];    // s do termínu, INT32_MAX = cíl splněn
+        uint8_t  n = 0;
+        for (BoilerMask m = cand; m; ) {
+            uint8_t i = _popBit(m);
+            left[n]   = (_deficitWh(i) && _secsToDeadline(i, dt) > 0)
+                      ? _secsToDeadline(i, dt) : INT32_MAX;
+            idx[n++]  = i;
+        }
+
+        // Je a před b? (bližší termín, pak starší ohřev (_heatKey), pak index)
+        auto before = [&](uint8_t a, uint8_t b) -> bool {
+            if (left[a] != left[b]) return left[a] < left[b];
+            uint64_t ha = _heatKey(idx[a]), hb = _heatKey(idx[b]);
+            if (ha != hb) return ha < hb;
+            return idx[a] < idx[b];
+        };
+
+        for (uint8_t a = 0; a < n; a++) {
+            uint16_t rank = 0, edf = 0;
+            for (uint8_t b = 0; b < n; b++) {
+                if (b == a || !before(a, b)) continue;
+                rank++;
+                if (left[b] != INT32_MAX) edf++;
+            }
+            units[a] = (_powerW[idx[a]] + BOILER_ALLOC_UNIT_W - 1) / BOILER_ALLOC_UNIT_W;
+            value[a] = (int64_t)units[a] * BOILER_ALLOC_FAIR_SCALE + rank;
+            if (left[a] != INT32_MAX) value[a] += BOILER_ALLOC_EDF_BONUS * (1 + edf);
+        }
+
+        BoilerMask best      = 0;
+        int64_t    bestValue = 0;
+        for (uint8_t a = 0; a < n; a++) {
+            uint16_t t = _cfg[idx[a]].allowedGridW;
+            if (t > gridCap) t = gridCap;
+
+            // Stejné t už bylo → přeskoč
+            bool seen = false;
+            for (uint8_t b = 0; b < a && !seen; b++) {
+                uint16_t tb = _cfg[idx[b]].allowedGridW;
+                seen = (tb > gridCap ? gridCap : tb) == t;
+            }
+            if (seen) continue;
+
+            int32_t capW = availW + (int32_t)t - (int32_t)_sys.solarMinSurplusW - 1;
+            if (capW < BOILER_ALLOC_UNIT_W) continue;
+            uint16_t cap = capW / BOILER_ALLOC_UNIT_W > BOILER_ALLOC_MAX_UNITS
+                         ? BOILER_ALLOC_MAX_UNITS : (uint16_t)(capW / BOILER_ALLOC_UNIT_W);
+
+            for (uint16_t c = 0; c <= cap; c++) { _kValue[c] = 0; _kSet[c] = 0; }
+            for (uint8_t b = 0; b < n; b++) {
+                if (_cfg[idx[b]].allowedGridW < t || units[b] > cap) continue;
+                for (uint16_t c = cap; c >= units[b]; c--) {
+                    int64_t v = _kValue[c - units[b]] + value[b];
+                    if (v > _kValue[c]) {
+                        _kValue[c] = v;
+                        _kSet[c]   = _kSet[c - units[b]] | BOILER_BIT(idx[b]);
+                    }
+                }
+            }
+            if (_kValue[cap] > bestValue) {
+                bestValue = _kValue[cap];
+                best      = _kSet[cap];
+            }
+        }
+        return best;
+    }
+
+    // ---------------------------------------------------------
+    //  Denní cíl (dailyTargetWh do deadlineHour)
+    // ---------------------------------------------------------
+
+    // Chybí do denního cíle [Wh] (0 = splněn / bez cíle)
+    uint32_t _deficitWh(uint8_t idx) const {
+        uint32_t target = _cfg[idx].dailyTargetWh;
+        uint32_t done   = _energyWs[idx] / 3600UL;
+        return done < target ? target - done : 0;
+    }
+
+    // Zbývá do termínu [s] (≤ 0 = termín dnes prošel)
+    int32_t _secsToDeadline(uint8_t idx, const DateTime& dt) const {
+        int32_t nowSec = (int32_t)dt.hour * 3600 + dt.minute * 60 + dt.second;
+        return (int32_t)_cfg[idx].deadlineSecOfDay() - nowSec;
+    }
+
+    // Nejpozdější start dohřevu ze sítě: do termínu zbývá jen doba
+    // ohřevu chybějící energie příkonem + rezerva topupMarginMin.
+    // Pokryjí-li ji HDO okna před termínem, dohřeje se v HDO.
+    bool _mustTopup(uint8_t idx, const DateTime& dt) const {
+        if (!_sys.hdoTopupEnable || !_powerW[idx]) return false;
+        uint32_t deficit = _deficitWh(idx);
+        if (!deficit) return false;
+        int32_t left = _secsToDeadline(idx, dt);
+        if (left <= 0) return false;
+        uint32_t needSec = deficit * 3600UL / _powerW[idx]
+                         + (uint32_t)_sys.topupMarginMin * 60UL;
+        if (_hdoSecsAhead(dt, (uint32_t)left) >= needSec) return false;
+        return (uint32_t)left <= needSec;
+    }
+
+    // Čas v HDO oknech od teď do +spanSec [s] (po hodinách, jen
+    // dnešek – termín je do půlnoci). S pinem HDO jde o předpověď
+    // podle časových oken; když pin v okně nepřijde, podíl HDO
+    // klesá a dohřev ze sítě naskočí jako bez HDO.
+    uint32_t _hdoSecsAhead(const DateTime& dt, uint32_t spanSec) const {
+        if (!_hdoAllowed()) return 0;
+        uint32_t t   = _secOfDay(dt);
+        uint32_t end = t + spanSec;
+        uint32_t sum = 0;
+        while (t < end) {
+            uint32_t next = (t / 3600UL + 1) * 3600UL;
+            if (next > end) next = end;
+            if (_isInHDOWindow((uint8_t)(t / 3600UL % 24))) sum += next - t;
+            t = next;
+        }
+        return sum;
+    }
+
+    // Termostat vypnul → víc se dnes nevejde, cíl je splněn
+    void _targetMet(uint8_t idx) {
+        uint32_t targetWs = (uint32_t)_cfg[idx].dailyTargetWh * 3600UL;
+        if (_energyWs[idx] < targetWs) _energyWs[idx] = targetWs;
+    }
+
+    // ---------------------------------------------------------
+    //  Round-robin výběr – je toto zásobník s nejstarším ohřevem
+    //  (_heatKey) na dané fázi? (mezi zásobníky ve stavu IDLE)
+    //
+    //  Pokud jiný IDLE zásobník na stejné fázi byl ohříván dávněji
+    //  (= má menší timestamp) → není náš tah. Volá se jen pro IDLE
+    //  zásobník, takže stačí porovnat s minimem fáze – to se počítá
+    //  líně a platí, dokud nějaký zásobník fáze nevstoupí/neodejde
+    //  z IDLE (_changeState).
+    // ---------------------------------------------------------
+    bool _isRoundRobinTurn(uint8_t idx) {
+        uint8_t ph = _phaseIdx[idx];
+        if (ph >= 3) return true;
+
+        if (!(_rrValid & (1 << ph))) {
+            uint64_t best = UINT64_MAX;
+            for (BoilerMask m = _phaseMask[ph] & _stateMask[BOILER_IDLE]; m; ) {
+                uint8_t i = _popBit(m);
+                if (_heatKey(i) < best) best = _heatKey(i);
+            }
+            _rrMin[ph]  = best;
+            _rrValid   |= (1 << ph);
+        }
+        return _heatKey(idx) <= _rrMin[ph];
+    }
+
+    // Pořadí posledního ohřevu (menší = dávněji): ohřev před startem
+    // podle RTC sekund ze snapshotu, jakýkoli ohřev od startu (millis)
+    // je novější; 0 = nikdy
+    uint64_t _heatKey(uint8_t idx) const {
+        if (_rt[idx].lastHeatedAt) return (1ULL << 32) | _rt[idx].lastHeatedAt;
+        return _heatedSecs[idx];
+    }
+
+    // ---------------------------------------------------------
+    //  Termíny zásobníků (TimerHeap)
+    //
+    //  Stavy, které jen čekají na čas, se zaparkují: bit ve
+    //  _waitMask + termín v _timers. Tick je přeskočí, dokud
+    //  termín nevyprší; handler stavu pak rozhodne jako dřív
+    //  (nesplněno → _armTimer zaparkuje znovu).
+    //    STANDBY     recheckScheduledAt (probíhající recheck ne)
+    //    SLOT_DONE   stateEnteredAt + slotCooldownMin
+    //    COOLDOWN    lastOffAt      + minOffTimeSec
+    //    FORCED_OFF  heatingStartMs + minOnTimeSec
+    // ---------------------------------------------------------
+    static uint32_t _remainMs(uint32_t elapsedMs, uint32_t durMs) {
+        return elapsedMs >= durMs ? 0 : durMs - elapsedMs;
+    }
+
+    void _armTimer(uint8_t idx, uint32_t now) {
+        const BoilerRuntime&  rt = _rt[idx];
+        const BoilerInternal& bi = _internal[idx];
+        BoilerMask bit = BOILER_BIT(idx);
+        uint64_t   at  = 0;
+        _timerState[idx] = rt.state;
+
+        switch (rt.state) {
+            case BOILER_STANDBY:
+                if (!bi.recheckActive) at = bi.recheckScheduledAt;
+                break;
+            case BOILER_SLOT_DONE:
+                at = _mono + _remainMs(now - rt.stateEnteredAt,
+                                       (uint32_t)_sys.slotCooldownMin * 60000UL);
+                break;
+            case BOILER_COOLDOWN:
+                at = _mono + _remainMs(now - rt.lastOffAt,
+                                       (uint32_t)_sys.minOffTimeSec * 1000UL);
+                break;
+            case BOILER_FORCED_OFF:
+                at = _mono + _remainMs(now - bi.heatingStartMs,
+                                       (uint32_t)_sys.minOnTimeSec * 1000UL);
+                break;
+            default:
+                break;
+        }
+
+        if (at) {
+            _timers.schedule(idx, at);
+            _waitMask |= bit;
+        } else {
+            _timers.cancel(idx);
+            _waitMask &= ~bit;
         }
-        return true;
+    }
+
+    // Začátek ticku: stav změněný mimo tick (begin, resetBoiler,
+    // importRuntime) nebo nové časy z UI → přepočti termín;
+    // prošlé termíny odparkuj
+    void _syncTimers(uint32_t now) {
+        uint64_t key = (uint64_t)_sys.minOnTimeSec |
+                       (uint64_t)_sys.minOffTimeSec   << 16 |
+                       (uint64_t)_sys.slotCooldownMin << 32;
+        bool rearm = key != _timerKey;
+        _timerKey  = key;
+
+        for (BoilerMask m = _activeMask; m; ) {
+            uint8_t i = _popBit(m);
+            if (rearm || _rt[i].state != _timerState[i]) _armTimer(i, now);
+        }
+        for (BoilerMask m = _waitMask & ~_activeMask; m; ) {
+            uint8_t i = _popBit(m);                // numBoilers se zmenšil
+            _timers.cancel(i);
+            _timerState[i] = 0xFF;
+        }
+        _waitMask &= _activeMask;
+
+        uint8_t id;
+        while (_timers.popDue(_mono, id)) _waitMask &= ~BOILER_BIT(id);
     }
 
     // ---------------------------------------------------------
     //  Naplánuj recheck STANDBY zásobníku
-    //  Rozložení v čase: T + recheckInterval + (idx * 2 min)
+    //  Rozložení v čase: T + interval + hash(idx) mod 10 min
     //  Zabraňuje simultánnímu rechecku všech zásobníků
+    //  interval = recheckIntervalMin, naučený model ztrát ho
+    //  prodlouží až na odhad ochlazení (max. THERMAL_MAX_FACTOR×)
+    //  Vrací zpoždění [ms]
     // ---------------------------------------------------------
-    void _scheduleRecheck(uint8_t idx, uint32_t now) {
-        uint32_t offsetMs = (uint32_t)_sys.recheckIntervalMin * 60000UL
-                          + (uint32_t)idx * 120000UL;  // +2 min na zásobník
-        _internal[idx].recheckScheduledAt = now + offsetMs;
+    uint32_t _scheduleRecheck(uint8_t idx, uint32_t now) {
+        uint32_t baseMs = (uint32_t)_sys.recheckIntervalMin * 60000UL;
+        uint32_t inS    = _thermal[idx].acceptInS(now, baseMs / 1000UL * THERMAL_MAX_FACTOR);
+        if (inS * 1000UL > baseMs) baseMs = inS * 1000UL;
+        uint32_t offsetMs = baseMs
+                          + ((uint32_t)(idx + 1) * 2654435761UL) % BOILER_RECHECK_JITTER_MS;
+        _internal[idx].recheckScheduledAt = _mono + offsetMs;
         _internal[idx].recheckActive      = false;
+        return offsetMs;
+    }
+
+    static uint32_t _secOfDay(const DateTime& dt) {
+        return (uint32_t)dt.hour * 3600UL + dt.minute * 60UL + dt.second;
     }
 
     // ---------------------------------------------------------
@@ -621,6 +1440,11 @@ private:
         return false;
     }
 
+    // Smí se ohřívat v nízkém tarifu (režim + ADAPTIVE blokace)
+    bool _hdoAllowed() const {
+        return _sys.hdoMode != HDO_NEVER && !_shouldBlockHDO();
+    }
+
     // ---------------------------------------------------------
     //  Získej stav HDO signálu
     //  true = nízký tarif (HDO aktivní – zásobníky smí ohřívat)
@@ -656,8 +1480,13 @@ private:
     //  Ovládání relé + Serial log
     // ---------------------------------------------------------
     void _setRelay(uint8_t idx, bool on) {
+        BoilerMask bit = BOILER_BIT(idx);
+        if (((_relayMask & bit) != 0) != on) {
+            _relayMask ^= bit;
+            _edgeMask  |= bit;
+        }
         _mcp.setRelay(idx, on);
-        Serial.printf("[BC] Byt %u: relé %s\n", idx + 1, on ? "ON" : "OFF");
+        LOGF("[BC] Byt %u: relé %s\n", idx + 1, on ? "ON" : "OFF");
     }
 
     // ---------------------------------------------------------
@@ -668,12 +1497,27 @@ private:
         _rt[idx].state          = newState;
         _rt[idx].stateEnteredAt = now;
 
-        Serial.printf("[BC] Byt %u: %s → %s\n",
+        // Masky stavu; vstup/odchod z IDLE mění minimum round-robinu
+        BoilerMask bit = BOILER_BIT(idx);
+        if (old < BOILER_STATE_COUNT) _stateMask[old] &= ~bit;
+        if (old == BOILER_PENDING) _allocMask &= ~bit;
+        if (newState != BOILER_PENDING && newState != BOILER_HEATING &&
+            newState != BOILER_FORCED_OFF) {
+            _internal[idx].gridTopup = false;
+            _internal[idx].hdoHeat   = false;
+        }
+        if (bit & _activeMask) _stateMask[newState] |= bit;
+        if (old == BOILER_IDLE || newState == BOILER_IDLE) {
+            if (_phaseIdx[idx] < 3) _rrValid &= ~(1 << _phaseIdx[idx]);
+        }
+
+        LOGF("[BC] Byt %u: %s → %s\n",
             idx + 1,
             boilerStateName(old),
             boilerStateName(newState));
 
-        // TODO: uložit _rt[idx] do FRAM pro přežití restartu
+        // Uložení do FRAM (Blok 7) zajistí WarmStart::loop() na Core 0
+        _rtDirty = true;
     }
 
     // ---------------------------------------------------------
@@ -681,20 +1525,185 @@ private:
     //  Akumuluje v RAM, flush do FRAM každý nový den
     // ---------------------------------------------------------
     void _updateStats(const SolarData& d, uint32_t now) {
-        // TODO: implementovat po přepracování FRAM mapy
+        // Energie denních cílů – příkon × doba sepnutí od minulého ticku
+        // (výpadek ticku > 4 periody se nepočítá – relé stav neznámý)
+        uint32_t dtMs = _lastTickMs ? now - _lastTickMs : 0;
+        _lastTickMs   = now;
+        if (dtMs > 4UL * BOILER_TICK_MS) dtMs = 0;
+        bool crossed = false;
+        for (BoilerMask m = _stateMask[BOILER_HEATING] | _stateMask[BOILER_FORCED_OFF]; m; ) {
+            uint8_t  i   = _popBit(m);
+            uint32_t ws  = (uint32_t)_powerW[i] * dtMs / 1000UL;
+            uint32_t old = _energyWs[i] / 360000UL;
+            _energyWs[i] += ws;
+            _thermal[i].addEnergy(ws);
+            if (_energyWs[i] / 360000UL != old) crossed = true;
+        }
+        // Nová stovka Wh → snapshot (Blok 7), nejvýš 1× za 5 min
+        if (crossed && now - _energySaveMs >= BOILER_ENERGY_SAVE_MS) {
+            _energySaveMs = now;
+            _rtDirty      = true;
+        }
+
+        // TODO: denní statistiky do FRAM po přepracování FRAM mapy
         // Pro každý HEATING zásobník:
         //   Pokud phaseL[ph] > 0 → energySolarWh += powerW * tickSec / 3600
         //   Pokud phaseL[ph] < 0 → energyGridWh  += powerW * tickSec / 3600
         (void)d;
-        (void)now;
+    }
+
+    // ---------------------------------------------------------
+    //  Odhad příkonu a fáze z hran relé
+    //  Základna = měření ticku s hranou (relé se zapíše až na
+    //  konci ticku), vyhodnocení po BOILER_ALLOC_SETTLE_MS.
+    //  Měří se jen osamocená hrana – další hrana kdekoli před
+    //  vyhodnocením měření zahodí. Filtr kontextu jako v
+    //  _stateHeating: PV stabilní, Load beze změny nebo změněný
+    //  o stejný výkon (podle toho, zda elektroměr vidí zásobníky).
+    // ---------------------------------------------------------
+    void _trackEdges(const SolarData& d, uint32_t now) {
+        const int32_t ph[3] = { d.phaseL1, d.phaseL2, d.phaseL3 };
+
+        // 1) Vyhodnoť ustálenou hranu (tato data jsou ještě bez
+        //    hran tohoto ticku)
+        if (_probeIdx != 0xFF && now - _probeAtMs >= BOILER_ALLOC_SETTLE_MS) {
+            uint8_t idx = _probeIdx;
+            _probeIdx   = 0xFF;
+            int32_t sgn = _probeOn ? 1 : -1;   // sepnutí = pokles přetoku
+            int32_t drop[3];
+            uint8_t k = 0;
+            for (uint8_t j = 0; j < 3; j++) {
+                drop[j] = sgn * phaseDrawW(_probePh[j], ph[j]);
+                if (drop[j] > drop[k]) k = j;
+            }
+            int32_t w     = drop[k];
+            int32_t dLoad = sgn * (d.powerLoad - _probeLoad);
+            bool    other = false;
+            for (uint8_t j = 0; j < 3; j++)
+                if (j != k && abs(drop[j]) >= BOILER_CONTEXT_TOLERANCE_W) other = true;
+
+            if (w >= BOILER_RECHECK_MIN_DELTA && !other &&        // termostat sepnutý
+                abs(d.powerPV - _probePV) < BOILER_CONTEXT_TOLERANCE_W &&
+                (abs(dLoad) < BOILER_CONTEXT_TOLERANCE_W ||
+                 abs(dLoad - w) < BOILER_CONTEXT_TOLERANCE_W)) {
+                _addPowerSample(idx, k, w);
+            }
+        }
+
+        // 2) Nové hrany tohoto ticku
+        if (!_edgeMask) return;
+        if (_probeIdx != 0xFF) {
+            _probeIdx = 0xFF;                  // překrytí – neměřitelné
+        } else if (!(_edgeMask & (_edgeMask - 1))) {
+            BoilerMask m = _edgeMask;
+            _probeIdx  = _popBit(m);
+            _probeOn   = (_relayMask & _edgeMask) != 0;
+            _probeAtMs = now;
+            for (uint8_t j = 0; j < 3; j++) _probePh[j] = ph[j];
+            _probePV   = d.powerPV;
+            _probeLoad = d.powerLoad;
+        }
+        _edgeMask = 0;
+    }
+
+    // ---------------------------------------------------------
+    //  Šum fází – rozptyl vzorku z rozdílů po sobě jdoucích ticků
+    //  (Var(x₁ − x₀) = 2σ²), jen když relé ani v jednom z ticků
+    //  ani během ustálení před nimi nepřepnulo. Pomalý trend FVE
+    //  odhad mírně zvětší – test je pak opatrnější, ne odvážnější.
+    // ---------------------------------------------------------
+    void _trackJitter(const SolarData& d, uint32_t now) {
+        const int32_t ph[3] = { d.phaseL1, d.phaseL2, d.phaseL3 };
+        if (_edgeMask) _lastEdgeMs = now;
+        bool quiet = now - _lastEdgeMs > BOILER_ALLOC_SETTLE_MS;
+
+        if (quiet && _jitPrevOk) {
+            for (uint8_t j = 0; j < 3; j++) {
+                float dx = (float)(ph[j] - _jitPrev[j]);
+                if (dx >  BOILER_JITTER_CLIP_W) dx =  BOILER_JITTER_CLIP_W;
+                if (dx < -BOILER_JITTER_CLIP_W) dx = -BOILER_JITTER_CLIP_W;
+                _jitVar[j] += (0.5f * dx * dx - _jitVar[j]) / BOILER_JITTER_AVG_N;
+            }
+        }
+        for (uint8_t j = 0; j < 3; j++) _jitPrev[j] = ph[j];
+        _jitPrevOk = quiet;
+    }
+
+    // σ poklesu fáze v rechecku: základna i vzorek mají šum fáze
+    // → √2 · σ fáze (min. BOILER_JITTER_MIN_W)
+    float _recheckSigma(uint8_t ph) const {
+        float v = ph < 3 ? _jitVar[ph] : (float)BOILER_RECHECK_SIGMA_W * BOILER_RECHECK_SIGMA_W;
+        float s = sqrtf(2.0f * v);
+        return s > BOILER_JITTER_MIN_W ? s : (float)BOILER_JITTER_MIN_W;
+    }
+
+    // Vzorek příkonu → průběžný odhad, kontrola změny, oprava powerW
+    void _addPowerSample(uint8_t idx, uint8_t ph, int32_t w) {
+        BoilerPowerEst&     e   = _est[idx];
+        const BoilerConfig& cfg = _cfg[idx];
+        e.w.add((float)w);
+        if (e.votes[ph] == 255) {
+            for (uint8_t j = 0; j < 3; j++) e.votes[j] /= 2;
+        }
+        e.votes[ph]++;
+        if (e.w.n < BOILER_EST_MIN_SAMPLES) return;
+
+        // Fáze: většina hran jinde než v konfiguraci
+        uint8_t estPh   = e.phase();
+        bool    phDrift = estPh && estPh != cfg.phase &&
+                          e.votes[estPh - 1] >= BOILER_EST_MIN_SAMPLES &&
+                          (cfg.phase < 1 || cfg.phase > 3 ||
+                           e.votes[cfg.phase - 1] < e.votes[estPh - 1] / 2);
+
+        // Příkon: odchylka nad práh i nad 3× nejistotu průměru
+        float diff  = fabsf(e.w.mean() - cfg.powerW);
+        bool  pwDrift = diff > cfg.powerW * BOILER_EST_DRIFT_PCT / 100.0f &&
+                        diff > 3.0f * e.w.stderrMean();
+
+        if (phDrift != e.phaseDrift || pwDrift != e.powerDrift) {
+            LOGF("[BC] Byt %u: odhad L%u %.0f W ±%.0f (n=%u) vs. L%u %u W%s%s\n",
+                idx + 1, estPh, e.w.mean(), e.w.stddev(), e.w.n,
+                cfg.phase, cfg.powerW,
+                pwDrift ? " – ZMĚNA PŘÍKONU" : "",
+                phDrift ? " – JINÁ FÁZE" : "");
+        }
+        e.phaseDrift = phDrift;
+        e.powerDrift = pwDrift;
+
+        // Automatická oprava příkonu (fázi mění jen Discovery –
+        // jiná fáze znamená přepojení, vzorky nemusí patřit zásobníku)
+        if (pwDrift && !phDrift && _sys.autoPowerUpdate) {
+            uint16_t newW = (uint16_t)((e.w.mean() + 25.0f) / 50.0f) * 50;  // jako Discovery
+            LOGF("[BC] Byt %u: powerW %u → %u W (z provozu)\n",
+                idx + 1, cfg.powerW, newW);
+            _newPowerW[idx] = newW;         // zapíše Core 0 (applyPowerUpdates)
+            e.powerDrift    = false;
+            e.w.reset();
+            _cfgDirty       = true;
+        }
+        _exportPowerEst();
+    }
+
+    void _exportPowerEst() {
+        uint16_t estW[BOILER_MAX_COUNT]  = {};
+        uint8_t  estPh[BOILER_MAX_COUNT] = {};
+        bool     drift[BOILER_MAX_COUNT] = {};
+        for (uint8_t i = 0; i < _sys.numBoilers && i < BOILER_MAX_COUNT; i++) {
+            const BoilerPowerEst& e = _est[i];
+            if (e.w.n < BOILER_EST_MIN_SAMPLES) continue;
+            estW[i]  = (uint16_t)(e.w.mean() + 0.5f);
+            estPh[i] = e.phase();
+            drift[i] = e.powerDrift || e.phaseDrift;
+        }
+        SolarModel::updatePowerEst(estW, estPh, drift);
     }
 
     // ---------------------------------------------------------
     //  Exportuj stav relé do SolarModel (pro UI)
     // ---------------------------------------------------------
     void _exportRelayState() {
-        bool relayOn[10]      = {};
-        bool relayHeating[10] = {};
+        bool relayOn[BOILER_MAX_COUNT]      = {};
+        bool relayHeating[BOILER_MAX_COUNT] = {};
 
         for (uint8_t i = 0; i < _sys.numBoilers; i++) {
             relayOn[i]      = (_rt[i].state == BOILER_HEATING ||
@@ -704,6 +1713,7 @@ private:
             relayHeating[i] = (_rt[i].state == BOILER_HEATING);
         }
 
-        SolarModel::updateRelays(relayOn, relayHeating);
+        SolarModel::updateRelays(relayOn, relayHeating,
+                                 _mcp.relayFault(), _mcp.verifyErrors());
     }
 };
@@ -7,9 +7,13 @@
 //    Povolený odběr  – allowedGridW [W]
 //    Čas od          – timeStart [h] (0+0 = bez omezení)
 //    Čas do          – timeEnd [h]
+//    Denní cíl       – dailyTargetWh [kWh] (0 = bez cíle)
+//    Termín          – deadlineHour [h] (0 = půlnoc)
+//    Relé            – lokální MCP23017 / Modbus deska (slave, cívka)
 //
 //  Readonly (výsledek Discovery):
 //    Discovery: fáze L1/L2/L3, příkon [W]
+//    vpravo odhad z hran relé (SolarData.powerEstW), změna = warn
 //
 //  Navigace – normální:
 //    UP/DOWN        – pohyb kurzoru
@@ -28,6 +32,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
@@ -38,6 +43,7 @@
 #include "PCF85063A.h"
 #include "BoilerConfig.h"
 #include "Config.h"
+#include "ModbusRelays.h"
 
 extern Config       gConfig;
 extern BoilerConfig gBoilerCfg[BOILER_MAX_COUNT];
@@ -53,6 +59,9 @@ namespace BoilerDetailScreen {
         ITEM_ALLOWED_GRID,
         ITEM_TIME_START,
         ITEM_TIME_END,
+        ITEM_TARGET,
+        ITEM_DEADLINE,
+        ITEM_RELAY,
         ITEM_COUNT,
     };
 
@@ -65,7 +74,7 @@ namespace BoilerDetailScreen {
     static char    _labelBuf[16] = {};
     static uint8_t _labelPos     = 0;     // aktivní pozice 0–15
 
-    #define DETAIL_ROW_H    24
+    #define DETAIL_ROW_H    16
     #define DETAIL_START_Y  (CONTENT_Y + 30)
 
     // Délka labelu (bez null terminátor)
@@ -240,9 +249,9 @@ namespace BoilerDetailScreen {
                     else
                         break;
                 }
-                Serial.printf("[BD] Label Byt %u: '%s'\n",
+                LOGF("[BD] Label Byt %u: '%s'\n",
                     _boilerIdx + 1, gBoilerCfg[_boilerIdx].label);
-                ConfigManager::saveBlockBoilerCfg();
+                ConfigManager::saveAsync(BLOCK_BOILCFG_ADDR);
                 _editingLabel = false;
                 _editing      = false;
                 return SCREEN_NONE;  // signál pro draw() aby překreslil seznam
@@ -252,6 +261,17 @@ namespace BoilerDetailScreen {
         }
     }
 
+    // ----------------------------------------------------------
+    //  Relé jako jedna hodnota: 0 = MCP23017, pak slave 1 cívky
+    //  0–15, slave 2 cívky 0–15 … (UP/DN s akcelerací)
+    // ----------------------------------------------------------
+    static void _stepRelay(BoilerConfig& cfg, int dir) {
+        int k = cfg.relaySlave ? (cfg.relaySlave - 1) * MBR_BOARD_COILS + cfg.relayCoil + 1 : 0;
+        k = constrain(k + dir * gSwitch.step(), 0, MBR_MAX_SLAVE * MBR_BOARD_COILS);
+        cfg.relaySlave = k ? (k - 1) / MBR_BOARD_COILS + 1 : 0;
+        cfg.relayCoil  = k ? (k - 1) % MBR_BOARD_COILS     : 0;
+    }
+
     // ----------------------------------------------------------
     //  Krok hodnoty UP/DOWN pro ostatní položky
     // ----------------------------------------------------------
@@ -261,11 +281,17 @@ namespace BoilerDetailScreen {
             case ITEM_ENABLE:
                 cfg.enabled = !cfg.enabled; break;
             case ITEM_ALLOWED_GRID:
-                cfg.allowedGridW = (uint16_t)constrain((int)cfg.allowedGridW + 100, 0, 3000); break;
+                cfg.allowedGridW = (uint16_t)constrain((int)cfg.allowedGridW + 100 * gSwitch.step(), 0, 3000); break;
             case ITEM_TIME_START:
                 cfg.timeStart = (cfg.timeStart + 1) % 24; break;
             case ITEM_TIME_END:
                 cfg.timeEnd = (cfg.timeEnd + 1) % 24; break;
+            case ITEM_TARGET:
+                cfg.dailyTargetWh = (uint16_t)constrain((int)cfg.dailyTargetWh + 500 * gSwitch.step(), 0, 20000); break;
+            case ITEM_DEADLINE:
+                cfg.deadlineHour = (cfg.deadlineHour + 1) % 24; break;
+            case ITEM_RELAY:
+                _stepRelay(cfg, +1); break;
             default: break;
         }
     }
@@ -276,11 +302,17 @@ namespace BoilerDetailScreen {
             case ITEM_ENABLE:
                 cfg.enabled = !cfg.enabled; break;
             case ITEM_ALLOWED_GRID:
-                cfg.allowedGridW = (uint16_t)constrain((int)cfg.allowedGridW - 100, 0, 3000); break;
+                cfg.allowedGridW = (uint16_t)constrain((int)cfg.allowedGridW - 100 * gSwitch.step(), 0, 3000); break;
             case ITEM_TIME_START:
                 cfg.timeStart = (cfg.timeStart + 23) % 24; break;
             case ITEM_TIME_END:
                 cfg.timeEnd = (cfg.timeEnd + 23) % 24; break;
+            case ITEM_TARGET:
+                cfg.dailyTargetWh = (uint16_t)constrain((int)cfg.dailyTargetWh - 500 * gSwitch.step(), 0, 20000); break;
+            case ITEM_DEADLINE:
+                cfg.deadlineHour = (cfg.deadlineHour + 23) % 24; break;
+            case ITEM_RELAY:
+                _stepRelay(cfg, -1); break;
             default: break;
         }
     }
@@ -338,9 +370,10 @@ namespace BoilerDetailScreen {
 
         tft.setFont(&fonts::Font2);
 
-        const char* labels[] = { "Label", "Aktivni", "Povol. odber", "Cas od", "Cas do" };
+        const char* labels[] = { "Label", "Aktivni", "Povol. odber", "Cas od", "Cas do",
+                                 "Denni cil", "Termin", "Rele" };
         tft.setTextColor(active ? t->accent : t->text);
-        tft.setCursor(20, y + 5);
+        tft.setCursor(20, y);
         tft.print(labels[idx]);
 
         // Hodnota vpravo
@@ -352,10 +385,10 @@ namespace BoilerDetailScreen {
                 tft.setTextDatum(middle_right);
                 tft.drawString(
                     cfg.label[0] ? cfg.label : "---",
-                    active ? 295 : 308, y + 12);
+                    active ? 295 : 308, y + 8);
                 if (active) {
                     tft.setTextColor(t->dim);
-                    tft.drawString(">>>", 308, y + 12);
+                    tft.drawString(">>>", 308, y + 8);
                 }
                 tft.setTextDatum(top_left);
                 return;
@@ -381,18 +414,34 @@ namespace BoilerDetailScreen {
                 else
                     snprintf(val, sizeof(val), "%u h", cfg.timeEnd);
                 break;
+            case ITEM_TARGET:
+                if (cfg.dailyTargetWh == 0)
+                    snprintf(val, sizeof(val), "0 (bez cile)");
+                else
+                    snprintf(val, sizeof(val), "%u.%u kWh",
+                        cfg.dailyTargetWh / 1000, cfg.dailyTargetWh % 1000 / 100);
+                break;
+            case ITEM_DEADLINE:
+                snprintf(val, sizeof(val), "do %u h", cfg.deadlineHour ? cfg.deadlineHour : 24);
+                break;
+            case ITEM_RELAY:
+                if (cfg.relaySlave == 0)
+                    snprintf(val, sizeof(val), "MCP R%u", _boilerIdx + 1);
+                else
+                    snprintf(val, sizeof(val), "Modbus %u / c%u", cfg.relaySlave, cfg.relayCoil);
+                break;
             default: break;
         }
 
         tft.setTextColor(editing ? t->accent : t->text);
         tft.setTextDatum(middle_right);
-        tft.drawString(val, 308, y + 12);
+        tft.drawString(val, 308, y + 8);
         tft.setTextDatum(top_left);
     }
 
     static void _drawDiscoveryInfo(const Theme* t) {
         BoilerConfig& cfg = gBoilerCfg[_boilerIdx];
-        int16_t y = DETAIL_START_Y + ITEM_COUNT * DETAIL_ROW_H + 8;
+        int16_t y = DETAIL_START_Y + ITEM_COUNT * DETAIL_ROW_H + 4;
 
         tft.drawFastHLine(8, y, 304, t->dim);
         y += 4;
@@ -404,13 +453,24 @@ namespace BoilerDetailScreen {
             tft.setTextColor(t->ok);
             tft.setCursor(16, y);
             tft.print(buf);
+
+            // Odhad z provozu – jen když je dost vzorků
+            SolarData d;
+            SolarModel::get(d);
+            if (d.powerEstW[_boilerIdx]) {
+                snprintf(buf, sizeof(buf), "odhad L%u %u W",
+                    d.powerEstPhase[_boilerIdx], d.powerEstW[_boilerIdx]);
+                tft.setTextColor(d.powerDrift[_boilerIdx] ? t->warn : t->dim);
+                tft.setTextDatum(top_right);
+                tft.drawString(buf, 304, y);
+                tft.setTextDatum(top_left);
+            }
         } else {
             tft.setTextColor(t->warn);
             tft.setCursor(16, y);
             tft.print("Discovery: nespusteno");
             tft.setTextColor(t->dim);
-            tft.setCursor(16, y + 14);
-            tft.print("UdP > Rizeni > Spustit");
+            tft.print("  (Rizeni > Spustit)");
         }
     }
 
@@ -491,8 +551,8 @@ namespace BoilerDetailScreen {
                 case SW_CENTER:
                 case SW_LEFT:
                     _editing = false;
-                    ConfigManager::saveBlockBoilerCfg();
-                    Serial.printf("[BD] Byt %u uloženo\n", _boilerIdx + 1);
+                    ConfigManager::saveAsync(BLOCK_BOILCFG_ADDR);
+                    LOGF("[BD] Byt %u uloženo\n", _boilerIdx + 1);
                     _drawRow(t, _cursor);
                     return SCREEN_NONE;
                 default:
@@ -544,7 +604,7 @@ namespace BoilerDetailScreen {
                     _editing = false;
                     _drawContent(t);
                 } else {
-                    ConfigManager::saveBlockBoilerCfg();
+                    ConfigManager::saveAsync(BLOCK_BOILCFG_ADDR);
                     return SCREEN_CONTROL;
                 }
                 return SCREEN_NONE;
@@ -0,0 +1,185 @@
+// =============================================================
+//  BoilerThermal.h – odhad tepelného stavu zásobníku (recheck)
+//
+//  Plný zásobník (STANDBY) se dřív testoval každých
+//  recheckIntervalMin sepnutím relé. Většina pulzů jen potvrdí
+//  "stále plný". Model odhadne, kdy zásobník ztratí dost energie,
+//  aby termostat sepnul, a recheck naplánuje až tehdy.
+//
+//  Model (na zásobník, jen RAM – po restartu se učí znovu):
+//    lossW[b]  průměrná ztráta + odběr vody [W] v úseku dne b
+//              (6 × 4 h – ranní/večerní odběr se liší od noci)
+//    acceptWh  deficit energie, při kterém termostat sepne [Wh]
+//
+//  Učení:
+//    plný → plný   energetická bilance: co se mezi dvěma plnými
+//                  stavy dodalo (cycleWs), to se ztratilo →
+//                  ztráta = cycleWs / doba cyklu (vážená do úseků)
+//    recheck plný  odhadnutý deficit < práh → acceptWh nahoru
+//    recheck bere  odhadnutý deficit ≥ práh → acceptWh mírně dolů
+//                  (příště zkusit dřív), menší deficit → přímo
+//
+//  Predikce: od okamžiku plného stavu integruje lossW po úsecích
+//  dne, dokud deficit nedosáhne acceptWh. BoilerController interval
+//  omezí na recheckIntervalMin … THERMAL_MAX_FACTOR × interval –
+//  nikdy nezkouší častěji než dřív a změna zvyklostí se projeví
+//  nejpozději po THERMAL_MAX_FACTOR intervalech.
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+#define THERMAL_BUCKETS        6          // úseků dne
+#define THERMAL_BUCKET_S       (86400UL / THERMAL_BUCKETS)
+#define THERMAL_MIN_CYCLES     2          // naučených cyklů před použitím
+#define THERMAL_MIN_CYCLE_S    1800UL     // kratší cyklus plný → plný ignoruj
+#define THERMAL_MAX_FACTOR     8          // max. násobek recheckIntervalMin
+
+struct BoilerThermal {
+    uint16_t lossW[THERMAL_BUCKETS];      // 0 = úsek zatím neznámý
+    uint16_t acceptWh;                    // 0 = neznámý
+    uint8_t  cycles;                      // naučené cykly (saturuje 255)
+
+    // Běžící cyklus od posledního plného stavu
+    bool     fullKnown;
+    uint32_t fullAtMs;                    // millis() plného stavu
+    uint32_t fullSecOfDay;                // lokální sekunda dne plného stavu
+    uint32_t cycleWs;                     // dodaná energie od plného stavu
+    uint32_t acceptAfterS;                // recheck přijal po … s (0 = ne)
+
+    BoilerThermal() { memset(this, 0, sizeof(*this)); }
+
+    bool trained() const { return cycles >= THERMAL_MIN_CYCLES && acceptWh; }
+
+    // Dodaná energie (volá _updateStats za HEATING/FORCED_OFF)
+    void addEnergy(uint32_t ws) { if (fullKnown) cycleWs += ws; }
+
+    // Zapomeň běžící cyklus (reset zásobníku, ruční zásah)
+    void breakCycle() { fullKnown = false; }
+
+    // ---------------------------------------------------------
+    //  Zásobník je plný (termostat vypnul)
+    // ---------------------------------------------------------
+    void onFull(uint32_t nowMs, uint32_t secOfDay) {
+        if (fullKnown) {
+            uint32_t T = (nowMs - fullAtMs) / 1000UL;
+            if (T >= THERMAL_MIN_CYCLE_S) {
+                _learnLoss(fullSecOfDay, T, cycleWs / T);
+                if (cycles < 255) cycles++;
+                // První práh z rechecku, který přijal ještě bez ztrát
+                if (acceptAfterS && !acceptWh)
+                    acceptWh = _clampWh(predictWh(fullSecOfDay, acceptAfterS));
+            }
+        }
+        fullKnown    = true;
+        fullAtMs     = nowMs;
+        fullSecOfDay = secOfDay % 86400UL;
+        cycleWs      = 0;
+        acceptAfterS = 0;
+    }
+
+    // ---------------------------------------------------------
+    //  Výsledek rechecku – accepted = termostat sepnul
+    // ---------------------------------------------------------
+    void onRecheck(bool accepted, uint32_t nowMs) {
+        if (!fullKnown) return;
+        uint32_t T = (nowMs - fullAtMs) / 1000UL;
+        uint32_t d = predictWh(fullSecOfDay, T);
+        if (accepted) {
+            acceptAfterS = T;
+            if (!d) return;
+            if (!acceptWh || d < acceptWh) acceptWh = _clampWh(d);
+            else                           acceptWh -= acceptWh / 20;
+        } else if (d) {
+            uint32_t up = d + d / 8;
+            if (up > acceptWh) acceptWh = _clampWh(up);
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Odhad deficitu [Wh] za durS sekund od fromSec (sekunda dne)
+    //  0 = ztráty zatím neznámé
+    // ---------------------------------------------------------
+    uint32_t predictWh(uint32_t fromSec, uint32_t durS) const {
+        uint16_t fallback = _meanLossW();
+        if (!fallback) return 0;
+        uint32_t wh = 0;
+        uint32_t s  = fromSec % 86400UL;
+        while (durS) {
+            uint8_t  b   = s / THERMAL_BUCKET_S;
+            uint32_t seg = THERMAL_BUCKET_S - s % THERMAL_BUCKET_S;
+            if (seg > durS) seg = durS;
+            wh   += (uint32_t)(lossW[b] ? lossW[b] : fallback) * seg / 3600UL;
+            durS -= seg;
+            s     = (s + seg) % 86400UL;
+        }
+        return wh;
+    }
+
+    // ---------------------------------------------------------
+    //  Za kolik sekund od teď termostat pravděpodobně sepne
+    //  0 = model nenaučený (použij pevný interval)
+    //  Hledá nejvýš maxS dopředu; prošlý odhad → 1
+    // ---------------------------------------------------------
+    uint32_t acceptInS(uint32_t nowMs, uint32_t maxS) const {
+        if (!fullKnown || !trained()) return 0;
+        uint16_t fallback = _meanLossW();
+        if (!fallback) return 0;
+
+        uint32_t elapsed = (nowMs - fullAtMs) / 1000UL;
+        uint32_t limit   = elapsed + maxS;
+        uint32_t wh      = 0;      // deficit × 3600 [Ws] kvůli přesnosti
+        uint32_t target  = (uint32_t)acceptWh * 3600UL;
+        uint32_t t       = 0;
+        uint32_t s       = fullSecOfDay;
+        while (t < limit) {
+            uint8_t  b    = s / THERMAL_BUCKET_S;
+            uint32_t seg  = THERMAL_BUCKET_S - s % THERMAL_BUCKET_S;
+            uint32_t w    = lossW[b] ? lossW[b] : fallback;
+            uint32_t need = (target - wh + w - 1) / w;
+            if (need <= seg) { t += need; break; }
+            wh += w * seg;
+            t  += seg;
+            s   = (s + seg) % 86400UL;
+        }
+        if (t > limit) t = limit;
+        return t > elapsed ? t - elapsed : 1;
+    }
+
+private:
+    uint16_t _meanLossW() const {
+        uint32_t sum = 0;
+        uint8_t  n   = 0;
+        for (uint8_t b = 0; b < THERMAL_BUCKETS; b++) {
+            if (lossW[b]) { sum += lossW[b]; n++; }
+        }
+        return n ? (uint16_t)(sum / n) : 0;
+    }
+
+    static uint16_t _clampWh(uint32_t wh) {
+        return wh > 0xFFFF ? 0xFFFF : (wh ? (uint16_t)wh : 1);
+    }
+
+    // Vzorek ztráty r [W] za cyklus → úseky podle podílu doby v nich
+    // (první cykly se učí rychleji – váha 1/2, pak 1/4)
+    void _learnLoss(uint32_t fromSec, uint32_t durS, uint32_t r) {
+        if (r > 0xFFFF) r = 0xFFFF;
+        if (!r) r = 1;
+        uint32_t s   = fromSec % 86400UL;
+        uint32_t T   = durS;
+        uint8_t  div = cycles < 4 ? 2 : 4;
+        while (durS) {
+            uint8_t  b   = s / THERMAL_BUCKET_S;
+            uint32_t seg = THERMAL_BUCKET_S - s % THERMAL_BUCKET_S;
+            if (seg > durS) seg = durS;
+            if (!lossW[b]) {
+                lossW[b] = (uint16_t)r;
+            } else {
+                int32_t delta = ((int32_t)r - lossW[b]) * (int32_t)seg / (int32_t)T / div;
+                lossW[b] = (uint16_t)(lossW[b] + delta);
+                if (!lossW[b]) lossW[b] = 1;
+            }
+            durS -= seg;
+            s     = (s + seg) % 86400UL;
+        }
+    }
+};
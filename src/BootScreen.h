@@ -7,7 +7,6 @@
 //  Použití:
 //    BootScreen::begin(theme, version);
 //    BootScreen::print(theme, BOOT_OK, "I2C OK");
-//    bool ok = BootScreen::wifiSta(theme, ssid, timeout_ms);
 // =============================================================
 #pragma once
 #include <Arduino.h>
@@ -106,18 +105,6 @@ namespace BootScreen {
         }
     }
 
-    static void _updateLastLine(const Theme* t,
-                                uint16_t color, const char* icon,
-                                const char* msg) {
-        uint8_t idx = (_count > 0 && _count <= BOOT_MAX_LINES) ?
-                      _count - 1 : BOOT_MAX_LINES - 1;
-        _lines[idx].color = color;
-        strncpy(_lines[idx].icon, icon, sizeof(_lines[idx].icon) - 1);
-        strncpy(_lines[idx].msg,  msg,  sizeof(_lines[idx].msg)  - 1);
-        int y = (BOOT_HEADER_H + 2) + idx * BOOT_LINE_H;
-        _drawLine(t, y, color, icon, msg);
-    }
-
     // ==========================================================
     //  Veřejné rozhraní
     // ==========================================================
@@ -144,33 +131,4 @@ namespace BootScreen {
         Serial.printf("%s %s\n", icon, msg);
     }
 
-    bool wifiSta(const Theme* t, const char* ssid, uint32_t timeoutMs) {
-        char buf[52];
-        snprintf(buf, sizeof(buf), "WiFi STA %s...", ssid);
-        _addLine(t, t->dim, "[ .. ]", buf);
-
-        uint32_t start = millis();
-        while (WiFi.status() != WL_CONNECTED) {
-            if (millis() - start > timeoutMs) break;
-            uint32_t remaining = (timeoutMs - (millis() - start)) / 1000;
-            snprintf(buf, sizeof(buf),
-                     "WiFi STA %s... %2lus", ssid, remaining);
-            _updateLastLine(t, t->dim, "[ .. ]", buf);
-            delay(500);
-        }
-
-        if (WiFi.status() == WL_CONNECTED) {
-            snprintf(buf, sizeof(buf), "WiFi STA %s",
-                     WiFi.localIP().toString().c_str());
-            _updateLastLine(t, t->ok, "[ OK ]", buf);
-            Serial.printf("[ OK ] WiFi STA %s\n",
-                          WiFi.localIP().toString().c_str());
-            return true;
-        } else {
-            _updateLastLine(t, t->warn, "[WARN]", "WiFi STA nedostupne");
-            Serial.println("[WARN] WiFi STA nedostupne");
-            return false;
-        }
-    }
-
 } // namespace BootScreen
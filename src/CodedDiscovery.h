@@ -0,0 +1,186 @@
+// =============================================================
+//  CodedDiscovery.h – paralelní discovery kódovaným spínáním
+//
+//  Místo jednoho zásobníku za druhým (~45 s na byt) spíná
+//  skupiny zásobníků podle řádků Hadamardovy matice a fázi +
+//  příkon všech zásobníků najednou řeší nejmenšími čtverci.
+//
+//  Návrh (Sylvester, M = nejbližší mocnina 2 > N):
+//    s(r, j) = (-1)^popcount(r & (j+1))   ±1 → relé ON/OFF
+//    sloupec j+1 (ne 0 = samé +1) → sloupce navzájem ortogonální
+//    liché sloupce se znaménkem −1 → řádek 0 nesepne všechny
+//  Pořadí kroků: řádky 0…M−1, pak M−1…0 (zrcadlově)
+//    → lineární drift PV/odběru se v odhadech přesně vyruší
+//       a trend je ortogonální ke všem sloupcům (odhad zvlášť)
+//
+//  Model na každé fázi:  y_k = c + γ·(t_k − t̄) + Σ_j s_kj·β_j + e
+//    příkon p_j = −2·β_j   (přetok klesá o příkon sepnutého,
+//                            znaménko jako phaseDrawW v SolarData.h)
+//    ortogonalita → β_j = Σ_k s_kj·y_k / K   (K = 2M kroků)
+//    rozptyl: σ² = RSS / (K − N − 2),  Var(p_j) = 4σ²/K
+//  Interval spolehlivosti ±t(95 %, K − N − 2)·sqrt(Var).
+//
+//  Zátěž: řádek sepne až ~70 % skupiny (10 zásobníků: 7 × 2 kW
+//  = 14 kW, fáze před discovery neznámé → klidně na jedné).
+//  DiscoveryScreen proto dělí zásobníky na skupiny po
+//  groupSize(maxOn) – každá skupina má vlastní návrh a v žádném
+//  kroku nesepne víc než maxOn zásobníků (maxOnFor).
+//
+//  Akumulace průběžně (bez ukládání vzorků) – RAM ~ N×3 double.
+//
+//  Nejednoznačný zásobník (malý příkon, široký interval,
+//  druhá fáze v dosahu intervalu) zopakuje DiscoveryScreen
+//  postaru po jednom.
+//
+//  Použití:
+//    CodedDiscovery::begin(n);             // n = velikost skupiny
+//    for k in 0 … steps()-1:
+//      relé j = on(k, j) → ustálení → addSample(k, L1, L2, L3)
+//    CodedDiscovery::solve(j, fit)
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <math.h>
+#include "HW_Config.h"
+#include "RunningStats.h"
+
+// Min. příkon zásobníku [W] – pod tím termostat rozepnutý / chyba
+#define CDISC_MIN_POWER_W     500
+// Max. šířka intervalu vůči příkonu [%] – jinak nejednoznačné
+#define CDISC_MAX_CI_PCT      15
+
+namespace CodedDiscovery {
+
+    struct Fit {
+        uint8_t phase;          // 1–3, 0 = nejednoznačné
+        float   powerW;         // odhad příkonu na nejlepší fázi
+        float   ciW;            // ± interval spolehlivosti [W]
+        float   secondW;        // odhad na druhé nejlepší fázi
+    };
+
+    static uint8_t  _n      = 0;             // počet zásobníků
+    static uint16_t _m      = 0;             // řád Hadamardovy matice
+    static uint16_t _k      = 0;             // přijaté kroky
+    // double – Σy² přetoku ~10⁴ W přes stovky kroků by ve float
+    // pohltil rozptyl šumu (RSS je rozdíl velkých součtů)
+    static double   _sy[3]  = {};            // Σ y
+    static double   _syy[3] = {};            // Σ y²
+    static double   _sty[3] = {};            // Σ (t − t̄)·y
+    static double   _ssy[BOILER_MAX_COUNT][3] = {};   // Σ s·y
+
+    // Kroků celkem (obě poloviny zrcadlového pořadí)
+    uint16_t steps() { return 2 * _m; }
+
+    // Řád návrhu pro n zásobníků
+    static uint16_t _order(uint8_t n) {
+        uint16_t m = 1;
+        while (m <= n) m <<= 1;              // M > N (sloupec 0 se nepoužije)
+        return m < 4 ? 4 : m;                // aspoň 2 stupně volnosti
+    }
+
+    // Znaménko řádku r, sloupce j: +1 sepnuto, −1 vypnuto
+    static int8_t _signRow(uint16_t r, uint8_t j) {
+        int8_t s = (__builtin_popcount(r & (uint16_t)(j + 1)) & 1) ? -1 : 1;
+        return (j & 1) ? -s : s;
+    }
+
+    // Nejvíc sepnutých v jednom kroku návrhu pro n zásobníků
+    uint8_t maxOnFor(uint8_t n) {
+        uint16_t m    = _order(n);
+        uint8_t  most = 0;
+        for (uint16_t r = 0; r < m; r++) {
+            uint8_t c = 0;
+            for (uint8_t j = 0; j < n; j++) if (_signRow(r, j) > 0) c++;
+            if (c > most) most = c;
+        }
+        return most;
+    }
+
+    // Největší skupina, jejíž návrh nesepne víc než maxOn najednou
+    // (maxOnFor s n neklesá)
+    uint8_t groupSize(uint8_t maxOn) {
+        uint8_t n = 1;
+        while (n < BOILER_MAX_COUNT && maxOnFor(n + 1) <= maxOn) n++;
+        return n;
+    }
+
+    void begin(uint8_t n) {
+        _n = n < BOILER_MAX_COUNT ? n : BOILER_MAX_COUNT;
+        _m = _order(_n);
+        _k = 0;
+        memset(_sy,  0, sizeof(_sy));
+        memset(_syy, 0, sizeof(_syy));
+        memset(_sty, 0, sizeof(_sty));
+        memset(_ssy, 0, sizeof(_ssy));
+    }
+
+    // Znaménko s(k, j) = +1 sepnuto, −1 vypnuto
+    static int8_t _sign(uint16_t step, uint8_t j) {
+        return _signRow(step < _m ? step : 2 * _m - 1 - step, j);
+    }
+
+    // Má být zásobník j v kroku sepnutý?
+    bool on(uint16_t step, uint8_t j) { return _sign(step, j) > 0; }
+
+    // Počet sepnutých v kroku (pro UI / kontrolu zátěže)
+    uint8_t onCount(uint16_t step) {
+        uint8_t c = 0;
+        for (uint8_t j = 0; j < _n; j++) if (on(step, j)) c++;
+        return c;
+    }
+
+    // Ustálené měření fází v kroku 'step' (kroky postupně 0, 1, …)
+    void addSample(uint16_t step, const float ph[3]) {
+        double tc = (double)step - (double)(2 * _m - 1) / 2.0;   // t − t̄
+        for (uint8_t f = 0; f < 3; f++) {
+            double y = ph[f];
+            _sy[f]  += y;
+            _syy[f] += y * y;
+            _sty[f] += tc * y;
+            for (uint8_t j = 0; j < _n; j++) _ssy[j][f] += _sign(step, j) * y;
+        }
+        _k++;
+    }
+
+    bool complete() { return _m && _k >= steps(); }
+
+    // ---------------------------------------------------------
+    //  Vyřeš zásobník j – vrací false pokud je nejednoznačný
+    // ---------------------------------------------------------
+    bool solve(uint8_t j, Fit& out) {
+        out = Fit{0, 0.0f, 0.0f, 0.0f};
+        if (!complete() || j >= _n) return false;
+
+        double K = (double)_k;
+        // Σ(t − t̄)² pro t = 0 … K−1
+        double stt = K * (K * K - 1.0) / 12.0;
+
+        // σ² každé fáze z reziduí (ortogonální rozklad součtu čtverců)
+        float p[3], ci[3];
+        int   dof = (int)_k - (int)_n - 2;
+        for (uint8_t f = 0; f < 3; f++) {
+            double rss = _syy[f] - _sy[f] * _sy[f] / K - _sty[f] * _sty[f] / stt;
+            for (uint8_t i = 0; i < _n; i++) rss -= _ssy[i][f] * _ssy[i][f] / K;
+            if (rss < 0.0) rss = 0.0;
+            double var = dof > 0 ? rss / dof : 0.0;
+            p[f]  = (float)(-2.0 * _ssy[j][f] / K);
+            ci[f] = (float)(tCrit95(dof > 0 ? dof : 0) * sqrt(4.0 * var / K));
+        }
+
+        uint8_t best = 0;
+        for (uint8_t f = 1; f < 3; f++) if (p[f] > p[best]) best = f;
+        float second = -1e9f;
+        for (uint8_t f = 0; f < 3; f++) if (f != best && p[f] > second) second = p[f];
+
+        out.powerW  = p[best];
+        out.ciW     = ci[best];
+        out.secondW = second;
+
+        bool ok = p[best] >= CDISC_MIN_POWER_W &&
+                  ci[best] <= p[best] * CDISC_MAX_CI_PCT / 100.0f &&
+                  p[best] - ci[best] > second + ci[best];
+        if (ok) out.phase = best + 1;
+        return ok;
+    }
+
+} // namespace CodedDiscovery
@@ -8,7 +8,8 @@
 //    loadDefaults()    – hardcoded výchozí hodnoty
 //    loadFromFram()    – načtení z FRAM (per-blok s verzováním)
 //    saveToFram()      – uložení celé konfigurace
-//    saveBlock_xxx()   – uložení jednotlivých bloků
+//    saveBlock_xxx()   – uložení jednotlivých bloků (blokující)
+//    saveAsync(addr)   – uložení bloku přes FramWriter (z UI)
 //
 //  POZOR: Config.h includovat POUZE v main.cpp!
 //  Obsahuje přímou definici instance Config gConfig.
@@ -16,9 +17,11 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "HW_Config.h"
 #include "BoilerConfig.h"
 #include "FramMap.h"
+#include "FramWriter.h"
 
 // Extern reference na FRAM driver (definován v main.cpp)
 extern FM24CL64 gFRAM;
@@ -108,6 +111,7 @@ struct Config {
 Config        gConfig;
 BoilerConfig  gBoilerCfg[BOILER_MAX_COUNT];
 BoilerSystem  gBoilerSys;
+volatile uint32_t gBoilerCfgGen = 0;   // ++ při uložení bloku 5/6 (BoilerController přepočte masky)
 
 // =============================================================
 //  ConfigManager – FRAM persistence
@@ -116,13 +120,13 @@ namespace ConfigManager {
 
     // Forward deklarace (kvůli vzájemným závislostem)
     void saveToFram();
-    void saveBlockSystem();
-    void saveBlockWifi();
-    void saveBlockModbus();
-    void saveBlockPlant();
-    void saveBlockMqtt();
-    void saveBlockBoilerSys();
-    void saveBlockBoilerCfg();
+    bool saveBlockSystem();
+    bool saveBlockWifi();
+    bool saveBlockModbus();
+    bool saveBlockPlant();
+    bool saveBlockMqtt();
+    bool saveBlockBoilerSys();
+    bool saveBlockBoilerCfg();
     void saveNumBoilers();
 
     // ─────────────────────────────────────────────────────────
@@ -277,7 +281,7 @@ namespace ConfigManager {
         }
 
         gBoilerSys.numBoilers = gConfig.numBoilers;
-        Serial.println("[Config] Načteny výchozí hodnoty");
+        LOGLN("[Config] Načteny výchozí hodnoty");
     }
 
     void loadFromFram() {
@@ -286,12 +290,12 @@ namespace ConfigManager {
 
         // Globální magic
         if (!FramBlock::isValid(gFRAM)) {
-            Serial.println("[Config] FRAM prázdná – první spuštění");
+            LOGLN("[Config] FRAM prázdná – první spuštění");
             saveToFram();
             return;
         }
 
-        Serial.println("[Config] Načítám z FRAM...");
+        LOGLN("[Config] Načítám z FRAM...");
 
         // Blok 0: Systém
         { FramSystem f;
@@ -329,84 +333,114 @@ namespace ConfigManager {
         }
 
         // Blok 5: Boiler System
+        // v3 → v4: okno hdoTopupStart/End přibylo na konec struktury
         { BoilerSystem f;
-          if (FramBlock::readBlock(gFRAM, BLOCK_BOILSYS_ADDR,
-                                   BLOCK_BOILSYS_VER, &f, sizeof(f)))
+          uint8_t ver = FramBlock::version(gFRAM, BLOCK_BOILSYS_ADDR);
+          if (ver == 3) {
+              gFRAM.readBlock(BLOCK_BOILSYS_ADDR + sizeof(FramBlockHeader), &f,
+                              offsetof(BoilerSystem, hdoTopupStart));
               gBoilerSys = f;
+              saveBlockBoilerSys();
+              LOGLN("[Config] Blok 5: migrace v3 → v4 (okno dohřevu 17–19 h)");
+          } else if (FramBlock::readBlock(gFRAM, BLOCK_BOILSYS_ADDR,
+                                          BLOCK_BOILSYS_VER, &f, sizeof(f))) {
+              gBoilerSys = f;
+          }
         }
 
         // Blok 6: Boiler Config ×10
-        FramBlock::readBlock(gFRAM, BLOCK_BOILCFG_ADDR,
-                             BLOCK_BOILCFG_VER,
-                             gBoilerCfg, sizeof(BoilerConfig) * BOILER_MAX_COUNT);
+        // v1 → v2: dailyTargetWh/deadlineHour vznikly z nulové rezervy –
+        // zásobník bez cíle dostane výchozí termín místo půlnoci
+        if (FramBlock::version(gFRAM, BLOCK_BOILCFG_ADDR) == 1) {
+            gFRAM.readBlock(BLOCK_BOILCFG_ADDR + sizeof(FramBlockHeader),
+                            gBoilerCfg, sizeof(BoilerConfig) * BOILER_MAX_COUNT);
+            for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
+                if (!gBoilerCfg[i].dailyTargetWh)
+                    gBoilerCfg[i].deadlineHour = BoilerConfig().deadlineHour;
+            }
+            saveBlockBoilerCfg();
+            LOGLN("[Config] Blok 6: migrace v1 → v2 (termín cíle)");
+        } else {
+            FramBlock::readBlock(gFRAM, BLOCK_BOILCFG_ADDR,
+                                 BLOCK_BOILCFG_VER,
+                                 gBoilerCfg, sizeof(BoilerConfig) * BOILER_MAX_COUNT);
+        }
 
         // Synchronizuj
         gBoilerSys.numBoilers = gConfig.numBoilers;
 
-        Serial.println("[Config] FRAM načtena OK");
+        LOGLN("[Config] FRAM načtena OK");
     }
 
     void saveToFram() {
-        Serial.println("[Config] Ukládám do FRAM...");
-        saveBlockSystem();
-        saveBlockWifi();
-        saveBlockModbus();
-        saveBlockPlant();
-        saveBlockMqtt();
-        saveBlockBoilerSys();
-        saveBlockBoilerCfg();
+        LOGLN("[Config] Ukládám do FRAM...");
+        bool ok = saveBlockSystem();
+        ok &= saveBlockWifi();
+        ok &= saveBlockModbus();
+        ok &= saveBlockPlant();
+        ok &= saveBlockMqtt();
+        ok &= saveBlockBoilerSys();
+        ok &= saveBlockBoilerCfg();
+        if (!ok) {
+            // Globální magic jen po úplném zápisu – jinak by se
+            // při startu načetly rozepsané bloky jako platné
+            LOGLN("[Config] FRAM: CHYBA zápisu, magic nezapsán");
+            return;
+        }
         FramBlock::writeGlobalMagic(gFRAM);
-        Serial.println("[Config] FRAM uložena OK");
+        LOGLN("[Config] FRAM uložena OK");
     }
 
     // ─────────────────────────────────────────────────────────
     //  Uložení jednotlivých bloků (volej z příslušného screenu)
     // ─────────────────────────────────────────────────────────
 
-    void saveBlockSystem() {
+    bool saveBlockSystem() {
         FramSystem f;
         _packSystem(f);
-        FramBlock::writeBlock(gFRAM, BLOCK_SYSTEM_ADDR,
+        return FramBlock::writeBlock(gFRAM, BLOCK_SYSTEM_ADDR,
                               BLOCK_SYSTEM_VER, &f, sizeof(f));
     }
 
-    void saveBlockWifi() {
+    bool saveBlockWifi() {
         FramWifi f;
         _packWifi(f);
-        FramBlock::writeBlock(gFRAM, BLOCK_WIFI_ADDR,
+        return FramBlock::writeBlock(gFRAM, BLOCK_WIFI_ADDR,
                               BLOCK_WIFI_VER, &f, sizeof(f));
     }
 
-    void saveBlockModbus() {
+    bool saveBlockModbus() {
         FramModbus f;
         _packModbus(f);
-        FramBlock::writeBlock(gFRAM, BLOCK_MODBUS_ADDR,
+        return FramBlock::writeBlock(gFRAM, BLOCK_MODBUS_ADDR,
                               BLOCK_MODBUS_VER, &f, sizeof(f));
     }
 
-    void saveBlockPlant() {
+    bool saveBlockPlant() {
         FramPlant f;
         _packPlant(f);
-        FramBlock::writeBlock(gFRAM, BLOCK_PLANT_ADDR,
+        return FramBlock::writeBlock(gFRAM, BLOCK_PLANT_ADDR,
                               BLOCK_PLANT_VER, &f, sizeof(f));
     }
 
-    void saveBlockMqtt() {
+    bool saveBlockMqtt() {
         FramMqtt f;
         _packMqtt(f);
-        FramBlock::writeBlock(gFRAM, BLOCK_MQTT_ADDR,
+        return FramBlock::writeBlock(gFRAM, BLOCK_MQTT_ADDR,
                               BLOCK_MQTT_VER, &f, sizeof(f));
     }
 
-    void saveBlockBoilerSys() {
+    bool saveBlockBoilerSys() {
         gBoilerSys.numBoilers = gConfig.numBoilers;
-        FramBlock::writeBlock(gFRAM, BLOCK_BOILSYS_ADDR,
+        gBoilerCfgGen++;
+        return FramBlock::writeBlock(gFRAM, BLOCK_BOILSYS_ADDR,
                               BLOCK_BOILSYS_VER,
                               &gBoilerSys, sizeof(gBoilerSys));
     }
 
-    void saveBlockBoilerCfg() {
-        FramBlock::writeBlock(gFRAM, BLOCK_BOILCFG_ADDR,
+    bool saveBlockBoilerCfg() {
+        gBoilerCfgGen++;
+        return FramBlock::writeBlock(gFRAM, BLOCK_BOILCFG_ADDR,
                               BLOCK_BOILCFG_VER,
                               gBoilerCfg,
                               sizeof(BoilerConfig) * BOILER_MAX_COUNT);
@@ -416,71 +450,143 @@ namespace ConfigManager {
         gBoilerSys.numBoilers = gConfig.numBoilers;
         saveBlockSystem();
         saveBlockBoilerSys();
-        Serial.printf("[Config] numBoilers = %u (FRAM)\n", gConfig.numBoilers);
+        LOGF("[Config] numBoilers = %u (FRAM)\n", gConfig.numBoilers);
+    }
+
+    // ─────────────────────────────────────────────────────────
+    //  Neblokující uložení bloku – volej z handleInput() screenů
+    //  Zabalí aktuální gConfig do FRAM struktury a předá ji
+    //  FramWriteru; zápis proběhne v uiLoop() po částech.
+    //  blockAddr = BLOCK_xxx_ADDR (konfigurační bloky 0–6)
+    //  Pokud je fronta plná, uloží se synchronně (fallback).
+    // ─────────────────────────────────────────────────────────
+    void saveAsync(uint16_t blockAddr, FramWriteCb cb = nullptr) {
+        bool queued = false;
+        bool ok     = true;
+        switch (blockAddr) {
+            case BLOCK_SYSTEM_ADDR: {
+                FramSystem f; _packSystem(f);
+                queued = FramWriter::submit(blockAddr, BLOCK_SYSTEM_VER, &f, sizeof(f), cb);
+                if (!queued) ok = saveBlockSystem();
+                break;
+            }
+            case BLOCK_WIFI_ADDR: {
+                FramWifi f; _packWifi(f);
+                queued = FramWriter::submit(blockAddr, BLOCK_WIFI_VER, &f, sizeof(f), cb);
+                if (!queued) ok = saveBlockWifi();
+                break;
+            }
+            case BLOCK_MODBUS_ADDR: {
+                FramModbus f; _packModbus(f);
+                queued = FramWriter::submit(blockAddr, BLOCK_MODBUS_VER, &f, sizeof(f), cb);
+                if (!queued) ok = saveBlockModbus();
+                break;
+            }
+            case BLOCK_PLANT_ADDR: {
+                FramPlant f; _packPlant(f);
+                queued = FramWriter::submit(blockAddr, BLOCK_PLANT_VER, &f, sizeof(f), cb);
+                if (!queued) ok = saveBlockPlant();
+                break;
+            }
+            case BLOCK_MQTT_ADDR: {
+                FramMqtt f; _packMqtt(f);
+                queued = FramWriter::submit(blockAddr, BLOCK_MQTT_VER, &f, sizeof(f), cb);
+                if (!queued) ok = saveBlockMqtt();
+                break;
+            }
+            case BLOCK_BOILSYS_ADDR:
+                gBoilerSys.numBoilers = gConfig.numBoilers;
+                gBoilerCfgGen++;
+                queued = FramWriter::submit(blockAddr, BLOCK_BOILSYS_VER,
+                                            &gBoilerSys, sizeof(gBoilerSys), cb);
+                if (!queued) ok = saveBlockBoilerSys();
+                break;
+            case BLOCK_BOILCFG_ADDR:
+                gBoilerCfgGen++;
+                queued = FramWriter::submit(blockAddr, BLOCK_BOILCFG_VER,
+                                            gBoilerCfg,
+                                            sizeof(BoilerConfig) * BOILER_MAX_COUNT, cb);
+                if (!queued) ok = saveBlockBoilerCfg();
+                break;
+            default:
+                LOGF("[Config] saveAsync: neznámý blok 0x%04X\n", blockAddr);
+                return;
+        }
+        // Synchronní fallback – ohlas skutečný výsledek zápisu
+        // stejně jako FramWriter
+        if (!queued && cb) cb(blockAddr, ok);
+    }
+
+    // numBoilers je v Bloku 0 i 5 – ulož oba
+    void saveNumBoilersAsync() {
+        gBoilerSys.numBoilers = gConfig.numBoilers;
+        saveAsync(BLOCK_SYSTEM_ADDR);
+        saveAsync(BLOCK_BOILSYS_ADDR);
+        LOGF("[Config] numBoilers = %u (FRAM async)\n", gConfig.numBoilers);
     }
 
     // Debug výpis
     void print() {
-        Serial.println("[Config] --- Aktuální konfigurace ---");
-        Serial.printf("  Theme:        %u\n",   gConfig.themeIndex);
-        Serial.printf("  PIN:          %u%u%u%u\n",
+        LOGLN("[Config] --- Aktuální konfigurace ---");
+        LOGF("  Theme:        %u\n",   gConfig.themeIndex);
+        LOGF("  PIN:          %u%u%u%u\n",
             gConfig.pin[0], gConfig.pin[1], gConfig.pin[2], gConfig.pin[3]);
-        Serial.printf("  Display:      timeout=%umin  bright=%u%%\n",
+        LOGF("  Display:      timeout=%umin  bright=%u%%\n",
             gConfig.displayTimeout, gConfig.displayBright);
-        Serial.printf("  WiFi STA:     %s\n",   gConfig.wifiStaEn ? "ON" : "OFF");
+        LOGF("  WiFi STA:     %s\n",   gConfig.wifiStaEn ? "ON" : "OFF");
         if (gConfig.wifiStaEn) {
-            Serial.printf("  STA SSID:     %s\n",   gConfig.wifiStaSsid);
-            Serial.printf("  STA DHCP:     %s\n",   gConfig.wifiStaDhcp ? "ano" : "ne");
+            LOGF("  STA SSID:     %s\n",   gConfig.wifiStaSsid);
+            LOGF("  STA DHCP:     %s\n",   gConfig.wifiStaDhcp ? "ano" : "ne");
         }
-        Serial.printf("  WiFi AP:      %s\n",   gConfig.wifiApEn ? "ON" : "OFF");
-        Serial.printf("  NTP:          %s\n",   gConfig.ntpEn ? "ON" : "OFF");
-        Serial.printf("  RTC offset:   %d\n",   gConfig.rtcCalOffset);
-        Serial.printf("  Merenic:      %s / %s\n",
+        LOGF("  WiFi AP:      %s\n",   gConfig.wifiApEn ? "ON" : "OFF");
+        LOGF("  NTP:          %s\n",   gConfig.ntpEn ? "ON" : "OFF");
+        LOGF("  RTC offset:   %d\n",   gConfig.rtcCalOffset);
+        LOGF("  Merenic:      %s / %s\n",
             gConfig.invProfileIndex == 0 ? "Solinteg" : "Sermatec",
             gConfig.invTransport == TRANSPORT_TCP ? "TCP" : "RTU");
         if (gConfig.invTransport == TRANSPORT_TCP) {
-            Serial.printf("  Merenic IP:   %u.%u.%u.%u:%u\n",
+            LOGF("  Merenic IP:   %u.%u.%u.%u:%u\n",
                 gConfig.invIp[0], gConfig.invIp[1],
                 gConfig.invIp[2], gConfig.invIp[3],
                 gConfig.invTcpPort);
         } else {
-            Serial.printf("  Merenic RTU:  SlaveID=%u  Baud=%lu  %u%c%u\n",
+            LOGF("  Merenic RTU:  SlaveID=%u  Baud=%lu  %u%c%u\n",
                 gConfig.invSlaveId, (unsigned long)gConfig.invBaudRate,
                 gConfig.invDataBits,
                 gConfig.invParity == 0 ? 'N' : (gConfig.invParity == 1 ? 'E' : 'O'),
                 gConfig.invStopBits);
         }
-        Serial.printf("  Poll:         %u ms\n", gConfig.invPollMs);
-        Serial.printf("  FVE:          %.1f kWp, %u fází\n",
+        LOGF("  Poll:         %u ms\n", gConfig.invPollMs);
+        LOGF("  FVE:          %.1f kWp, %u fází\n",
             gConfig.pvPowerKwp10 / 10.0f, gConfig.pvPhaseCount);
-        Serial.printf("  Baterie:      %.1f kWh\n",
+        LOGF("  Baterie:      %.1f kWh\n",
             gConfig.batteryKwh10 / 10.0f);
-        Serial.printf("  Max export:   %u W%s\n",
+        LOGF("  Max export:   %u W%s\n",
             gConfig.maxExportW,
             gConfig.maxExportW == 0 ? " (bez limitu)" : "");
-        Serial.printf("  Min SOC:      %u %%\n", gConfig.minSocGlobal);
-        Serial.printf("  Nocni nabij:  %s\n",
+        LOGF("  Min SOC:      %u %%\n", gConfig.minSocGlobal);
+        LOGF("  Nocni nabij:  %s\n",
             gConfig.nightCharge ? "ON" : "OFF");
-        Serial.printf("  MQTT:         %s\n",
+        LOGF("  MQTT:         %s\n",
             gConfig.mqttEn ? "ON" : "OFF");
         if (gConfig.mqttEn) {
-            Serial.printf("  MQTT broker:  %u.%u.%u.%u:%u\n",
+            LOGF("  MQTT broker:  %u.%u.%u.%u:%u\n",
                 gConfig.mqttBrokerIp[0], gConfig.mqttBrokerIp[1],
                 gConfig.mqttBrokerIp[2], gConfig.mqttBrokerIp[3],
                 gConfig.mqttPort);
-            Serial.printf("  MQTT topic:   %s  interval=%us\n",
+            LOGF("  MQTT topic:   %s  interval=%us\n",
                 gConfig.mqttTopic, gConfig.mqttIntervalSec);
         }
-        Serial.printf("  Zásobníky:    %u aktivních\n", gConfig.numBoilers);
-        Serial.printf("  HDO režim:    %s\n",
+        LOGF("  Zásobníky:    %u aktivních\n", gConfig.numBoilers);
+        LOGF("  HDO režim:    %s\n",
             hdoModeName(gBoilerSys.hdoMode));
-        Serial.printf("  Sezóna:       %s\n",
+        LOGF("  Sezóna:       %s\n",
             gBoilerSys.seasonWinter ? "ZIMA" : "LÉTO");
-        Serial.println("[Config] ----------------------------");
+        LOGLN("[Config] ----------------------------");
 
-        Serial.println("[Config] --- Zásobníky ---");
+        LOGLN("[Config] --- Zásobníky ---");
         for (uint8_t i = 0; i < gConfig.numBoilers; i++) {
-            Serial.printf("  Byt %2u: %-12s  L%u  %4uW  "
+            LOGF("  Byt %2u: %-12s  L%u  %4uW  "
                           "ready=%s  allowedGrid=%uW\n",
                 i + 1,
                 gBoilerCfg[i].label,
@@ -489,7 +595,7 @@ namespace ConfigManager {
                 gBoilerCfg[i].isReady() ? "ANO" : "NE",
                 gBoilerCfg[i].allowedGridW);
         }
-        Serial.println("[Config] -----------------");
+        LOGLN("[Config] -----------------");
     }
 
 } // namespace ConfigManager
\ No newline at end of file
@@ -13,20 +13,19 @@
 //  Sekce Discovery → přepne na SCREEN_DISCOVERY
 //
 //  Geometrie:
-//    CONTENT_Y = 26, FTR_Y = 214 → CONTENT_H = 188 px
-//    CTRL_START_Y = CONTENT_Y + 4 = 30
-//    Každý řádek: CTRL_ROW_H = 26 px
-//    Každá sekce hlavička: CTRL_SEC_H = 16 px
-//    CTRL_VISIBLE = 6 řádků → max výška obsahu = 6×26 + sekcí×16
-//    _drawAllItems kreslí pouze do FTR_Y – žádný přesah do lišty
+//    Sdílený gContentSprite, seznam = ListView (LIST_ROW_H 26 px,
+//    sekce LIST_SEC_H 16 px, nic nepřesahuje do lišty pod FTR_Y)
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
@@ -69,6 +68,7 @@ namespace ControlScreen {
         ITEM_HDO_MODE,
         ITEM_HDO_THRESHOLD,
         ITEM_HDO_TOPUP_EN,
+        ITEM_HDO_TOPUP_MARGIN,
         ITEM_HDO_TOPUP_START,
         ITEM_HDO_TOPUP_END,
         ITEM_HDO_WIN1_START,
@@ -77,6 +77,7 @@ namespace ControlScreen {
         ITEM_HDO_WIN2_END,
 
         // Sekce: Discovery
+        ITEM_AUTO_POWER,
         ITEM_DISCOVERY,
 
         // Sekce: Zásobníky
@@ -106,29 +107,20 @@ namespace ControlScreen {
         { nullptr,         "Min SOC",         "20 %"   },
         { "HDO",           "Rezim",           "ADAPT"  },
         { nullptr,         "FVE prah",        "8.0 kWh"},
-        { nullptr,         "Dohrev",          "on"     },
+        { nullptr,         "Dohrev k terminu", "on"    },
+        { nullptr,         "Rezerva dohrevu", "30 min" },
         { nullptr,         "Dohrev od",       "17 h"   },
         { nullptr,         "Dohrev do",       "19 h"   },
         { nullptr,         "Okno1 od",        "22 h"   },
         { nullptr,         "Okno1 do",        "6 h"    },
         { nullptr,         "Okno2 od",        "13 h"   },
         { nullptr,         "Okno2 do",        "15 h"   },
-        { "Discovery",     "Spustit",         ">>>"    },
+        { "Discovery",     "Auto prikon",     "off"    },
+        { nullptr,         "Spustit",         ">>>"    },
         { "Zasobniky",     "Konfigurace bytu", ">>>"    },
     };
 
-    #define CTRL_VISIBLE    6
-    #define CTRL_ROW_H      26
-    #define CTRL_SEC_H      16
-    #define CTRL_START_Y    (CONTENT_Y + 4)
-
-    static uint8_t _cursor       = 0;
-    static uint8_t _scrollOffset = 0;
-    static bool    _editing      = false;
-
-    // Sdílený sprite z main_ui_loop – nastav přes setSprite()
-    static LGFX_Sprite* _spr = nullptr;
-    static void setSprite(LGFX_Sprite* s) { _spr = s; }
+    static ListView _list;
 
     // ----------------------------------------------------------
     //  Načti hodnoty z gBoilerSys do _items[]
@@ -149,12 +141,14 @@ namespace ControlScreen {
         snprintf(_items[ITEM_HDO_MODE].value,     16, "%s",      hdoModeName(gBoilerSys.hdoMode));
         snprintf(_items[ITEM_HDO_THRESHOLD].value,16, "%.1f kWh",gBoilerSys.hdoThresholdKwh);
         snprintf(_items[ITEM_HDO_TOPUP_EN].value, 16, "%s",      gBoilerSys.hdoTopupEnable ? "on" : "off");
+        snprintf(_items[ITEM_HDO_TOPUP_MARGIN].value,16, "%u min", gBoilerSys.topupMarginMin);
         snprintf(_items[ITEM_HDO_TOPUP_START].value, 16, "%u h", gBoilerSys.hdoTopupStart);
         snprintf(_items[ITEM_HDO_TOPUP_END].value,   16, "%u h", gBoilerSys.hdoTopupEnd);
         snprintf(_items[ITEM_HDO_WIN1_START].value,  16, "%u h", gBoilerSys.hdoStart1);
         snprintf(_items[ITEM_HDO_WIN1_END].value,    16, "%u h", gBoilerSys.hdoEnd1);
         snprintf(_items[ITEM_HDO_WIN2_START].value,  16, "%u h", gBoilerSys.hdoStart2);
         snprintf(_items[ITEM_HDO_WIN2_END].value,    16, "%u h", gBoilerSys.hdoEnd2);
+        snprintf(_items[ITEM_AUTO_POWER].value,      16, "%s",   gBoilerSys.autoPowerUpdate ? "on" : "off");
     }
 
     // ----------------------------------------------------------
@@ -167,7 +161,7 @@ namespace ControlScreen {
             case ITEM_NUM_BOILERS:
                 gConfig.numBoilers    = (uint8_t)constrain(val, 1, BOILER_MAX_COUNT);
                 gBoilerSys.numBoilers = gConfig.numBoilers;
-                ConfigManager::saveNumBoilers();
+                ConfigManager::saveNumBoilersAsync();
                 break;
             case ITEM_SEASON:
                 gBoilerSys.seasonWinter =
@@ -226,6 +220,14 @@ namespace ControlScreen {
                 gBoilerSys.hdoTopupEnable =
                     (strcmp(_items[idx].value, "on") == 0);
                 break;
+            case ITEM_AUTO_POWER:
+                gBoilerSys.autoPowerUpdate =
+                    (strcmp(_items[idx].value, "on") == 0);
+                break;
+            case ITEM_HDO_TOPUP_MARGIN:
+                gBoilerSys.topupMarginMin =
+                    (uint8_t)constrain(val, 0, 120);
+                break;
             case ITEM_HDO_TOPUP_START:
                 gBoilerSys.hdoTopupStart =
                     (uint8_t)constrain(val, 0, 23);
@@ -254,8 +256,8 @@ namespace ControlScreen {
                 break;
         }
 
-        ConfigManager::saveBlockBoilerSys();
-        Serial.printf("[CTRL] Uloženo: %s = %s\n",
+        ConfigManager::saveAsync(BLOCK_BOILSYS_ADDR);
+        LOGF("[CTRL] Uloženo: %s = %s\n",
             _items[idx].label, _items[idx].value);
     }
 
@@ -275,47 +277,47 @@ namespace ControlScreen {
                 break;
             case ITEM_MIN_ON:
             case ITEM_MIN_OFF: {
-                int v = constrain(atoi(_items[idx].value) + 1, 1, 60);
+                int v = constrain(atoi(_items[idx].value) + gSwitch.step(), 1, 60);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_SWITCH_DELAY: {
-                int v = constrain(atoi(_items[idx].value) + 5, 5, 300);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 5, 300);
                 snprintf(_items[idx].value, 16, "%d s", v);
                 break;
             }
             case ITEM_SLOT_DURATION: {
-                int v = constrain(atoi(_items[idx].value) + 5, 0, 240);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 0, 240);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_SLOT_COOLDOWN: {
-                int v = constrain(atoi(_items[idx].value) + 5, 0, 120);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 0, 120);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_RECHECK_INTERVAL: {
-                int v = constrain(atoi(_items[idx].value) + 5, 10, 240);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 10, 240);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_RECHECK_DURATION: {
-                int v = constrain(atoi(_items[idx].value) + 5, 5, 60);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 5, 60);
                 snprintf(_items[idx].value, 16, "%d s", v);
                 break;
             }
             case ITEM_SOLAR_SURPLUS: {
-                int v = constrain(atoi(_items[idx].value) + 50, 0, 2000);
+                int v = constrain(atoi(_items[idx].value) + 50 * gSwitch.step(), 0, 2000);
                 snprintf(_items[idx].value, 16, "%d W", v);
                 break;
             }
             case ITEM_MAX_HEAT_TIME: {
-                int v = constrain(atoi(_items[idx].value) + 30, 30, 720);
+                int v = constrain(atoi(_items[idx].value) + 30 * gSwitch.step(), 30, 720);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_MIN_SOC: {
-                int v = constrain(atoi(_items[idx].value) + 5, 0, 90);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 0, 90);
                 snprintf(_items[idx].value, 16, "%d %%", v);
                 break;
             }
@@ -334,9 +336,15 @@ namespace ControlScreen {
                 break;
             }
             case ITEM_HDO_TOPUP_EN:
+            case ITEM_AUTO_POWER:
                 snprintf(_items[idx].value, 16, "%s",
                     strcmp(_items[idx].value, "on") == 0 ? "off" : "on");
                 break;
+            case ITEM_HDO_TOPUP_MARGIN: {
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 0, 120);
+                snprintf(_items[idx].value, 16, "%d min", v);
+                break;
+            }
             case ITEM_HDO_TOPUP_START:
             case ITEM_HDO_TOPUP_END:
             case ITEM_HDO_WIN1_START:
@@ -364,47 +372,47 @@ namespace ControlScreen {
                 break;
             case ITEM_MIN_ON:
             case ITEM_MIN_OFF: {
-                int v = constrain(atoi(_items[idx].value) - 1, 1, 60);
+                int v = constrain(atoi(_items[idx].value) - gSwitch.step(), 1, 60);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_SWITCH_DELAY: {
-                int v = constrain(atoi(_items[idx].value) - 5, 5, 300);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 5, 300);
                 snprintf(_items[idx].value, 16, "%d s", v);
                 break;
             }
             case ITEM_SLOT_DURATION: {
-                int v = constrain(atoi(_items[idx].value) - 5, 0, 240);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 0, 240);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_SLOT_COOLDOWN: {
-                int v = constrain(atoi(_items[idx].value) - 5, 0, 120);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 0, 120);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_RECHECK_INTERVAL: {
-                int v = constrain(atoi(_items[idx].value) - 5, 10, 240);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 10, 240);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_RECHECK_DURATION: {
-                int v = constrain(atoi(_items[idx].value) - 5, 5, 60);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 5, 60);
                 snprintf(_items[idx].value, 16, "%d s", v);
                 break;
             }
             case ITEM_SOLAR_SURPLUS: {
-                int v = constrain(atoi(_items[idx].value) - 50, 0, 2000);
+                int v = constrain(atoi(_items[idx].value) - 50 * gSwitch.step(), 0, 2000);
                 snprintf(_items[idx].value, 16, "%d W", v);
                 break;
             }
             case ITEM_MAX_HEAT_TIME: {
-                int v = constrain(atoi(_items[idx].value) - 30, 30, 720);
+                int v = constrain(atoi(_items[idx].value) - 30 * gSwitch.step(), 30, 720);
                 snprintf(_items[idx].value, 16, "%d min", v);
                 break;
             }
             case ITEM_MIN_SOC: {
-                int v = constrain(atoi(_items[idx].value) - 5, 0, 90);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 0, 90);
                 snprintf(_items[idx].value, 16, "%d %%", v);
                 break;
             }
@@ -423,9 +431,15 @@ namespace ControlScreen {
                 break;
             }
             case ITEM_HDO_TOPUP_EN:
+            case ITEM_AUTO_POWER:
                 snprintf(_items[idx].value, 16, "%s",
                     strcmp(_items[idx].value, "on") == 0 ? "off" : "on");
                 break;
+            case ITEM_HDO_TOPUP_MARGIN: {
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 0, 120);
+                snprintf(_items[idx].value, 16, "%d min", v);
+                break;
+            }
             case ITEM_HDO_TOPUP_START:
             case ITEM_HDO_TOPUP_END:
             case ITEM_HDO_WIN1_START:
@@ -441,129 +455,20 @@ namespace ControlScreen {
     }
 
     // ----------------------------------------------------------
-    //  Kreslení položky
-    //  Vrací skutečnou výšku nakreslené položky (sekce + řádek).
-    //  Nenakreslí nic pokud by řádek přesáhl FTR_Y.
+    //  Řádek seznamu – Discovery / Zásobníky vedou do podmenu
     // ----------------------------------------------------------
-
-
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
-        CtrlItem& item    = _items[idx];
-        bool       active   = (idx == _cursor);
-        bool       editing  = (active && _editing);
-        bool      isLink  = (idx == ITEM_DISCOVERY || idx == ITEM_BOILERS_LIST);
-        int16_t    drawn    = 0;
-        LovyanGFX* dc       = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t    sy       = _spr ? y - CONTENT_Y : y;
-
-        // Sekce header
-        if (item.section != nullptr) {
-            if (y + CTRL_SEC_H > FTR_Y) return 0;
-            dc->fillRect(0, sy, 320, CTRL_SEC_H, t->bg);
-            dc->setFont(&fonts::Font2);
-            dc->setTextColor(t->dim);
-            dc->setCursor(16, sy);
-            dc->print(item.section);
-            sy += 14;
-            dc->drawFastHLine(16, sy, 288, t->dim);
-            sy += 2;
-            drawn += CTRL_SEC_H;
-        }
-
-        if (y + drawn + CTRL_ROW_H > FTR_Y) return drawn;
-
-        // Pozadí řádku
-        if (active) {
-            dc->fillRect(8, sy, 304, CTRL_ROW_H, t->header);
-            dc->fillRect(8, sy, 3,   CTRL_ROW_H, t->accent);
-        } else {
-            dc->fillRect(8, sy, 304, CTRL_ROW_H, t->bg);
-        }
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(active ? t->accent : t->text);
-        dc->setCursor(20, sy + 7);
-        dc->print(item.label);
-
-        // Hodnota nebo šipka (Discovery / Zásobníky)
-        if (isLink) {
-            dc->setTextColor(active ? t->accent : t->dim);
-            dc->setTextDatum(middle_right);
-            dc->drawString(">>>", 308, sy + 12);
-            dc->setTextDatum(top_left);
-        } else {
-            dc->setTextColor(editing ? t->accent : t->text);
-            dc->setTextDatum(middle_right);
-            dc->drawString(item.value, 308, sy + 12);
-            dc->setTextDatum(top_left);
-        }
-
-        drawn += CTRL_ROW_H;
-        return drawn;
+    static void _row(uint8_t idx, ListRow& r) {
+        CtrlItem& item = _items[idx];
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        r.flags   = (idx == ITEM_DISCOVERY || idx == ITEM_BOILERS_LIST) ? LIST_LINK : 0;
     }
 
-    // ----------------------------------------------------------
-    //  Překresli všechny viditelné položky.
-    //  Kreslíme od _scrollOffset dokud _drawItemAt nenarazí na FTR_Y.
-    // ----------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        if (_spr) { _spr->fillScreen(t->bg); }
-        else { tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg); }
-        int16_t y = CTRL_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_COUNT; i++) {
-            int16_t h = _drawItemAt(t, i, y);
-            if (h == 0) break;  // FTR_Y dosaženo – stop
-            y += h;
-        }
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
-    }
-
-    // ----------------------------------------------------------
-    //  Pomocná: Y pozice kde _drawItemAt začne kreslit položku idx
-    //  (simuluje stejnou logiku jako _drawAllItems, bez kreslení)
-    // ----------------------------------------------------------
-    static int16_t _itemY(uint8_t idx) {
-        int16_t y = CTRL_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (_items[i].section != nullptr) y += CTRL_SEC_H;
-            y += CTRL_ROW_H;
-        }
-        return y;
-    }
-
-    // ----------------------------------------------------------
-    //  Překresli jednu položku (najdi Y pixelově)
-    // ----------------------------------------------------------
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        _drawAllItems(t);
-    }
-
-    // ----------------------------------------------------------
-    //  Scroll – pixelový přístup
-    //  Zajistí že kurzor je fyzicky viditelný mezi CTRL_START_Y a FTR_Y.
-    // ----------------------------------------------------------
-    static bool _ensureVisible() {
-        // Scroll nahoru – kurzor je nad offsetem
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-
-        // Scroll dolů – posouvej offset dokud se kurzor celý vejde nad FTR_Y.
-        // _itemY počítá Y kde začíná položka idx (bez vlastní sekce).
-        // _drawItemAt pak nakreslí sekci (CTRL_SEC_H) + řádek (CTRL_ROW_H).
-        // Spodní hrana kurzoru = _itemY + vlastní_sekce + CTRL_ROW_H.
-        bool changed = false;
-        while (_scrollOffset < _cursor) {
-            int16_t y      = _itemY(_cursor);
-            int16_t secH   = (_items[_cursor].section != nullptr) ? CTRL_SEC_H : 0;
-            int16_t bottom = y + secH + CTRL_ROW_H;
-            if (bottom <= FTR_Y) break;   // vejde se → hotovo
-            _scrollOffset++;
-            changed = true;
-        }
-        return changed;
+    // Sdílený sprite z main_ui_loop – nastav přes setSprite()
+    static void setSprite(LGFX_Sprite* s) {
+        _list.begin(ITEM_COUNT, _row);
+        _list.setSprite(s);
     }
 
     // ==========================================================
@@ -586,7 +491,7 @@ namespace ControlScreen {
         tft.setTextDatum(top_left);
 
         _loadFromConfig();
-        _drawAllItems(t);
+        _list.draw(t);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -597,26 +502,26 @@ namespace ControlScreen {
 
     Screen handleInput(const Theme* t, SwButton btn) {
 
-        if (_editing) {
+        if (_list.editing()) {
             switch (btn) {
                 case SW_UP:
-                    _stepUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepUp(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _stepDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepDown(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_CENTER:
-                    _editing = false;
-                    _saveItem(_cursor);
+                    _list.setEditing(false);
+                    _saveItem(_list.cursor());
                     _loadFromConfig();      // obnov zobrazení z uložené hodnoty
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_LEFT:
-                    _editing = false;
+                    _list.setEditing(false);
                     _loadFromConfig();      // zahoď změny
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -626,30 +531,22 @@ namespace ControlScreen {
         // Normální navigace
         switch (btn) {
             case SW_UP:
-                if (_cursor > 0) {
-                    _cursor--;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursor < ITEM_COUNT - 1) {
-                    _cursor++;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER:
-                if (_cursor == ITEM_DISCOVERY) {
+                if (_list.cursor() == ITEM_DISCOVERY) {
                     return SCREEN_DISCOVERY;
                 }
-                if (_cursor == ITEM_BOILERS_LIST) {
+                if (_list.cursor() == ITEM_BOILERS_LIST) {
                     return SCREEN_BOILER_DETAIL;
                 }
-                _editing = true;
-                _drawItem(t, _cursor);
+                _list.setEditing(true);
+                _list.drawRow(t, _list.cursor());
                 return SCREEN_NONE;
 
             case SW_LEFT:
@@ -661,9 +558,7 @@ namespace ControlScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _loadFromConfig();
     }
 
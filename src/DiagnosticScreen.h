@@ -6,7 +6,7 @@
 //
 //  I/O tab:
 //    Vlevo: IO1–IO10 pulzní vstupy (puntíky)
-//    Vpravo: R1–R10 výstupy relé (indikátory stavu)
+//    Vpravo: R1–R10 výstupy relé (indikátory stavu, deska relé 0)
 //
 //  HW Status: uptime, FRAM, RTC, Modbus stav – doladit
 //  Alarmy:    seznam aktivních alarmů – doladit
@@ -142,16 +142,35 @@ namespace DiagnosticScreen {
         row("RTC",      "OK",                        t->ok,  CONTENT_Y + 104);
         row("Err.count", String(d.errorCount).c_str(),
             d.errorCount > 5 ? t->err : t->ok,              CONTENT_Y + 122);
+
+        char rbuf[16];
+        snprintf(rbuf, sizeof(rbuf), d.relayFault ? "CHYBA (%u)" : "OK (%u)", d.relayErrors);
+        row("Rele verify", rbuf, d.relayFault ? t->err : t->ok, CONTENT_Y + 140);
     }
 
     // ---------------------------------------------------------
     //  Alarmy záložka (TODO: AlarmManager)
     // ---------------------------------------------------------
-    static void _drawAlarms(const Theme* t) {
+    static void _drawAlarms(const Theme* t, const SolarData& d) {
         tft.setFont(&fonts::Font2);
-        tft.setTextColor(t->dim);
-        tft.setCursor(16, CONTENT_Y + 50);
-        tft.print("Zadne aktivni alarmy");
+        int16_t y = CONTENT_Y + 50;
+        if (d.invStatus == 3) {
+            tft.setTextColor(t->err);
+            tft.setCursor(16, y);
+            tft.print("Menic hlasi poruchu");
+            y += 18;
+        }
+        if (d.relayFault) {
+            tft.setTextColor(t->err);
+            tft.setCursor(16, y);
+            tft.printf("Rele: zpetne cteni nesouhlasi (%u x)", d.relayErrors);
+            y += 18;
+        }
+        if (y == CONTENT_Y + 50) {
+            tft.setTextColor(t->dim);
+            tft.setCursor(16, y);
+            tft.print("Zadne aktivni alarmy");
+        }
 
         // TODO: AlarmManager::getList() → zobrazit seznam
     }
@@ -164,7 +183,7 @@ namespace DiagnosticScreen {
         switch (_tab) {
             case 0: _drawIO(t, d);     break;
             case 1: _drawHW(t, d);     break;
-            case 2: _drawAlarms(t);    break;
+            case 2: _drawAlarms(t, d); break;
         }
     }
 
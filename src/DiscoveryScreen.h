@@ -6,16 +6,40 @@
 //  Výsledky uloží do BoilerConfig[] (v RAM, TODO: persistovat do FRAM).
 //
 //  Průběh:
-//    Pro každý byt 1–numBoilers:
-//      1. Změř baseline fází (10s, 5 měření)
+//    1. Kódované měření bytů po skupinách (CodedDiscovery.h):
+//       skupina má 2M kroků (M = mocnina 2 > velikost skupiny),
+//       v každém sepnutá část podle Hadamardovy matice, ustálení
+//       DISC_CODE_SETTLE_MS a jedno měření fází. Fáze + příkon
+//       nejmenšími čtverci s intervalem spolehlivosti, lineární
+//       drift FVE se vyruší.
+//       Zátěž: fáze bytů nejsou známé → všechny sepnuté mohou být
+//       na jedné fázi. Velikost skupiny je taková, aby v žádném
+//       kroku nebylo sepnuto víc než DISC_CODE_MAX_LOAD_W / příkon
+//       (limit fáze = limit součtu). Každý krok se sepne jen když
+//       přetok (bez sepnutých bytů discovery) jeho zátěž pokryje,
+//       jinak vše vypne a skupinu začne znovu, až výkon vystačí;
+//       po DISC_CODE_WAIT_MS zbylé byty měří po jednom.
+//    2. Nejednoznačné byty postaru po jednom, sekvenčně
+//       (vzorky po 2 s, měření končí jakmile je výsledek
+//       v toleranci – RunningStats.h, 95% interval Student t):
+//      1. Baseline fází – dokud interval průměru > DISC_POWER_TOL_W
+//         (min. DISC_MIN_SAMPLES, max. DISC_MAX_SAMPLES)
 //      2. Sepni relé zásobníku
-//      3. Počkej 8s na ustálení
-//      4. Změř fáze po sepnutí (5 měření po 2s)
-//      5. Vyhodnoť delta – fáze s největší deltou = fáze zásobníku
-//      6. Pokud delta nespolehlivá → opakuj až 3×
+//      3. Ustálení – dva po sobě jdoucí vzorky shodné a odlišné
+//         od baseline (nejvýš DISC_SETTLE_MS)
+//      4. Fáze po sepnutí – dokud interval poklesu nejlepší fáze
+//         > tolerance nebo se nedá oddělit od druhé fáze;
+//         zřetelně žádný pokles → konec hned (opakování)
+//      5. Fáze s největším poklesem přetoku = fáze zásobníku,
+//         max. vzorků bez splněné tolerance → WARN
+//      6. Žádný pokles → opakuj až 3×
 //      7. Rozepni relé, počkej 10s před dalším
 //
-//  Celková délka: ~45s × numBoilers (max ~7,5 min pro 10 bytů)
+//  Celková délka: kódované měření ~4–6 s na krok (10 bytů po
+//  2 kW: skupiny 3+3+2+2 × 8 kroků = 32 kroků ≈ 2,5 min)
+//  + ~25 s za každý nejednoznačný byt
+//  (pevně 5 + 5 vzorků a 8 s ustálení ~45 s, zašuměný
+//  signál měření prodlouží až na 10 + 10 vzorků)
 //
 //  Podmínky pro spuštění:
 //    - FVE vyrábí alespoň numBoilers × MIN_PV_PER_BOILER_W
@@ -28,6 +52,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
@@ -36,8 +61,10 @@
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
-#include "MCP23017.h"
+#include "RelayBank.h"
 #include "BoilerConfig.h"
+#include "CodedDiscovery.h"
+#include "RunningStats.h"
 
 // Minimální výkon FVE na zásobník pro spuštění discovery [W]
 #define DISC_MIN_PV_PER_BOILER_W    500
@@ -45,15 +72,21 @@
 // Minimální SOC baterie pro spuštění discovery [%]
 #define DISC_MIN_SOC                20
 
-// Počet měření baseline a po sepnutí
-#define DISC_SAMPLE_COUNT           5
+// Počet měření baseline a po sepnutí – sekvenčně min … max
+#define DISC_MIN_SAMPLES            2
+#define DISC_MAX_SAMPLES            10
 
 // Interval mezi měřeními [ms] – synchronizováno s Modbus poll
 #define DISC_SAMPLE_INTERVAL_MS     2000
 
-// Čas ustálení po sepnutí relé [ms]
+// Čas ustálení po sepnutí relé [ms] – první vzorek po MIN,
+// nejvýš MAX i když se hodnoty neustálí
+#define DISC_SETTLE_MIN_MS          2000
 #define DISC_SETTLE_MS              8000
 
+// Ustálení: dva po sobě jdoucí vzorky se liší nejvýš o [W]
+#define DISC_STEP_TOL_W             100
+
 // Čas mezi zásobníky po rozepnutí [ms]
 #define DISC_BETWEEN_MS             10000
 
@@ -63,13 +96,30 @@
 // Max. počet opakování měření při nespolehlivém výsledku
 #define DISC_MAX_RETRIES            3
 
-// Tolerance směrodatné odchylky – pokud odchylka > (delta * TOLERANCE / 100)
-// → měření nespolehlivé
-#define DISC_RELIABILITY_PCT        30
+// Tolerance výsledku – 95% interval poklesu fáze nejvýš
+// max(DISC_POWER_TOL_W, delta × DISC_POWER_TOL_PCT / 100)
+#define DISC_POWER_TOL_W            150
+#define DISC_POWER_TOL_PCT          10
 
 // Zaokrouhlení příkonu [W]
 #define DISC_POWER_ROUND_W          50
 
+// Kódované měření – ustálení po přepnutí skupiny [ms]
+// (vzorek se vezme při prvním update() po uplynutí)
+#define DISC_CODE_SETTLE_MS         4000
+
+// Kódované měření – max. současná zátěž [W]. Fáze bytů před
+// discovery nejsou známé, platí proto pro každou fázi i pro
+// součet (4 kW ≈ 17 A na jedné fázi).
+#define DISC_CODE_MAX_LOAD_W        4000
+
+// Příkon bytu pro limit zátěže, když ho konfigurace nemá [W]
+#define DISC_CODE_DEFAULT_W         2000
+
+// Kódované měření – jak dlouho čekat na výkon pro krok [ms],
+// pak zbylé byty po jednom
+#define DISC_CODE_WAIT_MS           120000
+
 // =============================================================
 //  Stav discovery procedury
 // =============================================================
@@ -108,18 +158,29 @@ namespace DiscoveryScreen {
     static uint8_t         _measRetries[BOILER_MAX_COUNT] = {}; // počet opakování
 
     // --- Měřicí buffery ---
-    static float   _baselineL[3] = {};  // průměr baseline L1/L2/L3
-    static float   _afterL[3]    = {};  // průměr po sepnutí L1/L2/L3
-    static float   _stddevL[3]   = {};  // směrodatná odchylka po sepnutí
-    static uint8_t _sampleIdx    = 0;   // index aktuálního vzorku
-    static float   _sampleBuf[DISC_SAMPLE_COUNT][3] = {};  // buffer vzorků
+    static RunningStats _base[3];         // baseline L1/L2/L3
+    static RunningStats _after[3];        // po sepnutí L1/L2/L3
+    static uint8_t _sampleIdx    = 0;     // vzorků v aktuálním kroku
+    static float   _settlePrev[3] = {};   // předchozí vzorek při ustálení
 
     // --- Časování ---
     static uint32_t _stepStartMs  = 0;  // začátek aktuálního kroku
     static uint32_t _lastSampleMs = 0;  // čas posledního vzorku
 
+    // --- Kódované měření ---
+    static uint16_t _codeStep     = 0;  // aktuální krok návrhu
+    static uint8_t  _groupFirst   = 0;  // první byt skupiny
+    static uint8_t  _groupSize    = 0;  // bytů ve skupině (0 = po jednom)
+    static uint8_t  _groupMax     = 0;  // max. velikost skupiny (limit zátěže)
+    static uint16_t _loadW        = 0;  // příkon bytu pro limit zátěže [W]
+    static uint8_t  _codeOn       = 0;  // právě sepnuto kódovaným měřením
+    static bool     _codeWaiting  = false;  // čeká na výkon před krokem 0
+    static uint32_t _waitStartMs  = 0;
+    static bool     _gridOk       = false;  // uživatel potvrdil odběr ze sítě
+
     // --- Interní krok v rámci jednoho zásobníku ---
     enum MeasStep : uint8_t {
+        MEAS_CODED,      // kódované měření všech najednou
         MEAS_BASELINE,   // sbírá baseline vzorky
         MEAS_SETTLE,     // čeká na ustálení po sepnutí
         MEAS_AFTER,      // sbírá vzorky po sepnutí
@@ -129,13 +190,13 @@ namespace DiscoveryScreen {
     static MeasStep _measStep = MEAS_BASELINE;
 
     // --- Odkaz na hardware (nastaven v begin()) ---
-    static MCP23017*     _mcp      = nullptr;
+    static RelayBank*    _mcp      = nullptr;
     static BoilerConfig* _cfg      = nullptr;
 
     // ==========================================================
     //  Inicializace – volej při přepnutí na tento screen
     // ==========================================================
-    void begin(MCP23017& mcp, BoilerConfig* cfg, uint8_t numBoilers) {
+    void begin(RelayBank& mcp, BoilerConfig* cfg, uint8_t numBoilers) {
         _mcp        = &mcp;
         _cfg        = cfg;
         _numBoilers = numBoilers;
@@ -149,76 +210,93 @@ namespace DiscoveryScreen {
     }
 
     // ==========================================================
-    //  Pomocné: průměr a směrodatná odchylka z bufferu
+    //  Pomocné: sekvenční statistika vzorků
     // ==========================================================
-    static float _mean(float* arr, uint8_t n) {
-        float sum = 0;
-        for (uint8_t i = 0; i < n; i++) sum += arr[i];
-        return sum / n;
+    static void _sampleOf(const SolarData& d, float y[3]) {
+        y[0] = (float)d.phaseL1;
+        y[1] = (float)d.phaseL2;
+        y[2] = (float)d.phaseL3;
     }
 
-    static float _stddev(float* arr, uint8_t n, float mean) {
-        float sum = 0;
-        for (uint8_t i = 0; i < n; i++) {
-            float d = arr[i] - mean;
-            sum += d * d;
-        }
-        return sqrtf(sum / n);
+    static void _addSample(RunningStats st[3], const float y[3]) {
+        for (uint8_t ph = 0; ph < 3; ph++) st[ph].add(y[ph]);
     }
 
-    // Uloží vzorek fází do bufferu
-    static void _storeSample(uint8_t idx, const SolarData& d) {
-        if (idx >= DISC_SAMPLE_COUNT) return;
-        _sampleBuf[idx][0] = (float)d.phaseL1;
-        _sampleBuf[idx][1] = (float)d.phaseL2;
-        _sampleBuf[idx][2] = (float)d.phaseL3;
+    // Tolerance intervalu poklesu [W]
+    static float _tolW(float delta) {
+        float pct = delta * DISC_POWER_TOL_PCT / 100.0f;
+        return pct > DISC_POWER_TOL_W ? pct : (float)DISC_POWER_TOL_W;
     }
 
-    // Vypočítá průměr a stddev ze vzorků pro každou fázi
-    static void _calcStats(float mean[3], float stddev[3]) {
-        float tmp[DISC_SAMPLE_COUNT];
+    // Baseline stačí – interval průměru všech fází v toleranci
+    static bool _baselineDone() {
+        if (_base[0].n >= DISC_MAX_SAMPLES) return true;
+        if (_base[0].n <  DISC_MIN_SAMPLES) return false;
         for (uint8_t ph = 0; ph < 3; ph++) {
-            for (uint8_t i = 0; i < DISC_SAMPLE_COUNT; i++) {
-                tmp[i] = _sampleBuf[i][ph];
-            }
-            mean[ph]   = _mean(tmp, DISC_SAMPLE_COUNT);
-            stddev[ph] = _stddev(tmp, DISC_SAMPLE_COUNT, mean[ph]);
+            if (_base[ph].ciHalf95() > DISC_POWER_TOL_W) return false;
+        }
+        return true;
+    }
+
+    // Pokles přetoku po sepnutí a jeho ± interval na každé fázi,
+    // best / second = fáze s největším / druhým největším poklesem
+    static void _drop(float delta[3], float ci[3], uint8_t& best, uint8_t& second) {
+        for (uint8_t ph = 0; ph < 3; ph++) {
+            delta[ph] = phaseDrawW(_base[ph].mean(), _after[ph].mean());
+            ci[ph]    = diffCiHalf95(_base[ph], _after[ph]);
+        }
+        best = 0;
+        for (uint8_t ph = 1; ph < 3; ph++) if (delta[ph] > delta[best]) best = ph;
+        second = best == 0 ? 1 : 0;
+        for (uint8_t ph = 0; ph < 3; ph++) {
+            if (ph != best && delta[ph] > delta[second]) second = ph;
         }
     }
 
+    // Fáze i příkon určené v toleranci?
+    static bool _dropDecided(const float delta[3], const float ci[3],
+                             uint8_t best, uint8_t second) {
+        return delta[best] >= DISC_MIN_DELTA_W &&
+               ci[best] <= _tolW(delta[best]) &&
+               delta[best] - ci[best] > delta[second] + ci[second];
+    }
+
+    // Stop pravidlo po sepnutí: +1 rozhodnuto, −1 zřetelně žádný
+    // odběr (horní mez intervalu pod DISC_MIN_DELTA_W), 0 další vzorek
+    static int8_t _afterDecision() {
+        if (_after[0].n < DISC_MIN_SAMPLES) return 0;
+        float   delta[3], ci[3];
+        uint8_t best, second;
+        _drop(delta, ci, best, second);
+        if (delta[best] + ci[best] < DISC_MIN_DELTA_W) return -1;
+        if (_dropDecided(delta, ci, best, second))     return 1;
+        return 0;
+    }
+
     // ==========================================================
     //  Vyhodnocení měření jednoho zásobníku
     //  Vrátí true pokud je výsledek spolehlivý
     // ==========================================================
     static bool _evaluate(uint8_t boilerIdx) {
-        float delta[3];
-        for (uint8_t i = 0; i < 3; i++) {
-            delta[i] = _afterL[i] - _baselineL[i];
-        }
+        float   delta[3], ci[3];
+        uint8_t bestPh, second;
+        _drop(delta, ci, bestPh, second);
+        float   bestDelta = delta[bestPh];
 
-        // Najdi fázi s největší deltou
-        uint8_t bestPh   = 0;
-        float   bestDelta = delta[0];
-        for (uint8_t i = 1; i < 3; i++) {
-            if (delta[i] > bestDelta) {
-                bestDelta = delta[i];
-                bestPh    = i;
-            }
-        }
-
-        Serial.printf("[DISC] Byt %u: delta L1=%.0f L2=%.0f L3=%.0f W\n",
+        LOGF("[DISC] Byt %u: delta L1=%.0f L2=%.0f L3=%.0f W\n",
             boilerIdx + 1, delta[0], delta[1], delta[2]);
 
         // Minimální delta pro detekci
         if (bestDelta < DISC_MIN_DELTA_W) {
-            Serial.printf("[DISC] Byt %u: delta příliš malá (%.0f W) – "
-                          "zásobník plný nebo studený?\n",
+            LOGF("[DISC] Byt %u: delta příliš malá (%.0f W) – "
+                 "zásobník plný nebo studený?\n",
                 boilerIdx + 1, bestDelta);
             return false;
         }
 
-        // Spolehlivost – směrodatná odchylka nesmí být příliš velká
-        bool reliable = (_stddevL[bestPh] < bestDelta * DISC_RELIABILITY_PCT / 100.0f);
+        // Spolehlivost – interval v toleranci a fáze oddělená od druhé
+        // (jinak měření doběhlo na DISC_MAX_SAMPLES)
+        bool reliable = _dropDecided(delta, ci, bestPh, second);
 
         // Zaokrouhli příkon na DISC_POWER_ROUND_W
         uint16_t power = (uint16_t)(
@@ -229,11 +307,12 @@ namespace DiscoveryScreen {
         _measPhase[boilerIdx] = bestPh + 1;  // 1/2/3
         _measPower[boilerIdx] = power;
 
-        Serial.printf("[DISC] Byt %u: L%u, %u W, stddev=%.0f W, %s\n",
+        LOGF("[DISC] Byt %u: L%u, %u W ±%.0f W, vzorků %u+%u, %s\n",
             boilerIdx + 1,
             bestPh + 1,
             power,
-            _stddevL[bestPh],
+            ci[bestPh],
+            _base[0].n, _after[0].n,
             reliable ? "OK" : "WARN");
 
         return reliable;
@@ -247,13 +326,87 @@ namespace DiscoveryScreen {
         _cfg[boilerIdx].phase         = _measPhase[boilerIdx];
         _cfg[boilerIdx].powerW        = _measPower[boilerIdx];
         _cfg[boilerIdx].discoveryDone = true;
-        ConfigManager::saveBlockBoilerCfg();
-        Serial.printf("[DISC] Byt %u: uloženo L%u %u W\n",
+        ConfigManager::saveAsync(BLOCK_BOILCFG_ADDR);
+        LOGF("[DISC] Byt %u: uloženo L%u %u W\n",
             boilerIdx + 1,
             _cfg[boilerIdx].phase,
             _cfg[boilerIdx].powerW);
     }
 
+    // ==========================================================
+    //  Kódované měření – relé podle kroku návrhu (jedna dávka)
+    // ==========================================================
+    static void _applyPattern(uint16_t step) {
+        _mcp->beginBatch();
+        for (uint8_t i = 0; i < _numBoilers; i++) {
+            bool in = i >= _groupFirst && i < _groupFirst + _groupSize;
+            _mcp->setRelay(i, in && CodedDiscovery::on(step, i - _groupFirst));
+        }
+        _mcp->commit();
+        _codeOn = CodedDiscovery::onCount(step);
+    }
+
+    static void _allOff() {
+        _mcp->beginBatch();
+        for (uint8_t i = 0; i < _numBoilers; i++) _mcp->setRelay(i, false);
+        _mcp->commit();
+        _codeOn = 0;
+    }
+
+    // Pokryje přetok zátěž kroku? Přetok bez bytů discovery =
+    // součet fází + právě sepnuté × _loadW. Potvrzený start ze
+    // sítě hlídá jen limit zátěže (daný velikostí skupiny).
+    static bool _stepPowerOk(const SolarData& d, uint16_t step) {
+        if (_gridOk) return true;
+        int32_t freeW = d.phaseL1 + d.phaseL2 + d.phaseL3 + (int32_t)_codeOn * _loadW;
+        int32_t needW = (int32_t)CodedDiscovery::onCount(step) * _loadW;
+        return needW <= freeW;
+    }
+
+    // Další skupina kódovaného měření od prvního nezměřeného bytu,
+    // zbytek rozdělený rovnoměrně (10 po max. 3 → 3+3+2+2)
+    // false = nic nezbývá nebo limit zátěže nedovolí skupinu > 1
+    static bool _nextGroup() {
+        _groupFirst = _groupFirst + _groupSize;
+        _groupSize  = 0;
+        if (_groupMax < 2 || _groupFirst >= _numBoilers) return false;
+        uint8_t left   = _numBoilers - _groupFirst;
+        uint8_t groups = (left + _groupMax - 1) / _groupMax;
+        _groupSize     = (left + groups - 1) / groups;
+        CodedDiscovery::begin(_groupSize);
+        _codeStep      = 0;
+        _codeWaiting   = true;
+        return true;
+    }
+
+    // Další byt čekající na měření po jednom (>= _numBoilers = žádný)
+    static uint8_t _nextPending(uint8_t from) {
+        while (from < _numBoilers && _results[from] != DISC_RES_PENDING) from++;
+        return from;
+    }
+
+    // Vyřeš kódované měření – jednoznačné byty rovnou uloží
+    static void _solveCoded() {
+        uint8_t ok = 0;
+        for (uint8_t i = _groupFirst; i < _groupFirst + _groupSize; i++) {
+            CodedDiscovery::Fit f;
+            bool sure = CodedDiscovery::solve(i - _groupFirst, f);
+            LOGF("[DISC] Byt %u: kód L%u %.0f ±%.0f W (2. fáze %.0f) %s\n",
+                i + 1, f.phase, f.powerW, f.ciW, f.secondW,
+                sure ? "OK" : "→ po jednom");
+            if (!sure) continue;
+            _measPhase[i] = f.phase;
+            _measPower[i] = (uint16_t)(
+                ((int32_t)f.powerW + DISC_POWER_ROUND_W / 2) /
+                DISC_POWER_ROUND_W * DISC_POWER_ROUND_W);
+            _results[i]   = DISC_RES_OK;
+            _saveResult(i);
+            ok++;
+        }
+        LOGF("[DISC] Kódované měření byty %u–%u: %u/%u jednoznačně\n",
+            _groupFirst + 1, _groupFirst + _groupSize, ok, _groupSize);
+    }
+
     // ==========================================================
     //  Kreslení
     // ==========================================================
@@ -492,6 +645,24 @@ namespace DiscoveryScreen {
         }
     }
 
+    // Konec kódovaného měření → nezměřené byty po jednom
+    static void _codedDone(const Theme* t, uint32_t now) {
+        _allOff();
+        _groupSize   = 0;
+        _current     = _nextPending(0);
+        _retryCount  = 0;
+        _stepStartMs = now;
+        _measStep    = MEAS_BETWEEN;
+        if (_current >= _numBoilers) {
+            _phase = DISC_DONE;
+            _drawSummary(t);
+            _drawFooterHint(t, "Hotovo!  LEFT = zpet");
+            LOGLN("[DISC] Discovery dokončeno");
+        } else {
+            _drawFooterHint(t, "CENTER = přerušit");
+        }
+    }
+
     // ==========================================================
     //  update() – voláno každé 2s (synchronizováno s Modbus poll)
     //  Zde běží stavový automat měření
@@ -509,6 +680,65 @@ namespace DiscoveryScreen {
 
         switch (_measStep) {
 
+            // -----------------------------------------------------
+            case MEAS_CODED:
+            // Skupina sepnutá podle kroku – po ustálení jeden vzorek
+            {
+                if (_codeWaiting) {
+                    // Před skupinou / po výpadku výkonu vše vypnuto
+                    if (!_stepPowerOk(d, 0)) {
+                        if (now - _waitStartMs < DISC_CODE_WAIT_MS) break;
+                        LOGLN("[DISC] Výkon na kódované měření nestačí → po jednom");
+                        _codedDone(t, now);
+                        break;
+                    }
+                    _codeWaiting = false;
+                    _applyPattern(0);
+                    _stepStartMs = now;
+                    break;
+                }
+                if (now - _stepStartMs < DISC_CODE_SETTLE_MS) break;
+
+                const float y[3] = { (float)d.phaseL1, (float)d.phaseL2, (float)d.phaseL3 };
+                CodedDiscovery::addSample(_codeStep, y);
+                _codeStep++;
+
+                uint16_t total = CodedDiscovery::steps();
+                char buf[40];
+                snprintf(buf, sizeof(buf), "Kodovane mereni %u-%u: %u/%u",
+                    _groupFirst + 1, _groupFirst + _groupSize, _codeStep, total);
+                _drawFooterHint(t, buf);
+
+                if (_codeStep < total) {
+                    if (!_stepPowerOk(d, _codeStep)) {
+                        // Krok by šel ze sítě – vypni, skupina znovu od
+                        // kroku 0 (přerušení by rozbilo vyrušení driftu)
+                        LOGF("[DISC] Krok %u: přetok nestačí → čekám\n", _codeStep);
+                        _allOff();
+                        CodedDiscovery::begin(_groupSize);
+                        _codeStep    = 0;
+                        _codeWaiting = true;
+                        _waitStartMs = now;
+                        _drawFooterHint(t, "Cekam na vykon FVE...");
+                        break;
+                    }
+                    _applyPattern(_codeStep);
+                    _stepStartMs = now;
+                    break;
+                }
+
+                // Skupina hotová – vyřeš, další skupina nebo po jednom
+                _allOff();
+                _solveCoded();
+                for (uint8_t i = _groupFirst; i < _groupFirst + _groupSize; i++) _drawResultRow(t, i);
+                if (_nextGroup()) {
+                    _waitStartMs = now;
+                    break;
+                }
+                _codedDone(t, now);
+                break;
+            }
+
             // -----------------------------------------------------
             case MEAS_BASELINE:
             // Sbíráme vzorky baseline před sepnutím
@@ -522,26 +752,28 @@ namespace DiscoveryScreen {
                 if (now - _lastSampleMs < DISC_SAMPLE_INTERVAL_MS) break;
                 _lastSampleMs = now;
 
-                _storeSample(_sampleIdx, d);
+                float y[3];
+                _sampleOf(d, y);
+                _addSample(_base, y);
                 _sampleIdx++;
 
                 // Progress: 0–40%
-                uint8_t pct = _sampleIdx * 40 / DISC_SAMPLE_COUNT;
+                uint8_t pct = _sampleIdx * 40 / DISC_MAX_SAMPLES;
                 _drawCurrentRow(t, _current, "baseline...", pct);
 
-                if (_sampleIdx >= DISC_SAMPLE_COUNT) {
-                    // Hotovo – spočítej baseline průměr
-                    float tmp[3];
-                    _calcStats(_baselineL, tmp);  // stddev zahazujeme
+                if (_baselineDone()) {
+                    // Hotovo – baseline v toleranci
                     _sampleIdx   = 0;
 
                     // Sepni relé
                     _mcp->setRelay(_current, true);
-                    Serial.printf("[DISC] Byt %u: relé ON, čekám na ustálení\n",
-                        _current + 1);
+                    LOGF("[DISC] Byt %u: relé ON (baseline %u vzorků), "
+                         "čekám na ustálení\n",
+                        _current + 1, _base[0].n);
 
-                    _stepStartMs = now;
-                    _measStep    = MEAS_SETTLE;
+                    _stepStartMs  = now;
+                    _lastSampleMs = now;
+                    _measStep     = MEAS_SETTLE;
                     _drawCurrentRow(t, _current, "ustálení...", 40);
                 }
                 break;
@@ -549,16 +781,38 @@ namespace DiscoveryScreen {
 
             // -----------------------------------------------------
             case MEAS_SETTLE:
-            // Čekáme na ustálení proudu po sepnutí
+            // Čekáme na ustálení proudu po sepnutí – dva shodné vzorky
+            // mimo baseline (ne zastaralé čtení před sepnutím)
             {
-                uint8_t pct = 40 + (uint8_t)((now - _stepStartMs) * 20 / DISC_SETTLE_MS);
+                uint32_t elapsed = now - _stepStartMs;
+                uint8_t pct = 40 + (uint8_t)(elapsed * 20 / DISC_SETTLE_MS);
                 if (pct > 60) pct = 60;
                 _drawCurrentRow(t, _current, "ustálení...", pct);
 
-                if (now - _stepStartMs >= DISC_SETTLE_MS) {
-                    _sampleIdx   = 0;
-                    _lastSampleMs = now;
-                    _measStep    = MEAS_AFTER;
+                if (elapsed < DISC_SETTLE_MIN_MS) break;
+                if (now - _lastSampleMs < DISC_SAMPLE_INTERVAL_MS) break;
+                _lastSampleMs = now;
+
+                float y[3];
+                _sampleOf(d, y);
+                bool stable = _sampleIdx > 0;
+                bool moved  = false;
+                for (uint8_t ph = 0; ph < 3; ph++) {
+                    if (fabsf(y[ph] - _settlePrev[ph]) > DISC_STEP_TOL_W) stable = false;
+                    if (_base[ph].mean() - y[ph] >= DISC_MIN_DELTA_W)     moved  = true;
+                    _settlePrev[ph] = y[ph];
+                }
+                _sampleIdx = 1;
+
+                if ((stable && moved) || elapsed >= DISC_SETTLE_MS) {
+                    for (uint8_t ph = 0; ph < 3; ph++) _after[ph].reset();
+                    _sampleIdx = 0;
+                    if (stable && moved) {
+                        // Ustálený vzorek je první po sepnutí
+                        _addSample(_after, y);
+                        _sampleIdx = 1;
+                    }
+                    _measStep = MEAS_AFTER;
                 }
                 break;
             }
@@ -570,16 +824,18 @@ namespace DiscoveryScreen {
                 if (now - _lastSampleMs < DISC_SAMPLE_INTERVAL_MS) break;
                 _lastSampleMs = now;
 
-                _storeSample(_sampleIdx, d);
+                float y[3];
+                _sampleOf(d, y);
+                _addSample(_after, y);
                 _sampleIdx++;
 
                 // Progress: 60–90%
-                uint8_t pct = 60 + _sampleIdx * 30 / DISC_SAMPLE_COUNT;
+                uint8_t pct = 60 + _sampleIdx * 30 / DISC_MAX_SAMPLES;
                 _drawCurrentRow(t, _current, "měřím...", pct);
 
-                if (_sampleIdx >= DISC_SAMPLE_COUNT) {
-                    // Hotovo – spočítej průměr a stddev po sepnutí
-                    _calcStats(_afterL, _stddevL);
+                // Stop: výsledek v toleranci, zřetelně bez odběru,
+                // nebo max. vzorků (zašuměný signál)
+                if (_afterDecision() != 0 || _after[0].n >= DISC_MAX_SAMPLES) {
                     _sampleIdx = 0;
                     _measStep  = MEAS_EVALUATE;
                 }
@@ -592,7 +848,7 @@ namespace DiscoveryScreen {
             {
                 // Rozepni relé
                 _mcp->setRelay(_current, false);
-                Serial.printf("[DISC] Byt %u: relé OFF, vyhodnocuji\n",
+                LOGF("[DISC] Byt %u: relé OFF, vyhodnocuji\n",
                     _current + 1);
 
                 _drawCurrentRow(t, _current, "vyhodnocuji...", 95);
@@ -607,7 +863,7 @@ namespace DiscoveryScreen {
                     _drawResultRow(t, _current);
 
                     // Přejdi na další zásobník
-                    _current++;
+                    _current = _nextPending(_current + 1);
                     _retryCount  = 0;
                     _stepStartMs = now;
                     _measStep    = (_current < _numBoilers) ? MEAS_BETWEEN : MEAS_BETWEEN;
@@ -615,19 +871,20 @@ namespace DiscoveryScreen {
                 } else if (_retryCount < DISC_MAX_RETRIES - 1) {
                     // Opakuj měření
                     _retryCount++;
-                    Serial.printf("[DISC] Byt %u: opakuji (%u/%u)\n",
+                    LOGF("[DISC] Byt %u: opakuji (%u/%u)\n",
                         _current + 1, _retryCount, DISC_MAX_RETRIES);
-                    _measStep  = MEAS_BETWEEN;  // krátká pauza pak znovu
+                    _stepStartMs = now;
+                    _measStep    = MEAS_BETWEEN;  // krátká pauza pak znovu
 
                 } else {
                     // Selhalo po max. opakováních
                     _results[_current]     = DISC_RES_FAIL;
                     _measRetries[_current] = _retryCount;
                     _drawResultRow(t, _current);
-                    Serial.printf("[DISC] Byt %u: selhalo → ruční kontrola\n",
+                    LOGF("[DISC] Byt %u: selhalo → ruční kontrola\n",
                         _current + 1);
 
-                    _current++;
+                    _current = _nextPending(_current + 1);
                     _retryCount  = 0;
                     _stepStartMs = now;
                     _measStep    = MEAS_BETWEEN;
@@ -638,7 +895,7 @@ namespace DiscoveryScreen {
                     _phase = DISC_DONE;
                     _drawSummary(t);
                     _drawFooterHint(t, "Hotovo!  LEFT = zpet");
-                    Serial.println("[DISC] Discovery dokončeno");
+                    LOGLN("[DISC] Discovery dokončeno");
                 }
                 break;
             }
@@ -652,6 +909,7 @@ namespace DiscoveryScreen {
                     : DISC_BETWEEN_MS;
 
                 if (now - _stepStartMs >= waitMs) {
+                    for (uint8_t ph = 0; ph < 3; ph++) _base[ph].reset();
                     _sampleIdx = 0;
                     _measStep  = MEAS_BASELINE;
                 }
@@ -667,17 +925,35 @@ namespace DiscoveryScreen {
         _phase        = DISC_MEASURING;
         _current      = 0;
         _retryCount   = 0;
-        _measStep     = MEAS_BASELINE;
+        _measStep     = MEAS_CODED;
         _sampleIdx    = 0;
+        _codeStep     = 0;
         _stepStartMs  = millis();
         _lastSampleMs = millis();
 
         for (uint8_t i = 0; i < _numBoilers; i++) {
             _results[i] = DISC_RES_PENDING;
+            _drawCurrentRow(t, i, "kodovani...", 0);
         }
 
-        Serial.printf("[DISC] Spouštím discovery pro %u zásobníků\n", _numBoilers);
+        // Limit zátěže: nejvyšší nastavený příkon (fáze neznámé)
+        _loadW = 0;
+        for (uint8_t i = 0; i < _numBoilers; i++) {
+            if (_cfg && _cfg[i].powerW > _loadW) _loadW = _cfg[i].powerW;
+        }
+        if (!_loadW) _loadW = DISC_CODE_DEFAULT_W;
+        uint8_t maxOn = DISC_CODE_MAX_LOAD_W / _loadW;
+        _groupMax     = CodedDiscovery::groupSize(maxOn ? maxOn : 1);
+        _groupFirst   = 0;
+        _groupSize    = 0;
+        _codeOn       = 0;
+        _waitStartMs  = millis();
+
+        LOGF("[DISC] Spouštím discovery pro %u zásobníků "
+             "(skupiny po %u, max. %u × %u W)\n",
+            _numBoilers, _groupMax, CodedDiscovery::maxOnFor(_groupMax), _loadW);
         _drawFooterHint(t, "CENTER = přerušit");
+        if (!_nextGroup()) _codedDone(t, millis());
     }
 
     // ==========================================================
@@ -696,11 +972,13 @@ namespace DiscoveryScreen {
                         _drawConfirmDialog(t, d);
                     } else {
                         // Podmínky OK – spusť rovnou
+                        _gridOk = false;
                         _startMeasuring(t);
                     }
                 } else if (_phase == DISC_CONFIRM) {
                     // Uživatel potvrdil spuštění přes dialog
-                    _phase = DISC_IDLE;  // reset dialogu
+                    _phase  = DISC_IDLE;  // reset dialogu
+                    _gridOk = true;
                     _startMeasuring(t);
                 } else if (_phase == DISC_DONE || _phase == DISC_ABORTED) {
                     return SCREEN_UDP;
@@ -709,11 +987,11 @@ namespace DiscoveryScreen {
 
             case SW_LEFT:
                 if (_phase == DISC_MEASURING) {
-                    // Přeruš měření – rozepni relé
-                    if (_mcp) _mcp->setRelay(_current, false);
+                    // Přeruš měření – rozepni relé (kódované: celá skupina)
+                    if (_mcp) _allOff();
                     _phase = DISC_ABORTED;
                     _drawFooterHint(t, "Přerušeno.  LEFT = zpet");
-                    Serial.println("[DISC] Discovery přerušeno");
+                    LOGLN("[DISC] Discovery přerušeno");
                     return SCREEN_NONE;
                 }
                 // Jinak zpět
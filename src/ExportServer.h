@@ -0,0 +1,373 @@
+// =============================================================
+//  ExportServer.h – přenos exportu historie přes HTTP a USB
+//
+//  HTTP (port EXPORT_HTTP_PORT, AP i STA):
+//    GET /export?src=day&fmt=csv&from=20260101&to=20261231
+//    → Transfer-Encoding: chunked, Connection: close
+//
+//  USB sériová linka (příkaz ukončený '\n'):
+//    export day csv 20260101 20261231
+//    → řádek "#EXPORT ..." a pak stejné chunked rámce jako HTTP
+//      ("<hex délka>\r\n<data>\r\n" ... "0\r\n\r\n"), takže
+//      i binární data mají jasné hranice
+//
+//  Parametry:
+//    src   min | hour | day | month   (výchozí day)
+//    fmt   csv | bin                  (výchozí csv)
+//    from  RRRRMMDD, RRRRMMDDHHMM nebo sekundy od 2000 (výchozí 0)
+//    to    totéž, datum = včetně celého dne   (výchozí vše)
+//
+//  Vždy běží nejvýše jeden export (jeden HistoryExporter =
+//  jeden chunk v RAM). Druhý požadavek dostane 503 / "#BUSY".
+//  Zápis jen do volného místa výstupu (availableForWrite), takže
+//  loop() nikdy nečeká na pomalého klienta.
+//
+//  Vlákna: begin()/loop() POUZE z loop() (Core 0).
+//
+//  Použití:
+//    ExportServer::begin();      // v setup() po WiFi
+//    ExportServer::loop();       // v loop() každou iteraci
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include "HistoryExport.h"
+#include "Log.h"
+
+#define EXPORT_HTTP_PORT     80
+#define EXPORT_BUDGET_US     4000    // max. doba jednoho loop()
+#define EXPORT_REQ_TIMEOUT   3000    // čekání na řádek požadavku [ms]
+#define EXPORT_IDLE_TIMEOUT  30000   // klient nic nepřijímá [ms]
+
+namespace ExportServer {
+
+    // Kdo právě exportuje
+    enum : uint8_t {
+        OWNER_NONE   = 0,
+        OWNER_HTTP   = 1,
+        OWNER_SERIAL = 2,
+    };
+
+    static WiFiServer      _server(EXPORT_HTTP_PORT);
+    static bool            _listening = false;
+    static HistoryExporter _exp;
+    static uint8_t         _owner     = OWNER_NONE;
+    static volatile bool   _serialOn  = false;
+
+    // HTTP klient + řádek požadavku
+    static WiFiClient _client;
+    static bool       _clientOpen = false;
+    static uint32_t   _clientMs   = 0;
+    static char       _req[128];
+    static uint8_t    _reqLen     = 0;
+
+    // Sériový příkaz
+    static char    _cmd[64];
+    static uint8_t _cmdLen = 0;
+
+    // Rozpracovaný rámec: _pre + data chunku + "\r\n"
+    static char     _pre[160];
+    static uint16_t _preLen   = 0;
+    static uint16_t _dataLen  = 0;
+    static uint16_t _off      = 0;       // odesláno bajtů rámce
+    static bool     _inFrame  = false;
+    static bool     _final    = false;   // rámec "0\r\n\r\n"
+    static uint32_t _progress = 0;       // millis() posledního zápisu
+
+    // ---------------------------------------------------------
+    //  Parsování parametrů
+    // ---------------------------------------------------------
+    static bool _parseSource(const char* s, ExportSource& out) {
+        if      (!strcmp(s, "min"))   out = EXP_MINUTE;
+        else if (!strcmp(s, "hour"))  out = EXP_HOUR;
+        else if (!strcmp(s, "day"))   out = EXP_DAY;
+        else if (!strcmp(s, "month")) out = EXP_MONTH;
+        else return false;
+        return true;
+    }
+
+    static bool _parseFormat(const char* s, ExportFormat& out) {
+        if      (!strcmp(s, "csv")) out = EXP_CSV;
+        else if (!strcmp(s, "bin")) out = EXP_BIN;
+        else return false;
+        return true;
+    }
+
+    // RRRRMMDD[HHMM] nebo sekundy; isEnd → datum bez času = konec dne
+    static bool _parseTime(const char* s, bool isEnd, uint32_t& out) {
+        size_t n = strlen(s);
+        if (n == 0) return false;
+        for (size_t i = 0; i < n; i++) if (!isdigit((uint8_t)s[i])) return false;
+        if (n != 8 && n != 12) {
+            out = strtoul(s, nullptr, 10);
+            return true;
+        }
+        unsigned y, mo, d, h = 0, mi = 0;
+        if (n == 8) sscanf(s, "%4u%2u%2u", &y, &mo, &d);
+        else        sscanf(s, "%4u%2u%2u%2u%2u", &y, &mo, &d, &h, &mi);
+        if (y < 2000 || mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59)
+            return false;
+        DateTime dt = {};
+        dt.year = y; dt.month = mo; dt.day = d; dt.hour = h; dt.minute = mi;
+        out = dateTimeToSecs(dt);
+        if (isEnd) out += (n == 8) ? 86399UL : 59UL;
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Zahaj export – hdr = text před prvním rámcem
+    // ---------------------------------------------------------
+    static void _start(uint8_t owner, ExportSource src, ExportFormat fmt,
+                       uint32_t from, uint32_t to, const char* hdr) {
+        _exp.begin(src, fmt, from, to);
+        _owner    = owner;
+        _serialOn = (owner == OWNER_SERIAL);
+        _preLen   = snprintf(_pre, sizeof(_pre), "%s", hdr);
+        _dataLen  = 0;
+        _off      = 0;
+        _inFrame  = false;
+        _final    = false;
+        _progress = millis();
+        Serial.printf("[EXPORT] Start %s src=%u fmt=%u %lu..%lu\n",
+            owner == OWNER_HTTP ? "HTTP" : "USB", src, fmt,
+            (unsigned long)from, (unsigned long)to);
+        Log::muted = _serialOn;         // USB nese data – ostatní výpisy mlčí
+    }
+
+    static void _finish(bool ok) {
+        uint8_t owner = _owner;
+        _owner    = OWNER_NONE;
+        _serialOn = false;
+        Log::muted = false;
+        if (owner == OWNER_HTTP) {
+            _client.stop();
+            _clientOpen = false;
+        }
+        Serial.printf("[EXPORT] %s – %lu záznamů\n",
+            ok ? "Hotovo" : "Přerušeno", (unsigned long)_exp.rows());
+    }
+
+    // Zapiš část segmentu [base, base+len) rámce od _off
+    static bool _writeSeg(Print& out, const uint8_t* p, uint16_t len,
+                          uint16_t base, int& room) {
+        if (_off >= base + len) return true;
+        uint16_t from = _off - base;
+        uint16_t n    = len - from;
+        if ((int)n > room) n = room;
+        if (n == 0) return false;
+        n = out.write(p + from, n);
+        _off += n;
+        room -= n;
+        if (n) _progress = millis();
+        return _off >= base + len;
+    }
+
+    // ---------------------------------------------------------
+    //  Posílej rámce dokud je místo ve výstupu a čas v rozpočtu
+    //  Vrací true když je export kompletně odeslán.
+    // ---------------------------------------------------------
+    static bool _pump(Print& out, uint32_t start) {
+        while (micros() - start < EXPORT_BUDGET_US) {
+            if (!_inFrame) {
+                _dataLen = _exp.next();
+                int k = (_dataLen > 0)
+                    ? snprintf(_pre + _preLen, sizeof(_pre) - _preLen, "%X\r\n", _dataLen)
+                    : snprintf(_pre + _preLen, sizeof(_pre) - _preLen, "0\r\n\r\n");
+                _preLen += k;
+                _final   = (_dataLen == 0);
+                _off     = 0;
+                _inFrame = true;
+            }
+
+            int room = out.availableForWrite();
+            if (room <= 0) return false;
+
+            if (!_writeSeg(out, (const uint8_t*)_pre, _preLen, 0, room)) return false;
+            if (!_final) {
+                if (!_writeSeg(out, _exp.data(), _dataLen, _preLen, room)) return false;
+                if (!_writeSeg(out, (const uint8_t*)"\r\n", 2, _preLen + _dataLen, room))
+                    return false;
+            }
+
+            _inFrame = false;
+            _preLen  = 0;
+            if (_final) return true;
+        }
+        return false;
+    }
+
+    // ---------------------------------------------------------
+    //  HTTP – jednoduchá odpověď bez těla exportu
+    // ---------------------------------------------------------
+    static void _httpReply(const char* status, const char* text) {
+        _client.printf("HTTP/1.1 %s\r\nContent-Type: text/plain\r\n"
+                       "Connection: close\r\n\r\n%s\n", status, text);
+        _client.stop();
+        _clientOpen = false;
+    }
+
+    // "GET /export?src=..&fmt=.. HTTP/1.1" → zahaj export
+    static void _httpRequest() {
+        char* sp1 = strchr(_req, ' ');
+        if (strncmp(_req, "GET ", 4) != 0 || !sp1) {
+            _httpReply("405 Method Not Allowed", "jen GET");
+            return;
+        }
+        char* path = sp1 + 1;
+        char* sp2  = strchr(path, ' ');
+        if (sp2) *sp2 = '\0';
+        char* query = strchr(path, '?');
+        if (query) *query++ = '\0';
+        if (strcmp(path, "/export") != 0) {
+            _httpReply("404 Not Found", "GET /export?src=min|hour|day|month&fmt=csv|bin&from=&to=");
+            return;
+        }
+        if (_owner != OWNER_NONE) {
+            _httpReply("503 Service Unavailable", "export uz bezi");
+            return;
+        }
+
+        ExportSource src  = EXP_DAY;
+        ExportFormat fmt  = EXP_CSV;
+        uint32_t     from = 0, to = 0xFFFFFFFF;
+        bool         ok   = true;
+        char* save = nullptr;
+        for (char* kv = query ? strtok_r(query, "&", &save) : nullptr; kv;
+             kv = strtok_r(nullptr, "&", &save)) {
+            char* val = strchr(kv, '=');
+            if (!val) { ok = false; break; }
+            *val++ = '\0';
+            if      (!strcmp(kv, "src"))  ok = _parseSource(val, src);
+            else if (!strcmp(kv, "fmt"))  ok = _parseFormat(val, fmt);
+            else if (!strcmp(kv, "from")) ok = _parseTime(val, false, from);
+            else if (!strcmp(kv, "to"))   ok = _parseTime(val, true, to);
+            if (!ok) break;
+        }
+        if (!ok) {
+            _httpReply("400 Bad Request", "chybny parametr");
+            return;
+        }
+
+        char hdr[160];
+        snprintf(hdr, sizeof(hdr),
+            "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+            "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n",
+            fmt == EXP_CSV ? "text/csv" : "application/octet-stream");
+        _start(OWNER_HTTP, src, fmt, from, to, hdr);
+    }
+
+    static void _httpLoop(uint32_t start) {
+        if (!_clientOpen) {
+            if (!_listening) return;
+            _client = _server.accept();
+            if (!_client) return;
+            _clientOpen = true;
+            _clientMs   = millis();
+            _reqLen     = 0;
+        }
+
+        // Export běží – zbytek požadavku (hlavičky) zahoď
+        if (_owner == OWNER_HTTP) {
+            while (_client.available() > 0) _client.read();
+            if (!_client.connected() ||
+                millis() - _progress > EXPORT_IDLE_TIMEOUT) {
+                _finish(false);
+                return;
+            }
+            if (_pump(_client, start)) _finish(true);
+            return;
+        }
+
+        // Čti první řádek požadavku (neblokující)
+        while (_client.available() > 0) {
+            int c = _client.read();
+            if (c == '\r') continue;
+            if (c == '\n' || _reqLen >= sizeof(_req) - 1) {
+                _req[_reqLen] = '\0';
+                _httpRequest();
+                return;
+            }
+            _req[_reqLen++] = (char)c;
+        }
+        if (!_client.connected() || millis() - _clientMs > EXPORT_REQ_TIMEOUT) {
+            _client.stop();
+            _clientOpen = false;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  USB – příkaz "export <src> [fmt] [from] [to]"
+    // ---------------------------------------------------------
+    static void _serialCommand() {
+        char* save = nullptr;
+        char* tok  = strtok_r(_cmd, " ", &save);
+        if (!tok || strcmp(tok, "export") != 0) return;
+        if (_owner != OWNER_NONE) {
+            Serial.println("#BUSY");
+            return;
+        }
+
+        ExportSource src  = EXP_DAY;
+        ExportFormat fmt  = EXP_CSV;
+        uint32_t     from = 0, to = 0xFFFFFFFF;
+        bool ok = true;
+        if (ok && (tok = strtok_r(nullptr, " ", &save))) ok = _parseSource(tok, src);
+        if (ok && (tok = strtok_r(nullptr, " ", &save))) ok = _parseFormat(tok, fmt);
+        if (ok && (tok = strtok_r(nullptr, " ", &save))) ok = _parseTime(tok, false, from);
+        if (ok && (tok = strtok_r(nullptr, " ", &save))) ok = _parseTime(tok, true, to);
+        if (!ok) {
+            Serial.println("#ERR export <min|hour|day|month> [csv|bin] [from] [to]");
+            return;
+        }
+
+        char hdr[48];
+        snprintf(hdr, sizeof(hdr), "#EXPORT %u %s\r\n",
+                 src, fmt == EXP_CSV ? "csv" : "bin");
+        _start(OWNER_SERIAL, src, fmt, from, to, hdr);
+    }
+
+    static void _serialLoop(uint32_t start) {
+        if (_owner == OWNER_SERIAL) {
+            if (_pump(Serial, start)) _finish(true);
+            else if (millis() - _progress > EXPORT_IDLE_TIMEOUT) _finish(false);
+            return;
+        }
+        while (Serial.available() > 0) {
+            int c = Serial.read();
+            if (c == '\r') continue;
+            if (c == '\n' || _cmdLen >= sizeof(_cmd) - 1) {
+                _cmd[_cmdLen] = '\0';
+                _cmdLen = 0;
+                _serialCommand();
+                return;
+            }
+            _cmd[_cmdLen++] = (char)c;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Spusť HTTP server – volej v setup() po startu WiFi
+    // ---------------------------------------------------------
+    void begin() {
+        _server.begin();
+        _listening = true;
+        Serial.printf("[EXPORT] HTTP port %u, USB příkaz \"export\"\n", EXPORT_HTTP_PORT);
+    }
+
+    // ---------------------------------------------------------
+    //  Obsluha – volej z loop() každou iteraci
+    // ---------------------------------------------------------
+    void loop() {
+        uint32_t start = micros();
+        _httpLoop(start);
+        _serialLoop(start);
+    }
+
+    // true když USB linka nese export – ostatní výpisy mají mlčet
+    bool serialActive() { return _serialOn; }
+
+    // Probíhá export / otevřené spojení – loop() nemá dlouho spát
+    bool busy() { return _owner != OWNER_NONE || _clientOpen; }
+
+} // namespace ExportServer
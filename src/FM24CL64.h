@@ -19,22 +19,37 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <Wire.h>
 #include "HW_Config.h"
+#include "I2cBus.h"
 
 // FM24CL64: 8KB = 8192 bytů, jedna I2C adresa 0x50
 // 16-bitová adresa paměti – high byte první, pak low byte
+// Větší FRAM (FM24V02, 32KB) přepíše FRAM_SIZE v HW_Config.h
+#ifndef FRAM_SIZE
 #define FRAM_SIZE        8192
+#endif
 #define FRAM_CHUNK_SIZE  30    // Wire buffer = 32B, mínus 2B adresa
+#define FRAM_PROBE_ADDR  0x1FFE  // test zrcadlení adres (rezerva FramMap)
 
 class FM24CL64 {
 public:
     // ---------------------------------------------------------
     //  Inicializace – ověří přítomnost čipu testem zápisu/čtení
-    //  Test probíhá na poslední adrese paměti (0x1FFF),
+    //  Test probíhá na poslední adrese paměti (FRAM_SIZE − 1),
     //  původní hodnota je po testu obnovena.
+    //
+    //  Menší čip adresy nad svou velikostí tiše zrcadlí (FM24CL64
+    //  ignoruje horní bity) → test na konci paměti projde i tam,
+    //  kde by bloky od 0x2000 přepsaly bloky 0–5. Proto se
+    //  skutečná velikost ověří zápisem na adresu + 8/16 KB
+    //  a kontrolou, že se nezměnil bajt pod ní. Čip menší než
+    //  FRAM_SIZE = chyba (begin() vrací false).
     // ---------------------------------------------------------
     bool begin() {
+        _size = FRAM_SIZE;
+
         // Ověř přítomnost čipu na I2C sběrnici
         Wire.beginTransmission(ADDR_FM24CL64);
         if (Wire.endTransmission() != 0) {
@@ -57,15 +72,27 @@ public:
             return false;
         }
 
-        Serial.println("[FRAM] OK (8KB, I2C 0x50)");
+        // Skutečná velikost – zrcadlení adres
+        _size = _probeSize();
+        if (_size < FRAM_SIZE) {
+            Serial.printf("[FRAM] CHYBA: cip ma %luKB, mapa potrebuje %luKB (BOILER_MAX_COUNT)\n",
+                (unsigned long)(_size / 1024), (unsigned long)(FRAM_SIZE / 1024));
+            return false;
+        }
+
+        Serial.printf("[FRAM] OK (%luKB, I2C 0x50)\n", (unsigned long)(_size / 1024));
         return true;
     }
 
+    // Zjištěná velikost čipu [B] (po begin())
+    uint32_t size() const { return _size; }
+
     // ---------------------------------------------------------
     //  Zapiš jeden byte na adresu (0x0000–0x1FFF)
     // ---------------------------------------------------------
     void writeByte(uint16_t addr, uint8_t data) {
-        if (addr >= FRAM_SIZE) return;
+        if (addr >= _size) return;
+        I2cBus::Lock lock;
         Wire.beginTransmission(ADDR_FM24CL64);
         Wire.write((uint8_t)(addr >> 8));    // adresa high byte
         Wire.write((uint8_t)(addr & 0xFF));  // adresa low byte
@@ -77,7 +104,8 @@ public:
     //  Přečti jeden byte z adresy (0x0000–0x1FFF)
     // ---------------------------------------------------------
     uint8_t readByte(uint16_t addr) {
-        if (addr >= FRAM_SIZE) return 0xFF;
+        if (addr >= _size) return 0xFF;
+        I2cBus::Lock lock;
         Wire.beginTransmission(ADDR_FM24CL64);
         Wire.write((uint8_t)(addr >> 8));
         Wire.write((uint8_t)(addr & 0xFF));
@@ -87,20 +115,43 @@ public:
         return Wire.available() ? Wire.read() : 0xFF;
     }
 
+    // ---------------------------------------------------------
+    //  Burst zápis max FRAM_CHUNK_SIZE bajtů v jedné I2C transakci
+    //  Vrací false pokud čip neodpověděl (NACK / chyba sběrnice)
+    //  FRAM nemá stránkování ani zápisový cyklus – data jsou
+    //  zapsána hned po STOP, není potřeba čekat.
+    // ---------------------------------------------------------
+    bool writeChunk(uint16_t addr, const uint8_t* data, uint8_t len) {
+        if (len > FRAM_CHUNK_SIZE) len = FRAM_CHUNK_SIZE;
+        if (addr + len > _size) return false;
+        I2cBus::Lock lock;
+        Wire.beginTransmission(ADDR_FM24CL64);
+        Wire.write((uint8_t)(addr >> 8));
+        Wire.write((uint8_t)(addr & 0xFF));
+        Wire.write(data, len);
+        return Wire.endTransmission() == 0;
+    }
+
     // ---------------------------------------------------------
     //  Zapiš blok dat (libovolná struktura)
     //  Použití: gFRAM.writeBlock(0x0010, &config, sizeof(config));
     //
     //  FRAM podporuje sekvenční zápis bez omezení stránkování –
-    //  proto lze burst zapsat celý blok v jedné I2C transakci.
-    //  Limit je jen velikost Wire bufferu (~32B na Arduino/Pico).
-    //  Pro jednoduchost a univerzálnost používáme byte po bytu.
+    //  blok se zapisuje burstem po FRAM_CHUNK_SIZE bajtech
+    //  (limit Wire bufferu 32B minus 2B adresa).
+    //  Vrací false pokud některý chunk selhal.
     // ---------------------------------------------------------
-    void writeBlock(uint16_t addr, const void* data, uint16_t len) {
+    bool writeBlock(uint16_t addr, const void* data, uint16_t len) {
         const uint8_t* ptr = (const uint8_t*)data;
-        for (uint16_t i = 0; i < len; i++) {
-            writeByte(addr + i, ptr[i]);
+        bool ok = true;
+        while (len > 0) {
+            uint8_t chunk = (len > FRAM_CHUNK_SIZE) ? FRAM_CHUNK_SIZE : len;
+            ok &= writeChunk(addr, ptr, chunk);
+            addr += chunk;
+            ptr  += chunk;
+            len  -= chunk;
         }
+        return ok;
     }
 
     // ---------------------------------------------------------
@@ -122,8 +173,8 @@ public:
     //  Použití: gFRAM.eraseRegion(0x0010, 480);  // jen zásobníky
     // ---------------------------------------------------------
     void eraseRegion(uint16_t addr, uint16_t len) {
-        if (addr >= FRAM_SIZE) return;
-        if (addr + len > FRAM_SIZE) len = FRAM_SIZE - addr;  // ořízni za konec
+        if (addr >= _size) return;
+        if (addr + len > _size) len = _size - addr;          // ořízni za konec
 
         uint8_t blank[FRAM_CHUNK_SIZE];
         memset(blank, 0xFF, sizeof(blank));
@@ -133,6 +184,7 @@ public:
 
         while (remaining > 0) {
             uint16_t chunk = (remaining > FRAM_CHUNK_SIZE) ? FRAM_CHUNK_SIZE : remaining;
+            I2cBus::Lock lock;
             Wire.beginTransmission(ADDR_FM24CL64);
             Wire.write((uint8_t)(cur >> 8));
             Wire.write((uint8_t)(cur & 0xFF));
@@ -149,8 +201,27 @@ public:
     //  Burst zápis – 8KB za cca 150ms místo ~1500ms.
     // ---------------------------------------------------------
     void erase() {
-        Serial.print("[FRAM] Mazani pameti (8KB)...");
-        eraseRegion(0x0000, FRAM_SIZE);
-        Serial.println(" hotovo");
+        LOGF("[FRAM] Mazani pameti (%luKB)...", (unsigned long)(_size / 1024));
+        eraseRegion(0x0000, _size);
+        LOGLN(" hotovo");
+    }
+
+private:
+    uint32_t _size = FRAM_SIZE;     // zjištěná velikost (zápis/čtení za ní se ignoruje)
+
+    // Velikost čipu = první mocnina 2 (od 8 KB), kde se zápis na
+    // FRAM_PROBE_ADDR + size promítne na FRAM_PROBE_ADDR.
+    // Zkouší se jen do FRAM_SIZE – víc mapa nepoužívá.
+    uint32_t _probeSize() {
+        for (uint32_t sz = 8192; sz < FRAM_SIZE; sz <<= 1) {
+            uint16_t hi   = (uint16_t)(FRAM_PROBE_ADDR + sz);
+            uint8_t  low  = readByte(FRAM_PROBE_ADDR);
+            uint8_t  high = readByte(hi);
+            writeByte(hi, (uint8_t)~low);
+            bool alias = readByte(FRAM_PROBE_ADDR) != low;
+            writeByte(hi, alias ? low : high);      // obnov (alias = stejná buňka)
+            if (alias) return sz;
+        }
+        return FRAM_SIZE;
     }
 };
\ No newline at end of file
@@ -3,18 +3,45 @@
 //
 //  Piny: aktivní LOW s externími pull-up rezistory 10K
 //  Při stisku = GND (LOW), při uvolnění = VCC (HIGH)
+//
+//  Zachytávání v přerušení: každá hrana na kterémkoli pinu
+//  uloží do fronty snímek všech pinů + čas (millis). read()
+//  frontu vyhodnotí s časy z IRQ – stisk během blokující FRAM
+//  operace nebo NTP se neztratí, jen se zpracuje později.
+//  Bez attachIrq() (nebo po přetečení fronty) se stav dorovná
+//  čtením pinů, read() tedy funguje i čistě pollingem.
+//
+//  Události read():
+//    UP/DOWN/LEFT/RIGHT – při stisku, držení = auto-repeat
+//                         po SW_REPEAT_DELAY_MS, perioda se každých
+//                         SW_ACCEL_EVERY opakování zkrátí na půl
+//                         (min. SW_REPEAT_MIN_MS)
+//    CENTER             – při uvolnění (krátký stisk)
+//    CENTER_LONG        – po SW_LONG_MS držení, uvolnění pak nic
+//
+//  step() – násobič kroku pro editaci hodnot (1 / 5 / 10 podle
+//  délky auto-repeatu), screeny jím násobí krok UP/DOWN.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "HW_Config.h"
 
+#define SW_QUEUE_LEN        32      // hrany z IRQ (mocnina 2)
+#define SW_LONG_MS          800     // dlouhý stisk CENTER
+#define SW_REPEAT_DELAY_MS  400     // první auto-repeat
+#define SW_REPEAT_MS        160     // počáteční perioda auto-repeatu
+#define SW_REPEAT_MIN_MS    40
+#define SW_ACCEL_EVERY      8       // opakování na zrychlení
+
 enum SwButton : uint8_t {
-    SW_NONE   = 0,
-    SW_UP     = 1,
-    SW_DOWN   = 2,
-    SW_LEFT   = 3,
-    SW_RIGHT  = 4,
-    SW_CENTER = 5
+    SW_NONE        = 0,
+    SW_UP          = 1,
+    SW_DOWN        = 2,
+    SW_LEFT        = 3,
+    SW_RIGHT       = 4,
+    SW_CENTER      = 5,
+    SW_CENTER_LONG = 6
 };
 
 class FiveWaySwitch {
@@ -39,28 +66,48 @@ public:
     }
 
     // ---------------------------------------------------------
-    //  Čtení – volej z loop(), vrátí kód při novém stisku
+    //  Přerušení na obou hranách všech pinů – ISR uloží snímek
+    //  pinů do fronty a zavolá hook (UI ho použije jako budíček)
+    // ---------------------------------------------------------
+    void attachIrq(void (*hook)()) {
+        _self = this;
+        _hook = hook;
+        for (int i = 0; i < 5; i++) {
+            attachInterrupt(digitalPinToInterrupt(_pins[i]), _isr, CHANGE);
+        }
+    }
+
+    // Drží se právě nějaké tlačítko? (UI pak dál polluje read())
+    bool anyPressed() {
+        return _levels() != 0 || _downMask != 0;
+    }
+
+    // ---------------------------------------------------------
+    //  Čtení – vrátí jednu událost, volej dokud nevrátí SW_NONE
     // ---------------------------------------------------------
     SwButton read() {
+        SwButton btn;
+
+        // 1. Hrany z přerušení v pořadí, s jejich časy
+        while (_qTail != _qHead) {
+            SwEdge e = _q[_qTail];
+            _qTail = (_qTail + 1) & (SW_QUEUE_LEN - 1);
+            if ((btn = _apply(e.mask, e.ms)) != SW_NONE) return _log(btn);
+        }
+
+        // 2. Dorovnání podle pinů (bez IRQ, přetečení, zákmit)
         uint32_t now = millis();
+        if ((btn = _apply(_levels(), now)) != SW_NONE) return _log(btn);
 
-        for (int i = 0; i < 5; i++) {
-            bool pressed = (digitalRead(_pins[i]) == LOW);
-
-            if (pressed && !_lastState[i] &&
-                (now - _lastTime[i]) > SW_DEBOUNCE_MS) {
-                _lastTime[i]  = now;
-                _lastState[i] = true;
-                Serial.printf("[Switch] >>> %s stisknuto (GPIO%d=LOW)\n",
-                    name(_codes[i]), _pins[i]);
-                return _codes[i];
-            }
+        // 3. Držení – auto-repeat / dlouhý stisk
+        return _hold(now);
+    }
 
-            if (!pressed) {
-                _lastState[i] = false;
-            }
-        }
-        return SW_NONE;
+    // Násobič kroku pro poslední událost z read()
+    uint8_t step() const {
+        if (_stepRepeats < SW_ACCEL_EVERY)     return 1;
+        if (_stepRepeats < 2 * SW_ACCEL_EVERY) return 5;
+        return 10;
     }
 
     // ---------------------------------------------------------
@@ -80,7 +127,7 @@ public:
     //  Okamžitý stav pinu – pro debug z loop()
     // ---------------------------------------------------------
     void printPinStates() {
-        Serial.printf("[Switch] UP=%d DOWN=%d LEFT=%d RIGHT=%d CENTER=%d\n",
+        LOGF("[Switch] UP=%d DOWN=%d LEFT=%d RIGHT=%d CENTER=%d\n",
             digitalRead(PIN_SW_UP),
             digitalRead(PIN_SW_DOWN),
             digitalRead(PIN_SW_LEFT),
@@ -95,11 +142,20 @@ public:
             case SW_LEFT:   return "LEFT";
             case SW_RIGHT:  return "RIGHT";
             case SW_CENTER: return "CENTER";
+            case SW_CENTER_LONG: return "CENTER_LONG";
             default:        return "NONE";
         }
     }
 
 private:
+    struct SwEdge {
+        uint32_t ms;
+        uint8_t  mask;              // bit i = _pins[i] stisknut
+    };
+
+    static inline FiveWaySwitch* _self = nullptr;
+    static inline void (*_hook)()      = nullptr;
+
     const uint8_t _pins[5]   = {
         PIN_SW_UP, PIN_SW_DOWN, PIN_SW_LEFT, PIN_SW_RIGHT, PIN_SW_CENTER
     };
@@ -107,8 +163,104 @@ private:
         SW_UP, SW_DOWN, SW_LEFT, SW_RIGHT, SW_CENTER
     };
 
-    bool     _lastState[5] = {};
-    uint32_t _lastTime[5]  = {};
+    // Fronta hran – zapisuje jen ISR (_qHead), čte jen read() (_qTail)
+    SwEdge           _q[SW_QUEUE_LEN];
+    volatile uint8_t _qHead    = 0;
+    volatile uint8_t _qTail    = 0;
+
+    uint8_t  _downMask       = 0;       // po debounce
+    uint32_t _lastTime[5]    = {        // poslední přijatá hrana (start = mimo debounce)
+        0u - SW_DEBOUNCE_MS - 1, 0u - SW_DEBOUNCE_MS - 1, 0u - SW_DEBOUNCE_MS - 1,
+        0u - SW_DEBOUNCE_MS - 1, 0u - SW_DEBOUNCE_MS - 1
+    };
+    int8_t   _held           = -1;      // držené tlačítko (auto-repeat)
+    uint32_t _pressMs        = 0;
+    uint32_t _nextRepeat     = 0;
+    uint16_t _repeats        = 0;
+    uint16_t _stepRepeats    = 0;       // _repeats poslední události
+    bool     _longSent       = false;
+
+    uint8_t _levels() {
+        uint8_t m = 0;
+        for (int i = 0; i < 5; i++) {
+            if (digitalRead(_pins[i]) == LOW) m |= 1 << i;
+        }
+        return m;
+    }
+
+    // Hrana na pinu – snímek do fronty, plná fronta = dorovná read()
+    static void _isr() {
+        FiveWaySwitch* s = _self;
+        if (!s) return;
+        uint8_t next = (s->_qHead + 1) & (SW_QUEUE_LEN - 1);
+        if (next != s->_qTail) {
+            s->_q[s->_qHead].ms   = millis();
+            s->_q[s->_qHead].mask = s->_levels();
+            s->_qHead = next;
+        }
+        if (_hook) _hook();
+    }
+
+    // ---------------------------------------------------------
+    //  Nový stav pinů v čase ms → nejvýš jedna událost
+    //  Stisk platí hned, další hrana téhož pinu až po debounce
+    //  (zákmity; konečný stav dorovná polling v read()).
+    // ---------------------------------------------------------
+    SwButton _apply(uint8_t mask, uint32_t ms) {
+        for (int i = 0; i < 5; i++) {
+            bool low  = mask & (1 << i);
+            bool down = _downMask & (1 << i);
+            if (low == down) continue;
+            if (ms - _lastTime[i] <= SW_DEBOUNCE_MS) continue;
+            _lastTime[i] = ms;
+
+            if (low) {
+                _downMask   |= 1 << i;
+                _held        = i;
+                _pressMs     = ms;
+                _nextRepeat  = ms + SW_REPEAT_DELAY_MS;
+                _repeats     = 0;
+                _stepRepeats = 0;
+                _longSent    = false;
+                if (_codes[i] != SW_CENTER) return _codes[i];
+            } else {
+                _downMask &= ~(1 << i);
+                if (_held == i) _held = -1;
+                // CENTER až při uvolnění – pokud už nebyl dlouhý
+                if (_codes[i] == SW_CENTER && !_longSent) {
+                    _stepRepeats = 0;
+                    return SW_CENTER;
+                }
+            }
+        }
+        return SW_NONE;
+    }
+
+    // Držené tlačítko – dlouhý stisk CENTER, auto-repeat ostatních
+    SwButton _hold(uint32_t now) {
+        if (_held < 0 || !(_downMask & (1 << _held))) return SW_NONE;
+
+        if (_codes[_held] == SW_CENTER) {
+            if (_longSent || now - _pressMs < SW_LONG_MS) return SW_NONE;
+            _longSent = true;
+            return _log(SW_CENTER_LONG);
+        }
+
+        if ((int32_t)(now - _nextRepeat) < 0) return SW_NONE;
+        _repeats++;
+        uint8_t  shift  = min(_repeats / SW_ACCEL_EVERY, 4);
+        uint32_t period = max((uint32_t)SW_REPEAT_MS >> shift, (uint32_t)SW_REPEAT_MIN_MS);
+        // Po zablokované smyčce žádná dávka opakování – jen jedno
+        _nextRepeat  = (now - _nextRepeat > period) ? now + period : _nextRepeat + period;
+        _stepRepeats = _repeats;
+        return _codes[_held];
+    }
+
+    SwButton _log(SwButton btn) {
+        if (_repeats == 0 || btn == SW_CENTER_LONG)
+            LOGF("[Switch] >>> %s\n", name(btn));
+        return btn;
+    }
 };
 
-extern FiveWaySwitch gSwitch;
\ No newline at end of file
+extern FiveWaySwitch gSwitch;
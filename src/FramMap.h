@@ -3,6 +3,11 @@
 //
 //  FM24CL64: 8192 bajtů (0x0000–0x1FFF)
 //  Každý blok má fixní adresu, magic byte + verzi na začátku.
+//
+//  BOILER_MAX_COUNT > 10: bloky zásobníků (6, 7, 8, 9) se
+//  nevejdou na původní místa – leží za sebou od 0x2000 ve FRAM
+//  32 KB (FM24V02), velikost podle počtu zásobníků. Původní
+//  místa zůstanou nevyužitá, ostatní bloky se nehýbou.
 //  Přidání pole do bloku = zvýšit BLOCK_x_VERSION.
 //  Adresa dalšího bloku se NIKDY nemění.
 //
@@ -22,7 +27,9 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "FM24CL64.h"
+#include "BoilerConfig.h"
 
 // =============================================================
 //  Globální identifikace
@@ -34,34 +41,58 @@
 //  Adresy bloků – FIXNÍ, NIKDY NEMĚNIT!
 // =============================================================
 #define BLOCK_SYSTEM_ADDR     0x0000  // Blok 0: Systém (128B)
-#define BLOCK_WIFI_ADDR       0x0080  // Blok 1: WiFi + NTP (512B)
+#define BLOCK_WIFI_ADDR       0x0080  // Blok 1: WiFi + NTP (384B)
+#define BLOCK_SNAPSHOT_ADDR   0x0200  // Blok 12: Warm-start snapshot (128B, ve slacku bloku 1)
 #define BLOCK_MODBUS_ADDR     0x0280  // Blok 2: Modbus / Serial (128B)
 #define BLOCK_PLANT_ADDR      0x0300  // Blok 3: Elektrárna (128B)
 #define BLOCK_MQTT_ADDR       0x0380  // Blok 4: MQTT (128B)
 #define BLOCK_BOILSYS_ADDR    0x0400  // Blok 5: Boiler System (128B)
+#if BOILER_MAX_COUNT <= 10
 #define BLOCK_BOILCFG_ADDR    0x0480  // Blok 6: Boiler Config ×10 (512B)
 #define BLOCK_BOILRT_ADDR     0x0680  // Blok 7: Boiler Runtime ×10 (256B)
-#define BLOCK_PERSIST_ADDR    0x0780  // Blok 8: Řízení Persist (256B)
+#define BLOCK_PERSIST_ADDR    0x0780  // Blok 8: Řízení Persist (128B)
+#define BLOCK_RTCCAL_ADDR     0x0800  // Blok 14: Kalibrace RTC z NTP (128B, ve slacku bloku 8)
 #define BLOCK_DAYSTATS_ADDR   0x0880  // Blok 9: Boiler DayStats (1280B)
+#else
+#define BLOCK_BOILCFG_ADDR    0x2000                                        // Blok 6
+#define BLOCK_BOILRT_ADDR     (BLOCK_BOILCFG_ADDR  + BLOCK_BOILCFG_SIZE)    // Blok 7
+#define BLOCK_PERSIST_ADDR    (BLOCK_BOILRT_ADDR   + BLOCK_BOILRT_SIZE)     // Blok 8
+#define BLOCK_DAYSTATS_ADDR   (BLOCK_PERSIST_ADDR  + BLOCK_PERSIST_SIZE)    // Blok 9
+#define BLOCK_BOILER_END      (BLOCK_DAYSTATS_ADDR + BLOCK_DAYSTATS_SIZE)
+#define BLOCK_RTCCAL_ADDR     0x0800  // Blok 14 (0x0480–0x0D7F jinak volné)
+#endif
 #define BLOCK_SUMMARY_ADDR    0x0D80  // Blok 10: Day Summary (256B)
 #define BLOCK_SSR_ADDR        0x0E80  // Blok 11: SSR budoucnost (256B)
-// 0x0F80–0x1FFF = Rezerva (4224B)
+#define BLOCK_POWERLOG_ADDR   0x0F80  // Blok 13: Minutový log výkonů (4222B, rámce – viz PowerLog.h)
+// 0x1FFE = test zrcadlení adres, 0x1FFF = test bajt FM24CL64::begin u 8KB
 
 // =============================================================
 //  Velikosti bloků
 // =============================================================
 #define BLOCK_SYSTEM_SIZE     128
-#define BLOCK_WIFI_SIZE       512
+#define BLOCK_WIFI_SIZE       384
 #define BLOCK_MODBUS_SIZE     128
 #define BLOCK_PLANT_SIZE      128
 #define BLOCK_MQTT_SIZE       128
 #define BLOCK_BOILSYS_SIZE    128
+#if BOILER_MAX_COUNT <= 10
 #define BLOCK_BOILCFG_SIZE    512
 #define BLOCK_BOILRT_SIZE     256
-#define BLOCK_PERSIST_SIZE    256
+#define BLOCK_PERSIST_SIZE    128
 #define BLOCK_DAYSTATS_SIZE   1280
+#else
+// Hlavička + data, zaokrouhleno na 128B
+#define FRAM_ROUND(n)         ((((n) + 127) / 128) * 128)
+#define BLOCK_BOILCFG_SIZE    FRAM_ROUND(2 + sizeof(BoilerConfig) * BOILER_MAX_COUNT)
+#define BLOCK_BOILRT_SIZE     FRAM_ROUND(2 + sizeof(FramBoilerRt) * BOILER_MAX_COUNT)
+#define BLOCK_PERSIST_SIZE    FRAM_ROUND(2 + sizeof(FramPersist))
+#define BLOCK_DAYSTATS_SIZE   FRAM_ROUND(2 + sizeof(BoilerDayStats) * BOILER_STATS_DAYS * BOILER_MAX_COUNT)
+#endif
 #define BLOCK_SUMMARY_SIZE    256
 #define BLOCK_SSR_SIZE        256
+#define BLOCK_SNAPSHOT_SIZE   128
+#define BLOCK_POWERLOG_SIZE   (FRAM_PROBE_ADDR - BLOCK_POWERLOG_ADDR)   // 2B hlavička + 17 rámců × 248B
+#define BLOCK_RTCCAL_SIZE     128
 
 // =============================================================
 //  Verze bloků – zvýšit při přidání pole do struktury
@@ -71,13 +102,16 @@
 #define BLOCK_MODBUS_VER      1
 #define BLOCK_PLANT_VER       1
 #define BLOCK_MQTT_VER        1
-#define BLOCK_BOILSYS_VER     1
-#define BLOCK_BOILCFG_VER     1
+#define BLOCK_BOILSYS_VER     4
+#define BLOCK_BOILCFG_VER     2
 #define BLOCK_BOILRT_VER      1
 #define BLOCK_PERSIST_VER     1
 #define BLOCK_DAYSTATS_VER    1
 #define BLOCK_SUMMARY_VER     1
 #define BLOCK_SSR_VER         1
+#define BLOCK_SNAPSHOT_VER    2     // v2: přesun 0x0F80 → 0x0200
+#define BLOCK_POWERLOG_VER    2     // v2: Rice kód, 248B rámce od 0x0F82
+#define BLOCK_RTCCAL_VER      2     // v2: přesun 0x1F00 → 0x0800
 
 // =============================================================
 //  Hlavička bloku – prvních 2 bajty každého bloku
@@ -171,11 +205,23 @@ struct FramMqtt {
 // Používá přímo BoilerSystem struct z BoilerConfig.h
 // (mapování přes FramBlock helper funkce)
 
-// --- Blok 6: Boiler Config ×10 ---
-// Používá přímo BoilerConfig[10] z BoilerConfig.h (48B × 10)
-
-// --- Blok 7: Boiler Runtime ×10 ---
-// Používá přímo BoilerRuntime[10] z BoilerConfig.h
+// --- Blok 6: Boiler Config ×BOILER_MAX_COUNT ---
+// Používá přímo BoilerConfig[BOILER_MAX_COUNT] z BoilerConfig.h (48B × N)
+
+// --- Blok 7: Boiler Runtime ×BOILER_MAX_COUNT ---
+// BoilerRuntime drží časy v millis() – do FRAM jdou jako RTC
+// sekundy od 2000 (po restartu se přepočtou na nové millis()).
+// Pack/unpack viz BoilerController::exportRuntime/importRuntime.
+struct FramBoilerRt {
+    uint8_t  state;              // BoilerState
+    uint8_t  recheckIndex;
+    uint8_t  slotFull;
+    uint8_t  energyHWh;          // dodáno dnes [100 Wh] (denní cíl), max 25.5 kWh
+    uint32_t lastHeatedAt;       // [s od 2000], 0 = nikdy
+    uint32_t lastOffAt;          // [s od 2000], 0 = nikdy
+    uint32_t stateEnteredAt;     // [s od 2000]
+    uint32_t recheckDueAt;       // [s od 2000], 0 = neplánováno
+};
 
 // --- Blok 8: Řízení Persist ---
 struct FramPersist {
@@ -185,9 +231,9 @@ struct FramPersist {
     uint8_t  lastHdoState;
     uint32_t lastHdoActiveAt;
     // Denní akumulátory per zásobník
-    uint16_t accumSolarWh[10];
-    uint16_t accumGridWh[10];
-    uint8_t  accumSwitchCnt[10];
+    uint16_t accumSolarWh[BOILER_MAX_COUNT];
+    uint16_t accumGridWh[BOILER_MAX_COUNT];
+    uint8_t  accumSwitchCnt[BOILER_MAX_COUNT];
     // Denní akumulátory elektrárna
     uint16_t accumPvWh;
     uint16_t accumLoadWh;
@@ -202,11 +248,82 @@ struct FramPersist {
 };
 
 // --- Blok 9: Boiler DayStats ---
-// Používá přímo BoilerDayStats[14][10] z BoilerConfig.h (8B × 140)
+// Používá přímo BoilerDayStats[14][BOILER_MAX_COUNT] z BoilerConfig.h (8B × 14N)
+
+// Bloky zásobníků se musí vejít do svých míst (hlavička 2B + data)
+static_assert(sizeof(FramBoilerRt) == 20, "FramBoilerRt must be 20 bytes");
+static_assert(2 + sizeof(BoilerConfig) * BOILER_MAX_COUNT <= BLOCK_BOILCFG_SIZE,
+              "Boiler Config se nevejde do bloku 6");
+static_assert(2 + sizeof(FramBoilerRt) * BOILER_MAX_COUNT <= BLOCK_BOILRT_SIZE,
+              "Boiler Runtime se nevejde do bloku 7");
+static_assert(2 + sizeof(FramPersist) <= BLOCK_PERSIST_SIZE,
+              "FramPersist se nevejde do bloku 8");
+static_assert(2 + sizeof(BoilerDayStats) * BOILER_STATS_DAYS * BOILER_MAX_COUNT <= BLOCK_DAYSTATS_SIZE,
+              "DayStats se nevejdou do bloku 9");
+#if BOILER_MAX_COUNT > 10
+static_assert(BLOCK_BOILER_END <= FRAM_SIZE,
+              "Bloky zásobníků přesahují FRAM – zvětši FRAM_SIZE");
+#endif
 
 // --- Blok 10: Day Summary ---
 // Používá přímo DaySummary[7] z HistoryScreen.h (16B × 7)
 
+// --- Blok 12: Warm-start snapshot ---
+// Poslední známé hodnoty pro MainScreen hned po startu (viz WarmStart.h)
+struct FramSnapshot {
+    uint32_t savedAt;            // [s od 2000], 0 = čas neznámý
+    int32_t  powerPV;
+    int32_t  powerLoad;
+    int32_t  powerBattery;
+    int32_t  powerGrid;
+    int32_t  phaseL1;
+    int32_t  phaseL2;
+    int32_t  phaseL3;
+    uint16_t soc;
+    uint16_t soh;
+    uint32_t energyPvToday;
+    uint32_t energyGridToday;
+    uint32_t energySoldToday;
+    uint16_t invStatus;
+    uint8_t  screen;             // poslední screen (Screen)
+    uint8_t  reserved;
+};
+
+// --- Blok 14: Kalibrace RTC ---
+// Chyba RTC proti NTP z po sobě jdoucích syncú (viz RtcCalibration.h)
+#define RTC_CAL_POINTS  8
+
+struct FramRtcCalPoint {
+    uint32_t elapsedS;           // délka intervalu mezi NTP zápisy RTC [s]
+    int32_t  errMs;              // RTC – NTP na konci intervalu [ms]
+    int8_t   offset;             // kalibrační offset platný v intervalu
+    uint8_t  reserved[3];
+};
+
+struct FramRtcCal {
+    uint32_t lastSetAt;          // poslední NTP zápis RTC [s od 2000], 0 = neznámý
+    int8_t   offset;             // offset platný od lastSetAt
+    uint8_t  count;              // platných bodů
+    uint8_t  head;               // index dalšího zápisu (kruhově)
+    uint8_t  reserved;
+    FramRtcCalPoint pts[RTC_CAL_POINTS];
+};
+
+// Bloky 12 a 14 leží ve slacku bloků 1 a 8 – nesmí se překrýt
+static_assert(2 + sizeof(FramWifi) <= BLOCK_WIFI_SIZE &&
+              BLOCK_WIFI_ADDR + BLOCK_WIFI_SIZE <= BLOCK_SNAPSHOT_ADDR,
+              "FramWifi zasahuje do bloku 12");
+static_assert(2 + sizeof(FramSnapshot) <= BLOCK_SNAPSHOT_SIZE &&
+              BLOCK_SNAPSHOT_ADDR + BLOCK_SNAPSHOT_SIZE <= BLOCK_MODBUS_ADDR,
+              "FramSnapshot se nevejde do bloku 12");
+static_assert(2 + sizeof(FramRtcCal) <= BLOCK_RTCCAL_SIZE,
+              "FramRtcCal se nevejde do bloku 14");
+#if BOILER_MAX_COUNT <= 10
+static_assert(BLOCK_PERSIST_ADDR + BLOCK_PERSIST_SIZE <= BLOCK_RTCCAL_ADDR &&
+              BLOCK_RTCCAL_ADDR + BLOCK_RTCCAL_SIZE <= BLOCK_DAYSTATS_ADDR,
+              "Blok 14 se překrývá s bloky 8 / 9");
+#endif
+
 // =============================================================
 //  Helper funkce pro čtení/zápis bloků
 // =============================================================
@@ -237,13 +354,13 @@ namespace FramBlock {
         fram.readBlock(blockAddr, &hdr, sizeof(hdr));
 
         if (hdr.magic != FRAM_BLOCK_MAGIC) {
-            Serial.printf("[FRAM] Blok 0x%04X: magic nesedí (0x%02X)\n",
+            LOGF("[FRAM] Blok 0x%04X: magic nesedí (0x%02X)\n",
                 blockAddr, hdr.magic);
             return false;
         }
 
         if (hdr.version != expectedVersion) {
-            Serial.printf("[FRAM] Blok 0x%04X: verze %u, očekávána %u\n",
+            LOGF("[FRAM] Blok 0x%04X: verze %u, očekávána %u\n",
                 blockAddr, hdr.version, expectedVersion);
             // Stará verze – načteme co můžeme, zbytek zůstane defaults
             // Data mohou být kratší – čteme min(uložená, očekávaná)
@@ -254,29 +371,49 @@ namespace FramBlock {
         // Přečti data za hlavičkou
         fram.readBlock(blockAddr + sizeof(FramBlockHeader), data, dataSize);
 
-        Serial.printf("[FRAM] Blok 0x%04X: načteno OK (v%u, %uB)\n",
+        LOGF("[FRAM] Blok 0x%04X: načteno OK (v%u, %uB)\n",
             blockAddr, hdr.version, dataSize);
         return true;
     }
 
+    // ---------------------------------------------------------
+    //  Verze uloženého bloku (0 = neplatný magic)
+    //  Pro migraci: starší verzi přečte volající sám přes
+    //  fram.readBlock(blockAddr + 2, …) a doplní nová pole.
+    // ---------------------------------------------------------
+    uint8_t version(FM24CL64& fram, uint16_t blockAddr) {
+        FramBlockHeader hdr;
+        fram.readBlock(blockAddr, &hdr, sizeof(hdr));
+        return hdr.magic == FRAM_BLOCK_MAGIC ? hdr.version : 0;
+    }
+
     // ---------------------------------------------------------
     //  Zapiš blok do FRAM
     //  Nejdřív data, pak hlavičku (magic jako poslední = potvrzení)
+    //  Vrací false pokud FRAM některý zápis nepotvrdila
     // ---------------------------------------------------------
-    void writeBlock(FM24CL64& fram, uint16_t blockAddr,
+    bool writeBlock(FM24CL64& fram, uint16_t blockAddr,
                     uint8_t version,
                     const void* data, uint16_t dataSize) {
 
         // Nejdřív zapiš data (za hlavičku)
-        fram.writeBlock(blockAddr + sizeof(FramBlockHeader), data, dataSize);
+        bool ok = fram.writeBlock(blockAddr + sizeof(FramBlockHeader), data, dataSize);
 
         // Pak hlavičku – magic jako poslední bajt
         // (pokud se přeruší zápis, magic bude starý/neplatný)
-        fram.writeByte(blockAddr + 1, version);
-        fram.writeByte(blockAddr, FRAM_BLOCK_MAGIC);
-
-        Serial.printf("[FRAM] Blok 0x%04X: uloženo (v%u, %uB)\n",
-            blockAddr, version, dataSize);
+        // Po chybě dat se hlavička nepřepisuje – volající dostane false
+        uint8_t magic = FRAM_BLOCK_MAGIC;
+        ok = ok && fram.writeChunk(blockAddr + 1, &version, 1);
+        ok = ok && fram.writeChunk(blockAddr, &magic, 1);
+
+        if (ok) {
+            LOGF("[FRAM] Blok 0x%04X: uloženo (v%u, %uB)\n",
+                blockAddr, version, dataSize);
+        } else {
+            LOGF("[FRAM] Blok 0x%04X: CHYBA zápisu (v%u, %uB)\n",
+                blockAddr, version, dataSize);
+        }
+        return ok;
     }
 
     // ---------------------------------------------------------
@@ -285,14 +422,14 @@ namespace FramBlock {
     // ---------------------------------------------------------
     void invalidateBlock(FM24CL64& fram, uint16_t blockAddr) {
         fram.writeByte(blockAddr, 0xFF);
-        Serial.printf("[FRAM] Blok 0x%04X: invalidován\n", blockAddr);
+        LOGF("[FRAM] Blok 0x%04X: invalidován\n", blockAddr);
     }
 
     // ---------------------------------------------------------
     //  Factory reset – vymaž celou FRAM a zapiš globální magic
     // ---------------------------------------------------------
     void factoryReset(FM24CL64& fram) {
-        Serial.println("[FRAM] Factory reset...");
+        LOGLN("[FRAM] Factory reset...");
         fram.erase();
         // Globální magic se zapíše až po uložení defaults
         // (volající musí zavolat saveAll + pak zapsat magic)
@@ -0,0 +1,232 @@
+// =============================================================
+//  FramWriter.h – neblokující zápis bloků do FRAM z UI
+//
+//  Problém: ConfigManager::saveBlockXxx() volané z handleInput()
+//  zapisuje celý blok synchronně → UI smyčka stojí, switch
+//  nereaguje a watchdog se neobnovuje.
+//
+//  Řešení: submit() jen zkopíruje data bloku do staging bufferu
+//  a hned se vrátí. pump() (volá uiLoop každou iteraci) pak
+//  zapisuje burstem po FRAM_CHUNK_SIZE bajtech s časovým
+//  rozpočtem FRAMW_BUDGET_US na jedno volání.
+//
+//  Pořadí zápisu bloku (rule 2 z FramMap.h – magic POSLEDNÍ):
+//    1. magic = 0xFF   (blok neplatný po dobu zápisu)
+//    2. data           (po chunkách)
+//    3. verze
+//    4. magic = 0xAC   (potvrzení)
+//  Přerušený zápis (reset) → blok se při startu načte jako
+//  neplatný → defaults, nikdy ne směs starých a nových dat.
+//
+//  Slučování: opakovaný submit() stejného bloku (např. rychlé
+//  UP/DN na hodnotě) jen přepíše staging buffer. Pokud zápis
+//  bloku už běží, začne znovu od kroku 1 s novými daty.
+//
+//  Callback: volá se z pump() = z UI vlákna → může kreslit.
+//  Při sloučení se volá jen callback posledního submit().
+//
+//  Vlákna: submit()/pump()/flush() POUZE z UI smyčky (Core 0).
+//
+//  Použití:
+//    FramWriter::submit(BLOCK_WIFI_ADDR, BLOCK_WIFI_VER, &f, sizeof(f));
+//    ...
+//    FramWriter::pump();          // v uiLoop()
+//    FramWriter::flush(1000);     // před restartem
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include "FM24CL64.h"
+#include "FramMap.h"
+
+#define FRAMW_SLOTS        8       // max. současně čekajících bloků
+// Největší blok bez hlavičky – 510B, s víc než 10 zásobníky
+// může být větší Boiler Config (blok 6)
+#define FRAMW_BUF_MAX      (BLOCK_BOILCFG_SIZE - 2 > 510 ? BLOCK_BOILCFG_SIZE - 2 : 510)
+#define FRAMW_BUDGET_US    1500    // max. doba zápisu v jednom pump()
+#define FRAMW_RETRIES      3       // opakování chunku při chybě I2C
+
+// Stav pro indikátor "ukládám / uloženo"
+enum FramWriteState : uint8_t {
+    FRAMW_IDLE  = 0,
+    FRAMW_BUSY  = 1,    // něco čeká nebo se zapisuje
+    FRAMW_DONE  = 2,    // poslední blok zapsán OK
+    FRAMW_ERROR = 3,    // poslední blok se nepodařilo zapsat
+};
+
+// Callback po dokončení – blockAddr = adresa bloku, ok = zápis OK
+typedef void (*FramWriteCb)(uint16_t blockAddr, bool ok);
+
+extern FM24CL64 gFRAM;
+
+namespace FramWriter {
+
+    // Fáze zápisu jednoho bloku
+    enum : uint8_t {
+        PH_INVALIDATE = 0,
+        PH_DATA       = 1,
+        PH_VERSION    = 2,
+        PH_MAGIC      = 3,
+        PH_DONE       = 4,
+    };
+
+    struct Slot {
+        bool        used;
+        uint8_t     phase;
+        uint8_t     version;
+        uint8_t     retries;
+        uint16_t    addr;       // adresa bloku (hlavička)
+        uint16_t    len;        // délka dat bez hlavičky
+        uint16_t    pos;        // zapsáno bajtů dat
+        uint32_t    seq;        // pořadí submit() – FIFO
+        FramWriteCb cb;
+        uint8_t     buf[FRAMW_BUF_MAX];
+    };
+
+    static Slot           _slots[FRAMW_SLOTS] = {};
+    static uint32_t       _seq        = 0;
+    static int8_t         _active     = -1;    // slot který se právě zapisuje
+    static FramWriteState _lastResult = FRAMW_IDLE;
+    static uint32_t       _lastDoneMs = 0;
+
+    static int8_t _findSlot(uint16_t addr) {
+        for (uint8_t i = 0; i < FRAMW_SLOTS; i++)
+            if (_slots[i].used && _slots[i].addr == addr) return i;
+        return -1;
+    }
+
+    static int8_t _oldestSlot() {
+        int8_t best = -1;
+        for (uint8_t i = 0; i < FRAMW_SLOTS; i++) {
+            if (!_slots[i].used) continue;
+            if (best < 0 || (int32_t)(_slots[i].seq - _slots[best].seq) < 0) best = i;
+        }
+        return best;
+    }
+
+    static void _finish(int8_t idx, bool ok) {
+        Slot& s = _slots[idx];
+        LOGF("[FRAMW] Blok 0x%04X: %s (%uB)\n",
+            s.addr, ok ? "uloženo" : "CHYBA zápisu", s.len);
+        FramWriteCb cb   = s.cb;
+        uint16_t    addr = s.addr;
+        s.used      = false;
+        _active     = -1;
+        _lastResult = ok ? FRAMW_DONE : FRAMW_ERROR;
+        _lastDoneMs = millis();
+        if (cb) cb(addr, ok);
+    }
+
+    // Jeden krok zápisu aktivního slotu – vrací false při chybě I2C
+    static bool _step(Slot& s) {
+        switch (s.phase) {
+            case PH_INVALIDATE: {
+                uint8_t b = 0xFF;
+                if (!gFRAM.writeChunk(s.addr, &b, 1)) return false;
+                s.pos   = 0;
+                s.phase = PH_DATA;
+                return true;
+            }
+            case PH_DATA: {
+                uint16_t rem   = s.len - s.pos;
+                uint8_t  chunk = rem > FRAM_CHUNK_SIZE ? FRAM_CHUNK_SIZE : rem;
+                if (chunk > 0 &&
+                    !gFRAM.writeChunk(s.addr + sizeof(FramBlockHeader) + s.pos,
+                                      &s.buf[s.pos], chunk)) return false;
+                s.pos += chunk;
+                if (s.pos >= s.len) s.phase = PH_VERSION;
+                return true;
+            }
+            case PH_VERSION:
+                if (!gFRAM.writeChunk(s.addr + 1, &s.version, 1)) return false;
+                s.phase = PH_MAGIC;
+                return true;
+            default: {
+                uint8_t m = FRAM_BLOCK_MAGIC;
+                if (!gFRAM.writeChunk(s.addr, &m, 1)) return false;
+                s.phase = PH_DONE;
+                return true;
+            }
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Zařaď blok k zápisu – vrací se okamžitě
+    //  Vrací false pokud je fronta plná nebo blok moc velký
+    //  (volající pak může použít synchronní FramBlock::writeBlock)
+    // ---------------------------------------------------------
+    bool submit(uint16_t blockAddr, uint8_t version,
+                const void* data, uint16_t len, FramWriteCb cb = nullptr) {
+        if (len > FRAMW_BUF_MAX) return false;
+
+        int8_t idx = _findSlot(blockAddr);
+        if (idx < 0) {
+            for (uint8_t i = 0; i < FRAMW_SLOTS; i++)
+                if (!_slots[i].used) { idx = i; break; }
+            if (idx < 0) {
+                LOGF("[FRAMW] Fronta plná – blok 0x%04X\n", blockAddr);
+                return false;
+            }
+            _slots[idx].seq = _seq++;
+        }
+
+        Slot& s = _slots[idx];
+        memcpy(s.buf, data, len);
+        s.used    = true;
+        s.addr    = blockAddr;
+        s.version = version;
+        s.len     = len;
+        s.cb      = cb;
+        s.phase   = PH_INVALIDATE;   // sloučení = zapiš znovu od začátku
+        s.pos     = 0;
+        s.retries = 0;
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Proveď část zápisu – volej z uiLoop() každou iteraci
+    //  Nejvýše FRAMW_BUDGET_US [µs] na jedno volání.
+    // ---------------------------------------------------------
+    void pump() {
+        uint32_t start = micros();
+        do {
+            if (_active < 0) {
+                _active = _oldestSlot();
+                if (_active < 0) return;
+            }
+            Slot& s = _slots[_active];
+
+            if (!_step(s)) {
+                if (++s.retries >= FRAMW_RETRIES) {
+                    _finish(_active, false);
+                }
+                return;     // při chybě nepokračuj v tomto volání
+            }
+            s.retries = 0;
+            if (s.phase == PH_DONE) _finish(_active, true);
+        } while (micros() - start < FRAMW_BUDGET_US);
+    }
+
+    // ---------------------------------------------------------
+    //  Stav pro indikátor
+    // ---------------------------------------------------------
+    bool busy() { return _oldestSlot() >= 0; }
+
+    // BUSY dokud něco čeká, jinak výsledek posledního bloku
+    FramWriteState state()      { return busy() ? FRAMW_BUSY : _lastResult; }
+    uint32_t       lastDoneMs() { return _lastDoneMs; }
+
+    // ---------------------------------------------------------
+    //  Dokonči všechny čekající zápisy (blokující)
+    //  Volej před watchdog_reboot() – jinak se změny ztratí.
+    //  Vrací true pokud je fronta prázdná.
+    // ---------------------------------------------------------
+    bool flush(uint32_t timeoutMs) {
+        uint32_t start = millis();
+        while (busy() && millis() - start < timeoutMs) {
+            pump();
+        }
+        return !busy();
+    }
+
+} // namespace FramWriter
@@ -10,7 +10,7 @@
 #define I2C_FREQ            400000      // 400 kHz – Fast Mode
 
 // I2C adresy čipů
-#define ADDR_MCP23017       0x20        // GPIO expander (A0-A2 = GND)
+#define ADDR_MCP23017       0x20        // GPIO expander (A0-A2 = GND), další desky 0x21–0x27
 #define ADDR_FM24CL64       0x50        // FRAM 8KB (pevná adresa)
 #define ADDR_PCF85063A      0x51        // RTC
 
@@ -56,11 +56,13 @@ enum InverterTransport : uint8_t {
 #define PULSES_PER_KWH      1000        // impulzů na kWh
 
 // ── MCP23017 – přiřazení výstupů ─────────────────────────────
-// GPA0–GPA7  = Relé 1–8   (zásobníky bytů 1–8, přes ULN2003)
-// GPB0–GPB1  = Relé 9–10  (zásobníky bytů 9–10, přes ULN2003)
+// Každá deska relé = jeden MCP23017, deska k na adrese 0x20 + k:
+// GPA0–GPA7  = Relé 1–8   (zásobníky 10k+1 … 10k+8, přes ULN2003)
+// GPB0–GPB1  = Relé 9–10  (zásobníky 10k+9, 10k+10, přes ULN2003)
 // GPB2–GPB6  = volné
-// GPB7       = RS485 DE/RE
-#define MCP_RELAY_COUNT     10          // max. počet relé (= max. zásobníků)
+// GPB7       = RS485 DE/RE (jen deska 0)
+#define MCP_RELAYS_PER_CHIP 10          // relé na jednom expanderu
+#define MCP_CHIP_COUNT      ((BOILER_MAX_COUNT + MCP_RELAYS_PER_CHIP - 1) / MCP_RELAYS_PER_CHIP)
 #define MCP_PIN_RS485_DERE  15          // MCP GPB7
 
 // ── HDO – Hromadné Dálkové Ovládání ──────────────────────────
@@ -76,9 +78,18 @@ enum InverterTransport : uint8_t {
                                         // (signál distribuce může krátce překmitat)
 
 // ── BoilerController – konstanty ─────────────────────────────
-// Maximální počet zásobníků v systému
-// Fyzicky omezeno počtem relé na MCP23017 (10)
+// Maximální počet zásobníků v systému – jediná konstanta, od které
+// se odvozuje počet desek MCP23017, pole relé v SolarData, lišta
+// relé v Header a bloky zásobníků v FRAM (FramMap.h).
+// Nad 10 zásobníků: další desky relé (0x21–0x27) a FRAM 32 KB
+// (FM24V02 – stejný protokol, bloky zásobníků leží za 8 KB).
+// Max. 64 (bitové masky BoilerController).
+#ifndef BOILER_MAX_COUNT
 #define BOILER_MAX_COUNT    10
+#endif
+#if BOILER_MAX_COUNT > 10 && !defined(FRAM_SIZE)
+#define FRAM_SIZE           32768
+#endif
 
 // Interval volání BoilerController::tick() [ms]
 // Synchronizováno s Modbus poll intervalem
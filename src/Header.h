@@ -7,9 +7,13 @@
 //  Záhlaví: čas | ●AP ●STA ●INV | ⚠
 //  Spodní:  indikátory výstupů relé (jen aktivní zásobníky)
 //
+//  Při ukládání do FRAM (FramWriter) překryje pravou část
+//  záhlaví (INV + alarm) štítek "ukladam" / "ulozeno" / "chyba".
+//
 //  Použití:
 //    Header::draw(theme, data);    // první vykreslení
-//    Header::update(theme, data);  // aktualizace (každou sekundu)
+//    Header::update(theme, data);  // aktualizace – kreslí jen změny
+//    Header::updateSaveBadge(theme); // každá iterace uiLoop
 // =============================================================
 #pragma once
 #include <Arduino.h>
@@ -18,6 +22,7 @@
 #include "Theme.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
+#include "FramWriter.h"
 
 // Rozměry záhlaví a spodní lišty
 #define HDR_H       26      // výška záhlaví [px]
@@ -41,6 +46,13 @@
 #define FTR_BOX_W   16
 #define FTR_BOX_H   14
 #define FTR_BOX_GAP 3       // mezera mezi kostičkami
+#define FTR_ROW_W   312     // max. šířka řady kostiček (okraj 4px)
+
+// Štítek ukládání – překrývá INV puntík a alarm
+#define SAVE_BADGE_X     226
+#define SAVE_BADGE_W     (320 - SAVE_BADGE_X)
+#define SAVE_DONE_MS     1500    // jak dlouho svítí "ulozeno"
+#define SAVE_ERROR_MS    4000    // jak dlouho svítí "chyba"
 
 extern Config gConfig;
 
@@ -51,10 +63,21 @@ namespace Header {
     static bool     _alarmVisible = true;
 
     // Cache stavu relé pro updateFooter
-    static bool _lastRelayOn[10]      = {};
-    static bool _lastRelayHeating[10] = {};
+    static bool _lastRelayOn[BOILER_MAX_COUNT]      = {};
+    static bool _lastRelayHeating[BOILER_MAX_COUNT] = {};
     static uint8_t _lastNumBoilers    = 0;
 
+    // Štítek ukládání – zobrazený stav + stav INV pro obnovu
+    static uint8_t _saveShown    = FRAMW_IDLE;
+    static uint8_t _lastInvState = DOT_OFF;
+
+    // Co je právě na displeji – update() kreslí jen změny
+    static int16_t _shownMin     = -1;      // hour*60+minute
+    static uint8_t _shownAp      = 0xFF;
+    static uint8_t _shownSta     = 0xFF;
+    static uint8_t _shownInv     = 0xFF;
+    static bool    _alarmShown   = false;
+
     // ---------------------------------------------------------
     //  Interní: nakresli/smaž alarm trojúhelník
     //  MUSÍ být deklarováno před draw() a update() !
@@ -102,6 +125,13 @@ namespace Header {
               bool alarm) {
         // Pozadí záhlaví
         tft.fillRect(0, HDR_Y, 320, HDR_H, t->header);
+        _saveShown    = FRAMW_IDLE;   // štítek se případně nakreslí znovu
+        _lastInvState = invState;
+        _shownMin     = dt.hour * 60 + dt.minute;
+        _shownAp      = apState;
+        _shownSta     = staState;
+        _shownInv     = invState;
+        _alarmShown   = alarm;
 
         // Čas
         tft.setFont(&fonts::DejaVu24);
@@ -143,15 +173,27 @@ namespace Header {
 
         uint8_t n = gConfig.numBoilers;
         if (n == 0) return;
-        if (n > 10) n = 10;
+        if (n > BOILER_MAX_COUNT) n = BOILER_MAX_COUNT;
+
+        // Šířka kostičky – víc zásobníků (víc desek relé) se musí
+        // vejít do lišty, kostičky se zúží (min. 2px, mezera 1px)
+        int16_t boxW = FTR_BOX_W;
+        int16_t gap  = FTR_BOX_GAP;
+        if (n * boxW + (n - 1) * gap > FTR_ROW_W) {
+            boxW = (FTR_ROW_W - (n - 1) * gap) / n;
+            if (boxW < 4) {
+                gap  = 1;
+                boxW = (FTR_ROW_W - (n - 1) * gap) / n;
+            }
+        }
 
         // Šířka celé skupiny kostiček
-        uint16_t totalW = n * FTR_BOX_W + (n - 1) * FTR_BOX_GAP;
+        uint16_t totalW = n * boxW + (n - 1) * gap;
         int16_t startX = (320 - totalW) / 2;
         int16_t y = FTR_Y + (FTR_H - FTR_BOX_H) / 2;
 
         for (uint8_t i = 0; i < n; i++) {
-            int16_t x = startX + i * (FTR_BOX_W + FTR_BOX_GAP);
+            int16_t x = startX + i * (boxW + gap);
 
             uint8_t state = OUT_IDLE;
             if (d.relayOn[i]) {
@@ -161,48 +203,71 @@ namespace Header {
             uint16_t col = _outColor(t, state);
             if (state == OUT_IDLE) {
                 // Jen obrys
-                tft.drawRect(x, y, FTR_BOX_W, FTR_BOX_H, t->dim);
+                tft.drawRect(x, y, boxW, FTR_BOX_H, t->dim);
             } else {
-                tft.fillRect(x, y, FTR_BOX_W, FTR_BOX_H, col);
+                tft.fillRect(x, y, boxW, FTR_BOX_H, col);
             }
         }
 
         // Uložit cache
         _lastNumBoilers = n;
-        for (uint8_t i = 0; i < 10; i++) {
+        for (uint8_t i = 0; i < BOILER_MAX_COUNT; i++) {
             _lastRelayOn[i]      = d.relayOn[i];
             _lastRelayHeating[i] = d.relayHeating[i];
         }
     }
 
     // ---------------------------------------------------------
-    //  Aktualizuj záhlaví – volej každou sekundu
-    //  Překreslí jen části které se mění (čas, puntíky, alarm)
+    //  Aktualizuj záhlaví – volej při události UI
+    //  Překreslí jen části, které se od minula změnily
+    //  (čas, puntíky, alarm)
     // ---------------------------------------------------------
     void update(const Theme* t, const DateTime& dt,
                 uint8_t apState, uint8_t staState, uint8_t invState,
                 bool alarm) {
 
         // Čas – přes sprite aby neblikalo
-        static LGFX_Sprite _sprTime(&tft);
-        static bool _sprTimeCreated = false;
-        if (!_sprTimeCreated) {
-            _sprTime.createSprite(75, HDR_H);
-            _sprTimeCreated = true;
-        }
-        _sprTime.fillScreen(t->header);
-        _sprTime.setFont(&fonts::DejaVu24);
-        _sprTime.setTextColor(t->accent);
-        _sprTime.setCursor(0, 2);
-        char buf[9];
-        snprintf(buf, sizeof(buf), "%02d:%02d", dt.hour, dt.minute);
-        _sprTime.print(buf);
-        _sprTime.pushSprite(8, 0);
+        int16_t minute = dt.hour * 60 + dt.minute;
+        if (minute != _shownMin) {
+            static LGFX_Sprite _sprTime(&tft);
+            static bool _sprTimeCreated = false;
+            if (!_sprTimeCreated) {
+                _sprTime.createSprite(75, HDR_H);
+                _sprTimeCreated = true;
+            }
+            _sprTime.fillScreen(t->header);
+            _sprTime.setFont(&fonts::DejaVu24);
+            _sprTime.setTextColor(t->accent);
+            _sprTime.setCursor(0, 2);
+            char buf[9];
+            snprintf(buf, sizeof(buf), "%02d:%02d", dt.hour, dt.minute);
+            _sprTime.print(buf);
+            _sprTime.pushSprite(8, 0);
+            _shownMin = minute;
+        }
 
         // Puntíky
-        tft.fillCircle(100, 12, 6, _dotColor(t, apState));
-        tft.fillCircle(160, 12, 6, _dotColor(t, staState));
-        tft.fillCircle(235, 12, 6, _dotColor(t, invState));
+        if (apState != _shownAp) {
+            tft.fillCircle(100, 12, 6, _dotColor(t, apState));
+            _shownAp = apState;
+        }
+        if (staState != _shownSta) {
+            tft.fillCircle(160, 12, 6, _dotColor(t, staState));
+            _shownSta = staState;
+        }
+        _lastInvState = invState;
+
+        // Pravou část překrývá štítek ukládání – nekresli do něj
+        // (po zmizení ho obnoví updateSaveBadge, pak se kreslí znovu)
+        if (_saveShown != FRAMW_IDLE) {
+            _shownInv   = 0xFF;
+            _alarmShown = false;     // štítek oblast alarmu smazal
+            return;
+        }
+        if (invState != _shownInv) {
+            tft.fillCircle(235, 12, 6, _dotColor(t, invState));
+            _shownInv = invState;
+        }
 
         // Alarm – blikání 500ms
         if (alarm) {
@@ -212,10 +277,11 @@ namespace Header {
                 _alarmVisible = !_alarmVisible;
                 _drawAlarm(t, _alarmVisible);
             }
-        } else {
+        } else if (_alarmShown) {
             // Smazat alarm ikonu
             tft.fillRect(295, 4, 18, 18, t->header);
         }
+        _alarmShown = alarm;
     }
 
     // ---------------------------------------------------------
@@ -227,7 +293,7 @@ namespace Header {
         bool changed = (_lastNumBoilers != gConfig.numBoilers);
         if (!changed) {
             uint8_t n = gConfig.numBoilers;
-            if (n > 10) n = 10;
+            if (n > BOILER_MAX_COUNT) n = BOILER_MAX_COUNT;
             for (uint8_t i = 0; i < n; i++) {
                 if (d.relayOn[i] != _lastRelayOn[i] ||
                     d.relayHeating[i] != _lastRelayHeating[i]) {
@@ -241,4 +307,42 @@ namespace Header {
         drawFooter(t, d);
     }
 
+    // ---------------------------------------------------------
+    //  Štítek ukládání do FRAM – volej každou iteraci uiLoop
+    //  Kreslí jen při změně stavu (levné).
+    // ---------------------------------------------------------
+    void updateSaveBadge(const Theme* t) {
+        uint8_t want = FramWriter::state();
+        uint32_t age = millis() - FramWriter::lastDoneMs();
+        if (want == FRAMW_DONE  && age > SAVE_DONE_MS)  want = FRAMW_IDLE;
+        if (want == FRAMW_ERROR && age > SAVE_ERROR_MS) want = FRAMW_IDLE;
+        if (want == _saveShown) return;
+        _saveShown = want;
+
+        tft.fillRect(SAVE_BADGE_X, HDR_Y, SAVE_BADGE_W, HDR_H, t->header);
+
+        if (want == FRAMW_IDLE) {
+            // Obnov INV puntík + popisek (alarm obnoví update())
+            tft.fillCircle(235, 12, 6, _dotColor(t, _lastInvState));
+            tft.setFont(&fonts::DejaVu24);
+            tft.setTextColor(t->dim);
+            tft.setCursor(245, 2);
+            tft.print("INV");
+            return;
+        }
+
+        const char* txt;
+        uint16_t    col;
+        switch (want) {
+            case FRAMW_BUSY:  txt = "ukladam...";  col = t->dim; break;
+            case FRAMW_DONE:  txt = "ulozeno";     col = t->ok;  break;
+            default:          txt = "chyba zapisu"; col = t->err; break;
+        }
+        tft.setFont(&fonts::Font2);
+        tft.setTextColor(col);
+        tft.setTextDatum(middle_center);
+        tft.drawString(txt, SAVE_BADGE_X + SAVE_BADGE_W / 2, HDR_H / 2);
+        tft.setTextDatum(top_left);
+    }
+
 } // namespace Header
\ No newline at end of file
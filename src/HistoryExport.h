@@ -0,0 +1,222 @@
+// =============================================================
+//  HistoryExport.h – proudový export historie (CSV / binárně)
+//
+//  Projde minutový PowerLog (FRAM) nebo HistoryStore (LittleFS)
+//  a po částech plní JEDEN buffer EXPORT_CHUNK_SIZE bajtů.
+//  Stav exportu = jen kurzor (čas dalšího záznamu, u PowerLogu
+//  i rozdekódovaný rámec), takže i rok hodinových dat má pevnou
+//  paměťovou stopu.
+//
+//  Zdroje:
+//    EXP_MINUTE  PowerLog – minutové výkony [W] (~24–30 h)
+//    EXP_HOUR    HistoryStore – hodinové energie [Wh]
+//    EXP_DAY     HistoryStore – denní energie [Wh]
+//    EXP_MONTH   HistoryStore – měsíční energie [Wh]
+//
+//  CSV:  hlavička se jmény sloupců, čas "RRRR-MM-DD HH:MM"
+//  BIN:  ExportBinHeader (16B) + záznamy po 32B, little-endian
+//        EXP_MINUTE → PowerSample, ostatní → HistRecord
+//
+//  Použití (transport viz ExportServer.h):
+//    HistoryExporter exp;
+//    exp.begin(EXP_DAY, EXP_CSV, from, to);
+//    uint16_t n;
+//    while ((n = exp.next()) > 0) out.write(exp.data(), n);
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "PCF85063A.h"
+#include "PowerLog.h"
+#include "HistoryStore.h"
+
+#define EXPORT_CHUNK_SIZE   512     // jeden chunk = celá paměť exportu
+#define EXPORT_LINE_MAX     96      // nejdelší řádek CSV
+#define EXPORT_HIST_BATCH   4       // záznamů LittleFS na jedno read()
+
+enum ExportSource : uint8_t {
+    EXP_MINUTE = 0,
+    EXP_HOUR   = 1,
+    EXP_DAY    = 2,
+    EXP_MONTH  = 3,
+};
+
+enum ExportFormat : uint8_t {
+    EXP_CSV = 0,
+    EXP_BIN = 1,
+};
+
+// Hlavička binárního exportu – 16B
+struct ExportBinHeader {
+    char     magic[4];      // "ACHX"
+    uint8_t  version;       // 1
+    uint8_t  source;        // ExportSource
+    uint16_t recSize;       // 32
+    uint32_t from;          // požadovaný rozsah [s od 2000]
+    uint32_t to;
+};
+static_assert(sizeof(ExportBinHeader) == 16, "ExportBinHeader must be 16 bytes");
+static_assert(sizeof(PowerSample) == 32, "PowerSample must be 32 bytes");
+
+class HistoryExporter {
+public:
+    // ---------------------------------------------------------
+    //  Začni nový export – předchozí stav se zahodí
+    // ---------------------------------------------------------
+    void begin(ExportSource src, ExportFormat fmt, uint32_t from, uint32_t to) {
+        _src    = src;
+        _fmt    = fmt;
+        _from   = from;
+        _to     = to;
+        _cursor = from;
+        _rows   = 0;
+        PowerLog::cursorBegin(_plc, from);
+        _len    = 0;
+        _header = false;
+        _done   = from > to;
+
+        // LittleFS: začni u nejstaršího záznamu
+        if (_src != EXP_MINUTE && !_done) {
+            uint32_t first;
+            if (!HistoryStore::oldest(_level(), first)) _done = true;
+            else if (_cursor < first) _cursor = first;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Naplň další chunk – vrací počet bajtů (0 = konec)
+    // ---------------------------------------------------------
+    uint16_t next() {
+        _len = 0;
+        if (!_header) {
+            _writeHeader();
+            _header = true;
+        }
+        if (!_done) {
+            if (_src == EXP_MINUTE) _fillMinutes();
+            else                    _fillHistory();
+        }
+        return _len;
+    }
+
+    const uint8_t* data() const { return _buf; }
+    bool     done() const { return _done; }
+    uint32_t rows() const { return _rows; }
+
+    const char* contentType() const {
+        return _fmt == EXP_CSV ? "text/csv" : "application/octet-stream";
+    }
+
+private:
+    ExportSource _src    = EXP_MINUTE;
+    ExportFormat _fmt    = EXP_CSV;
+    uint32_t     _from   = 0;
+    uint32_t     _to     = 0;
+    uint32_t     _cursor = 0;       // ts dalšího záznamu k exportu
+    uint32_t     _rows   = 0;
+    uint16_t     _len    = 0;
+    bool         _header = false;
+    bool         _done   = true;
+    PowerLogCursor _plc;            // pozice v PowerLogu (rámec + bit)
+    uint8_t      _buf[EXPORT_CHUNK_SIZE];
+
+    HistLevel _level() const {
+        switch (_src) {
+            case EXP_HOUR: return HIST_HOUR;
+            case EXP_DAY:  return HIST_DAY;
+            default:       return HIST_MONTH;
+        }
+    }
+
+    uint16_t _room() const { return EXPORT_CHUNK_SIZE - _len; }
+
+    void _put(const void* p, uint16_t n) {
+        memcpy(&_buf[_len], p, n);
+        _len += n;
+    }
+
+    static int _stamp(char* s, size_t n, uint32_t ts) {
+        DateTime dt = secsToDateTime(ts);
+        return snprintf(s, n, "%04u-%02u-%02u %02u:%02u",
+                        dt.year, dt.month, dt.day, dt.hour, dt.minute);
+    }
+
+    void _writeHeader() {
+        if (_fmt == EXP_BIN) {
+            ExportBinHeader h = { {'A', 'C', 'H', 'X'}, 1, _src, 32, _from, _to };
+            _put(&h, sizeof(h));
+            return;
+        }
+        const char* cols = (_src == EXP_MINUTE)
+            ? "time,pv_w,load_w,grid_w,bat_w,l1_w,l2_w,l3_w\n"
+            : "time,pv_wh,load_wh,buy_wh,sell_wh,bat_chg_wh,bat_dis_wh,minutes\n";
+        _put(cols, strlen(cols));
+    }
+
+    // ---------------------------------------------------------
+    //  PowerLog – čtení od kurzoru, visitor plní buffer a při
+    //  zaplnění čtení přeruší (kurzor zůstane na tom vzorku).
+    //  Kurzor drží rámec i pozici v bitstreamu – chunk pokračuje
+    //  tam, kde předchozí skončil, místo dekódování od klíče.
+    // ---------------------------------------------------------
+    static bool _visitMinute(const PowerSample& s, void* ctx) {
+        HistoryExporter* e = static_cast<HistoryExporter*>(ctx);
+        if (e->_fmt == EXP_BIN) {
+            if (e->_room() < sizeof(s)) return false;
+            e->_put(&s, sizeof(s));
+        } else {
+            char line[EXPORT_LINE_MAX];
+            int n = _stamp(line, sizeof(line), s.ts);
+            n += snprintf(line + n, sizeof(line) - n, ",%ld,%ld,%ld,%ld,%ld,%ld,%ld\n",
+                (long)s.powerPV, (long)s.powerLoad, (long)s.powerGrid,
+                (long)s.powerBattery, (long)s.phaseL1, (long)s.phaseL2,
+                (long)s.phaseL3);
+            if (n >= (int)sizeof(line)) n = sizeof(line) - 1;
+            if (e->_room() < (uint16_t)n) return false;
+            e->_put(line, n);
+        }
+        e->_cursor = s.ts + 1;
+        e->_rows++;
+        return true;
+    }
+
+    void _fillMinutes() {
+        // false = čtení doběhlo do konce rozsahu
+        if (!PowerLog::queryNext(_plc, _to, _visitMinute, this)) _done = true;
+    }
+
+    // ---------------------------------------------------------
+    //  HistoryStore – čti po EXPORT_HIST_BATCH záznamech
+    // ---------------------------------------------------------
+    void _fillHistory() {
+        HistRecord rec[EXPORT_HIST_BATCH];
+        while (!_done) {
+            uint16_t per  = (_fmt == EXP_BIN) ? sizeof(HistRecord) : EXPORT_LINE_MAX;
+            uint16_t want = _room() / per;
+            if (want == 0) return;
+            if (want > EXPORT_HIST_BATCH) want = EXPORT_HIST_BATCH;
+
+            uint16_t n = HistoryStore::read(_level(), _cursor, _to, rec, want);
+            for (uint16_t i = 0; i < n; i++) {
+                const HistRecord& r = rec[i];
+                if (_fmt == EXP_BIN) {
+                    _put(&r, sizeof(r));
+                } else {
+                    char line[EXPORT_LINE_MAX];
+                    int k = _stamp(line, sizeof(line), r.ts);
+                    k += snprintf(line + k, sizeof(line) - k,
+                        ",%lu,%lu,%lu,%lu,%lu,%lu,%u\n",
+                        (unsigned long)r.pvWh, (unsigned long)r.loadWh,
+                        (unsigned long)r.gridBuyWh, (unsigned long)r.gridSellWh,
+                        (unsigned long)r.batChargeWh, (unsigned long)r.batDischargeWh,
+                        r.minutes);
+                    if (k >= (int)sizeof(line)) k = sizeof(line) - 1;
+                    _put(line, k);
+                }
+                _cursor = r.ts + 1;
+                _rows++;
+            }
+            // Méně než požadováno = konec rozsahu
+            if (n < want || _cursor == 0) _done = true;
+        }
+    }
+};
@@ -35,7 +35,7 @@
 #include "ScreenManager.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
-#include "PCF85063A.h"
+#include "TimeService.h"
 
 namespace HistoryScreen {
 
@@ -75,24 +75,11 @@ namespace HistoryScreen {
         return names[wday % 7];
     }
 
-    // ---------------------------------------------------------
-    //  Tomohiko Sakamoto – den v týdnu z data
-    //  Vrací: 0=Ne, 1=Po, 2=Út, 3=St, 4=Čt, 5=Pá, 6=So
-    // ---------------------------------------------------------
-    static uint8_t _calcWeekday(const DateTime& dt) {
-        static const int8_t t[] = {0,3,2,5,0,3,5,1,4,6,2,4};
-        uint16_t y = dt.year;
-        uint8_t  m = dt.month;
-        uint8_t  d = dt.day;
-        if (m < 3) y--;
-        return (y + y/4 - y/100 + y/400 + t[m-1] + d) % 7;
-    }
-
     // ---------------------------------------------------------
     //  Generuj popisky dnů relativně od dnes
     // ---------------------------------------------------------
     static void _buildDayLabels(const DateTime& dt) {
-        uint8_t today = _calcWeekday(dt);
+        uint8_t today = TimeService::dayOfWeek(dateTimeToSecs(dt));
         for (int8_t i = 0; i < HISTORY_DAYS; i++) {
             int8_t day = (today - (HISTORY_DAYS - 1 - i) + 7) % 7;
             strncpy(_dayLabels[i], _dayAbbr(day), 3);
@@ -0,0 +1,470 @@
+// =============================================================
+//  HistoryStore.h – dlouhodobá historie energií v LittleFS
+//
+//  FRAM drží jen ~24–30 h minutových dat (PowerLog) a 7 denních
+//  souhrnů. Pro roční přehledy (vlastní spotřeba, prodej) se
+//  hodinové / denní / měsíční součty ukládají do LittleFS
+//  (oddíl 1 MB z platformio.ini, sdílený s webovými soubory).
+//
+//  Soubory (všechny = pole HistRecord, 32B, seřazené podle ts):
+//    /hist/h_RRRRMM.bin   hodinové záznamy, jeden soubor / měsíc
+//                         (≤ 744 × 32B = 23 KB), drží se 13 měsíců
+//    /hist/d_RRRR.bin     denní součty, jeden soubor / rok (≤ 12 KB)
+//    /hist/m.bin          měsíční součty, celá historie
+//
+//  Index: záznamy mají pevnou velikost a jsou seřazené → pozice
+//  podle času = binární hledání přes seek(), O(log n) čtení.
+//  Měsíc denních dat pro graf = 1 seek + 1 read ~1 KB (< 10 ms).
+//
+//  Dávkový zápis (šetří flash): sync() se spustí jednou za
+//  HIST_FLUSH_HOURS hodin a poll() pak po jedné hodině na
+//  průchod loop() dopočítá všechny dokončené hodiny
+//  z PowerLogu ve FRAM (ten drží ≥ 24 h, takže restart mezi
+//  dávkami nic neztratí). Na jednu dávku připadá 1× append
+//  hodinového souboru + přepis posledního denního a měsíčního
+//  záznamu.
+//
+//  Časová razítka = lokální sekundy od 2000-01-01 (dateTimeToSecs).
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include <LittleFS.h>
+#include "PCF85063A.h"
+#include "PowerLog.h"
+
+#define HIST_DIR            "/hist"
+#define HIST_FLUSH_HOURS    6       // dávka: zápis 1× za 6 h
+#define HIST_KEEP_MONTHS    13      // hodinová data – kolik měsíců držet
+#define HIST_PENDING_MAX    48      // max. hodin v jedné dávce (PowerLog ≤ ~30 h)
+
+// Úroveň agregace
+enum HistLevel : uint8_t {
+    HIST_HOUR  = 0,
+    HIST_DAY   = 1,
+    HIST_MONTH = 2,
+};
+
+// =============================================================
+//  Jeden záznam – 32B, energie [Wh] za interval
+// =============================================================
+struct HistRecord {
+    uint32_t ts;              // začátek intervalu [s od 2000, lokální]
+    uint32_t pvWh;            // výroba FVE
+    uint32_t loadWh;          // spotřeba domu
+    uint32_t gridBuyWh;       // odběr ze sítě
+    uint32_t gridSellWh;      // dodávka do sítě
+    uint32_t batChargeWh;     // nabíjení baterie
+    uint32_t batDischargeWh;  // vybíjení baterie
+    uint16_t minutes;         // počet minutových vzorků (pokrytí)
+    uint16_t reserved;
+};
+static_assert(sizeof(HistRecord) == 32, "HistRecord must be 32 bytes");
+
+namespace HistoryStore {
+
+    static bool     _mounted      = false;
+    static uint32_t _lastHourTs   = 0;      // poslední uložená hodina (0 = nic)
+    static bool     _haveLast     = false;
+    static uint32_t _checkedHour  = 0;      // loop() kontroluje jen při změně hodiny
+
+    // Dávka – hodinové záznamy čekající na zápis
+    static HistRecord _pending[HIST_PENDING_MAX];
+    static uint8_t    _nPending   = 0;
+
+    // Akumulátor rozpracované hodiny [W·min]
+    static int64_t  _acc[6]       = {};
+    static uint32_t _accHour      = 0;
+    static uint16_t _accMin       = 0;
+
+    // Rozpracovaná dávka – poll() dotazuje PowerLog po hodinách
+    static bool     _syncing      = false;
+    static uint32_t _syncHour     = 0;      // další hodina k dotazu
+    static uint32_t _syncEnd      = 0;      // začátek aktuální hodiny (mimo)
+    static uint32_t _syncNow      = 0;      // čas spuštění dávky (_prune)
+
+    // ---------------------------------------------------------
+    //  Cesty k souborům
+    // ---------------------------------------------------------
+    static void _path(char* buf, size_t len, HistLevel lvl, uint32_t ts) {
+        DateTime dt = secsToDateTime(ts);
+        switch (lvl) {
+            case HIST_HOUR: snprintf(buf, len, HIST_DIR "/h_%04u%02u.bin", dt.year, dt.month); break;
+            case HIST_DAY:  snprintf(buf, len, HIST_DIR "/d_%04u.bin", dt.year); break;
+            default:        snprintf(buf, len, HIST_DIR "/m.bin"); break;
+        }
+    }
+
+    // Začátek dne / měsíce / následujícího souboru
+    static uint32_t _dayStart(uint32_t ts) { return ts - ts % 86400UL; }
+
+    static uint32_t _monthStart(uint32_t ts) {
+        DateTime dt = secsToDateTime(ts);
+        dt.day = 1; dt.hour = 0; dt.minute = 0; dt.second = 0;
+        return dateTimeToSecs(dt);
+    }
+
+    static uint32_t _nextFileStart(HistLevel lvl, uint32_t ts) {
+        DateTime dt = secsToDateTime(ts);
+        dt.day = 1; dt.hour = 0; dt.minute = 0; dt.second = 0;
+        if (lvl == HIST_HOUR) {
+            if (++dt.month > 12) { dt.month = 1; dt.year++; }
+        } else {
+            dt.month = 1; dt.year++;
+        }
+        return dateTimeToSecs(dt);
+    }
+
+    // ---------------------------------------------------------
+    //  Binární hledání: index prvního záznamu s ts >= key
+    // ---------------------------------------------------------
+    static uint32_t _lowerBound(File& f, uint32_t key) {
+        uint32_t lo = 0, hi = f.size() / sizeof(HistRecord);
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            uint32_t ts  = 0;
+            f.seek(mid * sizeof(HistRecord));
+            f.read((uint8_t*)&ts, sizeof(ts));
+            if (ts < key) lo = mid + 1;
+            else          hi = mid;
+        }
+        return lo;
+    }
+
+    // Přičti / ulož záznam do souboru – pokud poslední záznam má
+    // stejné ts, sečti a přepiš (rozpracovaný den / měsíc)
+    static bool _mergeLast(HistLevel lvl, const HistRecord& r) {
+        char path[32];
+        _path(path, sizeof(path), lvl, r.ts);
+        File f = LittleFS.open(path, LittleFS.exists(path) ? "r+" : "w+");
+        if (!f) return false;
+
+        HistRecord out = r;
+        uint32_t n = f.size() / sizeof(HistRecord);
+        uint32_t pos = n * sizeof(HistRecord);
+        if (n > 0) {
+            HistRecord last;
+            f.seek((n - 1) * sizeof(HistRecord));
+            f.read((uint8_t*)&last, sizeof(last));
+            if (last.ts == r.ts) {
+                out.pvWh           += last.pvWh;
+                out.loadWh         += last.loadWh;
+                out.gridBuyWh      += last.gridBuyWh;
+                out.gridSellWh     += last.gridSellWh;
+                out.batChargeWh    += last.batChargeWh;
+                out.batDischargeWh += last.batDischargeWh;
+                out.minutes        += last.minutes;
+                pos = (n - 1) * sizeof(HistRecord);
+            } else if (last.ts > r.ts) {
+                f.close();
+                return false;           // mimo pořadí – ignoruj
+            }
+        }
+        f.seek(pos);
+        bool ok = f.write((const uint8_t*)&out, sizeof(out)) == sizeof(out);
+        f.close();
+        return ok;
+    }
+
+    // Smaž hodinové soubory starší než HIST_KEEP_MONTHS
+    // (mazání až po dokončení průchodu adresářem)
+    static void _prune(uint32_t nowTs) {
+        DateTime dt = secsToDateTime(nowTs);
+        int32_t keepFrom = (int32_t)dt.year * 12 + (dt.month - 1) - (HIST_KEEP_MONTHS - 1);
+        char    victims[4][32];
+        uint8_t nv = 0;
+        Dir d = LittleFS.openDir(HIST_DIR);
+        while (d.next() && nv < 4) {
+            String name = d.fileName();
+            unsigned y, m;
+            if (sscanf(name.c_str(), "h_%4u%2u.bin", &y, &m) != 2) continue;
+            if ((int32_t)y * 12 + (int32_t)(m - 1) < keepFrom)
+                snprintf(victims[nv++], sizeof(victims[0]), HIST_DIR "/%s", name.c_str());
+        }
+        for (uint8_t i = 0; i < nv; i++) {
+            LittleFS.remove(victims[i]);
+            LOGF("[HIST] Smazáno %s\n", victims[i]);
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Agregace minutových vzorků → hodinové záznamy
+    // ---------------------------------------------------------
+    static void _emitHour() {
+        if (_accMin == 0) return;
+        if (_nPending >= HIST_PENDING_MAX) return;
+        HistRecord& r = _pending[_nPending++];
+        memset(&r, 0, sizeof(r));
+        r.ts             = _accHour;
+        r.pvWh           = (uint32_t)(_acc[0] / 60);
+        r.loadWh         = (uint32_t)(_acc[1] / 60);
+        r.gridBuyWh      = (uint32_t)(_acc[2] / 60);
+        r.gridSellWh     = (uint32_t)(_acc[3] / 60);
+        r.batChargeWh    = (uint32_t)(_acc[4] / 60);
+        r.batDischargeWh = (uint32_t)(_acc[5] / 60);
+        r.minutes        = _accMin;
+        memset(_acc, 0, sizeof(_acc));
+        _accMin = 0;
+    }
+
+    static bool _visit(const PowerSample& s, void*) {
+        uint32_t hour = s.ts - s.ts % 3600UL;
+        if (hour != _accHour) {
+            _emitHour();
+            _accHour = hour;
+        }
+        _acc[0] += max(s.powerPV, (int32_t)0);
+        _acc[1] += max(s.powerLoad, (int32_t)0);
+        _acc[2] += max(s.powerGrid, (int32_t)0);
+        _acc[3] += max(-s.powerGrid, (int32_t)0);
+        _acc[4] += max(-s.powerBattery, (int32_t)0);
+        _acc[5] += max(s.powerBattery, (int32_t)0);
+        _accMin++;
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Inicializace – připoj LittleFS, zjisti poslední hodinu
+    //  Volej v setup() po PowerLog::begin()
+    // ---------------------------------------------------------
+    bool begin() {
+        _mounted = LittleFS.begin();
+        if (!_mounted) {
+            LOGLN("[HIST] CHYBA: LittleFS nelze připojit");
+            return false;
+        }
+        if (!LittleFS.exists(HIST_DIR)) LittleFS.mkdir(HIST_DIR);
+
+        // Nejnovější hodinový soubor → poslední záznam
+        uint32_t best = 0;
+        char     bestName[32] = "";
+        Dir d = LittleFS.openDir(HIST_DIR);
+        while (d.next()) {
+            unsigned y, m;
+            String name = d.fileName();
+            if (sscanf(name.c_str(), "h_%4u%2u.bin", &y, &m) != 2) continue;
+            if (y * 100 + m > best) {
+                best = y * 100 + m;
+                snprintf(bestName, sizeof(bestName), HIST_DIR "/%s", name.c_str());
+            }
+        }
+        if (best) {
+            File f = LittleFS.open(bestName, "r");
+            uint32_t n = f ? f.size() / sizeof(HistRecord) : 0;
+            if (n > 0) {
+                f.seek((n - 1) * sizeof(HistRecord));
+                f.read((uint8_t*)&_lastHourTs, sizeof(_lastHourTs));
+                _haveLast = true;
+            }
+            if (f) f.close();
+        }
+
+        FSInfo info;
+        LittleFS.info(info);
+        LOGF("[HIST] Init OK – FS %u/%u KB, poslední hodina %s\n",
+            (unsigned)(info.usedBytes / 1024), (unsigned)(info.totalBytes / 1024),
+            _haveLast ? "nalezena" : "žádná");
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Zapiš dávku _pending[] – hodinové soubory, denní a měsíční
+    //  součty
+    // ---------------------------------------------------------
+    static void _flush() {
+        // Hodinové záznamy – append po měsících (1 open / soubor)
+        uint8_t i = 0;
+        while (i < _nPending) {
+            char path[32];
+            _path(path, sizeof(path), HIST_HOUR, _pending[i].ts);
+            uint32_t fileEnd = _nextFileStart(HIST_HOUR, _pending[i].ts);
+            uint8_t  j = i;
+            while (j < _nPending && _pending[j].ts < fileEnd) j++;
+            File f = LittleFS.open(path, "a");
+            if (!f) {
+                LOGF("[HIST] CHYBA: nelze otevřít %s\n", path);
+                return;
+            }
+            f.write((const uint8_t*)&_pending[i], (j - i) * sizeof(HistRecord));
+            f.close();
+            i = j;
+        }
+
+        // Denní a měsíční součty – sečti dávku po dnech / měsících
+        for (uint8_t lvl = HIST_DAY; lvl <= HIST_MONTH; lvl++) {
+            HistRecord agg;
+            bool open = false;
+            for (uint8_t k = 0; k <= _nPending; k++) {
+                uint32_t key = 0;
+                if (k < _nPending)
+                    key = (lvl == HIST_DAY) ? _dayStart(_pending[k].ts)
+                                            : _monthStart(_pending[k].ts);
+                if (open && (k == _nPending || key != agg.ts)) {
+                    _mergeLast((HistLevel)lvl, agg);
+                    open = false;
+                }
+                if (k == _nPending) break;
+                if (!open) {
+                    memset(&agg, 0, sizeof(agg));
+                    agg.ts = key;
+                    open   = true;
+                }
+                const HistRecord& r = _pending[k];
+                agg.pvWh           += r.pvWh;
+                agg.loadWh         += r.loadWh;
+                agg.gridBuyWh      += r.gridBuyWh;
+                agg.gridSellWh     += r.gridSellWh;
+                agg.batChargeWh    += r.batChargeWh;
+                agg.batDischargeWh += r.batDischargeWh;
+                agg.minutes        += r.minutes;
+            }
+        }
+
+        _lastHourTs = _pending[_nPending - 1].ts;
+        _haveLast   = true;
+        _prune(_syncNow);
+
+        LOGF("[HIST] Uloženo %u h\n", _nPending);
+    }
+
+    // ---------------------------------------------------------
+    //  Začni dávku – dopočítají se všechny dokončené hodiny
+    //  z PowerLogu (< začátek aktuální hodiny).
+    //  Dotaz přes celou dávku (až ~30 h) by dekódoval všechny
+    //  rámce najednou a držel mutex PowerLogu – HB task by mezitím
+    //  nemohl zapsat. Proto poll() zpracuje vždy jen jednu hodinu.
+    //  Vrací false pokud není co ukládat.
+    // ---------------------------------------------------------
+    bool sync(uint32_t nowTs) {
+        if (!_mounted || _syncing) return false;
+
+        uint32_t oldest, newest;
+        if (!PowerLog::range(oldest, newest)) return false;
+
+        uint32_t curHour = nowTs - nowTs % 3600UL;
+        uint32_t from    = _haveLast ? _lastHourTs + 3600UL : oldest - oldest % 3600UL;
+        if (from < oldest - oldest % 3600UL) from = oldest - oldest % 3600UL;
+        if (from >= curHour) return false;
+
+        _nPending = 0;
+        _syncHour = from;
+        _syncEnd  = curHour;
+        _syncNow  = nowTs;
+        _syncing  = true;
+        return true;
+    }
+
+    // Probíhá dávka (main loop pak nespí do události)
+    bool busy() { return _syncing; }
+
+    // ---------------------------------------------------------
+    //  Krok dávky – volej z loop() každou iteraci
+    //  Jedna hodina = 1–2 rámce PowerLogu; po poslední hodině
+    //  se dávka zapíše do LittleFS.
+    // ---------------------------------------------------------
+    void poll() {
+        if (!_syncing) return;
+
+        if (_syncHour < _syncEnd) {
+            _accHour = _syncHour;
+            _accMin  = 0;
+            memset(_acc, 0, sizeof(_acc));
+            PowerLog::query(_syncHour, _syncHour + 3599UL, _visit, nullptr);
+            _emitHour();
+            _syncHour += 3600UL;
+            return;
+        }
+
+        _syncing = false;
+        if (_nPending) _flush();
+    }
+
+    // ---------------------------------------------------------
+    //  Periodická kontrola – volej 1× za minutu
+    //  Dávku spustí až když čeká HIST_FLUSH_HOURS dokončených hodin.
+    // ---------------------------------------------------------
+    void loop(uint32_t nowTs) {
+        if (!_mounted) return;
+        uint32_t curHour = nowTs - nowTs % 3600UL;
+        if (curHour == _checkedHour) return;
+        _checkedHour = curHour;
+        if (_haveLast && curHour - _lastHourTs <= HIST_FLUSH_HOURS * 3600UL) return;
+        sync(nowTs);
+    }
+
+    // ---------------------------------------------------------
+    //  Nejstarší uložený záznam dané úrovně – vrací false pokud
+    //  žádný není. Export tím omezí začátek rozsahu, aby read()
+    //  neotevíral soubory od roku 2000.
+    // ---------------------------------------------------------
+    bool oldest(HistLevel lvl, uint32_t& ts) {
+        if (!_mounted) return false;
+        char path[32];
+        if (lvl == HIST_MONTH) {
+            _path(path, sizeof(path), lvl, 0);
+        } else {
+            uint32_t best = 0xFFFFFFFF;
+            Dir d = LittleFS.openDir(HIST_DIR);
+            while (d.next()) {
+                unsigned y, m = 1;
+                String name = d.fileName();
+                int got = (lvl == HIST_HOUR)
+                    ? sscanf(name.c_str(), "h_%4u%2u.bin", &y, &m)
+                    : sscanf(name.c_str(), "d_%4u.bin", &y) * 2;
+                if (got != 2 || y * 100 + m >= best) continue;
+                best = y * 100 + m;
+                snprintf(path, sizeof(path), HIST_DIR "/%s", name.c_str());
+            }
+            if (best == 0xFFFFFFFF) return false;
+        }
+        File f = LittleFS.open(path, "r");
+        if (!f) return false;
+        bool ok = f.size() >= sizeof(HistRecord) &&
+                  f.read((uint8_t*)&ts, sizeof(ts)) == sizeof(ts);
+        f.close();
+        return ok;
+    }
+
+    // ---------------------------------------------------------
+    //  Načti záznamy [from, to] dané úrovně do out[]
+    //  Vrací počet načtených záznamů (max. maxCount).
+    //
+    //  Příklad – denní data za březen 2026 pro graf:
+    //    HistRecord days[31];
+    //    uint16_t n = HistoryStore::read(HIST_DAY, t0, t1, days, 31);
+    // ---------------------------------------------------------
+    uint16_t read(HistLevel lvl, uint32_t from, uint32_t to,
+                  HistRecord* out, uint16_t maxCount) {
+        if (!_mounted || !_haveLast) return 0;
+        if (to > _lastHourTs) to = _lastHourTs;     // novější soubory nejsou
+        if (from > to) return 0;
+        uint16_t n = 0;
+        uint32_t fileTs = from;
+
+        while (n < maxCount && fileTs <= to) {
+            char path[32];
+            _path(path, sizeof(path), lvl, fileTs);
+            File f = LittleFS.open(path, "r");
+            if (f) {
+                uint32_t idx   = _lowerBound(f, from);
+                uint32_t total = f.size() / sizeof(HistRecord);
+                f.seek(idx * sizeof(HistRecord));
+                while (idx < total && n < maxCount) {
+                    // Čti po blocích přímo do out[]
+                    uint16_t want = min((uint32_t)(maxCount - n), total - idx);
+                    f.read((uint8_t*)&out[n], want * sizeof(HistRecord));
+                    for (uint16_t k = 0; k < want; k++) {
+                        if (out[n].ts > to) { f.close(); return n; }
+                        n++;
+                    }
+                    idx += want;
+                }
+                f.close();
+            }
+            if (lvl == HIST_MONTH) break;      // jediný soubor
+            fileTs = _nextFileStart(lvl, fileTs);
+        }
+        return n;
+    }
+
+} // namespace HistoryStore
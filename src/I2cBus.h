@@ -0,0 +1,40 @@
+// =============================================================
+//  I2cBus.h – zámek sdílené I2C sběrnice (Wire)
+//
+//  Na Wire visí FRAM, RTC i desky MCP23017. FRAM a RTC
+//  obsluhuje loop() (Core 0), relé ale zapisuje a zpětně čte
+//  Boiler task – bez zámku by se jeho transakce vklínila do
+//  rozepsaného burstu FRAM (sdílený buffer Wire, repeated start).
+//
+//  Každá transakce (beginTransmission … endTransmission /
+//  requestFrom … read) běží pod Lock. Zámek drží jen driver
+//  (FM24CL64, PCF85063A, MCP23017), nikdy volající – žádné
+//  vnořování, takže stačí obyčejný mutex s dědičností priority.
+//
+//  begin() volat v setup() po Wire.begin(), před spuštěním
+//  tasků. Před begin() je Lock prázdný (setup běží sám).
+//
+//  Použití:
+//    I2cBus::Lock lock;
+//    Wire.beginTransmission(addr); ...
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+namespace I2cBus {
+
+    static SemaphoreHandle_t _mutex = nullptr;
+
+    void begin() {
+        if (!_mutex) _mutex = xSemaphoreCreateMutex();
+    }
+
+    struct Lock {
+        Lock()  { if (_mutex) xSemaphoreTake(_mutex, portMAX_DELAY); }
+        ~Lock() { if (_mutex) xSemaphoreGive(_mutex); }
+        Lock(const Lock&)            = delete;
+        Lock& operator=(const Lock&) = delete;
+    };
+}
@@ -3,14 +3,21 @@
 // InverterDriver.h – Modbus driver pro komunikaci s menicem
 // Periodicky cte registry dle aktivniho profilu a plni InverterData
 // Bezi jako FreeRTOS task na Core 1
+//
+// Vlastni linku RS485 – obsluhuje i Modbus reléové desky zásobníků
+// (ModbusRelays.h): zápisy cívek mezi čtením registrů a během
+// čekání na další poll. Měnič přes TCP → linku RS485 má task pro
+// desky sám (samostatný ModbusRTUClient se stejnými parametry).
 // =============================================================================
 
 #include <Arduino.h>
+#include "Log.h"
 #include <FreeRTOS.h>
 #include <semphr.h>
 #include "Config.h"
 #include "InverterTypes.h"
 #include "ModbusClient.h"
+#include "ModbusRelays.h"
 
 // Pocet chyb za sebou nez se oznaci data za neplatna
 #define INVERTER_MAX_ERRORS  5
@@ -32,6 +39,7 @@ public:
 
     ~InverterDriver() {
         if (_client) delete _client;
+        if (_relayBus) delete _relayBus;
         if (_mutex)  vSemaphoreDelete(_mutex);
     }
 
@@ -40,7 +48,7 @@ public:
     // RTU: vzdy vraci true (jen init UART)
     bool begin() {
         const InverterProfile& profile = INVERTER_PROFILES[_cfg.invProfileIndex];
-        Serial.printf("[INV] Profil: %s  transport: %s\n",
+        LOGF("[INV] Profil: %s  transport: %s\n",
             profile.name,
             _cfg.invTransport == TRANSPORT_TCP ? "TCP" : "RTU");
 
@@ -62,7 +70,7 @@ public:
         }
 
         bool ok = _client->begin();
-        Serial.printf("[INV] Transport %s\n", ok ? "OK" : "CHYBA");
+        LOGF("[INV] Transport %s\n", ok ? "OK" : "CHYBA");
         return ok;
     }
 
@@ -88,13 +96,16 @@ public:
             if (err != MODBUS_OK) {
                 errorCount++;
                 if (errorCount <= 3) {
-                    Serial.printf("[INV] Chyba reg %u: %u\n", reg.address, err);
+                    LOGF("[INV] Chyba reg %u: %u\n", reg.address, err);
                 }
                 continue;
             }
 
             anyOk = true;
             _applyRegister(reg, raw);
+
+            // Čekající relé nečekají na konec pollu
+            _serviceRelays();
         }
 
         if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
@@ -159,31 +170,33 @@ public:
     // -----------------------------------------------------------------------
     static void task(void* param) {
         InverterDriver* drv = static_cast<InverterDriver*>(param);
-        Serial.println("[INV] Task spusten");
+        LOGLN("[INV] Task spusten");
 
         // Inicializace – pro TCP opakuj dokud server neni dostupny
         while (!drv->begin()) {
             if (drv->_cfg.invTransport == TRANSPORT_RTU) {
                 // RTU init selhal – fatální HW problém
-                Serial.println("[INV] RTU init selhal, task ukoncen");
+                LOGLN("[INV] RTU init selhal, task ukoncen");
                 vTaskDelete(nullptr);
                 return;
             }
             // TCP – server zatím nedostupný, zkus za chvíli
-            Serial.printf("[INV] TCP nedostupne, zkusim za %us...\n",
+            LOGF("[INV] TCP nedostupne, zkusim za %us...\n",
                           INVERTER_TCP_RETRY_MS / 1000);
-            vTaskDelay(pdMS_TO_TICKS(INVERTER_TCP_RETRY_MS));
+            drv->_idleUntil(xTaskGetTickCount() + pdMS_TO_TICKS(INVERTER_TCP_RETRY_MS));
         }
 
-        Serial.println("[INV] Pripojeno, spoustim polling");
+        LOGLN("[INV] Pripojeno, spoustim polling");
 
         TickType_t xLastWake = xTaskGetTickCount();
         for (;;) {
-            vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(drv->_cfg.invPollMs));
+            // Jako vTaskDelayUntil, ale relé se zapisují hned po commit()
+            xLastWake += pdMS_TO_TICKS(drv->_cfg.invPollMs);
+            drv->_idleUntil(xLastWake);
 
             if (!drv->poll()) {
-                Serial.println("[INV] Poll selhal, cekam 5s...");
-                vTaskDelay(pdMS_TO_TICKS(5000));
+                LOGLN("[INV] Poll selhal, cekam 5s...");
+                drv->_idleUntil(xTaskGetTickCount() + pdMS_TO_TICKS(5000));
                 // Reset timing aby se po pauze nespustilo víc pollů najednou
                 xLastWake = xTaskGetTickCount();
             }
@@ -193,10 +206,39 @@ public:
 private:
     const Config&      _cfg;
     ModbusDeReCallback _dereCallback;
-    ModbusClient*      _client = nullptr;
+    ModbusClient*      _client   = nullptr;
+    ModbusClient*      _relayBus = nullptr;     // RS485 pro desky při TCP měniči
     InverterData       _data;
     SemaphoreHandle_t  _mutex;
 
+    // -----------------------------------------------------------------------
+    // Zápis čekajících cívek reléových desek (jen RS485)
+    // -----------------------------------------------------------------------
+    void _serviceRelays() {
+        if (!ModbusRelays::pending()) return;
+        ModbusClient* bus = _client;
+        if (_cfg.invTransport != TRANSPORT_RTU) {
+            // Měnič na TCP – RS485 patří jen deskám
+            if (!_relayBus) {
+                _relayBus = new ModbusRTUClient(_cfg.invBaudRate, _dereCallback,
+                    _cfg.invDataBits, _cfg.invParity, _cfg.invStopBits);
+                _relayBus->begin();
+            }
+            bus = _relayBus;
+        }
+        if (bus) ModbusRelays::service(*bus);
+    }
+
+    // Čekání do 'until' – mezitím obsluhuj reléové desky (kick)
+    void _idleUntil(TickType_t until) {
+        for (;;) {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(until - now) <= 0) break;
+            ModbusRelays::waitKick((until - now) * portTICK_PERIOD_MS);
+            _serviceRelays();
+        }
+    }
+
     void _applyRegister(const RegisterDef& reg, const uint16_t* raw) {
         int32_t value = 0;
 
@@ -15,15 +15,18 @@
 //    LEFT     – zpět do UDP / zrušení editace
 //
 //  Geometrie:
-//    Sdílený gContentSprite, pixelový scroll, FTR_Y ochrana.
+//    Sdílený gContentSprite, seznam = ListView.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
@@ -72,17 +75,7 @@ namespace InverterScreen {
         { nullptr,      "FW verze",      "---",       true  },
     };
 
-    #define INV_ROW_H    26
-    #define INV_SEC_H    16
-    #define INV_START_Y  (CONTENT_Y + 4)
-
-    static uint8_t _cursor       = 0;
-    static uint8_t _scrollOffset = 0;
-    static bool    _editing      = false;
-
-    // Sdílený sprite z main_ui_loop
-    static LGFX_Sprite* _spr = nullptr;
-    void setSprite(LGFX_Sprite* s) { _spr = s; }
+    static ListView _list;
 
     // ----------------------------------------------------------
     //  Načti hodnoty z gConfig do _items[]
@@ -155,8 +148,8 @@ namespace InverterScreen {
                 break;
             default: break;
         }
-        ConfigManager::saveBlockPlant();
-        Serial.printf("[INV_S] Uloženo: %s = %s\n",
+        ConfigManager::saveAsync(BLOCK_PLANT_ADDR);
+        LOGF("[INV_S] Uloženo: %s = %s\n",
             _items[idx].label, _items[idx].value);
     }
 
@@ -167,13 +160,13 @@ namespace InverterScreen {
         switch ((ItemId)idx) {
             case ITEM_PV_POWER: {
                 float v = atof(_items[idx].value);
-                v = constrain(v + 0.5f, 0.5f, 100.0f);
+                v = constrain(v + 0.5f * gSwitch.step(), 0.5f, 100.0f);
                 snprintf(_items[idx].value, 20, "%.1f kWp", v);
                 break;
             }
             case ITEM_BATTERY: {
                 float v = atof(_items[idx].value);
-                v = constrain(v + 0.5f, 0.0f, 100.0f);
+                v = constrain(v + 0.5f * gSwitch.step(), 0.0f, 100.0f);
                 snprintf(_items[idx].value, 20, "%.1f kWh", v);
                 break;
             }
@@ -182,7 +175,7 @@ namespace InverterScreen {
                     strcmp(_items[idx].value, "1") == 0 ? "3" : "1");
                 break;
             case ITEM_MAX_EXPORT: {
-                int v = constrain(atoi(_items[idx].value) + 500, 0, 50000);
+                int v = constrain(atoi(_items[idx].value) + 500 * gSwitch.step(), 0, 50000);
                 if (v == 0)
                     snprintf(_items[idx].value, 20, "0 W (bez limitu)");
                 else
@@ -190,7 +183,7 @@ namespace InverterScreen {
                 break;
             }
             case ITEM_MIN_SOC: {
-                int v = constrain(atoi(_items[idx].value) + 5, 0, 90);
+                int v = constrain(atoi(_items[idx].value) + 5 * gSwitch.step(), 0, 90);
                 snprintf(_items[idx].value, 20, "%d %%", v);
                 break;
             }
@@ -206,13 +199,13 @@ namespace InverterScreen {
         switch ((ItemId)idx) {
             case ITEM_PV_POWER: {
                 float v = atof(_items[idx].value);
-                v = constrain(v - 0.5f, 0.5f, 100.0f);
+                v = constrain(v - 0.5f * gSwitch.step(), 0.5f, 100.0f);
                 snprintf(_items[idx].value, 20, "%.1f kWp", v);
                 break;
             }
             case ITEM_BATTERY: {
                 float v = atof(_items[idx].value);
-                v = constrain(v - 0.5f, 0.0f, 100.0f);
+                v = constrain(v - 0.5f * gSwitch.step(), 0.0f, 100.0f);
                 snprintf(_items[idx].value, 20, "%.1f kWh", v);
                 break;
             }
@@ -220,7 +213,7 @@ namespace InverterScreen {
                 _stepUp(idx);  // jen 2 hodnoty
                 break;
             case ITEM_MAX_EXPORT: {
-                int v = constrain(atoi(_items[idx].value) - 500, 0, 50000);
+                int v = constrain(atoi(_items[idx].value) - 500 * gSwitch.step(), 0, 50000);
                 if (v == 0)
                     snprintf(_items[idx].value, 20, "0 W (bez limitu)");
                 else
@@ -228,7 +221,7 @@ namespace InverterScreen {
                 break;
             }
             case ITEM_MIN_SOC: {
-                int v = constrain(atoi(_items[idx].value) - 5, 0, 90);
+                int v = constrain(atoi(_items[idx].value) - 5 * gSwitch.step(), 0, 90);
                 snprintf(_items[idx].value, 20, "%d %%", v);
                 break;
             }
@@ -240,121 +233,25 @@ namespace InverterScreen {
     }
 
     // ----------------------------------------------------------
-    //  Kreslení položky – vrací výšku (0 = za FTR_Y)
-    // ----------------------------------------------------------
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
-        InvItem& item   = _items[idx];
-        bool     active  = (idx == _cursor);
-        bool     editing = (active && _editing);
-        int16_t  drawn   = 0;
-        LovyanGFX* dc    = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t    sy    = _spr ? y - CONTENT_Y : y;
-
-        // Sekce header
-        if (item.section != nullptr) {
-            if (y + INV_SEC_H > FTR_Y) return 0;
-            dc->fillRect(0, sy, 320, INV_SEC_H, t->bg);
-            dc->setFont(&fonts::Font2);
-            dc->setTextColor(t->dim);
-            dc->setCursor(16, sy);
-            dc->print(item.section);
-            sy += 14;
-            dc->drawFastHLine(16, sy, 288, t->dim);
-            sy += 2;
-            drawn += INV_SEC_H;
-        }
-
-        if (y + drawn + INV_ROW_H > FTR_Y) return drawn;
-
-        // Pozadí řádku
-        if (active) {
-            dc->fillRect(8, sy, 304, INV_ROW_H, t->header);
-            dc->fillRect(8, sy, 3,   INV_ROW_H, t->accent);
-        } else {
-            dc->fillRect(8, sy, 304, INV_ROW_H, t->bg);
-        }
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(item.readonly
-            ? t->dim
-            : (active ? t->accent : t->text));
-        dc->setCursor(20, sy + 7);
-        dc->print(item.label);
-
-        // Hodnota
-        uint16_t valCol;
-        if (item.readonly) {
-            // Pracovní režim – barva podle stavu
-            if (idx == ITEM_WORK_MODE) {
-                if (strcmp(item.value, "On-grid") == 0)       valCol = t->ok;
-                else if (strcmp(item.value, "Porucha") == 0)  valCol = t->err;
-                else                                           valCol = t->dim;
-            } else {
-                valCol = t->dim;
-            }
-        } else {
-            valCol = editing ? t->accent : t->text;
-        }
-
-        dc->setTextColor(valCol);
-        dc->setTextDatum(middle_right);
-        dc->drawString(item.value, 308, sy + 12);
-        dc->setTextDatum(top_left);
-
-        drawn += INV_ROW_H;
-        return drawn;
-    }
-
-    // ----------------------------------------------------------
-    //  Překresli všechny viditelné položky
+    //  Řádek seznamu
     // ----------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        if (_spr) { _spr->fillScreen(t->bg); }
-        else { tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg); }
-        int16_t y = INV_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_COUNT; i++) {
-            int16_t h = _drawItemAt(t, i, y);
-            if (h == 0) break;
-            y += h;
+    static void _row(uint8_t idx, ListRow& r) {
+        InvItem& item = _items[idx];
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        r.flags   = item.readonly ? LIST_READONLY : 0;
+
+        // Pracovní režim – barva podle stavu
+        if (idx == ITEM_WORK_MODE) {
+            if (strcmp(item.value, "On-grid") == 0)      r.tone = LIST_TONE_OK;
+            else if (strcmp(item.value, "Porucha") == 0) r.tone = LIST_TONE_ERR;
         }
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
-    }
-
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        _drawAllItems(t);
     }
 
-    // ----------------------------------------------------------
-    //  Y pozice položky (pro scroll výpočet)
-    // ----------------------------------------------------------
-    static int16_t _itemY(uint8_t idx) {
-        int16_t y = INV_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (_items[i].section != nullptr) y += INV_SEC_H;
-            y += INV_ROW_H;
-        }
-        return y;
-    }
-
-    // ----------------------------------------------------------
-    //  Scroll
-    // ----------------------------------------------------------
-    static bool _ensureVisible() {
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-        bool changed = false;
-        while (_scrollOffset < _cursor) {
-            int16_t y      = _itemY(_cursor);
-            int16_t secH   = (_items[_cursor].section != nullptr) ? INV_SEC_H : 0;
-            int16_t bottom = y + secH + INV_ROW_H;
-            if (bottom <= FTR_Y) break;
-            _scrollOffset++;
-            changed = true;
-        }
-        return changed;
+    void setSprite(LGFX_Sprite* s) {
+        _list.begin(ITEM_COUNT, _row);
+        _list.setSprite(s);
     }
 
     // ==========================================================
@@ -378,7 +275,7 @@ namespace InverterScreen {
 
         _loadFromConfig();
         _updateStatus(d);
-        _drawAllItems(t);
+        _list.draw(t);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -387,35 +284,36 @@ namespace InverterScreen {
         Header::update(t, dt, apState, staState, invState, alarm);
 
         // Live update stavu
-        if (!_editing) {
+        if (!_list.editing()) {
             _updateStatus(d);
-            _drawAllItems(t);
+            _list.drawRow(t, ITEM_WORK_MODE);
+            _list.drawRow(t, ITEM_FW_VERSION);
         }
     }
 
     Screen handleInput(const Theme* t, SwButton btn) {
 
         // --- Editace ---
-        if (_editing) {
+        if (_list.editing()) {
             switch (btn) {
                 case SW_UP:
-                    _stepUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepUp(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _stepDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepDown(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_CENTER:
-                    _editing = false;
-                    _saveItem(_cursor);
+                    _list.setEditing(false);
+                    _saveItem(_list.cursor());
                     _loadFromConfig();
-                    _drawAllItems(t);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_LEFT:
-                    _editing = false;
+                    _list.setEditing(false);
                     _loadFromConfig();
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -425,25 +323,17 @@ namespace InverterScreen {
         // --- Normální navigace ---
         switch (btn) {
             case SW_UP:
-                if (_cursor > 0) {
-                    _cursor--;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursor < ITEM_COUNT - 1) {
-                    _cursor++;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER:
-                if (_items[_cursor].readonly) return SCREEN_NONE;
-                _editing = true;
-                _drawItem(t, _cursor);
+                if (_items[_list.cursor()].readonly) return SCREEN_NONE;
+                _list.setEditing(true);
+                _list.drawRow(t, _list.cursor());
                 return SCREEN_NONE;
 
             case SW_LEFT:
@@ -455,9 +345,7 @@ namespace InverterScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _loadFromConfig();
     }
 
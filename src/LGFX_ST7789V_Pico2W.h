@@ -2,6 +2,11 @@
 
 #include <LovyanGFX.hpp>
 
+#ifdef ACU_HOST
+// Host build (env:host) – displej je sprite v RAM, viz host/HostDisplay.h
+#include <HostDisplay.h>
+#else
+
 class LGFX : public lgfx::LGFX_Device {
 
   lgfx::Panel_ST7789  _panel_instance;
@@ -64,5 +69,7 @@ public:
   }
 };
 
+#endif // ACU_HOST
+
 // Globální instance – použij v main.cpp
 static LGFX tft;
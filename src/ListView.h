@@ -0,0 +1,398 @@
+// =============================================================
+//  ListView.h – sdílený scrollovací seznam konfiguračních screenů
+//
+//  Setting, Control, Network, Serial, Inverter a Mqtt screen
+//  měly každý vlastní kopii stejného seznamu (sekce + řádky,
+//  pixelový scroll, FTR_Y ochrana) a při každém kroku kurzoru
+//  kreslily všechny položky znovu.
+//
+//  ListView:
+//    - data řádku si bere líně přes callback (ListRowFn) – jen
+//      pro řádky, které se opravdu kreslí
+//    - pohyb kurzoru bez scrollu = překreslí 2 řádky
+//    - scroll o jednu položku = posun obsahu spritu (memmove
+//      řádků bufferu) + dokreslení nově odkryté položky
+//    - Render::push() pak pošle jen změněné dlaždice
+//  Hardwarový scroll ST7789 se použít nedá – v landscape
+//  orientaci posouvá ve směru X.
+//
+//  Geometrie (stejná pro všechny screeny):
+//    LIST_START_Y = CONTENT_Y + 4 = 30
+//    řádek LIST_ROW_H = 26 px, hlavička sekce LIST_SEC_H = 16 px
+//    nic se nekreslí pod FTR_Y (položka, která se nevejde celá,
+//    se nekreslí; hlavička sekce bez řádku ano)
+//
+//  Bez spritu (alokace selhala) kreslí přímo na tft, scroll
+//  pak znamená překreslení celého seznamu.
+//
+//  Použití:
+//    static ListView _list;
+//    static void _row(uint8_t idx, ListRow& r) { r.label = ...; }
+//    _list.begin(ITEM_COUNT, _row);       _list.setSprite(spr);
+//    _list.draw(t);                       // celý seznam
+//    _list.move(t, +1);                   // SW_DOWN
+//    _list.drawRow(t, _list.cursor());    // po změně hodnoty
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "LGFX_ST7789V_Pico2W.h"
+#include "Theme.h"
+#include "Header.h"
+#include "Render.h"
+
+#define LIST_ROW_H      26
+#define LIST_SEC_H      16
+#define LIST_START_Y    (CONTENT_Y + 4)
+
+// Příznaky řádku
+#define LIST_READONLY   0x01    // šedý label, hodnota v barvě tone
+#define LIST_TEXT       0x02    // textová hodnota, aktivní řádek má ">>>"
+#define LIST_LINK       0x04    // místo hodnoty ">>>" (podmenu)
+#define LIST_CUSTOM     0x08    // editovanou hodnotu kreslí screen (ListCustomFn)
+#define LIST_HIDDEN     0x10    // položka se nekreslí ani nevybírá (Serial TCP/RTU)
+
+// Barva hodnoty readonly řádku
+enum ListTone : uint8_t {
+    LIST_TONE_DIM = 0,
+    LIST_TONE_OK,
+    LIST_TONE_ERR
+};
+
+// Obsah jednoho řádku – vyplní screen v ListRowFn
+struct ListRow {
+    const char* section;    // nullptr = pokračování předchozí sekce
+    const char* label;
+    const char* value;
+    uint8_t     flags;      // LIST_xxx
+    uint8_t     tone;       // ListTone pro LIST_READONLY
+};
+
+typedef void (*ListRowFn)(uint8_t idx, ListRow& row);
+
+// Editor hodnoty v řádku (LIST_CUSTOM) – dc/t/y už pro cíl kreslení
+typedef void (*ListCustomFn)(LovyanGFX* dc, const Theme* t, uint8_t idx, int16_t y);
+
+class ListView {
+public:
+    void begin(uint8_t count, ListRowFn rowFn, ListCustomFn customFn = nullptr) {
+        _count  = count;
+        _rowFn  = rowFn;
+        _custom = customFn;
+        reset();
+    }
+
+    // Sprite bez bufferu (alokace selhala) = kreslení na tft
+    void setSprite(LGFX_Sprite* spr) {
+        _spr = (spr && spr->getBuffer()) ? spr : nullptr;
+    }
+
+    void reset() {
+        _cursor  = 0;
+        _scroll  = 0;
+        _editing = false;
+    }
+
+    uint8_t cursor()  const { return _cursor; }
+    bool    editing() const { return _editing; }
+    void    setEditing(bool e) { _editing = e; }
+
+    // ---------------------------------------------------------
+    //  Celý seznam znovu
+    // ---------------------------------------------------------
+    void draw(const Theme* t) {
+        if (_spr) _spr->fillScreen(Render::ink(_spr, t)->bg);
+        else      tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg);
+        _paintFrom(t, _scroll, LIST_START_Y);
+        push();
+    }
+
+    // ---------------------------------------------------------
+    //  Jeden řádek (změna hodnoty / editace) – jen pokud je vidět
+    // ---------------------------------------------------------
+    void drawRow(const Theme* t, uint8_t idx) {
+        if (_drawRowOnly(t, idx)) push();
+    }
+
+    // ---------------------------------------------------------
+    //  Posun kurzoru o dir (±1) – false na okraji seznamu
+    // ---------------------------------------------------------
+    bool move(const Theme* t, int8_t dir) {
+        int16_t next = (int16_t)_cursor + dir;
+        while (next >= 0 && next < _count && _itemH((uint8_t)next) == 0) next += dir;
+        if (next < 0 || next >= _count) return false;
+        uint8_t prev      = _cursor;
+        uint8_t oldScroll = _scroll;
+        _cursor = (uint8_t)next;
+        _ensureVisible();
+
+        if (_scroll == oldScroll) {
+            _drawRowOnly(t, prev);
+            _drawRowOnly(t, _cursor);
+        } else if (_spr && _span(oldScroll, _scroll) <= LIST_SEC_H + LIST_ROW_H) {
+            _shift(t, oldScroll);
+            _drawRowOnly(t, prev);
+            _drawRowOnly(t, _cursor);
+        } else {
+            draw(t);
+            return true;
+        }
+        push();
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Y řádku idx na displeji (bez hlavičky sekce),
+    //  -1 = položka není celá vidět
+    // ---------------------------------------------------------
+    int16_t rowY(uint8_t idx) {
+        if (idx < _scroll || idx >= _count || _itemH(idx) == 0) return -1;
+        int16_t y = LIST_START_Y;
+        for (uint8_t i = _scroll; i < idx; i++) y += _itemH(i);
+        if (_hasSection(idx)) y += LIST_SEC_H;
+        return (y + LIST_ROW_H <= FTR_Y) ? y : -1;
+    }
+
+    // ---------------------------------------------------------
+    //  Cíl kreslení pro vlastní overlay screenu (IP editor):
+    //  t se přepne na indexy palety, dy = posun Y displej → cíl
+    // ---------------------------------------------------------
+    LovyanGFX* canvas(const Theme*& t, int16_t& dy) {
+        if (_spr) {
+            t  = Render::ink(_spr, t);
+            dy = -CONTENT_Y;
+            return _spr;
+        }
+        dy = 0;
+        return &tft;
+    }
+
+    void push() {
+        if (_spr) Render::push(_spr, 0, CONTENT_Y);
+    }
+
+    // ---------------------------------------------------------
+    //  Hodnota IP po oktetech s podtržením aktivního
+    //  (ListCustomFn pro Serial / Mqtt IP editor)
+    // ---------------------------------------------------------
+    static void drawIp(LovyanGFX* dc, const Theme* t, int16_t y,
+                       const uint8_t octets[4], uint8_t field) {
+        char parts[4][4];
+        for (uint8_t i = 0; i < 4; i++) snprintf(parts[i], 4, "%u", octets[i]);
+
+        dc->setFont(&fonts::Font2);
+        int16_t cx = 180;
+        for (uint8_t i = 0; i < 4; i++) {
+            bool    act = (field == i);
+            uint8_t w   = (uint8_t)strlen(parts[i]) * 8;
+
+            dc->setTextColor(act ? t->accent : t->text);
+            dc->setCursor(cx, y + 7);
+            dc->print(parts[i]);
+            if (act) dc->fillRect(cx, y + LIST_ROW_H - 4, w, 2, t->accent);
+            cx += w;
+
+            // Tečka za oktetem (kromě posledního)
+            if (i < 3) {
+                dc->setTextColor(t->dim);
+                dc->setCursor(cx, y + 7);
+                dc->print(".");
+                cx += 6;
+            }
+        }
+    }
+
+private:
+    LGFX_Sprite* _spr     = nullptr;
+    ListRowFn    _rowFn   = nullptr;
+    ListCustomFn _custom  = nullptr;
+    uint8_t      _count   = 0;
+    uint8_t      _cursor  = 0;
+    uint8_t      _scroll  = 0;      // první zobrazená položka
+    bool         _editing = false;
+
+    bool _hasSection(uint8_t idx) {
+        ListRow r = {};
+        _rowFn(idx, r);
+        return r.section != nullptr;
+    }
+
+    // Výška položky včetně hlavičky sekce, skrytá = 0
+    int16_t _itemH(uint8_t idx) {
+        ListRow r = {};
+        _rowFn(idx, r);
+        if (r.flags & LIST_HIDDEN) return 0;
+        return (r.section ? LIST_SEC_H : 0) + LIST_ROW_H;
+    }
+
+    // Výška položek mezi dvěma scroll pozicemi
+    int16_t _span(uint8_t a, uint8_t b) {
+        if (a > b) { uint8_t x = a; a = b; b = x; }
+        int16_t h = 0;
+        for (uint8_t i = a; i < b; i++) h += _itemH(i);
+        return h;
+    }
+
+    // První položka od scroll, která se nevejde celá (+ její Y)
+    uint8_t _firstCut(uint8_t scroll, int16_t& y) {
+        y = LIST_START_Y;
+        for (uint8_t i = scroll; i < _count; i++) {
+            int16_t h = _itemH(i);
+            if (y + h > FTR_Y) return i;
+            y += h;
+        }
+        return _count;
+    }
+
+    // Dokud je scroll nad kurzorem a kurzor přesahuje FTR_Y → scroll++
+    void _ensureVisible() {
+        if (_cursor < _scroll) {
+            _scroll = _cursor;
+            return;
+        }
+        while (_scroll < _cursor) {
+            int16_t y = LIST_START_Y;
+            for (uint8_t i = _scroll; i <= _cursor; i++) y += _itemH(i);
+            if (y <= FTR_Y) break;
+            _scroll++;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Nakresli položku idx od Y (displej) – vrací výšku,
+    //  0 = nevešla se ani hlavička sekce
+    // ---------------------------------------------------------
+    int16_t _paintItem(const Theme* t, uint8_t idx, int16_t y, bool withSection) {
+        ListRow row = {};
+        _rowFn(idx, row);
+        if (row.flags & LIST_HIDDEN) return 0;
+        int16_t    dy;
+        LovyanGFX* dc      = canvas(t, dy);
+        int16_t    sy      = y + dy;
+        int16_t    drawn   = 0;
+        bool       active  = (idx == _cursor);
+        bool       editing = (active && _editing);
+        bool       rdonly  = (row.flags & LIST_READONLY);
+
+        // Sekce header
+        if (row.section != nullptr) {
+            if (y + LIST_SEC_H > FTR_Y) return 0;
+            if (withSection) {
+                dc->fillRect(0, sy, 320, LIST_SEC_H, t->bg);
+                dc->setFont(&fonts::Font2);
+                dc->setTextColor(t->dim);
+                dc->setCursor(16, sy);
+                dc->print(row.section);
+                dc->drawFastHLine(16, sy + 14, 288, t->dim);
+            }
+            sy    += LIST_SEC_H;
+            drawn += LIST_SEC_H;
+        }
+
+        if (y + drawn + LIST_ROW_H > FTR_Y) return drawn;
+
+        // Pozadí řádku
+        if (active) {
+            dc->fillRect(8, sy, 304, LIST_ROW_H, t->header);
+            dc->fillRect(8, sy, 3,   LIST_ROW_H, t->accent);
+        } else {
+            dc->fillRect(8, sy, 304, LIST_ROW_H, t->bg);
+        }
+
+        // Label
+        dc->setFont(&fonts::Font2);
+        dc->setTextColor(rdonly ? t->dim : (active ? t->accent : t->text));
+        dc->setCursor(20, sy + 7);
+        dc->print(row.label);
+
+        // Hodnota
+        const char* val = row.value ? row.value : "";
+        if (row.flags & LIST_LINK) {
+            dc->setTextColor(active ? t->accent : t->dim);
+            dc->setTextDatum(middle_right);
+            dc->drawString(">>>", 308, sy + 12);
+        } else if (editing && (row.flags & LIST_CUSTOM) && _custom) {
+            _custom(dc, t, idx, sy);
+        } else if (row.flags & LIST_TEXT) {
+            dc->setTextColor(editing ? t->accent : t->text);
+            dc->setTextDatum(middle_right);
+            dc->drawString(val[0] && strcmp(val, "---") != 0 ? val : "---",
+                           active ? 290 : 303, sy + 12);
+            if (active) {
+                dc->setTextColor(t->dim);
+                dc->drawString(">>>", 308, sy + 12);
+            }
+        } else if (val[0]) {
+            uint16_t col = editing ? t->accent : t->text;
+            if (rdonly) {
+                col = row.tone == LIST_TONE_OK  ? t->ok
+                    : row.tone == LIST_TONE_ERR ? t->err : t->dim;
+            }
+            dc->setTextColor(col);
+            dc->setTextDatum(middle_right);
+            dc->drawString(val, 308, sy + 12);
+        }
+        dc->setTextDatum(top_left);
+
+        return drawn + LIST_ROW_H;
+    }
+
+    // Smaž od Y do FTR_Y a kresli položky od idx, dokud se vejdou
+    void _paintFrom(const Theme* t, uint8_t idx, int16_t y) {
+        if (y < FTR_Y) {
+            int16_t    dy;
+            const Theme* ti = t;
+            LovyanGFX* dc = canvas(ti, dy);
+            dc->fillRect(0, y + dy, 320, FTR_Y - y, ti->bg);
+        }
+        for (uint8_t i = idx; i < _count; i++) {
+            int16_t h = _paintItem(t, i, y, true);
+            if (h < _itemH(i)) break;
+            y += h;
+        }
+    }
+
+    // Jen řádek položky (bez hlavičky) – false pokud není vidět
+    bool _drawRowOnly(const Theme* t, uint8_t idx) {
+        int16_t y = rowY(idx);
+        if (y < 0) return false;
+        if (_hasSection(idx)) y -= LIST_SEC_H;
+        _paintItem(t, idx, y, false);
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Scroll o jednu položku posunem obsahu spritu
+    // ---------------------------------------------------------
+    void _moveRows(int16_t dstY, int16_t srcY, int16_t rows) {
+        if (rows <= 0) return;
+        int32_t  stride = (int32_t)_spr->width() * (_spr->getColorDepth() & 0xFF) / 8;
+        uint8_t* buf    = (uint8_t*)_spr->getBuffer();
+        memmove(buf + (int32_t)(dstY - CONTENT_Y) * stride,
+                buf + (int32_t)(srcY - CONTENT_Y) * stride,
+                rows * stride);
+    }
+
+    void _shift(const Theme* t, uint8_t oldScroll) {
+        int16_t yCut;
+        if (_scroll > oldScroll) {
+            // Dolů – horní položka odjede, obsah nahoru o její výšku
+            int16_t h   = _span(oldScroll, _scroll);
+            uint8_t cut = _firstCut(oldScroll, yCut);
+            _moveRows(LIST_START_Y, LIST_START_Y + h, FTR_Y - LIST_START_Y - h);
+            _paintFrom(t, cut, yCut - h);
+        } else {
+            // Nahoru – nová horní položka, obsah dolů o její výšku
+            int16_t h = _span(_scroll, oldScroll);
+            _moveRows(LIST_START_Y + h, LIST_START_Y, FTR_Y - LIST_START_Y - h);
+            int16_t    dy;
+            const Theme* ti = t;
+            LovyanGFX* dc = canvas(ti, dy);
+            dc->fillRect(0, LIST_START_Y + dy, 320, h, ti->bg);
+            _paintItem(t, _scroll, LIST_START_Y, true);
+            // Co vyjelo pod FTR_Y, zmizí; hlavička sekce se může vejít
+            uint8_t cut = _firstCut(_scroll, yCut);
+            _paintFrom(t, cut, yCut);
+        }
+    }
+};
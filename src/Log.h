@@ -0,0 +1,27 @@
+// =============================================================
+//  Log.h – diagnostické výpisy, které jde ztlumit
+//
+//  Během exportu přes USB (ExportServer) nese Serial datový
+//  proud – výpis z Boiler / Inverter tasku nebo z loop() by se
+//  do něj vmíchal a rozbil chunked rámce. Moduly, které
+//  vypisují za běhu (tasky, render, relé, switch, obrazovky),
+//  proto píšou přes LOGF / LOGLN a ExportServer po dobu USB
+//  exportu nastaví Log::muted.
+//
+//  Přímo na Serial.printf zůstávají jen výpisy při startu
+//  (begin() / setup) – export se spouští až za běhu příkazem.
+//  Kontrola: host/scripts/export_quiet.txt
+//
+//  Použití:
+//    LOGF("[BC] Zásobník %u: HEATING\n", idx);
+//    LOGLN("[INV] Task spusten");
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+namespace Log {
+    static volatile bool muted = false;     // true = USB linka nese export
+}
+
+#define LOGF(...)   do { if (!Log::muted) Serial.printf(__VA_ARGS__); } while (0)
+#define LOGLN(...)  do { if (!Log::muted) Serial.println(__VA_ARGS__); } while (0)
@@ -2,15 +2,29 @@
 //  MCP23017.h  –  Driver pro I2C GPIO expander
 //  Čip má 16 výstupů rozdělených do dvou portů A a B.
 //  Používáme ho pro relé (výstupy) a RS485 DE/RE.
+//  Jeden čip = jedna deska 10 relé; víc desek spojuje RelayBank.
 //
 //  Graceful degradace: pokud čip není přítomen (begin() vrátí false),
 //  všechna volání setRelay(), setRS485Transmit() jsou tiše ignorována.
 //  Systém funguje bez MCP23017 – jen bez relé a RS485.
+//
+//  Dávka relé (BoilerController::tick):
+//    beginBatch();             // setRelay() jen mění stín portů
+//    setRelay(...) × N;
+//    commit();                 // 1× zápis OLATA+OLATB, zpětné
+//                              // čtení GPIOA/B a porovnání
+//  Nesouhlas pinů se stínem zvýší verifyErrors() a drží
+//  relayFault() do první úspěšné kontroly. Další commit zapíše
+//  latch znovu, i když se stín nezměnil.
+//  Mimo dávku (Discovery, RS485 DE/RE) zapisuje setRelay() hned.
+//  Index relé je lokální na čipu (0–9).
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <Wire.h>
 #include "HW_Config.h"
+#include "I2cBus.h"
 
 // Interní registry MCP23017
 #define MCP_IODIRA    0x00   // směr portu A (1=vstup, 0=výstup)
@@ -20,19 +34,24 @@
 #define MCP_OLATA     0x14   // output latch A
 #define MCP_OLATB     0x15   // output latch B
 
+// Piny relé na portu B (relé 8–9 = GPB0–GPB1), GPB7 = RS485
+#define MCP_RELAY_MASK_B  ((uint8_t)((1 << (MCP_RELAYS_PER_CHIP - 8)) - 1))
+
 class MCP23017 {
 public:
+    explicit MCP23017(uint8_t addr = ADDR_MCP23017) : _addr(addr) {}
+
     // ---------------------------------------------------------
     //  Inicializace – nastaví všechny piny jako výstupy, vše vypnuto
     //  Vrátí false pokud čip není přítomen – systém funguje dál
     // ---------------------------------------------------------
     bool begin() {
-        Wire.beginTransmission(ADDR_MCP23017);
+        Wire.beginTransmission(_addr);
         Wire.write(MCP_IODIRA);
         Wire.write(0x00);   // Port A: výstupy
         Wire.write(0x00);   // Port B: výstupy
         if (Wire.endTransmission() != 0) {
-            Serial.println("[MCP23017] WARN: Čip nenalezen – relé/RS485 nedostupné");
+            Serial.printf("[MCP23017] WARN: Čip 0x%02X nenalezen – jeho relé nedostupná\n", _addr);
             _available = false;
             return false;
         }
@@ -41,8 +60,9 @@ public:
         _portB = 0x00;
         writeAll();
         _available = true;
+        _verify();
 
-        Serial.println("[MCP23017] OK");
+        Serial.printf("[MCP23017] 0x%02X OK\n", _addr);
         return true;
     }
 
@@ -52,16 +72,39 @@ public:
     // ---------------------------------------------------------
     void setRelay(uint8_t index, bool state) {
         if (!_available) return;
-        if (index >= MCP_RELAY_COUNT) return;
+        if (index >= MCP_RELAYS_PER_CHIP) return;
 
         if (index < 8) {
             bitWrite(_portA, index, state);
         } else {
             bitWrite(_portB, index - 8, state);
         }
+        if (!_batch) writeAll();
+    }
+
+    // ---------------------------------------------------------
+    //  Dávka – setRelay() do commit() jen mění stín portů
+    // ---------------------------------------------------------
+    void beginBatch() { _batch = true; }
+
+    // ---------------------------------------------------------
+    //  Zapiš dávku jednou transakcí a ověř zpětným čtením
+    //  Vrátí false při nesouhlasu pinů (nebo chybě I2C)
+    // ---------------------------------------------------------
+    bool commit() {
+        _batch = false;
+        if (!_available) return true;
+        if (_portA == _latchA && _portB == _latchB && !_fault) return true;
         writeAll();
+        return _verify();
     }
 
+    // Počet nesouhlasů zpětného čtení od startu
+    uint16_t verifyErrors() const { return _verifyErrors; }
+
+    // Poslední kontrola nesouhlasila (alarm)
+    bool relayFault() const { return _fault; }
+
     // ---------------------------------------------------------
     //  Nastav RS485 DE/RE pin (GPB7)
     //  Tiše ignoruje pokud čip není přítomen
@@ -69,7 +112,7 @@ public:
     void setRS485Transmit(bool transmit) {
         if (!_available) return;
         bitWrite(_portB, 7, transmit);
-        writeAll();
+        if (!_batch) writeAll();
     }
 
     // ---------------------------------------------------------
@@ -77,7 +120,7 @@ public:
     // ---------------------------------------------------------
     bool getRelay(uint8_t index) const {
         if (!_available) return false;
-        if (index >= MCP_RELAY_COUNT) return false;
+        if (index >= MCP_RELAYS_PER_CHIP) return false;
         if (index < 8) return bitRead(_portA, index);
         return bitRead(_portB, index - 8);
     }
@@ -89,8 +132,8 @@ public:
         if (!_available) return;
         _portA = 0x00;
         _portB &= 0x80;  // zachovej RS485 bit
-        writeAll();
-        Serial.println("[MCP23017] Všechna relé vypnuta");
+        if (!_batch) writeAll();
+        LOGF("[MCP23017] 0x%02X všechna relé vypnuta\n", _addr);
     }
 
     // ---------------------------------------------------------
@@ -103,29 +146,67 @@ public:
     // ---------------------------------------------------------
     void printStatus() const {
         if (!_available) {
-            Serial.println("[MCP23017] Čip nedostupný");
+            LOGF("[MCP23017] 0x%02X nedostupný\n", _addr);
             return;
         }
-        Serial.print("[MCP23017] Stav relé: ");
-        for (int i = 0; i < MCP_RELAY_COUNT; i++) {
-            Serial.print(getRelay(i) ? "1" : "0");
+        LOGF("[MCP23017] 0x%02X relé: ", _addr);
+        for (int i = 0; i < MCP_RELAYS_PER_CHIP; i++) {
+            LOGF("%s", getRelay(i) ? "1" : "0");
         }
-        Serial.printf("  RS485: %s\n",
-            bitRead(_portB, 7) ? "TX" : "RX");
+        LOGF("  RS485: %s  verify chyb: %u%s\n",
+            bitRead(_portB, 7) ? "TX" : "RX",
+            _verifyErrors, _fault ? " (FAULT)" : "");
     }
 
 private:
-    uint8_t _portA     = 0x00;
-    uint8_t _portB     = 0x00;
-    bool    _available = false;  // true = čip nalezen a inicializován
+    uint8_t  _addr;
+    uint8_t  _portA        = 0x00;   // stín výstupů
+    uint8_t  _portB        = 0x00;
+    uint8_t  _latchA       = 0x00;   // naposledy zapsáno do OLAT
+    uint8_t  _latchB       = 0x00;
+    bool     _available    = false;  // true = čip nalezen a inicializován
+    bool     _batch        = false;
+    bool     _fault        = false;
+    uint16_t _verifyErrors = 0;
 
     void writeAll() {
-        Wire.beginTransmission(ADDR_MCP23017);
+        I2cBus::Lock lock;
+        Wire.beginTransmission(_addr);
         Wire.write(MCP_OLATA);
         Wire.write(_portA);
         Wire.write(_portB);
         Wire.endTransmission();
+        _latchA = _portA;
+        _latchB = _portB;
+    }
+
+    // ---------------------------------------------------------
+    //  Zpětné čtení GPIOA/GPIOB (sekvenční čtení 2 B)
+    //  Porovnává jen piny relé – RS485 DE/RE se přepíná za běhu
+    // ---------------------------------------------------------
+    bool _verify() {
+        uint8_t a = 0, b = 0;
+        bool    ok = false;
+        {
+            I2cBus::Lock lock;
+            Wire.beginTransmission(_addr);
+            Wire.write(MCP_GPIOA);
+            if (Wire.endTransmission(false) == 0 &&
+                Wire.requestFrom(_addr, 2) == 2) {
+                a  = Wire.read();
+                b  = Wire.read();
+                ok = a == _latchA && (b & MCP_RELAY_MASK_B) == (_latchB & MCP_RELAY_MASK_B);
+            }
+        }
+        if (!ok) {
+            _verifyErrors++;
+            LOGF("[MCP23017] 0x%02X VERIFY FAIL #%u: zapsáno A=%02X B=%02X, čteno A=%02X B=%02X\n",
+                _addr, _verifyErrors, _latchA, _latchB, a, b);
+        } else if (_fault) {
+            LOGF("[MCP23017] 0x%02X verify OK – relé opět souhlasí\n", _addr);
+        }
+        _fault = !ok;
+        return ok;
     }
 };
 
-extern MCP23017 gMCP;
@@ -27,6 +27,7 @@
 #include "Header.h"
 #include "ScreenManager.h"
 #include "FiveWaySwitch.h"
+#include "Render.h"
 
 // Rozměry dlaždic
 #define MAIN_LEFT_W     160     // šířka levého sloupce
@@ -43,6 +44,11 @@ namespace MainScreen {
     static LGFX_Sprite _sprRight(&tft);
     static bool        _spritesCreated = false;
 
+    // Data, ze kterých jsou sloupce nakreslené – update() kreslí
+    // sloupec jen při změně jeho hodnot
+    static SolarData   _shown   = {};
+    static bool        _shownOk = false;
+
     // ---------------------------------------------------------
     //  Pomocná funkce: formátuj výkon
     // ---------------------------------------------------------
@@ -57,10 +63,15 @@ namespace MainScreen {
     // ---------------------------------------------------------
     //  Inicializace spriteů – jednou při prvním draw()
     // ---------------------------------------------------------
-    static void _initSprites() {
+    static void _initSprites(const Theme* t) {
         if (_spritesCreated) return;
+        // 4 bity/px s paletou tématu – 2× 15 KB místo 2× 59 KB
+        _sprLeft.setColorDepth(4);
+        _sprRight.setColorDepth(4);
         _sprLeft.createSprite(MAIN_LEFT_W, CONTENT_H);
         _sprRight.createSprite(MAIN_RIGHT_W, CONTENT_H);
+        Render::attach(&_sprLeft, t);
+        Render::attach(&_sprRight, t);
         _spritesCreated = true;
     }
 
@@ -88,21 +99,26 @@ namespace MainScreen {
     //  Nakresli hodnoty levého sloupce (Výroba + Baterie)
     // ---------------------------------------------------------
     static void _drawLeft(const Theme* t, const SolarData& d) {
+        t = Render::ink(&_sprLeft, t);     // sprite je paletový → indexy
         _sprLeft.fillScreen(t->bg);
         _sprLeft.drawFastHLine(0, MAIN_TILE_H, MAIN_LEFT_W, t->splitline);
 
         char buf[16];
 
+        // Hodnoty ze snapshotu po startu (stale) – šedě, dokud nepřijdou živá data
+        bool     show   = d.valid || d.stale;
+        uint16_t colVal = d.valid ? t->text : t->dim;
+
         // --- Výroba ---
         _sprLeft.setFont(&fonts::DejaVu18);
         _sprLeft.setTextDatum(top_left);
         _sprLeft.setTextColor(t->dim);
         _sprLeft.drawString("Vyroba", 5, 5);
 
-        if (d.valid) {
+        if (show) {
             _fmtPower(buf, sizeof(buf), d.powerPV);
             _sprLeft.setFont(&fonts::DejaVu40);
-            _sprLeft.setTextColor(t->text);
+            _sprLeft.setTextColor(colVal);
             _sprLeft.setTextDatum(top_right);
             _sprLeft.drawString(buf, 130, 30);
 
@@ -135,7 +151,7 @@ namespace MainScreen {
         _sprLeft.setTextColor(t->dim);
         _sprLeft.drawString("Baterie", 5, bat_y + 10);
 
-        if (d.valid) {
+        if (show) {
             _sprLeft.setFont(&fonts::DejaVu18);
             _sprLeft.setTextColor(t->dim);
             _sprLeft.setCursor(90, bat_y + 10);
@@ -145,7 +161,7 @@ namespace MainScreen {
 
             snprintf(buf, sizeof(buf), "%u", d.soc);
             _sprLeft.setFont(&fonts::DejaVu40);
-            _sprLeft.setTextColor(t->ok);
+            _sprLeft.setTextColor(d.valid ? t->ok : t->dim);
             _sprLeft.setTextDatum(top_right);
             _sprLeft.drawString(buf, 130, bat_y + 30);
 
@@ -156,7 +172,7 @@ namespace MainScreen {
 
             int16_t bar_y    = bat_y + 70;
             int16_t fill     = (int16_t)(d.soc * 140 / 100);
-            uint16_t barColor = (d.soc > 20) ? t->ok : t->err;
+            uint16_t barColor = !d.valid ? t->text : (d.soc > 20) ? t->ok : t->err;
             _sprLeft.fillRect(10, bar_y, 140, 10, t->dim);
             _sprLeft.fillRect(10, bar_y, fill, 10, barColor);
         } else {
@@ -170,7 +186,7 @@ namespace MainScreen {
             _sprLeft.drawString(" %", 122, bat_y + 40);
         }
 
-        _sprLeft.pushSprite(0, CONTENT_Y);
+        Render::push(&_sprLeft, 0, CONTENT_Y);
     }
 
     // ---------------------------------------------------------
@@ -178,6 +194,7 @@ namespace MainScreen {
     //  Popisek "Pretok" a legenda se kreslí VŽDY – i bez dat.
     // ---------------------------------------------------------
     static void _drawRight(const Theme* t, const SolarData& d) {
+        t = Render::ink(&_sprRight, t);     // sprite je paletový → indexy
         _sprRight.fillScreen(t->bg);
         _sprRight.drawFastVLine(0, 0, CONTENT_H, t->splitline);
 
@@ -206,10 +223,10 @@ namespace MainScreen {
             _sprRight.setCursor(10, rowY[i]);
             _sprRight.print(labels[i]);
 
-            if (d.valid) {
-                // Barevná hodnota
+            if (d.valid || d.stale) {
+                // Barevná hodnota (snapshot po startu šedě)
                 _fmtPower(buf, sizeof(buf), phases[i]);
-                _sprRight.setTextColor(phases[i] >= 0 ? t->ok : t->err);
+                _sprRight.setTextColor(!d.valid ? t->dim : phases[i] >= 0 ? t->ok : t->err);
                 _sprRight.setTextDatum(top_right);
                 _sprRight.drawString(buf, 130, rowY[i]);
             } else {
@@ -225,7 +242,32 @@ namespace MainScreen {
             _sprRight.drawString(" W", 126, rowY[i]);
         }
 
-        _sprRight.pushSprite(MAIN_RIGHT_X, CONTENT_Y);
+        Render::push(&_sprRight, MAIN_RIGHT_X, CONTENT_Y);
+    }
+
+    static bool _leftChanged(const SolarData& d) {
+        return !_shownOk ||
+               d.valid != _shown.valid || d.stale != _shown.stale ||
+               d.powerPV != _shown.powerPV ||
+               d.energyPvToday != _shown.energyPvToday ||
+               d.powerBattery != _shown.powerBattery ||
+               d.soc != _shown.soc;
+    }
+
+    static bool _rightChanged(const SolarData& d) {
+        return !_shownOk ||
+               d.valid != _shown.valid || d.stale != _shown.stale ||
+               d.phaseL1 != _shown.phaseL1 ||
+               d.phaseL2 != _shown.phaseL2 ||
+               d.phaseL3 != _shown.phaseL3;
+    }
+
+    // Překresli jen sloupce, jejichž hodnoty se změnily
+    static void _drawChanged(const Theme* t, const SolarData& d) {
+        if (_leftChanged(d))  _drawLeft(t, d);
+        if (_rightChanged(d)) _drawRight(t, d);
+        _shown   = d;
+        _shownOk = true;
     }
 
     // ==========================================================
@@ -236,13 +278,13 @@ namespace MainScreen {
               uint8_t apState, uint8_t staState, uint8_t invState,
               bool alarm, const SolarData& d) {
 
-        _initSprites();
+        _initSprites(t);
         tft.fillScreen(t->bg);
         Header::draw(t, dt, apState, staState, invState, alarm);
         Header::drawFooter(t, d);
         _drawStatic(t);
-        _drawLeft(t, d);
-        _drawRight(t, d);
+        _shownOk = false;
+        _drawChanged(t, d);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -250,8 +292,7 @@ namespace MainScreen {
                 bool alarm, const SolarData& d) {
 
         Header::update(t, dt, apState, staState, invState, alarm);
-        _drawLeft(t, d);
-        _drawRight(t, d);
+        _drawChanged(t, d);
         Header::updateFooter(t, d);
     }
 
@@ -264,15 +305,17 @@ namespace MainScreen {
 
     void begin(const Theme* t, const char* version) {
         (void)version;
-        _initSprites();
+        _initSprites(t);
         tft.fillScreen(t->bg);
+        Render::invalidate(&_sprLeft);
+        Render::invalidate(&_sprRight);
         static SolarData empty   = {};
         static DateTime  emptyDt = {};
         Header::draw(t, emptyDt, DOT_OFF, DOT_OFF, DOT_OFF, false);
         Header::drawFooter(t, empty);
         _drawStatic(t);
-        _drawLeft(t, empty);
-        _drawRight(t, empty);
+        _shownOk = false;
+        _drawChanged(t, empty);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -282,11 +325,10 @@ namespace MainScreen {
         uint8_t ap  = wifiAp  ? DOT_OK : DOT_OFF;
         uint8_t sta = wifiSta ? DOT_OK : DOT_OFF;
         uint8_t inv = d.invOnline ? DOT_OK : DOT_ERROR;
-        bool alarm  = (d.invStatus == 3);
+        bool alarm  = (d.invStatus == 3) || d.relayFault;
         Header::update(t, dt, ap, sta, inv, alarm);
         Header::updateFooter(t, d);
-        _drawLeft(t, d);
-        _drawRight(t, d);
+        _drawChanged(t, d);
     }
 
 } // namespace MainScreen
\ No newline at end of file
@@ -1,7 +1,7 @@
 // =============================================================
 //  MenuScreen.h – hlavní menu
 //
-//  Položky: Historie / Diagnostika / Nastavení / Instalace / Zpět
+//  Položky: Historie / Trend / Diagnostika / Nastavení / Instalace
 //
 //  Navigace:
 //    UP/DOWN  – pohyb kurzoru (scroll pokud více než MENU_VISIBLE)
@@ -30,6 +30,7 @@ namespace MenuScreen {
 
     static const MenuItem _items[] = {
         { "Historie",    SCREEN_HISTORY,    true  },
+        { "Trend",       SCREEN_TREND,      true  },
         { "Diagnostika", SCREEN_DIAGNOSTIC, true  },
         { "Nastaveni",   SCREEN_SETTING,    true  },
         { "Instalace",   SCREEN_PASSWORD,   true  },
@@ -3,9 +3,13 @@
 // ModbusClient.h – Modbus RTU a TCP klient pro Raspberry Pi Pico 2W
 // Podporuje Function Code 03 (Read Holding Registers)
 //             Function Code 06 (Write Single Register)
+//             Function Code 01 (Read Coils)            – relé desky
+//             Function Code 05 (Write Single Coil)     – relé desky
+//             Function Code 15 (Write Multiple Coils)  – relé desky
 // =============================================================================
 
 #include <Arduino.h>
+#include "Log.h"
 #include <WiFiClient.h>
 
 // UART pro RS485 (dle HW_Config.h)
@@ -29,6 +33,12 @@ typedef void (*ModbusDeReCallback)(bool transmit);
 // Modbus funkční kódy
 #define FC_READ_HOLDING_REGS    0x03
 #define FC_WRITE_SINGLE_REG     0x06
+#define FC_READ_COILS           0x01
+#define FC_WRITE_SINGLE_COIL    0x05
+#define FC_WRITE_MULTIPLE_COILS 0x0F
+
+// Max. počet cívek v jednom FC01/FC15 (rámec ≤ 32 B)
+#define MODBUS_MAX_COILS        64
 
 // Chybové kódy
 enum ModbusError : uint8_t {
@@ -99,6 +109,30 @@ public:
         uint16_t value
     ) = 0;
 
+    // Přečte count cívek od startAddr (FC01)
+    // bits: LSB první cívky v bits[0], (count+7)/8 bajtů
+    virtual ModbusError readCoils(
+        uint8_t  slaveId,
+        uint16_t startAddr,
+        uint8_t  count,
+        uint8_t* bits
+    ) = 0;
+
+    // Zapíše jednu cívku (FC05)
+    virtual ModbusError writeSingleCoil(
+        uint8_t  slaveId,
+        uint16_t addr,
+        bool     on
+    ) = 0;
+
+    // Zapíše count cívek od startAddr jedním rámcem (FC15)
+    virtual ModbusError writeMultipleCoils(
+        uint8_t        slaveId,
+        uint16_t       startAddr,
+        uint8_t        count,
+        const uint8_t* bits
+    ) = 0;
+
     virtual ~ModbusClient() {}
 };
 
@@ -135,7 +169,7 @@ public:
         auto cfg = buildSerialConfig(_dataBits, _parity, _stopBits);
         MODBUS_UART.begin(_baudRate, cfg);
 
-        Serial.printf("[RTU] UART init: %lu baud, %u%c%u\n",
+        LOGF("[RTU] UART init: %lu baud, %u%c%u\n",
             _baudRate, _dataBits,
             _parity == 0 ? 'N' : (_parity == 1 ? 'E' : 'O'),
             _stopBits);
@@ -231,6 +265,62 @@ public:
         return MODBUS_OK;
     }
 
+    ModbusError readCoils(
+        uint8_t slaveId, uint16_t startAddr,
+        uint8_t count, uint8_t* bits) override
+    {
+        if (count == 0 || count > MODBUS_MAX_COILS) return MODBUS_ERR_FRAME;
+        // [SlaveID][FC=01][AddrHi][AddrLo][CntHi][CntLo] → [SlaveID][FC][ByteCount][bity...]
+        uint8_t req[6] = { slaveId, FC_READ_COILS,
+                           (uint8_t)(startAddr >> 8), (uint8_t)startAddr,
+                           0, count };
+        uint8_t nBytes = (count + 7) / 8;
+        uint8_t resp[5 + MODBUS_MAX_COILS / 8];
+        ModbusError err = _transact(req, 6, resp, 5 + nBytes);
+        if (err != MODBUS_OK) return err;
+        if (resp[2] != nBytes) return MODBUS_ERR_WRONG_RESP;
+        memcpy(bits, resp + 3, nBytes);
+        return MODBUS_OK;
+    }
+
+    ModbusError writeSingleCoil(
+        uint8_t slaveId, uint16_t addr, bool on) override
+    {
+        // Hodnota 0xFF00 = zapnuto, 0x0000 = vypnuto; odpověď = echo
+        uint8_t req[6] = { slaveId, FC_WRITE_SINGLE_COIL,
+                           (uint8_t)(addr >> 8), (uint8_t)addr,
+                           (uint8_t)(on ? 0xFF : 0x00), 0 };
+        uint8_t resp[8];
+        ModbusError err = _transact(req, 6, resp, 8);
+        if (err != MODBUS_OK) return err;
+        if (memcmp(resp, req, 6) != 0) return MODBUS_ERR_WRONG_RESP;
+        return MODBUS_OK;
+    }
+
+    ModbusError writeMultipleCoils(
+        uint8_t slaveId, uint16_t startAddr,
+        uint8_t count, const uint8_t* bits) override
+    {
+        if (count == 0 || count > MODBUS_MAX_COILS) return MODBUS_ERR_FRAME;
+        // [SlaveID][FC=15][AddrHi][AddrLo][CntHi][CntLo][ByteCount][bity...]
+        // Odpověď: [SlaveID][FC][AddrHi][AddrLo][CntHi][CntLo][CRC]
+        uint8_t nBytes = (count + 7) / 8;
+        uint8_t req[7 + MODBUS_MAX_COILS / 8];
+        req[0] = slaveId;
+        req[1] = FC_WRITE_MULTIPLE_COILS;
+        req[2] = (startAddr >> 8) & 0xFF;
+        req[3] = startAddr & 0xFF;
+        req[4] = 0;
+        req[5] = count;
+        req[6] = nBytes;
+        memcpy(req + 7, bits, nBytes);
+        uint8_t resp[8];
+        ModbusError err = _transact(req, 7 + nBytes, resp, 8);
+        if (err != MODBUS_OK) return err;
+        if (memcmp(resp, req, 6) != 0) return MODBUS_ERR_WRONG_RESP;
+        return MODBUS_OK;
+    }
+
 private:
     uint32_t           _baudRate;
     ModbusDeReCallback _dereCallback;
@@ -247,10 +337,43 @@ private:
         while (MODBUS_UART.available()) MODBUS_UART.read();
     }
 
+    // ---------------------------------------------------------
+    //  Odešli req (bez CRC) a přečti odpověď délky respLen (s CRC)
+    //  Exception odpověď je kratší (5 B) – pozná se podle FC | 0x80
+    // ---------------------------------------------------------
+    ModbusError _transact(const uint8_t* req, uint8_t reqLen,
+                          uint8_t* resp, uint8_t respLen) {
+        uint8_t  frame[7 + MODBUS_MAX_COILS / 8 + 2];
+        memcpy(frame, req, reqLen);
+        uint16_t crc = _crc16(frame, reqLen);
+        frame[reqLen]     = crc & 0xFF;
+        frame[reqLen + 1] = (crc >> 8) & 0xFF;
+
+        _flushRx();
+        _setDE(true);
+        MODBUS_UART.write(frame, reqLen + 2);
+        MODBUS_UART.flush();
+        _setDE(false);
+
+        uint8_t received = _readBytes(resp, 5, MODBUS_RESPONSE_TIMEOUT_MS);
+        if (received < 5)            return MODBUS_ERR_TIMEOUT;
+        if (resp[0] != req[0])       return MODBUS_ERR_WRONG_RESP;
+        if (resp[1] == (req[1] | 0x80)) return MODBUS_ERR_EXCEPTION;
+        if (resp[1] != req[1])       return MODBUS_ERR_WRONG_RESP;
+
+        received += _readBytes(resp + 5, respLen - 5, MODBUS_RESPONSE_TIMEOUT_MS);
+        if (received < respLen)      return MODBUS_ERR_FRAME;
+
+        uint16_t rxCrc   = resp[respLen - 2] | (resp[respLen - 1] << 8);
+        uint16_t calcCrc = _crc16(resp, respLen - 2);
+        if (rxCrc != calcCrc)        return MODBUS_ERR_CRC;
+        return MODBUS_OK;
+    }
+
     uint8_t _readBytes(uint8_t* buf, uint8_t maxLen, uint32_t timeoutMs) {
-        uint32_t deadline = millis() + timeoutMs;
+        uint32_t start = millis();            // rozdíl – přetečení millis() nevadí
         uint8_t idx = 0;
-        while (idx < maxLen && millis() < deadline) {
+        while (idx < maxLen && millis() - start < timeoutMs) {
             if (MODBUS_UART.available()) {
                 buf[idx++] = MODBUS_UART.read();
             }
@@ -373,6 +496,51 @@ public:
         return MODBUS_OK;
     }
 
+    ModbusError readCoils(
+        uint8_t slaveId, uint16_t startAddr,
+        uint8_t count, uint8_t* bits) override
+    {
+        if (count == 0 || count > MODBUS_MAX_COILS) return MODBUS_ERR_FRAME;
+        uint8_t pdu[5] = { FC_READ_COILS,
+                           (uint8_t)(startAddr >> 8), (uint8_t)startAddr,
+                           0, count };
+        uint8_t nBytes = (count + 7) / 8;
+        uint8_t resp[9 + MODBUS_MAX_COILS / 8];
+        ModbusError err = _transact(slaveId, pdu, 5, resp, 9 + nBytes);
+        if (err != MODBUS_OK) return err;
+        if (resp[8] != nBytes) return MODBUS_ERR_WRONG_RESP;
+        memcpy(bits, resp + 9, nBytes);
+        return MODBUS_OK;
+    }
+
+    ModbusError writeSingleCoil(
+        uint8_t slaveId, uint16_t addr, bool on) override
+    {
+        uint8_t pdu[5] = { FC_WRITE_SINGLE_COIL,
+                           (uint8_t)(addr >> 8), (uint8_t)addr,
+                           (uint8_t)(on ? 0xFF : 0x00), 0 };
+        uint8_t resp[12];
+        return _transact(slaveId, pdu, 5, resp, 12);
+    }
+
+    ModbusError writeMultipleCoils(
+        uint8_t slaveId, uint16_t startAddr,
+        uint8_t count, const uint8_t* bits) override
+    {
+        if (count == 0 || count > MODBUS_MAX_COILS) return MODBUS_ERR_FRAME;
+        uint8_t nBytes = (count + 7) / 8;
+        uint8_t pdu[6 + MODBUS_MAX_COILS / 8];
+        pdu[0] = FC_WRITE_MULTIPLE_COILS;
+        pdu[1] = (startAddr >> 8) & 0xFF;
+        pdu[2] = startAddr & 0xFF;
+        pdu[3] = 0;
+        pdu[4] = count;
+        pdu[5] = nBytes;
+        memcpy(pdu + 6, bits, nBytes);
+        uint8_t resp[12];
+        return _transact(slaveId, pdu, 6 + nBytes, resp, 12);
+    }
+
 private:
     uint8_t    _ip[4];
     uint16_t   _port;
@@ -402,10 +570,37 @@ private:
         return _connect();
     }
 
+    // MBAP hlavička + PDU, odpověď délky respLen (s MBAP)
+    ModbusError _transact(uint8_t slaveId, const uint8_t* pdu, uint8_t pduLen,
+                          uint8_t* resp, uint8_t respLen) {
+        if (!_ensureConnected()) return MODBUS_ERR_NO_CONN;
+
+        uint16_t tid = _nextTransactionId();
+        uint8_t  req[7 + 6 + MODBUS_MAX_COILS / 8];
+        req[0] = (tid >> 8) & 0xFF;
+        req[1] = tid & 0xFF;
+        req[2] = 0;
+        req[3] = 0;
+        req[4] = 0;
+        req[5] = pduLen + 1;                // UnitID + PDU
+        req[6] = slaveId;
+        memcpy(req + 7, pdu, pduLen);
+        _client.write(req, 7 + pduLen);
+
+        uint8_t received = _readTCP(resp, 9, MODBUS_RESPONSE_TIMEOUT_MS);
+        if (received < 9)            return MODBUS_ERR_TIMEOUT;
+        if (resp[7] & 0x80)          return MODBUS_ERR_EXCEPTION;
+        if (resp[7] != pdu[0])       return MODBUS_ERR_WRONG_RESP;
+        if ((((uint16_t)resp[0] << 8) | resp[1]) != tid) return MODBUS_ERR_WRONG_RESP;
+        received += _readTCP(resp + 9, respLen - 9, MODBUS_RESPONSE_TIMEOUT_MS);
+        if (received < respLen)      return MODBUS_ERR_FRAME;
+        return MODBUS_OK;
+    }
+
     uint8_t _readTCP(uint8_t* buf, uint8_t maxLen, uint32_t timeoutMs) {
-        uint32_t deadline = millis() + timeoutMs;
+        uint32_t start = millis();            // rozdíl – přetečení millis() nevadí
         uint8_t idx = 0;
-        while (idx < maxLen && millis() < deadline) {
+        while (idx < maxLen && millis() - start < timeoutMs) {
             if (_client.available()) {
                 buf[idx++] = _client.read();
             }
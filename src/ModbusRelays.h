@@ -0,0 +1,249 @@
+// =============================================================
+//  ModbusRelays.h – relé zásobníků na Modbus RTU deskách (RS485)
+//
+//  Zásobníky mimo dosah desek MCP23017 spíná standardní Modbus
+//  RTU reléová deska (cívky FC05/FC15) na stejné lince RS485
+//  jako měnič. Zásobník se na ni přiřadí v BoilerConfig:
+//    relaySlave = 0        → lokální relé MCP23017 (výchozí)
+//    relaySlave = 1–32     → slave ID desky, relayCoil = cívka
+//
+//  RelayBank::setRelay() jen zapíše požadovaný stav (want) a
+//  označí cívku jako změněnou. Linku vlastní InverterDriver –
+//  service() volá mezi čtením registrů měniče a během čekání na
+//  další poll (kick() ho probudí), takže zápis relé nečeká na
+//  celý poll a poll nečeká na relé déle než jednu transakci.
+//
+//  Zápis jedné desky:
+//    1 změněná cívka → FC05, víc → jeden FC15 přes rozsah
+//    změněných cívek (nezměněné v rozsahu se zapíší se
+//    stejnou hodnotou) → FC01 zpětné čtení a porovnání.
+//  Nesouhlas / chyba komunikace → fault, errors++ a opakování
+//  po MBR_RETRY_MS. Jednou za MBR_VERIFY_MS se použité cívky
+//  přečtou i bez změny (deska mohla ztratit napájení).
+//
+//  Vlákna: set()/get()/kick() z Boiler tasku i UI (Discovery),
+//  service() jen z Inverter tasku. Stav pod mutexem, I/O mimo.
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include "ModbusClient.h"
+
+#define MBR_MAX_BOARDS    8         // různých desek (slave ID) současně
+#define MBR_BOARD_COILS   16        // cívek na desku (adresy 0–15)
+#define MBR_MAX_SLAVE     32        // nejvyšší slave ID desky
+#define MBR_RETRY_MS      5000      // opakování po chybě desky
+#define MBR_VERIFY_MS     60000     // kontrolní čtení bez změny
+
+namespace ModbusRelays {
+
+    struct Board {
+        uint8_t  slave;             // 0 = volný slot
+        bool     fault;             // poslední zápis/čtení nesouhlasí
+        uint16_t want;              // požadovaný stav cívek
+        uint16_t dirty;             // cívky čekající na zápis
+        uint16_t used;              // cívky přiřazené zásobníkům
+        uint32_t retryAt;           // millis() dalšího pokusu po chybě
+        uint32_t verifyAt;          // millis() kontrolního čtení
+    };
+
+    static Board             _boards[MBR_MAX_BOARDS] = {};
+    static uint16_t          _errors = 0;
+    static SemaphoreHandle_t _mutex  = nullptr;
+    static SemaphoreHandle_t _kick   = nullptr;
+
+    void begin() {
+        if (!_mutex) _mutex = xSemaphoreCreateMutex();
+        if (!_kick)  _kick  = xSemaphoreCreateBinary();
+    }
+
+    // Slot desky (vytvoří nový) – volat pod mutexem
+    static Board* _board(uint8_t slave, bool create) {
+        Board* freeSlot = nullptr;
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++) {
+            if (_boards[i].slave == slave) return &_boards[i];
+            if (!_boards[i].slave && !freeSlot) freeSlot = &_boards[i];
+        }
+        if (!create || !freeSlot) return nullptr;
+        *freeSlot          = Board();
+        freeSlot->slave    = slave;
+        freeSlot->verifyAt = millis() + MBR_VERIFY_MS;
+        return freeSlot;
+    }
+
+    // ---------------------------------------------------------
+    //  Požadovaný stav cívky – zapíše až service()
+    // ---------------------------------------------------------
+    void set(uint8_t slave, uint8_t coil, bool on) {
+        if (!_mutex || slave == 0 || slave > MBR_MAX_SLAVE || coil >= MBR_BOARD_COILS) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+        Board* b = _board(slave, true);
+        if (b) {
+            uint16_t bit = 1u << coil;
+            b->used |= bit;
+            if (((b->want & bit) != 0) != on) {
+                b->want ^= bit;
+                b->dirty |= bit;
+            }
+        } else {
+            LOGF("[MBR] Víc než %u desek – slave %u ignorován\n", MBR_MAX_BOARDS, slave);
+        }
+        xSemaphoreGive(_mutex);
+    }
+
+    // Požadovaný stav (ne ověřený) – pro UI a getRelay()
+    bool get(uint8_t slave, uint8_t coil) {
+        if (!_mutex || coil >= MBR_BOARD_COILS) return false;
+        bool on = false;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            Board* b = _board(slave, false);
+            on = b && (b->want & (1u << coil));
+            xSemaphoreGive(_mutex);
+        }
+        return on;
+    }
+
+    // Vypni všechny cívky všech desek (bezpečnostní funkce)
+    void allOff() {
+        if (!_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++) {
+            Board& b = _boards[i];
+            if (!b.slave) continue;
+            b.dirty |= b.want | b.used;
+            b.want   = 0;
+        }
+        xSemaphoreGive(_mutex);
+    }
+
+    // Probuď vlastníka linky – jsou změny k zápisu
+    void kick() {
+        if (_kick) xSemaphoreGive(_kick);
+    }
+
+    // Čekej na kick() max. ms – volá vlastník linky místo delay
+    void waitKick(uint32_t ms) {
+        if (_kick) xSemaphoreTake(_kick, pdMS_TO_TICKS(ms));
+        else       vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+
+    // Je přiřazená aspoň jedna deska? (jinak linku nepotřebujeme)
+    bool configured() {
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++)
+            if (_boards[i].slave) return true;
+        return false;
+    }
+
+    bool fault() {
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++)
+            if (_boards[i].slave && _boards[i].fault) return true;
+        return false;
+    }
+
+    uint16_t errors() { return _errors; }
+
+    // ---------------------------------------------------------
+    //  Zápis + ověření jedné desky (I/O mimo mutex)
+    //  Vrací true pokud deska souhlasí
+    // ---------------------------------------------------------
+    static bool _sync(ModbusClient& bus, Board& b, uint16_t want, uint16_t mask) {
+        uint8_t lo = __builtin_ctz(mask);
+        uint8_t hi = 15 - __builtin_clz((uint32_t)mask << 16);
+        uint8_t n  = hi - lo + 1;
+
+        ModbusError err = MODBUS_OK;
+        uint8_t     bits[2] = { (uint8_t)(want >> lo), (uint8_t)(want >> (lo + 8)) };
+        if (b.dirty & mask) {
+            err = (n == 1)
+                ? bus.writeSingleCoil(b.slave, lo, want & (1u << lo))
+                : bus.writeMultipleCoils(b.slave, lo, n, bits);
+        }
+
+        uint8_t rd[2] = {};
+        if (err == MODBUS_OK) err = bus.readCoils(b.slave, lo, n, rd);
+        if (err != MODBUS_OK) {
+            LOGF("[MBR] Slave %u: chyba Modbus %u (cívky %u–%u)\n",
+                b.slave, err, lo, hi);
+            return false;
+        }
+        uint16_t got = (uint16_t)((rd[0] | (rd[1] << 8)) << lo);
+        if ((got ^ want) & mask & b.used) {
+            LOGF("[MBR] Slave %u: VERIFY FAIL zapsáno %04X čteno %04X\n",
+                b.slave, want & mask, got & mask);
+            return false;
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Obsluha linky – zapiš změněné desky, kontrolní čtení
+    //  Volá Inverter task (vlastník RS485) mezi transakcemi
+    //  Vrací počet obsloužených desek
+    // ---------------------------------------------------------
+    uint8_t service(ModbusClient& bus) {
+        if (!_mutex) return 0;
+        uint8_t done = 0;
+
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++) {
+            // Snapshot pod mutexem
+            Board    snap;
+            uint16_t mask = 0;
+            uint32_t now  = millis();
+            if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return done;
+            Board& b = _boards[i];
+            snap = b;
+            if (b.slave && (int32_t)(now - b.retryAt) >= 0) {
+                if (b.dirty)                                      mask = b.dirty;
+                else if (b.used && (int32_t)(now - b.verifyAt) >= 0) mask = b.used;
+            }
+            xSemaphoreGive(_mutex);
+            if (!mask) continue;
+
+            bool ok = _sync(bus, snap, snap.want, mask);
+            done++;
+
+            // Výsledek – cívky změněné během zápisu zůstanou dirty
+            if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return done;
+            if (b.slave == snap.slave) {
+                if (ok) {
+                    b.dirty &= ~mask | (b.want ^ snap.want);
+                    if (b.fault) LOGF("[MBR] Slave %u: opět OK\n", b.slave);
+                    b.fault = false;
+                } else {
+                    b.dirty  |= mask & b.used;
+                    b.fault   = true;
+                    b.retryAt = millis() + MBR_RETRY_MS;
+                    _errors++;
+                }
+                b.verifyAt = millis() + MBR_VERIFY_MS;
+            }
+            xSemaphoreGive(_mutex);
+        }
+        return done;
+    }
+
+    // Čeká něco na zápis? (levné – bez mutexu, jen pro rozhodnutí)
+    bool pending() {
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++) {
+            const Board& b = _boards[i];
+            if (!b.slave || (int32_t)(now - b.retryAt) < 0) continue;
+            if (b.dirty || (b.used && (int32_t)(now - b.verifyAt) >= 0)) return true;
+        }
+        return false;
+    }
+
+    void printStatus() {
+        for (uint8_t i = 0; i < MBR_MAX_BOARDS; i++) {
+            const Board& b = _boards[i];
+            if (!b.slave) continue;
+            LOGF("[MBR] Slave %u: cívky %04X (použité %04X)%s%s\n",
+                b.slave, b.want, b.used,
+                b.dirty ? " čeká zápis" : "", b.fault ? " FAULT" : "");
+        }
+    }
+
+} // namespace ModbusRelays
@@ -23,15 +23,18 @@
 //    CENTER → vstup, L/R oktet, UP/DN hodnota, CENTER potvrdit
 //
 //  Geometrie:
-//    Sdílený gContentSprite, pixelový scroll, FTR_Y ochrana.
+//    Sdílený gContentSprite, seznam = ListView.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
@@ -85,17 +88,10 @@ namespace MqttScreen {
         { nullptr,     "Posl. odesl",  "---",           true,  false },
     };
 
-    #define MQ_ROW_H    26
-    #define MQ_SEC_H    16
-    #define MQ_START_Y  (CONTENT_Y + 4)
-
-    static uint8_t _cursor       = 0;
-    static uint8_t _scrollOffset = 0;
-    static bool    _editing      = false;
+    static ListView _list;
 
     // Sdílený sprite z main_ui_loop
     static LGFX_Sprite* _spr = nullptr;
-    void setSprite(LGFX_Sprite* s) { _spr = s; }
 
     // IP editace po oktetech
     static bool    _editingIp    = false;
@@ -205,8 +201,8 @@ namespace MqttScreen {
                 break;
             default: break;
         }
-        ConfigManager::saveBlockMqtt();
-        Serial.printf("[MQTT_S] Uloženo: %s = %s\n",
+        ConfigManager::saveAsync(BLOCK_MQTT_ADDR);
+        LOGF("[MQTT_S] Uloženo: %s = %s\n",
             _items[idx].label, _items[idx].value);
     }
 
@@ -220,12 +216,12 @@ namespace MqttScreen {
                     strcmp(_items[idx].value, "on") == 0 ? "off" : "on");
                 break;
             case ITEM_PORT: {
-                int v = constrain(atoi(_items[idx].value) + 1, 1, 65535);
+                int v = constrain(atoi(_items[idx].value) + gSwitch.step(), 1, 65535);
                 snprintf(_items[idx].value, 20, "%d", v);
                 break;
             }
             case ITEM_INTERVAL: {
-                int v = constrain(atoi(_items[idx].value) + 10, 10, 300);
+                int v = constrain(atoi(_items[idx].value) + 10 * gSwitch.step(), 10, 300);
                 snprintf(_items[idx].value, 20, "%d s", v);
                 break;
             }
@@ -239,12 +235,12 @@ namespace MqttScreen {
                 _stepUp(idx);  // jen 2 hodnoty
                 break;
             case ITEM_PORT: {
-                int v = constrain(atoi(_items[idx].value) - 1, 1, 65535);
+                int v = constrain(atoi(_items[idx].value) - gSwitch.step(), 1, 65535);
                 snprintf(_items[idx].value, 20, "%d", v);
                 break;
             }
             case ITEM_INTERVAL: {
-                int v = constrain(atoi(_items[idx].value) - 10, 10, 300);
+                int v = constrain(atoi(_items[idx].value) - 10 * gSwitch.step(), 10, 300);
                 snprintf(_items[idx].value, 20, "%d s", v);
                 break;
             }
@@ -256,6 +252,7 @@ namespace MqttScreen {
     //  FULLSCREEN TEXTOVÝ EDITOR
     // ==========================================================
     static void _drawTextEditor(const Theme* t) {
+        if (_spr) Render::invalidate(_spr);     // editor přepíše obsah spritu na displeji
         tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg);
 
         // Nadpis
@@ -412,7 +409,7 @@ namespace MqttScreen {
                     _drawTextEditor(t);
                 } else {
                     _editingText = false;
-                    _editing     = false;
+                    _list.setEditing(false);
                 }
                 return SCREEN_NONE;
             case SW_CENTER: {
@@ -438,11 +435,11 @@ namespace MqttScreen {
                     default: break;
                 }
 
-                Serial.printf("[MQTT_S] %s = '%.*s'\n",
+                LOGF("[MQTT_S] %s = '%.*s'\n",
                     _items[_textItem].label, plen, _textBuf);
-                ConfigManager::saveBlockMqtt();
+                ConfigManager::saveAsync(BLOCK_MQTT_ADDR);
                 _editingText = false;
-                _editing     = false;
+                _list.setEditing(false);
                 return SCREEN_NONE;
             }
             default:
@@ -450,86 +447,53 @@ namespace MqttScreen {
         }
     }
 
+    // ----------------------------------------------------------
+    //  Řádek seznamu
+    // ----------------------------------------------------------
+    static void _row(uint8_t idx, ListRow& r) {
+        MqItem& item = _items[idx];
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        r.flags   = (item.readonly ? LIST_READONLY : 0) | (item.isText ? LIST_TEXT : 0);
+        if (idx == ITEM_BROKER_IP) r.flags |= LIST_CUSTOM;
+    }
+
     // ==========================================================
     //  IP EDITOR po oktetech
     // ==========================================================
+    static void _drawIp(LovyanGFX* dc, const Theme* t, uint8_t idx, int16_t y) {
+        ListView::drawIp(dc, t, y, _ipOctets, _ipField);
+    }
 
-    // Forward deklarace – definice níže
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y);
-    static void    _drawAllItems(const Theme* t);
-    static void    _drawItem(const Theme* t, uint8_t idx);
-
-    static void _drawIpEditor(const Theme* t) {
-        _drawAllItems(t);
-
-        int16_t y = MQ_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_BROKER_IP; i++) {
-            if (_items[i].section != nullptr) y += MQ_SEC_H;
-            y += MQ_ROW_H;
-        }
-        int16_t secH = (_items[ITEM_BROKER_IP].section != nullptr) ? MQ_SEC_H : 0;
-        int16_t rowY = y + secH;
-
-        LovyanGFX* dc = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t sy = _spr ? rowY - CONTENT_Y : rowY;
-
-        dc->fillRect(8, sy, 304, MQ_ROW_H, t->header);
-        dc->fillRect(8, sy, 3,   MQ_ROW_H, t->accent);
-
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(t->accent);
-        dc->setCursor(20, sy + 7);
-        dc->print("Broker IP");
-
-        char parts[4][4];
-        for (uint8_t i = 0; i < 4; i++)
-            snprintf(parts[i], 4, "%u", _ipOctets[i]);
-
-        const int16_t baseX = 180;
-        int16_t cx = baseX;
-        for (uint8_t i = 0; i < 4; i++) {
-            bool act = (_ipField == i);
-            uint8_t w = (uint8_t)strlen(parts[i]) * 8;
-
-            dc->setTextColor(act ? t->accent : t->text);
-            dc->setCursor(cx, sy + 7);
-            dc->print(parts[i]);
-            if (act)
-                dc->fillRect(cx, sy + MQ_ROW_H - 4, w, 2, t->accent);
-            cx += w;
-            if (i < 3) {
-                dc->setTextColor(t->dim);
-                dc->setCursor(cx, sy + 7);
-                dc->print(".");
-                cx += 6;
-            }
-        }
-
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
+    void setSprite(LGFX_Sprite* s) {
+        _spr = s;
+        _list.begin(ITEM_COUNT, _row, _drawIp);
+        _list.setSprite(s);
     }
 
     static Screen _handleIpInput(const Theme* t, SwButton btn) {
         switch (btn) {
             case SW_UP:
-                _ipOctets[_ipField] = (_ipOctets[_ipField] + 1) % 256;
-                _drawIpEditor(t);
+                _ipOctets[_ipField] = (_ipOctets[_ipField] + gSwitch.step()) % 256;
+                _list.drawRow(t, ITEM_BROKER_IP);
                 return SCREEN_NONE;
             case SW_DOWN:
-                _ipOctets[_ipField] = (_ipOctets[_ipField] + 255) % 256;
-                _drawIpEditor(t);
+                _ipOctets[_ipField] = (_ipOctets[_ipField] + 256 - gSwitch.step()) % 256;
+                _list.drawRow(t, ITEM_BROKER_IP);
                 return SCREEN_NONE;
             case SW_RIGHT:
-                if (_ipField < 3) { _ipField++; _drawIpEditor(t); }
+                if (_ipField < 3) { _ipField++; _list.drawRow(t, ITEM_BROKER_IP); }
                 return SCREEN_NONE;
             case SW_LEFT:
                 if (_ipField > 0) {
                     _ipField--;
-                    _drawIpEditor(t);
+                    _list.drawRow(t, ITEM_BROKER_IP);
                 } else {
                     _editingIp = false;
-                    _editing   = false;
+                    _list.setEditing(false);
                     _loadFromConfig();
-                    _drawAllItems(t);
+                    _list.drawRow(t, ITEM_BROKER_IP);
                 }
                 return SCREEN_NONE;
             case SW_CENTER:
@@ -537,137 +501,17 @@ namespace MqttScreen {
                 snprintf(_items[ITEM_BROKER_IP].value, 20, "%u.%u.%u.%u",
                     _ipOctets[0], _ipOctets[1], _ipOctets[2], _ipOctets[3]);
                 _editingIp = false;
-                _editing   = false;
-                Serial.printf("[MQTT_S] Broker IP = %u.%u.%u.%u\n",
+                _list.setEditing(false);
+                LOGF("[MQTT_S] Broker IP = %u.%u.%u.%u\n",
                     _ipOctets[0], _ipOctets[1], _ipOctets[2], _ipOctets[3]);
-                ConfigManager::saveBlockMqtt();
-                _drawAllItems(t);
+                ConfigManager::saveAsync(BLOCK_MQTT_ADDR);
+                _list.drawRow(t, ITEM_BROKER_IP);
                 return SCREEN_NONE;
             default:
                 return SCREEN_NONE;
         }
     }
 
-    // ----------------------------------------------------------
-    //  Kreslení položky
-    // ----------------------------------------------------------
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
-        MqItem& item   = _items[idx];
-        bool     active  = (idx == _cursor);
-        bool     editing = (active && _editing && !_editingIp && !_editingText);
-        int16_t  drawn   = 0;
-        LovyanGFX* dc    = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t    sy    = _spr ? y - CONTENT_Y : y;
-
-        // Sekce header
-        if (item.section != nullptr) {
-            if (y + MQ_SEC_H > FTR_Y) return 0;
-            dc->fillRect(0, sy, 320, MQ_SEC_H, t->bg);
-            dc->setFont(&fonts::Font2);
-            dc->setTextColor(t->dim);
-            dc->setCursor(16, sy);
-            dc->print(item.section);
-            sy += 14;
-            dc->drawFastHLine(16, sy, 288, t->dim);
-            sy += 2;
-            drawn += MQ_SEC_H;
-        }
-
-        if (y + drawn + MQ_ROW_H > FTR_Y) return drawn;
-
-        // Pozadí řádku
-        if (active) {
-            dc->fillRect(8, sy, 304, MQ_ROW_H, t->header);
-            dc->fillRect(8, sy, 3,   MQ_ROW_H, t->accent);
-        } else {
-            dc->fillRect(8, sy, 304, MQ_ROW_H, t->bg);
-        }
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(item.readonly
-            ? t->dim
-            : (active ? t->accent : t->text));
-        dc->setCursor(20, sy + 7);
-        dc->print(item.label);
-
-        // Hodnota
-        if (item.isText) {
-            // Textové položky – >>> hint
-            dc->setTextColor(editing ? t->accent : t->text);
-            dc->setTextDatum(middle_right);
-            dc->drawString(item.value[0] && strcmp(item.value, "---") != 0
-                           ? item.value : "---",
-                           active ? 290 : 303, sy + 12);
-            if (active) {
-                dc->setTextColor(t->dim);
-                dc->drawString(">>>", 308, sy + 12);
-            }
-            dc->setTextDatum(top_left);
-        } else {
-            uint16_t valCol = item.readonly ? t->dim
-                            : (editing ? t->accent : t->text);
-            dc->setTextColor(valCol);
-            dc->setTextDatum(middle_right);
-            dc->drawString(item.value, 308, sy + 12);
-            dc->setTextDatum(top_left);
-        }
-
-        drawn += MQ_ROW_H;
-        return drawn;
-    }
-
-    // ----------------------------------------------------------
-    //  Překresli všechny viditelné položky
-    // ----------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        if (_spr) { _spr->fillScreen(t->bg); }
-        else { tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg); }
-        int16_t y = MQ_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_COUNT; i++) {
-            int16_t h = _drawItemAt(t, i, y);
-            if (h == 0) break;
-            y += h;
-        }
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
-    }
-
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        _drawAllItems(t);
-    }
-
-    // ----------------------------------------------------------
-    //  Y pozice položky
-    // ----------------------------------------------------------
-    static int16_t _itemY(uint8_t idx) {
-        int16_t y = MQ_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (_items[i].section != nullptr) y += MQ_SEC_H;
-            y += MQ_ROW_H;
-        }
-        return y;
-    }
-
-    // ----------------------------------------------------------
-    //  Scroll
-    // ----------------------------------------------------------
-    static bool _ensureVisible() {
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-        bool changed = false;
-        while (_scrollOffset < _cursor) {
-            int16_t y      = _itemY(_cursor);
-            int16_t secH   = (_items[_cursor].section != nullptr) ? MQ_SEC_H : 0;
-            int16_t bottom = y + secH + MQ_ROW_H;
-            if (bottom <= FTR_Y) break;
-            _scrollOffset++;
-            changed = true;
-        }
-        return changed;
-    }
-
     // ----------------------------------------------------------
     //  Spodní lišta pro seznam
     // ----------------------------------------------------------
@@ -697,7 +541,7 @@ namespace MqttScreen {
             _drawFooter(t);
             _loadFromConfig();
             _updateStatus();
-            _drawAllItems(t);
+            _list.draw(t);
         }
     }
 
@@ -706,9 +550,10 @@ namespace MqttScreen {
                 bool alarm, const SolarData& d) {
         Header::update(t, dt, apState, staState, invState, alarm);
 
-        if (!_editing && !_editingText) {
+        if (!_list.editing() && !_editingText) {
             _updateStatus();
-            _drawAllItems(t);
+            _list.drawRow(t, ITEM_STAT_CONN);
+            _list.drawRow(t, ITEM_STAT_LAST);
         }
     }
 
@@ -720,7 +565,7 @@ namespace MqttScreen {
             if (!_editingText) {
                 _loadFromConfig();
                 _drawFooter(t);
-                _drawAllItems(t);
+                _list.draw(t);
             }
             return ret;
         }
@@ -731,26 +576,26 @@ namespace MqttScreen {
         }
 
         // --- Editace běžné položky ---
-        if (_editing) {
+        if (_list.editing()) {
             switch (btn) {
                 case SW_UP:
-                    _stepUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepUp(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _stepDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepDown(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_CENTER:
-                    _editing = false;
-                    _saveItem(_cursor);
+                    _list.setEditing(false);
+                    _saveItem(_list.cursor());
                     _loadFromConfig();
-                    _drawAllItems(t);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_LEFT:
-                    _editing = false;
+                    _list.setEditing(false);
                     _loadFromConfig();
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -760,42 +605,34 @@ namespace MqttScreen {
         // --- Normální navigace ---
         switch (btn) {
             case SW_UP:
-                if (_cursor > 0) {
-                    _cursor--;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursor < ITEM_COUNT - 1) {
-                    _cursor++;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER:
-                if (_items[_cursor].readonly) return SCREEN_NONE;
+                if (_items[_list.cursor()].readonly) return SCREEN_NONE;
 
                 // IP adresa – speciální editor
-                if (_cursor == ITEM_BROKER_IP) {
+                if (_list.cursor() == ITEM_BROKER_IP) {
                     _editingIp = true;
-                    _editing   = true;
+                    _list.setEditing(true);
                     _ipField   = 0;
                     memcpy(_ipOctets, gConfig.mqttBrokerIp, 4);
-                    _drawIpEditor(t);
+                    _list.drawRow(t, ITEM_BROKER_IP);
                     return SCREEN_NONE;
                 }
 
                 // Textové položky – fullscreen editor
-                if (_items[_cursor].isText) {
-                    _textItem    = _cursor;
+                if (_items[_list.cursor()].isText) {
+                    _textItem    = _list.cursor();
                     _textPos     = 0;
                     _editingText = true;
-                    _editing     = true;
+                    _list.setEditing(true);
 
-                    switch ((ItemId)_cursor) {
+                    switch ((ItemId)_list.cursor()) {
                         case ITEM_USER:
                             _textMaxLen = sizeof(gConfig.mqttUser) - 1;
                             strncpy(_textBuf, gConfig.mqttUser, _textMaxLen);
@@ -810,7 +647,7 @@ namespace MqttScreen {
                             break;
                         default:
                             _textMaxLen = sizeof(_items[0].value) - 1;
-                            strncpy(_textBuf, _items[_cursor].value, _textMaxLen);
+                            strncpy(_textBuf, _items[_list.cursor()].value, _textMaxLen);
                             break;
                     }
                     uint8_t srcLen = (uint8_t)strlen(_textBuf);
@@ -823,8 +660,8 @@ namespace MqttScreen {
                 }
 
                 // Běžná editace
-                _editing = true;
-                _drawItem(t, _cursor);
+                _list.setEditing(true);
+                _list.drawRow(t, _list.cursor());
                 return SCREEN_NONE;
 
             case SW_LEFT:
@@ -836,9 +673,7 @@ namespace MqttScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _editingIp    = false;
         _editingText  = false;
         _ipField      = 0;
@@ -20,15 +20,18 @@
 //    Charset: A–Z, a–z, 0–9, mezera, . - _ @ / : ! # $
 //
 //  Geometrie:
-//    Stejná jako ControlScreen – pixelový scroll, FTR_Y ochrana
+//    Sdílený gContentSprite, seznam = ListView.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
@@ -108,17 +111,10 @@ namespace NetworkScreen {
         { "Ostatni",   "Hostname",  "ACU-RP",         true  },
     };
 
-    #define NET_ROW_H    26
-    #define NET_SEC_H    16
-    #define NET_START_Y  (CONTENT_Y + 4)
-
-    static uint8_t _cursor       = 0;
-    static uint8_t _scrollOffset = 0;
-    static bool    _editing      = false;
+    static ListView _list;
 
     // Sdílený sprite z main_ui_loop – nastav přes setSprite()
     static LGFX_Sprite* _spr = nullptr;
-    static void setSprite(LGFX_Sprite* s) { _spr = s; }
     static bool    _editingText  = false;  // fullscreen textový editor
 
     // ----------------------------------------------------------
@@ -169,6 +165,7 @@ namespace NetworkScreen {
 
     // Nakresli fullscreen textový editor
     static void _drawTextEditor(const Theme* t) {
+        if (_spr) Render::invalidate(_spr);     // editor přepíše obsah spritu na displeji
         tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg);
 
         // Nadpis – název položky
@@ -405,8 +402,8 @@ namespace NetworkScreen {
                         break;
                     default: break;
                 }
-                ConfigManager::saveBlockWifi();
-                Serial.printf("[NET] %s = '%s'\n",
+                ConfigManager::saveAsync(BLOCK_WIFI_ADDR);
+                LOGF("[NET] %s = '%s'\n",
                     _items[_textItem].label, _items[_textItem].value);
                 _editingText = false;
                 return SCREEN_NONE;
@@ -541,8 +538,8 @@ namespace NetworkScreen {
                 break;
             default: break;
         }
-        ConfigManager::saveBlockWifi();
-        Serial.printf("[NET] Ulozeno: %s = %s\n",
+        ConfigManager::saveAsync(BLOCK_WIFI_ADDR);
+        LOGF("[NET] Ulozeno: %s = %s\n",
             _items[idx].label, _items[idx].value);
     }
 
@@ -582,7 +579,7 @@ namespace NetworkScreen {
             case ITEM_AP_DHCP_END: {
                 uint8_t a, b, c, d;
                 sscanf(_items[idx].value, "%hhu.%hhu.%hhu.%hhu", &a, &b, &c, &d);
-                d = (d + 1) % 256;
+                d = (d + gSwitch.step()) % 256;
                 snprintf(_items[idx].value, 20, "%u.%u.%u.%u", a, b, c, d);
                 break;
             }
@@ -622,7 +619,7 @@ namespace NetworkScreen {
             case ITEM_AP_DHCP_END: {
                 uint8_t a, b, c, d;
                 sscanf(_items[idx].value, "%hhu.%hhu.%hhu.%hhu", &a, &b, &c, &d);
-                d = (d + 255) % 256;
+                d = (d + 256 - gSwitch.step()) % 256;
                 snprintf(_items[idx].value, 20, "%u.%u.%u.%u", a, b, c, d);
                 break;
             }
@@ -637,117 +634,20 @@ namespace NetworkScreen {
 
 
     // ----------------------------------------------------------
-    //  Pomocná: Y pozice položky idx (simuluje _drawAllItems)
-    // ----------------------------------------------------------
-    static int16_t _itemY(uint8_t idx) {
-        int16_t y = NET_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (_items[i].section != nullptr) y += NET_SEC_H;
-            y += NET_ROW_H;
-        }
-        return y;
-    }
-
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
-        NetItem& item    = _items[idx];
-        bool       active   = (idx == _cursor);
-        bool       editing  = (active && _editing);
-        int16_t    drawn    = 0;
-        LovyanGFX* dc       = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t    sy       = _spr ? y - CONTENT_Y : y;
-
-        // Sekce header
-        if (item.section != nullptr) {
-            if (y + NET_SEC_H > FTR_Y) return 0;
-            dc->fillRect(0, sy, 320, NET_SEC_H, t->bg);
-            dc->setFont(&fonts::Font2);
-            dc->setTextColor(t->dim);
-            dc->setCursor(16, sy);
-            dc->print(item.section);
-            sy += 14;
-            dc->drawFastHLine(16, sy, 288, t->dim);
-            sy += 2;
-            drawn += NET_SEC_H;
-        }
-
-        if (y + drawn + NET_ROW_H > FTR_Y) return drawn;
-
-        // Pozadí řádku
-        if (active) {
-            dc->fillRect(8, sy, 304, NET_ROW_H, t->header);
-            dc->fillRect(8, sy, 3,   NET_ROW_H, t->accent);
-        } else {
-            dc->fillRect(8, sy, 304, NET_ROW_H, t->bg);
-        }
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(active ? t->accent : t->text);
-        dc->setCursor(20, sy + 7);
-        dc->print(item.label);
-
-        // Hodnota – textové položky mají >>> hint
-        if (item.isText) {
-            dc->setTextColor(editing ? t->accent : t->text);
-            dc->setTextDatum(middle_right);
-            dc->drawString(item.value[0] ? item.value : "---",
-                           active ? 290 : 303, sy + 12);
-            if (active) {
-                dc->setTextColor(t->dim);
-                dc->drawString(">>>", 308, sy + 12);
-            }
-            dc->setTextDatum(top_left);
-        } else {
-            dc->setTextColor(editing ? t->accent : t->text);
-            dc->setTextDatum(middle_right);
-            dc->drawString(item.value, 308, sy + 12);
-            dc->setTextDatum(top_left);
-        }
-
-        drawn += NET_ROW_H;
-        return drawn;
-    }
-
-    // ----------------------------------------------------------
-    //  Překresli všechny viditelné položky
+    //  Řádek seznamu
     // ----------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        if (_spr) { _spr->fillScreen(t->bg); }
-        else { tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg); }
-        int16_t y = NET_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_COUNT; i++) {
-            int16_t h = _drawItemAt(t, i, y);
-            if (h == 0) break;
-            y += h;
-        }
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
+    static void _row(uint8_t idx, ListRow& r) {
+        NetItem& item = _items[idx];
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        r.flags   = item.isText ? LIST_TEXT : 0;
     }
 
-    // ----------------------------------------------------------
-    //  Překresli jednu položku
-    // ----------------------------------------------------------
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        _drawAllItems(t);
-    }
-
-    // ----------------------------------------------------------
-    //  Scroll – pixelový přístup (stejný jako ControlScreen)
-    // ----------------------------------------------------------
-    static bool _ensureVisible() {
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-        bool changed = false;
-        while (_scrollOffset < _cursor) {
-            int16_t y      = _itemY(_cursor);
-            int16_t secH   = (_items[_cursor].section != nullptr) ? NET_SEC_H : 0;
-            int16_t bottom = y + secH + NET_ROW_H;
-            if (bottom <= FTR_Y) break;
-            _scrollOffset++;
-            changed = true;
-        }
-        return changed;
+    static void setSprite(LGFX_Sprite* s) {
+        _spr = s;
+        _list.begin(ITEM_COUNT, _row);
+        _list.setSprite(s);
     }
 
     // ----------------------------------------------------------
@@ -778,7 +678,7 @@ namespace NetworkScreen {
         } else {
             _drawFooter(t);
             _loadFromConfig();
-            _drawAllItems(t);
+            _list.draw(t);
         }
     }
 
@@ -797,28 +697,28 @@ namespace NetworkScreen {
                 // Editor zavřen – překresli seznam
                 _loadFromConfig();
                 _drawFooter(t);
-                _drawAllItems(t);
+                _list.draw(t);
             }
             return ret;
         }
 
         // --- Editace non-text položky ---
-        if (_editing) {
+        if (_list.editing()) {
             switch (btn) {
                 case SW_UP:
-                    _stepUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepUp(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _stepDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepDown(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_CENTER:
                 case SW_LEFT:
-                    _editing = false;
-                    _saveItem(_cursor);
+                    _list.setEditing(false);
+                    _saveItem(_list.cursor());
                     _loadFromConfig();
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -828,31 +728,23 @@ namespace NetworkScreen {
         // --- Normální navigace ---
         switch (btn) {
             case SW_UP:
-                if (_cursor > 0) {
-                    _cursor--;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursor < ITEM_COUNT - 1) {
-                    _cursor++;
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER: {
-                NetItem& item = _items[_cursor];
+                NetItem& item = _items[_list.cursor()];
                 if (item.isText) {
                     // Otevři textový editor
-                    _textItem   = _cursor;
+                    _textItem   = _list.cursor();
                     _textPos    = 0;
                     _editingText = true;
 
                     // Zjisti max délku pole a naplň buffer
-                    switch ((ItemId)_cursor) {
+                    switch ((ItemId)_list.cursor()) {
                         case ITEM_STA_SSID:
                             _textMaxLen = sizeof(gConfig.wifiStaSsid) - 1;
                             strncpy(_textBuf, gConfig.wifiStaSsid, _textMaxLen);
@@ -895,8 +787,8 @@ namespace NetworkScreen {
 
                     _drawTextEditor(t);
                 } else {
-                    _editing = true;
-                    _drawItem(t, _cursor);
+                    _list.setEditing(true);
+                    _list.drawRow(t, _list.cursor());
                 }
                 return SCREEN_NONE;
             }
@@ -910,9 +802,7 @@ namespace NetworkScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _editingText  = false;
         _textPos      = 0;
         _loadFromConfig();
@@ -23,8 +23,10 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <Wire.h>
 #include "HW_Config.h"
+#include "I2cBus.h"
 
 // Offset registr 0x02 – layout:
 //   bit7   = MODE  (0=hrubý ±4.34ppm/krok, 1=jemný ±1.09ppm/krok)
@@ -42,6 +44,47 @@ struct DateTime {
     uint8_t  second;  // 0–59
 };
 
+// =============================================================
+//  Převod DateTime ↔ sekundy od 2000-01-01 00:00:00
+//  RTC drží lokální čas → i výsledek je "lokální epocha".
+//  Slouží jako kompaktní časové razítko (uint32_t, do r. 2136).
+// =============================================================
+uint32_t dateTimeToSecs(const DateTime& dt) {
+    // Dny od 2000-01-01 (algoritmus days_from_civil, H. Hinnant)
+    int32_t  y   = (int32_t)dt.year - (dt.month <= 2 ? 1 : 0);
+    int32_t  era = y / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t mp  = (dt.month + 9) % 12;
+    uint32_t doy = (153 * mp + 2) / 5 + dt.day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int32_t  days = era * 146097 + (int32_t)doe - 730425;   // 730425 = dny 0000-03-01 → 2000-01-01
+    if (days < 0) days = 0;
+    return (uint32_t)days * 86400UL
+         + (uint32_t)dt.hour * 3600UL
+         + (uint32_t)dt.minute * 60UL
+         + dt.second;
+}
+
+DateTime secsToDateTime(uint32_t secs) {
+    DateTime dt;
+    uint32_t days = secs / 86400UL;
+    uint32_t rem  = secs % 86400UL;
+    dt.hour   = rem / 3600;
+    dt.minute = (rem % 3600) / 60;
+    dt.second = rem % 60;
+
+    int32_t  z   = (int32_t)days + 730425;
+    int32_t  era = z / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp  = (5 * doy + 2) / 153;
+    dt.day   = doy - (153 * mp + 2) / 5 + 1;
+    dt.month = mp < 10 ? mp + 3 : mp - 9;
+    dt.year  = (uint16_t)((int32_t)yoe + era * 400 + (dt.month <= 2 ? 1 : 0));
+    return dt;
+}
+
 class PCF85063A {
 public:
 
@@ -82,6 +125,7 @@ public:
     // ---------------------------------------------------------
     DateTime getTime() {
         DateTime dt = {2000, 1, 1, 0, 0, 0};
+        I2cBus::Lock lock;
         Wire.beginTransmission(ADDR_PCF85063A);
         Wire.write(0x04);
         Wire.endTransmission(false);
@@ -110,6 +154,8 @@ public:
         if (dt.month < 1 || dt.month > 12)      return false;
         if (dt.year < 2000 || dt.year > 2099)   return false;
 
+        I2cBus::Lock lock;
+
         // Krok 1: Minutes–Year
         Wire.beginTransmission(ADDR_PCF85063A);
         Wire.write(0x05);
@@ -130,7 +176,7 @@ public:
         if (Wire.endTransmission() != 0) return false;
 
         _valid = true;
-        Serial.printf("[RTC] Cas nastaven: %04d-%02d-%02d %02d:%02d:%02d\n",
+        LOGF("[RTC] Cas nastaven: %04d-%02d-%02d %02d:%02d:%02d\n",
             dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second);
         return true;
     }
@@ -158,14 +204,18 @@ public:
         // bit7=1 (jemný režim) + offset v two's complement (7 bitů)
         uint8_t reg = RTC_OFFSET_MODE_FINE | (offset & 0x7F);
 
-        Wire.beginTransmission(ADDR_PCF85063A);
-        Wire.write(RTC_OFFSET_REG);
-        Wire.write(reg);
-        bool ok = Wire.endTransmission() == 0;
+        bool ok;
+        {
+            I2cBus::Lock lock;
+            Wire.beginTransmission(ADDR_PCF85063A);
+            Wire.write(RTC_OFFSET_REG);
+            Wire.write(reg);
+            ok = Wire.endTransmission() == 0;
+        }
 
         if (ok) {
             _calibOffset = offset;
-            Serial.printf("[RTC] Kalibrace nastavena: %+d kroky (%.2f ppm)\n",
+            LOGF("[RTC] Kalibrace nastavena: %+d kroky (%.2f ppm)\n",
                 offset, offset * RTC_PPM_PER_STEP);
         }
         return ok;
@@ -173,6 +223,7 @@ public:
 
     // Přečti aktuální kalibrační offset z čipu
     int8_t getCalibration() {
+        I2cBus::Lock lock;
         Wire.beginTransmission(ADDR_PCF85063A);
         Wire.write(RTC_OFFSET_REG);
         Wire.endTransmission(false);
@@ -203,7 +254,7 @@ public:
 
     void printTime() {
         DateTime dt = getTime();
-        Serial.printf("[RTC] %04d-%02d-%02d %02d:%02d:%02d [%s] kalib=%+d\n",
+        LOGF("[RTC] %04d-%02d-%02d %02d:%02d:%02d [%s] kalib=%+d\n",
             dt.year, dt.month, dt.day,
             dt.hour, dt.minute, dt.second,
             _valid ? "OK" : "ceka na NTP",
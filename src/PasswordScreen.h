@@ -17,6 +17,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
@@ -47,7 +48,7 @@ namespace PasswordScreen {
     void loadFromFRAM() {
         // PIN je už v gConfig.pin[] (načteno ConfigManager::loadFromFram)
         // Tato funkce existuje pro zpětnou kompatibilitu s uiSetup()
-        Serial.printf("[PWD] PIN: %u%u%u%u\n",
+        LOGF("[PWD] PIN: %u%u%u%u\n",
             gConfig.pin[0], gConfig.pin[1], gConfig.pin[2], gConfig.pin[3]);
     }
 
@@ -0,0 +1,753 @@
+// =============================================================
+//  PowerLog.h – komprimovaný minutový záznam výkonů ve FRAM
+//
+//  Blok 13 (0x0F80–0x1FFD, 4222B) = hlavička bloku (2B, verze
+//  formátu) + kruhový buffer POWERLOG_FRAMES rámců. Každou minutu
+//  se uloží jeden vzorek (průměr za minutu):
+//    PV, spotřeba, síť, baterie, fáze L1–L3
+//
+//  Komprese:
+//    - výkony kvantovány na POWERLOG_QUANT_W (50 W)
+//    - PV, spotřeba, L1, L2 a ΣL = L1 + L2 + L3 = delta proti
+//      předchozímu vzorku; L3 = ΣL − L1 − L2. ΣL ≈ −síť a tu hybrid
+//      s baterií drží většinou u nuly → delta ΣL je levná, šum
+//      spotřebičů nesou jen L1 a L2
+//    - síť a baterie se neukládají přímo, ale jako reziduum
+//      vůči energetické bilanci (v kvantovaných jednotkách):
+//        gridRes = grid + ΣL                  (fáze: + = dodávka)
+//        batRes  = bat − (load − PV − grid)
+//      → reziduum je jen zaokrouhlení / chyba měření kolem 0,
+//        ukládá se přímo (bez delty)
+//    - každý kanál = zigzag + adaptivní Rice kód: parametr k
+//      z klouzavého průměru |z| kanálu (A/N, půlení po
+//      POWERLOG_RICE_NMAX vzorcích) → ticho ~1 bit, mraky/skoky
+//      si k během pár vzorků zvednou. Kvocient ≥ POWERLOG_RICE_ESC
+//      = escape + 16b raw.
+//    - klíč (první vzorek rámce) je na začátku bitstreamu, krátký
+//      prefixový kód (0 / 3 / 6 / 12 / 20 bitů) – hlavička má 9B
+//    - čas se neukládá: vzorky v rámci jdou po 60s od startTs,
+//      mezera (restart, výpadek RTC) = nový rámec
+//
+//  Kapacita (měřeno na modelovém dni: šum domácnosti ±60 W,
+//  fáze ±40 W, spotřebiče, bojler 2 kW, baterie; oblačno = náhodná
+//  procházka oblačnosti ±25 %/min celý den; kvantizace 50 W):
+//    jasno     ~16 bitů / vzorek
+//    oblačno   ~20 bitů / vzorek (nejhorší případ)
+//  Nejstarší rámec se přepisuje při otevření nového → jistých je
+//  POWERLOG_FRAMES − 1 plných rámců. Nejkratší držená historie
+//  v ustáleném stavu (5 dní, restarty): oblačno 24.6–25.3 h,
+//  jasno ~30 h.
+//  Rámec se uzavře, až když další vzorek skutečně nevejde
+//  (zakóduje se nanečisto) → na konci rámce se neplýtvá.
+//
+//  Zápis: aktuální rámec drží RAM kopie, append zapíše do FRAM
+//  jen nově dopsané bajty bitstreamu + 4B hlavičky (count, bitLen)
+//  → O(1) zápisů na vzorek. Hlavička se zapisuje JAKO POSLEDNÍ,
+//  takže přerušený zápis nechá rámec v předchozím platném stavu.
+//  Stav Rice kódu se neukládá – begin() ho obnoví přehráním rámce.
+//
+//  Vlákna: feed() běží v heartbeat tasku, ale I2C smí jen Core 0
+//  (Wire nemá mutex sdílený s RTC a MCP23017). Minutový průměr
+//  proto jde do fronty POWERLOG_QUEUE_LEN a do FRAM ho zapíše
+//  pump() z loop(). Plná fronta / obsazený mutex = zahozený
+//  vzorek – počítá dropped() a loguje se.
+//
+//  Čtení: PowerLog::query(from, to, callback) projde rámce od
+//  nejstaršího a zavolá callback pro každý vzorek v rozsahu.
+//  Použití: HistoryScreen (grafy), web endpoint, řídicí logika.
+//
+//  Časová razítka = lokální sekundy od 2000-01-01 (dateTimeToSecs).
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <queue.h>
+#include "FM24CL64.h"
+#include "FramMap.h"
+#include "PCF85063A.h"
+
+#define POWERLOG_ADDR         (BLOCK_POWERLOG_ADDR + 2)                     // za hlavičkou bloku
+#define POWERLOG_FRAME_SIZE   248
+#define POWERLOG_FRAMES       ((BLOCK_POWERLOG_SIZE - 2) / POWERLOG_FRAME_SIZE)  // 17
+#define POWERLOG_QUANT_W      50      // kvantizace výkonu [W]
+#define POWERLOG_INTERVAL_S   60      // perioda vzorku [s]
+#define POWERLOG_CHANNELS     7
+#define POWERLOG_DELTA_MASK   0x1F    // kanály 0–4 delta, 5–6 (rezidua) přímo
+#define POWERLOG_FRAME_MAGIC  0xAC
+#define POWERLOG_QUEUE_LEN    8       // minut čekajících na zápis (Core 0)
+
+#define POWERLOG_RICE_ESC     12      // kvocient ≥ ESC → escape + 16b raw
+#define POWERLOG_RICE_NMAX    8       // po kolika vzorcích se A/N půlí
+#define POWERLOG_RICE_ZCAP    4095    // strop z pro adaptaci (A vejde do 16b)
+
+// =============================================================
+//  Jeden vzorek (dekódovaný)
+// =============================================================
+struct PowerSample {
+    uint32_t ts;            // začátek minuty [s od 2000-01-01, lokální]
+    int32_t  powerPV;       // [W]
+    int32_t  powerLoad;
+    int32_t  powerGrid;     // + odběr, − dodávka
+    int32_t  powerBattery;  // + vybíjení, − nabíjení
+    int32_t  phaseL1;       // + dodávka, − odběr
+    int32_t  phaseL2;
+    int32_t  phaseL3;
+};
+
+// Callback pro query – vrať false pro ukončení průchodu
+typedef bool (*PowerLogVisitor)(const PowerSample& s, void* ctx);
+
+// =============================================================
+//  Hlavička rámce (9B) – zbytek rámce je bitstream (klíč + delty)
+// =============================================================
+struct PowerLogFrameHdr {
+    uint8_t  magic;                     // POWERLOG_FRAME_MAGIC = platný rámec
+    uint16_t count;                     // počet vzorků v rámci
+    uint16_t bitLen;                    // délka bitstreamu [bit]
+    uint32_t startTs;                   // čas prvního vzorku
+} __attribute__((packed));
+
+#define POWERLOG_DATA_BYTES   (POWERLOG_FRAME_SIZE - sizeof(PowerLogFrameHdr))   // 239
+#define POWERLOG_DATA_BITS    (POWERLOG_DATA_BYTES * 8)
+#define POWERLOG_MAX_SAMPLE_BITS (POWERLOG_CHANNELS * (POWERLOG_RICE_ESC + 16))
+// Buffer rámce + místo na jeden vzorek navíc (kódování nanečisto,
+// dekodér poškozeného rámce se zastaví až za vzorkem)
+#define POWERLOG_BUF_BYTES    (POWERLOG_DATA_BYTES + (POWERLOG_MAX_SAMPLE_BITS + 7) / 8)
+
+// =============================================================
+//  Stav kodéru / dekodéru – poslední vzorek + adaptace Rice
+// =============================================================
+struct PowerLogCoder {
+    int16_t  ch[POWERLOG_CHANNELS];     // poslední vzorek (kvantovaný)
+    uint16_t sum[POWERLOG_CHANNELS];    // A: Σz od posledního půlení
+    uint8_t  n[POWERLOG_CHANNELS];      // N: počet vzorků v sum
+};
+
+// =============================================================
+//  Kurzor proudového čtení (export po částech)
+//  Drží rozdekódovaný rámec – další volání queryNext() pokračuje
+//  od posledního vzorku bez opakovaného čtení a dekódování rámce
+//  od klíče. Přepsaný rámec (kruhový buffer) = kurzor se znovu
+//  najde podle času next.
+// =============================================================
+struct PowerLogCursor {
+    uint32_t next;                          // ts dalšího vzorku k vydání
+    uint32_t frameTs;                       // startTs načteného rámce (0 = žádný)
+    uint8_t  frame;                         // slot načteného rámce
+    uint16_t count;                         // vzorků v data[]
+    uint16_t bitLen;                        // platných bitů v data[]
+    uint16_t index;                         // index vzorku v dec.ch
+    uint16_t pos;                           // bit za vzorkem index
+    PowerLogCoder dec;                      // hodnoty vzorku index + stav Rice
+    uint8_t  data[POWERLOG_BUF_BYTES];
+};
+
+namespace PowerLog {
+
+    // ---------------------------------------------------------
+    //  Bitový zápis / čtení (MSB first)
+    // ---------------------------------------------------------
+    static void _putBits(uint8_t* buf, uint16_t& pos, uint32_t val, uint8_t n) {
+        while (n--) {
+            uint8_t  bit  = (val >> n) & 1;
+            uint16_t byte = pos >> 3;
+            uint8_t  mask = 0x80 >> (pos & 7);
+            if (bit) buf[byte] |=  mask;
+            else     buf[byte] &= ~mask;
+            pos++;
+        }
+    }
+
+    static uint32_t _getBits(const uint8_t* buf, uint16_t& pos, uint8_t n) {
+        uint32_t v = 0;
+        while (n--) {
+            v = (v << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+            pos++;
+        }
+        return v;
+    }
+
+    static uint32_t _zigzag(int32_t v)    { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t  _unzigzag(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+    // ---------------------------------------------------------
+    //  Klíč rámce – hodnota kanálu prefixovým kódem
+    //    0                    z = 0             1 bit
+    //    10   + 1b            z = 1–2           3 bity
+    //    110  + 3b            z = 3–10          6 bitů
+    //    1110 + 8b            z = 11–266       12 bitů
+    //    1111 + 16b           cokoli (raw)     20 bitů
+    // ---------------------------------------------------------
+    static void _putValue(uint8_t* buf, uint16_t& pos, int16_t v) {
+        uint32_t z = _zigzag(v);
+        if (z == 0)        { _putBits(buf, pos, 0b0, 1); }
+        else if (z <= 2)   { _putBits(buf, pos, 0b10, 2);   _putBits(buf, pos, z - 1, 1); }
+        else if (z <= 10)  { _putBits(buf, pos, 0b110, 3);  _putBits(buf, pos, z - 3, 3); }
+        else if (z <= 266) { _putBits(buf, pos, 0b1110, 4); _putBits(buf, pos, z - 11, 8); }
+        else               { _putBits(buf, pos, 0b1111, 4); _putBits(buf, pos, (uint16_t)v, 16); }
+    }
+
+    static int16_t _getValue(const uint8_t* buf, uint16_t& pos) {
+        if (!_getBits(buf, pos, 1)) return 0;
+        if (!_getBits(buf, pos, 1)) return (int16_t)_unzigzag(_getBits(buf, pos, 1) + 1);
+        if (!_getBits(buf, pos, 1)) return (int16_t)_unzigzag(_getBits(buf, pos, 3) + 3);
+        if (!_getBits(buf, pos, 1)) return (int16_t)_unzigzag(_getBits(buf, pos, 8) + 11);
+        return (int16_t)_getBits(buf, pos, 16);
+    }
+
+    // ---------------------------------------------------------
+    //  Adaptivní Rice – k = nejmenší s N·2^k ≥ A
+    // ---------------------------------------------------------
+    static uint8_t _riceK(const PowerLogCoder& c, uint8_t i) {
+        uint8_t k = 0;
+        while (((uint32_t)c.n[i] << k) < c.sum[i]) k++;
+        return k;
+    }
+
+    static void _riceUpdate(PowerLogCoder& c, uint8_t i, uint32_t z) {
+        c.sum[i] += (uint16_t)min(z, (uint32_t)POWERLOG_RICE_ZCAP);
+        if (++c.n[i] >= POWERLOG_RICE_NMAX) {
+            c.sum[i] >>= 1;
+            c.n[i]   >>= 1;
+        }
+    }
+
+    static int16_t _predict(const PowerLogCoder& c, uint8_t i) {
+        return (POWERLOG_DELTA_MASK & (1 << i)) ? c.ch[i] : 0;
+    }
+
+    // Klíč: hodnoty kanálů + start adaptace (k = 1)
+    static void _putKey(uint8_t* buf, uint16_t& pos, PowerLogCoder& c,
+                        const int16_t ch[POWERLOG_CHANNELS]) {
+        for (uint8_t i = 0; i < POWERLOG_CHANNELS; i++) {
+            _putValue(buf, pos, ch[i]);
+            c.ch[i]  = ch[i];
+            c.sum[i] = 4;
+            c.n[i]   = 2;
+        }
+    }
+
+    static void _getKey(const uint8_t* buf, uint16_t& pos, PowerLogCoder& c) {
+        for (uint8_t i = 0; i < POWERLOG_CHANNELS; i++) {
+            c.ch[i]  = _getValue(buf, pos);
+            c.sum[i] = 4;
+            c.n[i]   = 2;
+        }
+    }
+
+    // Další vzorek: kvocient unárně (1…10), zbytek k bitů
+    static void _putSample(uint8_t* buf, uint16_t& pos, PowerLogCoder& c,
+                           const int16_t ch[POWERLOG_CHANNELS]) {
+        for (uint8_t i = 0; i < POWERLOG_CHANNELS; i++) {
+            int32_t  e = (int32_t)ch[i] - _predict(c, i);
+            uint32_t z = _zigzag(e);
+            uint8_t  k = _riceK(c, i);
+            uint32_t q = z >> k;
+            if (q < POWERLOG_RICE_ESC) {
+                _putBits(buf, pos, (1UL << (q + 1)) - 2, q + 1);
+                _putBits(buf, pos, z, k);
+            } else {
+                _putBits(buf, pos, (1UL << POWERLOG_RICE_ESC) - 1, POWERLOG_RICE_ESC);
+                _putBits(buf, pos, (uint16_t)e, 16);
+            }
+            _riceUpdate(c, i, z);
+            c.ch[i] = ch[i];
+        }
+    }
+
+    static void _getSample(const uint8_t* buf, uint16_t& pos, PowerLogCoder& c) {
+        for (uint8_t i = 0; i < POWERLOG_CHANNELS; i++) {
+            uint8_t  k = _riceK(c, i);
+            uint32_t q = 0;
+            while (q < POWERLOG_RICE_ESC && _getBits(buf, pos, 1)) q++;
+            int32_t e;
+            if (q < POWERLOG_RICE_ESC) e = _unzigzag((q << k) | _getBits(buf, pos, k));
+            else                       e = (int16_t)_getBits(buf, pos, 16);
+            _riceUpdate(c, i, _zigzag(e));
+            c.ch[i] = (int16_t)(_predict(c, i) + e);
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Kvantizace + rezidua ↔ PowerSample
+    // ---------------------------------------------------------
+    static int16_t _q(int32_t w) {
+        int32_t q = (w >= 0) ? (w + POWERLOG_QUANT_W / 2) / POWERLOG_QUANT_W
+                             : (w - POWERLOG_QUANT_W / 2) / POWERLOG_QUANT_W;
+        return (int16_t)constrain(q, -32768, 32767);
+    }
+
+    // Pořadí kanálů: PV, load, L1, L2, ΣL, gridRes, batRes
+    static void _toChannels(const PowerSample& s, int16_t ch[POWERLOG_CHANNELS]) {
+        int16_t pv = _q(s.powerPV), load = _q(s.powerLoad);
+        int16_t l1 = _q(s.phaseL1), l2 = _q(s.phaseL2), l3 = _q(s.phaseL3);
+        int16_t grid = _q(s.powerGrid), bat = _q(s.powerBattery);
+        ch[0] = pv;  ch[1] = load;
+        ch[2] = l1;  ch[3] = l2;  ch[4] = (int16_t)(l1 + l2 + l3);
+        ch[5] = (int16_t)(grid + ch[4]);
+        ch[6] = (int16_t)(bat - (load - pv - grid));
+    }
+
+    static void _fromChannels(const int16_t ch[POWERLOG_CHANNELS], uint32_t ts, PowerSample& s) {
+        int32_t grid = ch[5] - ch[4];
+        int32_t bat  = ch[6] + (ch[1] - ch[0] - grid);
+        s.ts           = ts;
+        s.powerPV      = ch[0] * POWERLOG_QUANT_W;
+        s.powerLoad    = ch[1] * POWERLOG_QUANT_W;
+        s.phaseL1      = ch[2] * POWERLOG_QUANT_W;
+        s.phaseL2      = ch[3] * POWERLOG_QUANT_W;
+        s.phaseL3      = (ch[4] - ch[2] - ch[3]) * POWERLOG_QUANT_W;
+        s.powerGrid    = grid  * POWERLOG_QUANT_W;
+        s.powerBattery = bat   * POWERLOG_QUANT_W;
+    }
+
+    // ---------------------------------------------------------
+    //  Stav
+    // ---------------------------------------------------------
+    static FM24CL64*         _fram   = nullptr;
+    static SemaphoreHandle_t _mutex  = nullptr;
+    static uint8_t           _cur    = 0;        // index aktuálního rámce
+    static bool              _open   = false;    // aktuální rámec přijímá vzorky
+    static PowerLogFrameHdr  _hdr    = {};       // hlavička aktuálního rámce
+    static uint8_t           _data[POWERLOG_BUF_BYTES];
+    static PowerLogCoder     _enc    = {};       // poslední vzorek + stav Rice
+    static QueueHandle_t     _pending = nullptr;  // minuty z feed() → pump()
+    static volatile uint32_t _dropped = 0;        // zahozené vzorky od startu
+
+    static void _drop(const char* why) {
+        _dropped++;
+        LOGF("[PLOG] Vzorek zahozen (%s), celkem %lu\n", why, _dropped);
+    }
+
+    static uint16_t _frameAddr(uint8_t idx) {
+        return POWERLOG_ADDR + (uint16_t)idx * POWERLOG_FRAME_SIZE;
+    }
+
+    static bool _readHdr(uint8_t idx, PowerLogFrameHdr& h) {
+        _fram->readBlock(_frameAddr(idx), &h, sizeof(h));
+        return h.magic == POWERLOG_FRAME_MAGIC && h.count > 0
+            && h.bitLen <= POWERLOG_DATA_BITS;
+    }
+
+    // Dekóduj celý rámec, volej visitor pro vzorky v [from, to]
+    // Vrací false pokud visitor požádal o konec
+    static bool _decodeFrame(const PowerLogFrameHdr& h, const uint8_t* data,
+                             uint32_t from, uint32_t to,
+                             PowerLogVisitor cb, void* ctx, uint16_t& visited) {
+        PowerLogCoder dec;
+        uint16_t pos = 0;
+        PowerSample s;
+        for (uint16_t i = 0; i < h.count; i++) {
+            if (i == 0) _getKey(data, pos, dec);
+            else        _getSample(data, pos, dec);
+            if (pos > h.bitLen) return true;       // poškozený rámec
+            uint32_t ts = h.startTs + (uint32_t)i * POWERLOG_INTERVAL_S;
+            if (ts > to) return false;
+            if (ts < from) continue;
+            _fromChannels(dec.ch, ts, s);
+            visited++;
+            if (!cb(s, ctx)) return false;
+        }
+        return true;
+    }
+
+    // Začni nový rámec s prvním vzorkem (klíčem)
+    static void _startFrame(uint32_t ts, const int16_t ch[POWERLOG_CHANNELS]) {
+        if (_open) _cur = (_cur + 1) % POWERLOG_FRAMES;
+
+        uint16_t addr = _frameAddr(_cur);
+        _fram->writeByte(addr, 0xFF);             // invaliduj starý obsah slotu
+
+        memset(&_hdr, 0, sizeof(_hdr));
+        memset(_data, 0, sizeof(_data));
+        uint16_t pos = 0;
+        _putKey(_data, pos, _enc, ch);
+        _hdr.count   = 1;
+        _hdr.bitLen  = pos;
+        _hdr.startTs = ts;
+
+        // Klíč, hlavička bez magic, pak magic jako poslední
+        _fram->writeBlock(addr + sizeof(PowerLogFrameHdr), _data, (pos + 7) >> 3);
+        _fram->writeBlock(addr + 1, ((const uint8_t*)&_hdr) + 1, sizeof(_hdr) - 1);
+        _hdr.magic = POWERLOG_FRAME_MAGIC;
+        _fram->writeByte(addr, POWERLOG_FRAME_MAGIC);
+        _open = true;
+    }
+
+    // Oblast jiné verze (starý formát, dřív snapshot/RTC kalibrace
+    // na 0x0F80/0x1F00) – invaliduj všechny sloty, pak hlavičku bloku
+    static void _format() {
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++)
+            _fram->writeByte(_frameAddr(i), 0xFF);
+        _fram->writeByte(BLOCK_POWERLOG_ADDR + 1, BLOCK_POWERLOG_VER);
+        _fram->writeByte(BLOCK_POWERLOG_ADDR, FRAM_BLOCK_MAGIC);
+    }
+
+    // ---------------------------------------------------------
+    //  Inicializace – najdi nejnovější platný rámec a naváž na něj
+    //  Volej v setup() po úspěšném gFRAM.begin()
+    // ---------------------------------------------------------
+    void begin(FM24CL64& fram) {
+        _fram  = &fram;
+        _mutex = xSemaphoreCreateMutex();
+        if (!_pending) _pending = xQueueCreate(POWERLOG_QUEUE_LEN, sizeof(PowerSample));
+        _open  = false;
+        _cur   = 0;
+
+        FramBlockHeader bh;
+        _fram->readBlock(BLOCK_POWERLOG_ADDR, &bh, sizeof(bh));
+        if (bh.magic != FRAM_BLOCK_MAGIC || bh.version != BLOCK_POWERLOG_VER) {
+            LOGF("[PLOG] Formát v%u → v%u – log vymazán\n",
+                bh.magic == FRAM_BLOCK_MAGIC ? bh.version : 0, BLOCK_POWERLOG_VER);
+            _format();
+        }
+
+        uint32_t newest  = 0;
+        uint32_t samples = 0;
+        uint8_t  valid   = 0;
+        PowerLogFrameHdr h;
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++) {
+            if (!_readHdr(i, h)) continue;
+            valid++;
+            samples += h.count;
+            if (!_open || h.startTs >= newest) {
+                newest = h.startTs;
+                _cur   = i;
+                _open  = true;
+            }
+        }
+
+        if (_open) {
+            // Načti rámec do RAM a přehraj ho → _enc (vzorek + stav Rice)
+            _readHdr(_cur, _hdr);
+            memset(_data, 0, sizeof(_data));
+            _fram->readBlock(_frameAddr(_cur) + sizeof(PowerLogFrameHdr),
+                             _data, POWERLOG_DATA_BYTES);
+            uint16_t pos = 0;
+            _getKey(_data, pos, _enc);
+            for (uint16_t i = 1; i < _hdr.count && pos <= _hdr.bitLen; i++)
+                _getSample(_data, pos, _enc);
+            if (pos != _hdr.bitLen) {
+                LOGF("[PLOG] Rámec %u nekonzistentní – uzavírám\n", _cur);
+                _hdr.startTs = 0;    // vynutí nový rámec při dalším append
+            }
+        }
+
+        LOGF("[PLOG] Init OK – %u/%u rámců, aktuální %u (%u vzorků), "
+                      "historie %lu min (%.1f vzorků/rámec)\n",
+            valid, POWERLOG_FRAMES, _cur, _open ? _hdr.count : 0,
+            samples, valid > 1 ? (float)(samples - _hdr.count) / (valid - 1) : 0.0f);
+    }
+
+    // ---------------------------------------------------------
+    //  Přidej vzorek – zapisuje FRAM, volej jen z Core 0
+    //  (pump()); s.ts musí být zarovnán na POWERLOG_INTERVAL_S
+    // ---------------------------------------------------------
+    void append(const PowerSample& s) {
+        if (!_fram || !_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            _drop("mutex");
+            return;
+        }
+
+        int16_t ch[POWERLOG_CHANNELS];
+        _toChannels(s, ch);
+
+        uint32_t expected = _hdr.startTs + (uint32_t)_hdr.count * POWERLOG_INTERVAL_S;
+        bool contiguous = _open && _hdr.startTs != 0 && s.ts == expected;
+
+        // Zakóduj nanečisto za konec bitstreamu (buffer má rezervu)
+        uint16_t      oldLen = _hdr.bitLen;
+        uint16_t      pos    = oldLen;
+        PowerLogCoder enc    = _enc;
+        if (contiguous) _putSample(_data, pos, enc, ch);
+
+        if (!contiguous || pos > POWERLOG_DATA_BITS) {
+            _startFrame(s.ts, ch);
+        } else {
+            _enc = enc;
+
+            // Nové bajty bitstreamu (včetně rozpracovaného posledního)
+            uint16_t addr  = _frameAddr(_cur);
+            uint16_t first = oldLen >> 3;
+            uint16_t last  = (pos - 1) >> 3;
+            _fram->writeBlock(addr + sizeof(PowerLogFrameHdr) + first,
+                              &_data[first], last - first + 1);
+
+            // Commit – count + bitLen (4B) až po datech
+            _hdr.count++;
+            _hdr.bitLen = pos;
+            _fram->writeBlock(addr + offsetof(PowerLogFrameHdr, count),
+                              &_hdr.count, 4);
+        }
+
+        xSemaphoreGive(_mutex);
+    }
+
+    // ---------------------------------------------------------
+    //  Dotaz na rozsah [from, to] – volá cb pro každý vzorek
+    //  chronologicky. Vrací počet navštívených vzorků.
+    //
+    //  Příklad:
+    //    PowerLog::query(t0, t1, [](const PowerSample& s, void* c) {
+    //        ((Graph*)c)->add(s.ts, s.powerPV); return true;
+    //    }, &graph);
+    // ---------------------------------------------------------
+    uint16_t query(uint32_t from, uint32_t to, PowerLogVisitor cb, void* ctx) {
+        if (!_fram || !_mutex || !cb) return 0;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(200)) != pdTRUE) return 0;
+
+        // Seřaď platné rámce podle startTs (max POWERLOG_FRAMES → insertion sort)
+        uint8_t  order[POWERLOG_FRAMES];
+        uint32_t start[POWERLOG_FRAMES];
+        uint8_t  n = 0;
+        PowerLogFrameHdr h;
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++) {
+            if (_open && i == _cur) h = _hdr;
+            else if (!_readHdr(i, h)) continue;
+            uint32_t end = h.startTs + (uint32_t)(h.count - 1) * POWERLOG_INTERVAL_S;
+            if (end < from || h.startTs > to) continue;
+            uint8_t j = n++;
+            while (j > 0 && start[j - 1] > h.startTs) {
+                order[j] = order[j - 1];
+                start[j] = start[j - 1];
+                j--;
+            }
+            order[j] = i;
+            start[j] = h.startTs;
+        }
+
+        uint16_t visited = 0;
+        uint8_t  buf[POWERLOG_BUF_BYTES];
+        for (uint8_t k = 0; k < n; k++) {
+            uint8_t idx = order[k];
+            bool more;
+            if (_open && idx == _cur) {
+                more = _decodeFrame(_hdr, _data, from, to, cb, ctx, visited);
+            } else {
+                _readHdr(idx, h);
+                _fram->readBlock(_frameAddr(idx) + sizeof(PowerLogFrameHdr),
+                                 buf, (h.bitLen + 7) >> 3);
+                more = _decodeFrame(h, buf, from, to, cb, ctx, visited);
+            }
+            if (!more) break;
+        }
+
+        xSemaphoreGive(_mutex);
+        return visited;
+    }
+
+    // ---------------------------------------------------------
+    //  Proudové čtení od času from – volej queryNext() opakovaně,
+    //  mezi voláními drží stav jen kurzor
+    //
+    //  Příklad (export po částech):
+    //    PowerLogCursor c;
+    //    PowerLog::cursorBegin(c, t0);
+    //    while (PowerLog::queryNext(c, t1, visit, &exp)) { … }
+    // ---------------------------------------------------------
+    void cursorBegin(PowerLogCursor& c, uint32_t from) {
+        c.next    = from;
+        c.frameTs = 0;
+    }
+
+    // Načti do kurzoru rámec, který pokrývá c.next (nebo nejbližší
+    // následující) – vrací false pokud takový není
+    static bool _cursorFind(PowerLogCursor& c, uint32_t to) {
+        PowerLogFrameHdr h;
+        bool     found = false;
+        uint8_t  best  = 0;
+        uint32_t bestTs = 0;
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++) {
+            if (_open && i == _cur) h = _hdr;
+            else if (!_readHdr(i, h)) continue;
+            uint32_t end = h.startTs + (uint32_t)(h.count - 1) * POWERLOG_INTERVAL_S;
+            if (end < c.next || h.startTs > to) continue;
+            if (!found || h.startTs < bestTs) {
+                found  = true;
+                best   = i;
+                bestTs = h.startTs;
+            }
+        }
+        if (!found) return false;
+
+        if (_open && best == _cur) {
+            h = _hdr;
+            memcpy(c.data, _data, (h.bitLen + 7) >> 3);
+        } else {
+            _readHdr(best, h);
+            _fram->readBlock(_frameAddr(best) + sizeof(PowerLogFrameHdr),
+                             c.data, (h.bitLen + 7) >> 3);
+        }
+        c.frameTs = h.startTs;
+        c.frame   = best;
+        c.count   = h.count;
+        c.bitLen  = h.bitLen;
+        c.index   = 0;
+        c.pos     = 0;
+        _getKey(c.data, c.pos, c.dec);
+        return true;
+    }
+
+    // Ověř, že slot kurzoru pořád drží stejný rámec; dopsané
+    // vzorky otevřeného rámce donačti (jen nové bajty)
+    static bool _cursorCheck(PowerLogCursor& c) {
+        PowerLogFrameHdr h;
+        if (_open && c.frame == _cur) h = _hdr;
+        else if (!_readHdr(c.frame, h)) return false;
+        if (h.startTs != c.frameTs || h.count < c.count) return false;
+        if (h.count > c.count) {
+            uint16_t first = c.bitLen >> 3;
+            uint16_t last  = (h.bitLen + 7) >> 3;
+            if (_open && c.frame == _cur)
+                memcpy(&c.data[first], &_data[first], last - first);
+            else
+                _fram->readBlock(_frameAddr(c.frame) + sizeof(PowerLogFrameHdr) + first,
+                                 &c.data[first], last - first);
+            c.count  = h.count;
+            c.bitLen = h.bitLen;
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Pokračuj od kurzoru do to – volá cb chronologicky.
+    //  Vrací true pokud cb průchod přerušil (zbývají data),
+    //  false = rozsah vyčerpán. Vzorek, na kterém cb vrátil
+    //  false, se příště vydá znovu.
+    // ---------------------------------------------------------
+    bool queryNext(PowerLogCursor& c, uint32_t to, PowerLogVisitor cb, void* ctx) {
+        if (!_fram || !_mutex || !cb) return false;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(200)) != pdTRUE) return true;
+
+        bool more = false;
+        PowerSample s;
+        for (;;) {
+            if (c.frameTs && !_cursorCheck(c)) c.frameTs = 0;   // rámec přepsán
+            if (!c.frameTs && !_cursorFind(c, to)) break;
+
+            // Vzorky rámce od kurzoru
+            bool stop = false;
+            for (;;) {
+                uint32_t ts = c.frameTs + (uint32_t)c.index * POWERLOG_INTERVAL_S;
+                if (ts > to) { stop = true; break; }
+                if (ts >= c.next) {
+                    _fromChannels(c.dec.ch, ts, s);
+                    if (!cb(s, ctx)) { more = true; stop = true; break; }
+                    c.next = ts + 1;
+                }
+                if (c.index + 1 >= c.count) break;
+                _getSample(c.data, c.pos, c.dec);
+                c.index++;
+                if (c.pos > c.bitLen) break;            // poškozený rámec
+            }
+            if (stop) break;
+
+            // Rámec vyčerpán – další najde _cursorFind podle c.next
+            c.next    = c.frameTs + (uint32_t)c.count * POWERLOG_INTERVAL_S;
+            c.frameTs = 0;
+        }
+
+        xSemaphoreGive(_mutex);
+        return more;
+    }
+
+    // ---------------------------------------------------------
+    //  Rozsah uložených dat – vrací false pokud je log prázdný
+    // ---------------------------------------------------------
+    bool range(uint32_t& oldest, uint32_t& newest) {
+        if (!_fram || !_mutex) return false;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(200)) != pdTRUE) return false;
+        bool any = false;
+        PowerLogFrameHdr h;
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++) {
+            if (_open && i == _cur) h = _hdr;
+            else if (!_readHdr(i, h)) continue;
+            uint32_t end = h.startTs + (uint32_t)(h.count - 1) * POWERLOG_INTERVAL_S;
+            if (!any || h.startTs < oldest) oldest = h.startTs;
+            if (!any || end > newest)       newest = end;
+            any = true;
+        }
+        xSemaphoreGive(_mutex);
+        return any;
+    }
+
+    // ---------------------------------------------------------
+    //  Poslední uložený vzorek (bez čtení FRAM)
+    // ---------------------------------------------------------
+    bool latest(PowerSample& out) {
+        if (!_open || !_mutex) return false;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return false;
+        _fromChannels(_enc.ch,
+            _hdr.startTs + (uint32_t)(_hdr.count - 1) * POWERLOG_INTERVAL_S, out);
+        xSemaphoreGive(_mutex);
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Vymaž celý log (invaliduje všechny rámce)
+    // ---------------------------------------------------------
+    void clear() {
+        if (!_fram || !_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(200)) != pdTRUE) return;
+        for (uint8_t i = 0; i < POWERLOG_FRAMES; i++)
+            _fram->writeByte(_frameAddr(i), 0xFF);
+        _open = false;
+        _cur  = 0;
+        memset(&_hdr, 0, sizeof(_hdr));
+        xSemaphoreGive(_mutex);
+        LOGLN("[PLOG] Log vymazán");
+    }
+
+    // ---------------------------------------------------------
+    //  Zapiš minuty čekající ve frontě – volej v loop() (Core 0)
+    // ---------------------------------------------------------
+    void pump() {
+        if (!_pending) return;
+        PowerSample s;
+        while (xQueueReceive(_pending, &s, 0) == pdTRUE) append(s);
+    }
+
+    // Zahozené vzorky od startu (fronta plná / mutex obsazený)
+    uint32_t dropped() { return _dropped; }
+
+    // =========================================================
+    //  Minutový průměr – plní heartbeat task každou sekundu
+    // =========================================================
+    static int64_t  _acc[7]     = {};
+    static uint16_t _accN       = 0;
+    static uint32_t _accMinute  = 0;     // ts začátku akumulované minuty
+
+    // Přidej 1s vzorek; při přechodu minuty uloží průměr předchozí
+    // nowTs = aktuální čas [s od 2000], valid = data měniče platná
+    void feed(uint32_t nowTs, const PowerSample& s, bool valid) {
+        uint32_t minute = nowTs - (nowTs % POWERLOG_INTERVAL_S);
+        if (minute != _accMinute) {
+            if (_accN > 0 && _accMinute != 0) {
+                PowerSample avg;
+                avg.ts           = _accMinute;
+                avg.powerPV      = (int32_t)(_acc[0] / _accN);
+                avg.powerLoad    = (int32_t)(_acc[1] / _accN);
+                avg.powerGrid    = (int32_t)(_acc[2] / _accN);
+                avg.powerBattery = (int32_t)(_acc[3] / _accN);
+                avg.phaseL1      = (int32_t)(_acc[4] / _accN);
+                avg.phaseL2      = (int32_t)(_acc[5] / _accN);
+                avg.phaseL3      = (int32_t)(_acc[6] / _accN);
+                // FRAM zapíše Core 0 (pump) – tady jen fronta
+                if (_pending && xQueueSend(_pending, &avg, 0) != pdTRUE) _drop("fronta");
+            }
+            memset(_acc, 0, sizeof(_acc));
+            _accN      = 0;
+            _accMinute = minute;
+        }
+        if (!valid) return;
+        _acc[0] += s.powerPV;   _acc[1] += s.powerLoad;
+        _acc[2] += s.powerGrid; _acc[3] += s.powerBattery;
+        _acc[4] += s.phaseL1;   _acc[5] += s.phaseL2;
+        _acc[6] += s.phaseL3;
+        _accN++;
+    }
+
+} // namespace PowerLog
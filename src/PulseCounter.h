@@ -10,6 +10,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "HW_Config.h"
 
 // Sdílená data mezi IRQ a hlavní smyčkou
@@ -118,9 +119,9 @@ public:
     //  Výpis stavu všech čítačů do Serial
     // ---------------------------------------------------------
     void printStatus() {
-        Serial.println("[PulseCounter] Stav elektroměrů:");
+        LOGLN("[PulseCounter] Stav elektroměrů:");
         for (int i = 0; i < PULSE_COUNT; i++) {
-            Serial.printf("  Byt %2d: %6.3f kWh  (%lu pulzů celkem)\n",
+            LOGF("  Byt %2d: %6.3f kWh  (%lu pulzů celkem)\n",
                 i + 1, getEnergyKWh(i), pulseCount[i]);
         }
     }
@@ -0,0 +1,166 @@
+// =============================================================
+//  RelayBank.h  –  Relé všech zásobníků přes víc MCP23017
+//
+//  Jedna deska relé = jeden MCP23017 s 10 relé. Deska k leží
+//  na I2C adrese ADDR_MCP23017 + k a spíná zásobníky
+//  10k … 10k+9. Počet desek odvozuje MCP_CHIP_COUNT
+//  z BOILER_MAX_COUNT (výchozí 10 → jedna deska jako dřív).
+//
+//  Rozhraní kopíruje MCP23017 s globálním indexem relé –
+//  BoilerController a DiscoveryScreen nevidí, kolik desek je.
+//
+//  Dávka: beginBatch() → setRelay() × N → commit()
+//    commit() zapíše a ověří jen desky, kde se něco změnilo
+//    (MCP23017::commit přeskočí nezměněný čip bez fault).
+//
+//  Chybějící deska se chová jako chybějící čip – její relé
+//  jsou tiše ignorována, ostatní desky fungují.
+//  RS485 DE/RE je jen na desce 0 (GPB7).
+//
+//  Vzdálené relé: BoilerConfig.relaySlave != 0 → zásobník spíná
+//  cívka relayCoil Modbus RTU desky (ModbusRelays.h) místo relé
+//  MCP23017. Mimo dávku setRelay() hned probudí obsluhu linky,
+//  v dávce až commit(). Změna přiřazení za běhu nejdřív vypne
+//  dosavadní relé/cívku zásobníku.
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include "HW_Config.h"
+#include "MCP23017.h"
+#include "ModbusRelays.h"
+#include "BoilerConfig.h"
+
+extern BoilerConfig gBoilerCfg[BOILER_MAX_COUNT];
+
+static_assert(MCP_CHIP_COUNT >= 1 && MCP_CHIP_COUNT <= 8,
+              "MCP23017 má jen 8 adres (0x20–0x27) – max. 80 zásobníků");
+
+class RelayBank {
+public:
+    RelayBank() {
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++)
+            _chips[k] = MCP23017(ADDR_MCP23017 + k);
+    }
+
+    // ---------------------------------------------------------
+    //  Inicializace všech desek
+    //  Vrátí false pokud chybí deska 0 (bez ní ani RS485)
+    // ---------------------------------------------------------
+    bool begin() {
+        ModbusRelays::begin();
+        uint8_t found = 0;
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) {
+            if (_chips[k].begin()) found++;
+        }
+        if (MCP_CHIP_COUNT > 1) {
+            LOGF("[RelayBank] Desek relé: %u/%u\n", found, MCP_CHIP_COUNT);
+        }
+        return _chips[0].isAvailable();
+    }
+
+    // ---------------------------------------------------------
+    //  Relé zásobníku (index 0 … BOILER_MAX_COUNT-1)
+    // ---------------------------------------------------------
+    void setRelay(uint8_t index, bool state) {
+        if (index >= BOILER_MAX_COUNT) return;
+        uint8_t slave = gBoilerCfg[index].relaySlave;
+        uint8_t coil  = gBoilerCfg[index].relayCoil;
+
+        // Přiřazení se změnilo (UI) – staré relé nesmí zůstat sepnuté
+        if (slave != _slave[index] || coil != _coil[index]) {
+            _write(index, _slave[index], _coil[index], false);
+            _slave[index] = slave;
+            _coil[index]  = coil;
+        }
+        _write(index, slave, coil, state);
+        if (slave && !_batch) ModbusRelays::kick();
+    }
+
+    bool getRelay(uint8_t index) const {
+        if (index >= BOILER_MAX_COUNT) return false;
+        if (_slave[index]) return ModbusRelays::get(_slave[index], _coil[index]);
+        return _chips[index / MCP_RELAYS_PER_CHIP].getRelay(index % MCP_RELAYS_PER_CHIP);
+    }
+
+    // ---------------------------------------------------------
+    //  Dávka přes všechny desky
+    //  commit() vrátí false pokud nesouhlasí kterákoli deska MCP;
+    //  Modbus desky zapíše Inverter task – commit() ho jen probudí,
+    //  výsledek jejich ověření se projeví v relayFault() později
+    // ---------------------------------------------------------
+    void beginBatch() {
+        _batch = true;
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) _chips[k].beginBatch();
+    }
+
+    bool commit() {
+        _batch = false;
+        bool ok = true;
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) {
+            if (!_chips[k].commit()) ok = false;
+        }
+        if (ModbusRelays::pending()) ModbusRelays::kick();
+        return ok;
+    }
+
+    // Součet nesouhlasů zpětného čtení všech desek (MCP i Modbus)
+    uint16_t verifyErrors() const {
+        uint32_t n = ModbusRelays::errors();
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) n += _chips[k].verifyErrors();
+        return n > 0xFFFF ? 0xFFFF : (uint16_t)n;
+    }
+
+    // Alarm – nesouhlasí kterákoli deska
+    bool relayFault() const {
+        if (ModbusRelays::fault()) return true;
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) {
+            if (_chips[k].relayFault()) return true;
+        }
+        return false;
+    }
+
+    // ---------------------------------------------------------
+    //  RS485 DE/RE – deska 0
+    // ---------------------------------------------------------
+    void setRS485Transmit(bool transmit) { _chips[0].setRS485Transmit(transmit); }
+
+    // ---------------------------------------------------------
+    //  Vypni všechna relé (bezpečnostní funkce)
+    // ---------------------------------------------------------
+    void allRelaysOff() {
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) _chips[k].allRelaysOff();
+        ModbusRelays::allOff();
+        ModbusRelays::kick();
+    }
+
+    // Deska 0 dostupná (relé 1–10 + RS485)
+    bool isAvailable() const { return _chips[0].isAvailable(); }
+
+    // Deska se zásobníkem 'index' dostupná
+    bool isAvailable(uint8_t index) const {
+        if (index >= BOILER_MAX_COUNT) return false;
+        return _chips[index / MCP_RELAYS_PER_CHIP].isAvailable();
+    }
+
+    // ---------------------------------------------------------
+    //  Debug výpis
+    // ---------------------------------------------------------
+    void printStatus() const {
+        for (uint8_t k = 0; k < MCP_CHIP_COUNT; k++) _chips[k].printStatus();
+        ModbusRelays::printStatus();
+    }
+
+private:
+    MCP23017 _chips[MCP_CHIP_COUNT];
+    uint8_t  _slave[BOILER_MAX_COUNT] = {};    // naposledy použité přiřazení
+    uint8_t  _coil[BOILER_MAX_COUNT]  = {};
+    bool     _batch = false;
+
+    void _write(uint8_t index, uint8_t slave, uint8_t coil, bool state) {
+        if (slave) ModbusRelays::set(slave, coil, state);
+        else       _chips[index / MCP_RELAYS_PER_CHIP].setRelay(index % MCP_RELAYS_PER_CHIP, state);
+    }
+};
+
+extern RelayBank gRelays;
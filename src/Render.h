@@ -0,0 +1,415 @@
+// =============================================================
+//  Render.h – dirty-rect vykreslování spriteů přes SPI DMA
+//
+//  Problém: screeny překreslí celý sprite (MainScreen 2× 160×188,
+//  config screeny 320×188 = 117 KB) a pushSprite() ho celý pošle
+//  po SPI (40 MHz ≈ 24 ms), i když se změnilo jedno číslo.
+//
+//  Řešení – sprite zaregistrovaný jako "surface":
+//    1. Sprite se dál kreslí celý (v RAM je to levné).
+//    2. push() rozdělí sprite na dlaždice RENDER_TILE_W × RENDER_TILE_H,
+//       spočítá hash každé dlaždice a porovná s hashem toho, co je
+//       na displeji → změněné dlaždice = invalidované oblasti.
+//       Widget může oblast invalidovat i explicitně (invalidate()).
+//    3. Dlaždice se slijí do obdélníků (běhy v řádku → stejné běhy
+//       pod sebou → sloučení blízkých), max RENDER_MAX_RECTS.
+//    4. Obdélníky jdou přes pushImageDMA(). Plná šířka spritu je
+//       v paměti souvislá → DMA přímo ze spritu. Užší obdélník se
+//       po řádcích kopíruje do jednoho ze dvou bounce bufferů –
+//       CPU plní další buffer, zatímco DMA posílá předchozí.
+//
+//  Paletové sprity (4 bity/px): content sprite 320×188 zabírá
+//  29 KB místo 117 KB, MainScreen 2× 15 KB místo 2× 59 KB.
+//  Screen do nich kreslí indexy (Render::ink() → THEME_INK),
+//  _pushRect() je při kopii do bounce bufferu rozbalí přes
+//  paletu tématu na RGB565 – na displeji žádný rozdíl.
+//  Paleta se nastaví v attach() a setTheme().
+//
+//  Kreslí-li screen přímo na tft přes oblast spritu (editor,
+//  dialog, fillScreen v draw()), musí surface invalidovat –
+//  jinak by push() nepoznal, že displej už spritu neodpovídá.
+//  _drawCurrent() v main_ui_loop.h volá invalidateAll().
+//
+//  Měření: endFrame() po každém draw/update/vstupu ukládá
+//  odeslané bajty a čas snímku per screen, každých
+//  RENDER_LOG_FRAMES snímků výpis [RENDER] na Serial.
+//
+//  Použití:
+//    spr.setColorDepth(4);  spr.createSprite(w, h);
+//    Render::attach(&spr, gTheme);
+//    t = Render::ink(&spr, t);            // barvy → indexy palety
+//    ... kreslení do spr ...
+//    Render::push(&spr, x, y);            // místo spr.pushSprite(x, y)
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include <LovyanGFX.hpp>
+#include "LGFX_ST7789V_Pico2W.h"
+#include "ScreenManager.h"
+#include "Theme.h"
+
+#define RENDER_MAX_SURFACES  4
+#define RENDER_TILE_W        32       // [px] – celá 32bit slova i při 4 bitech/px
+#define RENDER_TILE_H        8
+#define RENDER_MAX_RECTS     12       // víc obdélníků → sloučí se do jednoho
+#define RENDER_DMA_PIXELS    2048     // velikost jednoho bounce bufferu [px]
+#define RENDER_MERGE_SLACK   256      // [px²] přípustný odpad při slučování
+#define RENDER_SCREENS       17       // počet Screen ID pro statistiky
+#define RENDER_LOG_FRAMES    60
+
+// Statistika vykreslování jednoho screenu
+struct RenderStats {
+    uint32_t frames;
+    uint32_t bytes;           // součet odeslaných bajtů
+    uint32_t us;              // součet času snímků
+    uint32_t maxUs;
+    uint32_t lastBytes;
+    uint32_t lastUs;
+    uint16_t lastRects;
+};
+
+namespace Render {
+
+    struct Rect {
+        int16_t x, y, w, h;
+    };
+
+    struct Surface {
+        LGFX_Sprite* spr;
+        uint32_t*    hash;        // hash dlaždice tak, jak je na displeji
+        uint8_t      bpp;         // 16 = RGB565, 4 = paleta
+        const Theme* theme;       // téma, ze kterého je pal
+        uint16_t     pal[THEME_PALETTE_SIZE];   // RGB565 s prohozenými bajty (pro panel)
+        uint8_t      tilesX;
+        uint8_t      tilesY;
+        bool         all;         // celý sprite neplatný
+        uint8_t      nRects;
+        Rect         rects[RENDER_MAX_RECTS];
+    };
+
+    static Surface     _surf[RENDER_MAX_SURFACES] = {};
+    static uint8_t     _numSurf = 0;
+    static uint16_t    _bounce[2][RENDER_DMA_PIXELS];
+    static uint8_t     _bi      = 0;
+
+    static uint32_t    _frameBytes = 0;
+    static uint16_t    _frameRects = 0;
+    static RenderStats _stats[RENDER_SCREENS] = {};
+
+    static Surface* _find(LGFX_Sprite* spr) {
+        for (uint8_t i = 0; i < _numSurf; i++)
+            if (_surf[i].spr == spr) return &_surf[i];
+        return nullptr;
+    }
+
+    // Bity na pixel bez příznaku palety (lgfx::color_depth_t)
+    static uint8_t _bpp(LGFX_Sprite* spr) {
+        return (uint8_t)(spr->getColorDepth() & 0xFF);
+    }
+
+    // Bajtů na řádek spritu
+    static int32_t _stride(const Surface& s) {
+        return (int32_t)s.spr->width() * s.bpp / 8;
+    }
+
+    // Paleta tématu → sprite (pro fallback pushSprite) + tabulka pro push
+    static void _setPalette(Surface& s, const Theme* t) {
+        if (s.bpp == 16 || !t || s.theme == t) return;
+        uint16_t pal[THEME_PALETTE_SIZE];
+        themePalette(t, pal);
+        s.spr->createPalette(pal, THEME_PALETTE_SIZE);
+        for (uint8_t i = 0; i < THEME_PALETTE_SIZE; i++)
+            s.pal[i] = (uint16_t)((pal[i] << 8) | (pal[i] >> 8));
+        s.theme  = t;
+        s.all    = true;
+        s.nRects = 0;
+    }
+
+    // ---------------------------------------------------------
+    //  Obdélníky – přidání se slučováním
+    // ---------------------------------------------------------
+    static Rect _union(const Rect& a, const Rect& b) {
+        int16_t x0 = min(a.x, b.x), y0 = min(a.y, b.y);
+        int16_t x1 = max(a.x + a.w, b.x + b.w), y1 = max(a.y + a.h, b.y + b.h);
+        return { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+    }
+
+    static int32_t _area(const Rect& r) { return (int32_t)r.w * r.h; }
+
+    // Sloučit se vyplatí, když obálka nepřidá víc než SLACK px
+    // (každý obdélník = nové okno na panelu + start DMA)
+    static bool _worthMerging(const Rect& a, const Rect& b) {
+        return _area(_union(a, b)) <= _area(a) + _area(b) + RENDER_MERGE_SLACK;
+    }
+
+    static void _addRect(Surface& s, Rect r) {
+        if (s.all) return;
+        // Slučuj opakovaně – nová obálka může pohltit další obdélníky
+        for (uint8_t i = 0; i < s.nRects; ) {
+            if (_worthMerging(s.rects[i], r)) {
+                r = _union(s.rects[i], r);
+                s.rects[i] = s.rects[--s.nRects];
+                i = 0;
+            } else {
+                i++;
+            }
+        }
+        if (s.nRects < RENDER_MAX_RECTS) {
+            s.rects[s.nRects++] = r;
+        } else {
+            for (uint8_t i = 0; i < s.nRects; i++) r = _union(s.rects[i], r);
+            s.rects[0] = r;
+            s.nRects   = 1;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Hash dlaždice (FNV-1a po 32bit slovech = 2 px / 8 px)
+    // ---------------------------------------------------------
+    static uint32_t _tileHash(const Surface& s, int16_t x, int16_t y, int16_t w, int16_t h) {
+        const uint8_t* buf    = (const uint8_t*)s.spr->getBuffer();
+        int32_t        stride = _stride(s);
+        int32_t        xb     = (int32_t)x * s.bpp / 8;
+        int16_t        words  = (int16_t)((int32_t)w * s.bpp / 32);
+        uint32_t hv = 2166136261UL;
+        for (int16_t r = 0; r < h; r++) {
+            const uint32_t* p = (const uint32_t*)(buf + (int32_t)(y + r) * stride + xb);
+            for (int16_t i = 0; i < words; i++) hv = (hv ^ p[i]) * 16777619UL;
+        }
+        return hv;
+    }
+
+    // Změněné dlaždice → obdélníky (běhy v řádku, spojené svisle)
+    static void _detect(Surface& s) {
+        int16_t W = s.spr->width(), H = s.spr->height();
+        Rect    prev[RENDER_MAX_RECTS];     // běhy předchozí řady dlaždic
+        uint8_t nPrev = 0;
+
+        for (uint8_t ty = 0; ty < s.tilesY; ty++) {
+            int16_t y  = ty * RENDER_TILE_H;
+            int16_t th = min((int16_t)RENDER_TILE_H, (int16_t)(H - y));
+            Rect    cur[RENDER_MAX_RECTS];
+            uint8_t nCur = 0;
+            int16_t runX = -1;
+
+            for (uint8_t tx = 0; tx <= s.tilesX; tx++) {
+                bool changed = false;
+                if (tx < s.tilesX) {
+                    int16_t  x  = tx * RENDER_TILE_W;
+                    int16_t  tw = min((int16_t)RENDER_TILE_W, (int16_t)(W - x));
+                    uint32_t hv = _tileHash(s, x, y, tw, th);
+                    uint32_t& stored = s.hash[ty * s.tilesX + tx];
+                    changed = (hv != stored);
+                    stored  = hv;
+                }
+                if (changed && runX < 0) runX = tx * RENDER_TILE_W;
+                if (!changed && runX >= 0) {
+                    int16_t x1 = min((int16_t)(tx * RENDER_TILE_W), W);
+                    Rect r = { runX, y, (int16_t)(x1 - runX), th };
+                    // Stejný běh v předchozí řadě → prodluž dolů
+                    for (uint8_t i = 0; i < nPrev; i++) {
+                        if (prev[i].x == r.x && prev[i].w == r.w &&
+                            prev[i].y + prev[i].h == y) {
+                            r.y = prev[i].y;
+                            r.h = prev[i].h + th;
+                            prev[i] = prev[--nPrev];
+                            break;
+                        }
+                    }
+                    if (nCur < RENDER_MAX_RECTS) cur[nCur++] = r;
+                    else _addRect(s, r);
+                    runX = -1;
+                }
+            }
+            // Neprodloužené běhy předchozí řady jsou hotové
+            for (uint8_t i = 0; i < nPrev; i++) _addRect(s, prev[i]);
+            memcpy(prev, cur, sizeof(Rect) * nCur);
+            nPrev = nCur;
+        }
+        for (uint8_t i = 0; i < nPrev; i++) _addRect(s, prev[i]);
+    }
+
+    // Po plném pushi – hashe odpovídají obsahu spritu
+    static void _rehashAll(Surface& s) {
+        int16_t W = s.spr->width(), H = s.spr->height();
+        for (uint8_t ty = 0; ty < s.tilesY; ty++) {
+            int16_t y  = ty * RENDER_TILE_H;
+            int16_t th = min((int16_t)RENDER_TILE_H, (int16_t)(H - y));
+            for (uint8_t tx = 0; tx < s.tilesX; tx++) {
+                int16_t x  = tx * RENDER_TILE_W;
+                int16_t tw = min((int16_t)RENDER_TILE_W, (int16_t)(W - x));
+                s.hash[ty * s.tilesX + tx] = _tileHash(s, x, y, tw, th);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  DMA push jednoho obdélníku
+    // ---------------------------------------------------------
+    // Řádek paletového spritu → RGB565 (sudý pixel = horní nibble)
+    static void _expandRow(const Surface& s, const uint8_t* row, int16_t x, int16_t w,
+                           uint16_t* dst) {
+        for (int16_t i = 0; i < w; i++) {
+            int16_t px = x + i;
+            uint8_t b  = row[px >> 1];
+            dst[i] = s.pal[(px & 1) ? (b & 0x0F) : (b >> 4)];
+        }
+    }
+
+    static void _pushRect(const Surface& s, int16_t dx, int16_t dy, const Rect& r) {
+        const uint16_t* buf = (const uint16_t*)s.spr->getBuffer();
+        int16_t W = s.spr->width();
+
+        // Plná šířka 16bit spritu = souvislý blok paměti → DMA přímo ze spritu
+        if (s.bpp == 16 && r.w == W) {
+            tft.waitDMA();
+            tft.pushImageDMA(dx, dy + r.y, r.w, r.h,
+                             (const lgfx::swap565_t*)(buf + (int32_t)r.y * W));
+            return;
+        }
+
+        // Užší obdélník / paleta – po pásech přes střídané bounce buffery
+        int16_t rows = max(1, RENDER_DMA_PIXELS / r.w);
+        for (int16_t y = 0; y < r.h; y += rows) {
+            int16_t   n   = min(rows, (int16_t)(r.h - y));
+            uint16_t* dst = _bounce[_bi];
+            _bi ^= 1;
+            for (int16_t k = 0; k < n; k++) {
+                if (s.bpp == 16) {
+                    memcpy(dst + k * r.w, buf + (int32_t)(r.y + y + k) * W + r.x, r.w * 2);
+                } else {
+                    const uint8_t* row = (const uint8_t*)buf + (int32_t)(r.y + y + k) * _stride(s);
+                    _expandRow(s, row, r.x, r.w, dst + k * r.w);
+                }
+            }
+            tft.waitDMA();              // předchozí pás (druhý buffer) dojel
+            tft.pushImageDMA(dx + r.x, dy + r.y + y, r.w, n,
+                             (const lgfx::swap565_t*)dst);
+        }
+    }
+
+    // ==========================================================
+    //  Veřejné rozhraní
+    // ==========================================================
+
+    // ---------------------------------------------------------
+    //  Zaregistruj sprite (po createSprite) – 16bit RGB565 nebo
+    //  4bit paleta (šířka násobek 8); t = téma pro paletu
+    // ---------------------------------------------------------
+    bool attach(LGFX_Sprite* spr, const Theme* t) {
+        if (!spr || !spr->getBuffer() || _find(spr)) return _find(spr) != nullptr;
+        if (_numSurf >= RENDER_MAX_SURFACES) return false;
+        uint8_t bpp = _bpp(spr);
+        if (bpp == 16 ? (spr->width() & 1) : (bpp != 4 || (spr->width() & 7))) return false;
+
+        Surface& s = _surf[_numSurf];
+        s.spr    = spr;
+        s.bpp    = bpp;
+        s.theme  = nullptr;
+        s.tilesX = (spr->width()  + RENDER_TILE_W - 1) / RENDER_TILE_W;
+        s.tilesY = (spr->height() + RENDER_TILE_H - 1) / RENDER_TILE_H;
+        s.hash   = (uint32_t*)malloc(sizeof(uint32_t) * s.tilesX * s.tilesY);
+        if (!s.hash) return false;
+        s.all    = true;
+        s.nRects = 0;
+        _setPalette(s, t);
+        _numSurf++;
+        return true;
+    }
+
+    // Změna tématu – přepočti palety (volá _drawCurrent())
+    void setTheme(const Theme* t) {
+        for (uint8_t i = 0; i < _numSurf; i++) _setPalette(_surf[i], t);
+    }
+
+    // Barvy pro kreslení do spritu: paleta → THEME_INK, jinak t
+    const Theme* ink(LGFX_Sprite* spr, const Theme* t) {
+        return _bpp(spr) == 16 ? t : &THEME_INK;
+    }
+
+    // Celý surface neplatný (na displeji je něco jiného)
+    void invalidate(LGFX_Sprite* spr) {
+        Surface* s = _find(spr);
+        if (s) { s->all = true; s->nRects = 0; }
+    }
+
+    // Explicitní oblast widgetu [souřadnice ve spritu]
+    void invalidate(LGFX_Sprite* spr, int16_t x, int16_t y, int16_t w, int16_t h) {
+        Surface* s = _find(spr);
+        if (!s || w <= 0 || h <= 0) return;
+        _addRect(*s, { x, y, w, h });
+    }
+
+    // Všechny surface – volá _drawCurrent() před draw() screenu
+    void invalidateAll() {
+        for (uint8_t i = 0; i < _numSurf; i++) {
+            _surf[i].all    = true;
+            _surf[i].nRects = 0;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Pošli změněné oblasti spritu na displej (x, y = pozice)
+    // ---------------------------------------------------------
+    void push(LGFX_Sprite* spr, int16_t x, int16_t y) {
+        Surface* s = _find(spr);
+        if (!s) {
+            // Neregistrovaný sprite – klasicky celý
+            spr->pushSprite(x, y);
+            _frameBytes += (uint32_t)spr->width() * spr->height() * 2;   // na panel vždy RGB565
+            _frameRects++;
+            return;
+        }
+
+        Rect full = { 0, 0, (int16_t)spr->width(), (int16_t)spr->height() };
+        if (s->all) {
+            _rehashAll(*s);
+            s->nRects   = 1;
+            s->rects[0] = full;
+        } else {
+            _detect(*s);
+        }
+        if (s->nRects == 0) return;
+
+        tft.startWrite();
+        for (uint8_t i = 0; i < s->nRects; i++) {
+            _pushRect(*s, x, y, s->rects[i]);
+            _frameBytes += (uint32_t)_area(s->rects[i]) * 2;
+        }
+        tft.waitDMA();                  // sprite se smí znovu kreslit
+        tft.endWrite();
+
+        _frameRects += s->nRects;
+        s->nRects = 0;
+        s->all    = false;
+    }
+
+    // ---------------------------------------------------------
+    //  Konec snímku – us = doba draw/update včetně pushů
+    // ---------------------------------------------------------
+    void endFrame(Screen scr, uint32_t us) {
+        if (scr >= RENDER_SCREENS) { _frameBytes = 0; _frameRects = 0; return; }
+        RenderStats& st = _stats[scr];
+        st.frames++;
+        st.bytes    += _frameBytes;
+        st.us       += us;
+        st.lastBytes = _frameBytes;
+        st.lastUs    = us;
+        st.lastRects = _frameRects;
+        if (us > st.maxUs) st.maxUs = us;
+        _frameBytes = 0;
+        _frameRects = 0;
+
+        if (st.frames % RENDER_LOG_FRAMES == 0) {
+            LOGF("[RENDER] scr %u: %lu sn., prumer %lu B / %lu us, max %lu us\n",
+                scr, (unsigned long)st.frames,
+                (unsigned long)(st.bytes / st.frames),
+                (unsigned long)(st.us / st.frames),
+                (unsigned long)st.maxUs);
+        }
+    }
+
+    const RenderStats& stats(Screen scr) { return _stats[scr < RENDER_SCREENS ? scr : 0]; }
+
+} // namespace Render
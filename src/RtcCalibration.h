@@ -0,0 +1,158 @@
+// =============================================================
+//  RtcCalibration.h – automatická kalibrace PCF85063A z NTP
+//
+//  Každý NTP sync zapíše RTC na přesný čas → chyba RTC těsně
+//  před zápisem (SntpClient ji měří na hraně sekundy čipu) je
+//  drift nasčítaný od předchozího zápisu:
+//
+//      err_i [s] = (d + c_i) · 1e-6 · t_i
+//
+//  d   = vlastní drift krystalu [ppm] (+ = RTC spěchá)
+//  c_i = korekce offsetem platná v intervalu (offset · 1.09 ppm)
+//  t_i = délka intervalu [s]
+//
+//  Odhad d metodou nejmenších čtverců přes posledních
+//  RTC_CAL_POINTS intervalů (přímka přes počátek, delší
+//  interval má přirozeně větší váhu):
+//
+//      y_i = err_i − c_i·1e-6·t_i
+//      d   = Σ(y_i·t_i) / Σ(t_i²) · 1e6
+//
+//  Nový offset = calcOffset(d), zapíše se do čipu hned po NTP
+//  zápisu (interval tak má vždy jediný offset) a do gConfig
+//  (FramSystem.rtcCalOffset). Body + čas posledního zápisu
+//  jsou ve FRAM bloku 14 → měření přežije restart.
+//
+//  Interval se zahodí, pokud:
+//    - je kratší než RTC_CAL_MIN_INTERVAL_S (ruční sync z UI)
+//    - drift vychází přes RTC_CAL_MAX_PPM (výpadek, ruční čas)
+//  Ruční nastavení času nebo ztráta napájení RTC (OS flag)
+//  rozpracovaný interval zruší (invalidate()).
+//
+//  Použití:
+//    RtcCalibration::begin(gRTC);        // setup() po gRTC.begin()
+//    RtcCalibration::invalidate();       // po ručním setTime()
+//    (sync hlásí SntpClient přes onSync – registruje begin())
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include "Config.h"
+#include "FramMap.h"
+#include "FramWriter.h"
+#include "PCF85063A.h"
+#include "SntpClient.h"
+
+#define RTC_CAL_MIN_INTERVAL_S  3600UL          // kratší interval nemá rozlišení
+#define RTC_CAL_MIN_SPAN_S      (24UL * 3600UL) // min. Σ intervalů pro změnu offsetu
+#define RTC_CAL_MAX_PPM         200.0f          // víc = nesmysl (skok času)
+
+extern Config gConfig;
+
+namespace RtcCalibration {
+
+    static PCF85063A* _rtc  = nullptr;
+    static FramRtcCal _data = {};
+    static float      _driftPpm = 0.0f;         // poslední odhad (diagnostika)
+
+    static void _save() {
+        FramWriter::submit(BLOCK_RTCCAL_ADDR, BLOCK_RTCCAL_VER, &_data, sizeof(_data));
+    }
+
+    // ---------------------------------------------------------
+    //  Odhad driftu krystalu [ppm] – false pokud málo dat
+    // ---------------------------------------------------------
+    static bool _estimate(float& drift) {
+        double sxy = 0, sxx = 0, span = 0;
+        for (uint8_t i = 0; i < _data.count; i++) {
+            const FramRtcCalPoint& p = _data.pts[i];
+            double t = p.elapsedS;
+            double c = p.offset * RTC_PPM_PER_STEP * 1e-6;
+            double y = p.errMs / 1000.0 - c * t;
+            sxy  += y * t;
+            sxx  += t * t;
+            span += t;
+        }
+        if (_data.count < 2 || span < RTC_CAL_MIN_SPAN_S || sxx <= 0) return false;
+        drift = (float)(sxy / sxx * 1e6);
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  SntpClient → RTC právě zapsán na čas NTP
+    // ---------------------------------------------------------
+    static void _onSync(uint32_t localSecs, int32_t errMs, bool measured) {
+        // errMs = RTC – NTP změřené SntpClientem na hraně sekundy
+        // RTC (ne TimeService – ten jede z časovače RP2350)
+        uint32_t elapsed = localSecs - _data.lastSetAt;
+
+        if (!measured) {
+            LOGLN("[RTCCAL] Chyba RTC neměřena – interval zahozen");
+        } else if (_data.lastSetAt && localSecs > _data.lastSetAt &&
+                   elapsed >= RTC_CAL_MIN_INTERVAL_S) {
+            float ppm = errMs * 1000.0f / elapsed;
+            if (fabsf(ppm) <= RTC_CAL_MAX_PPM) {
+                FramRtcCalPoint& p = _data.pts[_data.head];
+                p.elapsedS = elapsed;
+                p.errMs    = errMs;
+                p.offset   = _data.offset;
+                _data.head = (_data.head + 1) % RTC_CAL_POINTS;
+                if (_data.count < RTC_CAL_POINTS) _data.count++;
+                LOGF("[RTCCAL] Interval %lu h, chyba %ld ms (%.2f ppm při offsetu %+d)\n",
+                    (unsigned long)(elapsed / 3600), (long)errMs, ppm, _data.offset);
+            } else {
+                LOGF("[RTCCAL] Interval zahozen – %.0f ppm\n", ppm);
+            }
+        }
+
+        // Nový offset platí od tohoto zápisu
+        float drift;
+        if (_estimate(drift)) {
+            _driftPpm = drift;
+            int8_t off = PCF85063A::calcOffset(drift);
+            if (off != _data.offset && _rtc && _rtc->setCalibration(off)) {
+                LOGF("[RTCCAL] Drift krystalu %.2f ppm → offset %+d\n", drift, off);
+                _data.offset         = off;
+                gConfig.rtcCalOffset = off;
+                ConfigManager::saveAsync(BLOCK_SYSTEM_ADDR);
+            }
+        }
+        _data.lastSetAt = localSecs;
+        _save();
+    }
+
+    // ---------------------------------------------------------
+    //  Inicializace – načti body, nastav uložený offset do čipu
+    // ---------------------------------------------------------
+    void begin(PCF85063A& rtc) {
+        _rtc = &rtc;
+        if (!FramBlock::readBlock(gFRAM, BLOCK_RTCCAL_ADDR, BLOCK_RTCCAL_VER,
+                                  &_data, sizeof(_data)) ||
+            _data.count > RTC_CAL_POINTS || _data.head >= RTC_CAL_POINTS) {
+            memset(&_data, 0, sizeof(_data));
+            _data.offset = gConfig.rtcCalOffset;
+        }
+        // RTC ztratilo napájení → interval od posledního syncu neplatí
+        if (!rtc.isValid()) _data.lastSetAt = 0;
+
+        rtc.setCalibration(gConfig.rtcCalOffset);
+        _data.offset = gConfig.rtcCalOffset;
+        _estimate(_driftPpm);
+        SntpClient::onSync(_onSync);
+        LOGF("[RTCCAL] offset %+d, %u bodů, drift %.2f ppm\n",
+            _data.offset, _data.count, _driftPpm);
+    }
+
+    // ---------------------------------------------------------
+    //  Ruční nastavení času – rozpracovaný interval neplatí
+    // ---------------------------------------------------------
+    void invalidate() {
+        if (!_data.lastSetAt) return;
+        _data.lastSetAt = 0;
+        _save();
+    }
+
+    float   driftPpm()   { return _driftPpm; }
+    uint8_t points()     { return _data.count; }
+
+} // namespace RtcCalibration
@@ -0,0 +1,110 @@
+// =============================================================
+//  RunningStats.h – průběžné statistiky a sekvenční testy
+//
+//  RunningStats  průměr a rozptyl (Welford) bez ukládání vzorků,
+//                numericky stabilní i pro mnoho vzorků blízko
+//                sebe (příkon zásobníku ~2000 W ± desítky W)
+//  ciHalf95()    poloviční šířka 95% intervalu průměru (Student t)
+//  diffCiHalf95  totéž pro rozdíl dvou průměrů (skok fáze)
+//  Sprt          Waldův sekvenční test průměru: H0 μ0 / H1 μ1
+//                při známém šumu σ – rozhodne po nejmenším
+//                počtu vzorků (ne dřív než minN), zašuměný
+//                signál test prodlouží. Rozhodovací bod je
+//                (μ0 + μ1) / 2 – volbou μ0 se posune práh.
+//
+//  Měření se zastaví, jakmile je výsledek v toleranci, místo
+//  pevného počtu vzorků (Discovery po jednom, recheck).
+//
+//  Použití:
+//    RunningStats s;
+//    s.add(1980); s.add(2010);
+//    s.mean(), s.stddev(), s.ciHalf95()
+//
+//    Sprt t; t.begin(0, 1600, 150);     // nic / odběr 1600 W, min. 2 vzorky
+//    int8_t r = t.add(x);               // −1 H0, +1 H1, 0 dál
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <math.h>
+
+// Kritická hodnota Studentova t pro oboustranných 95 %
+// (malý počet vzorků – interval z normálního rozdělení by byl úzký)
+inline float tCrit95(uint16_t df) {
+    static const float t[] = { 0.0f, 12.71f, 4.30f, 3.18f, 2.78f, 2.57f,
+                               2.45f, 2.36f, 2.31f, 2.26f, 2.23f };
+    if (df == 0) return INFINITY;
+    if (df <= 10) return t[df];
+    if (df <= 20) return 2.09f;
+    return 1.96f;
+}
+
+struct RunningStats {
+    uint16_t n    = 0;
+    float    avg  = 0.0f;
+    float    m2   = 0.0f;     // součet čtverců odchylek od průměru
+
+    void reset() { n = 0; avg = 0.0f; m2 = 0.0f; }
+
+    void add(float x) {
+        if (n < 0xFFFF) n++;
+        float d = x - avg;
+        avg += d / n;
+        m2  += d * (x - avg);
+    }
+
+    float mean()     const { return avg; }
+    float variance() const { return n > 1 ? m2 / (n - 1) : 0.0f; }
+    float stddev()   const { return sqrtf(variance()); }
+
+    // Směrodatná chyba průměru – šířka intervalu spolehlivosti
+    float stderrMean() const { return n > 1 ? sqrtf(variance() / n) : 0.0f; }
+
+    // ± 95% interval průměru (n < 2 → nekonečno)
+    float ciHalf95() const { return n > 1 ? tCrit95(n - 1) * stderrMean() : INFINITY; }
+};
+
+// ± 95% interval rozdílu průměrů b − a (Welch, konzervativně
+// stupně volnosti menšího vzorku)
+inline float diffCiHalf95(const RunningStats& a, const RunningStats& b) {
+    if (a.n < 2 || b.n < 2) return INFINITY;
+    uint16_t df = (a.n < b.n ? a.n : b.n) - 1;
+    return tCrit95(df) * sqrtf(a.variance() / a.n + b.variance() / b.n);
+}
+
+// =============================================================
+//  Sprt – Waldův sekvenční test H0: μ = μ0 proti H1: μ = μ1
+//  (normální šum se známým σ, chyby 1. a 2. druhu α = β)
+// =============================================================
+struct Sprt {
+    float llr   = 0.0f;       // log poměr věrohodností H1/H0
+    float mu0   = 0.0f;
+    float mu1   = 0.0f;
+    float k     = 0.0f;       // (μ1 − μ0) / σ²
+    float bound = 0.0f;       // ln((1 − α) / α)
+    uint16_t n    = 0;        // přidané vzorky
+    uint8_t  minN = 2;        // dřív nerozhodne (jeden vzorek = jeden výkyv)
+
+    void begin(float m0, float m1, float sigma, float alpha = 0.01f,
+               uint8_t minSamples = 2) {
+        mu0   = m0;
+        mu1   = m1;
+        k     = (m1 - m0) / (sigma * sigma);
+        bound = logf((1.0f - alpha) / alpha);
+        llr   = 0.0f;
+        n     = 0;
+        minN  = minSamples;
+    }
+
+    // Přidej vzorek → +1 přijmi H1, −1 přijmi H0, 0 pokračuj
+    int8_t add(float x) {
+        llr += k * (x - 0.5f * (mu0 + mu1));
+        if (n < 0xFFFF) n++;
+        if (n < minN) return 0;
+        if (llr >=  bound) return  1;
+        if (llr <= -bound) return -1;
+        return 0;
+    }
+
+    // Vynucené rozhodnutí po max. počtu vzorků – bližší hypotéza
+    int8_t decide() const { return llr >= 0.0f ? 1 : -1; }
+};
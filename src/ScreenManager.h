@@ -3,7 +3,7 @@
 //
 //  Každý screen implementuje tři funkce:
 //    draw()        – první vykreslení (po přepnutí)
-//    update()      – periodická aktualizace dat (každou sekundu)
+//    update()      – aktualizace dat (po události UI – viz main_ui_loop.h)
 //    handleInput() – obsluha 5-way switche, vrátí cílový Screen
 //
 //  Přepínání obrazovek:
@@ -14,6 +14,7 @@
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include "FiveWaySwitch.h"
 #include "Theme.h"
 
@@ -37,6 +38,7 @@ enum Screen : uint8_t {
     SCREEN_SERIAL        = 13, // UdP → Serial (Modbus transport, profil, RTU)
     SCREEN_INVERTER      = 14, // UdP → Střídač (parametry elektrárny)
     SCREEN_MQTT          = 15, // UdP → MQTT (odesílání dat na internet)
+    SCREEN_TREND         = 16, // Menu → Trend (krátkodobý graf výkonů)
     SCREEN_NONE         = 0xFF
 };
 
@@ -59,14 +61,14 @@ namespace ScreenManager {
         if (_stackTop < SCREEN_STACK_DEPTH) {
             _stack[_stackTop++] = _current;
         }
-        Serial.printf("[SCR] %d → %d\n", _current, next);
+        LOGF("[SCR] %d → %d\n", _current, next);
         _current      = next;
         _needDraw     = true;
         _lastUpdateMs = 0;
     }
 
     void replaceTo(Screen next) {
-        Serial.printf("[SCR] replace %d → %d\n", _current, next);
+        LOGF("[SCR] replace %d → %d\n", _current, next);
         _current      = next;
         _needDraw     = true;
         _lastUpdateMs = 0;
@@ -78,11 +80,11 @@ namespace ScreenManager {
             _current  = SCREEN_MAIN;
             _needDraw = true;
             _lastUpdateMs = 0;
-            Serial.println("[SCR] goBack → MAIN (stack prazdny)");
+            LOGLN("[SCR] goBack → MAIN (stack prazdny)");
             return;
         }
         Screen prev = _stack[--_stackTop];
-        Serial.printf("[SCR] goBack → %d\n", prev);
+        LOGF("[SCR] goBack → %d\n", prev);
         _current      = prev;
         _needDraw     = true;
         _lastUpdateMs = 0;
@@ -25,15 +25,18 @@
 //  Při změně parametrů které vyžadují restart se zobrazí dialog.
 //
 //  Geometrie:
-//    Sdílený gContentSprite, pixelový scroll, FTR_Y ochrana.
+//    Sdílený gContentSprite, seznam = ListView.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
@@ -100,13 +103,7 @@ namespace SerialScreen {
     // Viditelnost položek (skrývání TCP/RTU sekcí)
     static bool _visible[ITEM_COUNT] = {};
 
-    #define SER_ROW_H    26
-    #define SER_SEC_H    16
-    #define SER_START_Y  (CONTENT_Y + 4)
-
-    static uint8_t _cursor       = 0;
-    static uint8_t _scrollOffset = 0;
-    static bool    _editing      = false;
+    static ListView _list;
     static bool    _needsRestart = false;   // změna vyžaduje restart
     static bool    _showRestart  = false;   // zobrazuje restart dialog
 
@@ -117,7 +114,6 @@ namespace SerialScreen {
 
     // Sdílený sprite z main_ui_loop
     static LGFX_Sprite* _spr = nullptr;
-    void setSprite(LGFX_Sprite* s) { _spr = s; }
 
     // Baudrate předvolby
     static const uint32_t _baudPresets[] = { 9600, 19200, 38400, 57600, 115200 };
@@ -266,8 +262,8 @@ namespace SerialScreen {
             default: break;
         }
 
-        ConfigManager::saveBlockModbus();
-        Serial.printf("[SER] Uloženo: %s = %s%s\n",
+        ConfigManager::saveAsync(BLOCK_MODBUS_ADDR);
+        LOGF("[SER] Uloženo: %s = %s%s\n",
             _items[idx].label, _items[idx].value,
             restart ? " (restart)" : "");
         return restart;
@@ -388,222 +384,54 @@ namespace SerialScreen {
     }
 
     // ----------------------------------------------------------
-    //  Kreslení položky – vrací výšku (0 = za FTR_Y)
-    // ----------------------------------------------------------
-    static int16_t _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
-        SerItem& item   = _items[idx];
-        bool     active  = (idx == _cursor);
-        bool     editing = (active && _editing && !_editingIp);
-        int16_t  drawn   = 0;
-        LovyanGFX* dc    = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t    sy    = _spr ? y - CONTENT_Y : y;
-
-        // Sekce header
-        if (item.section != nullptr) {
-            if (y + SER_SEC_H > FTR_Y) return 0;
-            dc->fillRect(0, sy, 320, SER_SEC_H, t->bg);
-            dc->setFont(&fonts::Font2);
-            dc->setTextColor(t->dim);
-            dc->setCursor(16, sy);
-            dc->print(item.section);
-            sy += 14;
-            dc->drawFastHLine(16, sy, 288, t->dim);
-            sy += 2;
-            drawn += SER_SEC_H;
-        }
-
-        if (y + drawn + SER_ROW_H > FTR_Y) return drawn;
-
-        // Pozadí řádku
-        if (active) {
-            dc->fillRect(8, sy, 304, SER_ROW_H, t->header);
-            dc->fillRect(8, sy, 3,   SER_ROW_H, t->accent);
-        } else {
-            dc->fillRect(8, sy, 304, SER_ROW_H, t->bg);
-        }
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(item.readonly
-            ? t->dim
-            : (active ? t->accent : t->text));
-        dc->setCursor(20, sy + 7);
-        dc->print(item.label);
-
-        // Hodnota
-        uint16_t valCol = item.readonly
-            ? (idx == ITEM_STAT_CONN
-                ? (strcmp(item.value, "OK") == 0 ? t->ok : t->err)
-                : t->dim)
-            : (editing ? t->accent : t->text);
-
-        dc->setTextColor(valCol);
-        dc->setTextDatum(middle_right);
-        dc->drawString(item.value, 308, sy + 12);
-        dc->setTextDatum(top_left);
-
-        drawn += SER_ROW_H;
-        return drawn;
-    }
-
-    // ----------------------------------------------------------
-    //  Překresli všechny viditelné položky
-    // ----------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        if (_spr) { _spr->fillScreen(t->bg); }
-        else { tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg); }
-        int16_t y = SER_START_Y;
-        for (uint8_t i = _scrollOffset; i < ITEM_COUNT; i++) {
-            if (!_visible[i]) continue;
-            int16_t h = _drawItemAt(t, i, y);
-            if (h == 0) break;
-            y += h;
-        }
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
-    }
-
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        _drawAllItems(t);
-    }
-
-    // ----------------------------------------------------------
-    //  Y pozice položky (pro scroll výpočet)
-    // ----------------------------------------------------------
-    static int16_t _itemY(uint8_t idx) {
-        int16_t y = SER_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (!_visible[i]) continue;
-            if (_items[i].section != nullptr) y += SER_SEC_H;
-            y += SER_ROW_H;
-        }
-        return y;
-    }
-
-    // ----------------------------------------------------------
-    //  Scroll
-    // ----------------------------------------------------------
-    static bool _ensureVisible() {
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-        bool changed = false;
-        while (_scrollOffset < _cursor) {
-            int16_t y      = _itemY(_cursor);
-            int16_t secH   = (_items[_cursor].section != nullptr) ? SER_SEC_H : 0;
-            int16_t bottom = y + secH + SER_ROW_H;
-            if (bottom <= FTR_Y) break;
-            _scrollOffset++;
-            changed = true;
-        }
-        return changed;
-    }
-
-    // ----------------------------------------------------------
-    //  Přeskoč na další/předchozí viditelnou položku
+    //  Řádek seznamu
     // ----------------------------------------------------------
-    static bool _cursorUp() {
-        uint8_t c = _cursor;
-        while (c > 0) {
-            c--;
-            if (_visible[c]) { _cursor = c; return true; }
-        }
-        return false;
+    static void _row(uint8_t idx, ListRow& r) {
+        SerItem& item = _items[idx];
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        r.flags   = item.readonly ? LIST_READONLY : 0;
+        if (!_visible[idx])        r.flags |= LIST_HIDDEN;
+        if (idx == ITEM_TCP_IP)    r.flags |= LIST_CUSTOM;
+        if (idx == ITEM_STAT_CONN)
+            r.tone = strcmp(item.value, "OK") == 0 ? LIST_TONE_OK : LIST_TONE_ERR;
     }
 
-    static bool _cursorDown() {
-        uint8_t c = _cursor;
-        while (c < ITEM_COUNT - 1) {
-            c++;
-            if (_visible[c]) { _cursor = c; return true; }
-        }
-        return false;
+    // IP editor – oktety místo hodnoty v řádku IP adresy
+    static void _drawIp(LovyanGFX* dc, const Theme* t, uint8_t idx, int16_t y) {
+        ListView::drawIp(dc, t, y, _ipOctets, _ipField);
     }
 
-    // ==========================================================
-    //  IP EDITOR – editace po oktetech s podtržením
-    // ==========================================================
-    static void _drawIpEditor(const Theme* t) {
-        // Najdi Y řádku IP adresy
-        _drawAllItems(t);  // překresli vše (IP řádek bude přepsán)
-
-        // Nakresli IP s podtržením aktivního oktetu přímo přes sprite/tft
-        int16_t y = _itemY(ITEM_TCP_IP);
-        int16_t secH = (_items[ITEM_TCP_IP].section != nullptr) ? SER_SEC_H : 0;
-        int16_t rowY = y + secH;
-
-        LovyanGFX* dc = _spr ? (LovyanGFX*)_spr : (LovyanGFX*)&tft;
-        int16_t sy = _spr ? rowY - CONTENT_Y : rowY;
-
-        // Pozadí řádku
-        dc->fillRect(8, sy, 304, SER_ROW_H, t->header);
-        dc->fillRect(8, sy, 3,   SER_ROW_H, t->accent);
-
-        // Label
-        dc->setFont(&fonts::Font2);
-        dc->setTextColor(t->accent);
-        dc->setCursor(20, sy + 7);
-        dc->print("IP adresa");
-
-        // Oktety s podtržením
-        char parts[4][4];
-        for (uint8_t i = 0; i < 4; i++) {
-            snprintf(parts[i], 4, "%u", _ipOctets[i]);
-        }
-
-        const int16_t baseX = 180;
-        int16_t cx = baseX;
-
-        for (uint8_t i = 0; i < 4; i++) {
-            bool act = (_ipField == i);
-            uint8_t w = (uint8_t)strlen(parts[i]) * 8;
-
-            dc->setTextColor(act ? t->accent : t->text);
-            dc->setCursor(cx, sy + 7);
-            dc->print(parts[i]);
-
-            // Podtržení aktivního oktetu
-            if (act) {
-                dc->fillRect(cx, sy + SER_ROW_H - 4, w, 2, t->accent);
-            }
-
-            cx += w;
-
-            // Tečka za oktetem (kromě posledního)
-            if (i < 3) {
-                dc->setTextColor(t->dim);
-                dc->setCursor(cx, sy + 7);
-                dc->print(".");
-                cx += 6;
-            }
-        }
-
-        if (_spr) { _spr->pushSprite(0, CONTENT_Y); }
+    void setSprite(LGFX_Sprite* s) {
+        _spr = s;
+        _list.begin(ITEM_COUNT, _row, _drawIp);
+        _list.setSprite(s);
     }
 
     static Screen _handleIpInput(const Theme* t, SwButton btn) {
         switch (btn) {
             case SW_UP:
-                _ipOctets[_ipField] = (_ipOctets[_ipField] + 1) % 256;
-                _drawIpEditor(t);
+                _ipOctets[_ipField] = (_ipOctets[_ipField] + gSwitch.step()) % 256;
+                _list.drawRow(t, ITEM_TCP_IP);
                 return SCREEN_NONE;
             case SW_DOWN:
-                _ipOctets[_ipField] = (_ipOctets[_ipField] + 255) % 256;
-                _drawIpEditor(t);
+                _ipOctets[_ipField] = (_ipOctets[_ipField] + 256 - gSwitch.step()) % 256;
+                _list.drawRow(t, ITEM_TCP_IP);
                 return SCREEN_NONE;
             case SW_RIGHT:
-                if (_ipField < 3) { _ipField++; _drawIpEditor(t); }
+                if (_ipField < 3) { _ipField++; _list.drawRow(t, ITEM_TCP_IP); }
                 return SCREEN_NONE;
             case SW_LEFT:
                 if (_ipField > 0) {
                     _ipField--;
-                    _drawIpEditor(t);
+                    _list.drawRow(t, ITEM_TCP_IP);
                 } else {
                     // Zruš editaci IP
                     _editingIp = false;
-                    _editing   = false;
+                    _list.setEditing(false);
                     _loadFromConfig();
-                    _drawAllItems(t);
+                    _list.drawRow(t, ITEM_TCP_IP);
                 }
                 return SCREEN_NONE;
             case SW_CENTER:
@@ -612,12 +440,12 @@ namespace SerialScreen {
                 snprintf(_items[ITEM_TCP_IP].value, 20, "%u.%u.%u.%u",
                     _ipOctets[0], _ipOctets[1], _ipOctets[2], _ipOctets[3]);
                 _editingIp = false;
-                _editing   = false;
+                _list.setEditing(false);
                 _needsRestart = true;
-                ConfigManager::saveBlockModbus();
-                Serial.printf("[SER] IP = %u.%u.%u.%u (restart)\n",
+                ConfigManager::saveAsync(BLOCK_MODBUS_ADDR);
+                LOGF("[SER] IP = %u.%u.%u.%u (restart)\n",
                     _ipOctets[0], _ipOctets[1], _ipOctets[2], _ipOctets[3]);
-                _drawAllItems(t);
+                _list.drawRow(t, ITEM_TCP_IP);
                 return SCREEN_NONE;
             default:
                 return SCREEN_NONE;
@@ -628,6 +456,7 @@ namespace SerialScreen {
     //  RESTART DIALOG
     // ==========================================================
     static void _drawRestartDialog(const Theme* t) {
+        if (_spr) Render::invalidate(_spr);     // dialog překryje sprite na displeji
         tft.fillRect(30, 70, 260, 100, t->header);
         tft.drawRect(30, 70, 260, 100, t->warn);
 
@@ -651,8 +480,9 @@ namespace SerialScreen {
     static Screen _handleRestartInput(const Theme* t, SwButton btn) {
         switch (btn) {
             case SW_CENTER:
-                ConfigManager::saveBlockModbus();
-                Serial.println("[SER] Restart...");
+                ConfigManager::saveAsync(BLOCK_MODBUS_ADDR);
+                FramWriter::flush(1000);   // restart nesmí předběhnout zápis
+                LOGLN("[SER] Restart...");
                 delay(200);
                 watchdog_reboot(0, 0, 0);  // okamžitý restart
                 // Sem se nedostaneme
@@ -660,7 +490,7 @@ namespace SerialScreen {
             case SW_LEFT:
                 _showRestart  = false;
                 _needsRestart = false;
-                _drawAllItems(t);
+                _list.draw(t);
                 // Překresli footer
                 tft.fillRect(0, FTR_Y, 320, FTR_H, t->header);
                 tft.setFont(&fonts::Font2);
@@ -695,7 +525,7 @@ namespace SerialScreen {
 
         _loadFromConfig();
         _updateStatus(d);
-        _drawAllItems(t);
+        _list.draw(t);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -704,9 +534,11 @@ namespace SerialScreen {
         Header::update(t, dt, apState, staState, invState, alarm);
 
         // Live update stavu – jen pokud needitujeme a není restart dialog
-        if (!_editing && !_showRestart) {
+        if (!_list.editing() && !_showRestart) {
             _updateStatus(d);
-            _drawAllItems(t);
+            _list.drawRow(t, ITEM_STAT_CONN);
+            _list.drawRow(t, ITEM_STAT_ERRORS);
+            _list.drawRow(t, ITEM_STAT_LAST_POLL);
         }
     }
 
@@ -723,34 +555,35 @@ namespace SerialScreen {
         }
 
         // --- Editace běžné položky ---
-        if (_editing) {
+        if (_list.editing()) {
             switch (btn) {
                 case SW_UP:
-                    _stepUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepUp(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _stepDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _stepDown(_list.cursor());
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 case SW_CENTER: {
-                    _editing = false;
-                    bool restart = _saveItem(_cursor);
+                    _list.setEditing(false);
+                    bool restart = _saveItem(_list.cursor());
                     if (restart) _needsRestart = true;
+                    _loadFromConfig();
                     // Při změně transportu přepočítej viditelnost
-                    if (_cursor == ITEM_TRANSPORT) {
+                    // (kurzor na Rezim zůstává – ten je vidět vždy)
+                    if (_list.cursor() == ITEM_TRANSPORT) {
                         _updateVisibility();
-                        // Pokud kurzor skočil na skrytou položku, posuň
-                        if (!_visible[_cursor]) _cursorDown();
+                        _list.draw(t);
+                    } else {
+                        _list.drawRow(t, _list.cursor());
                     }
-                    _loadFromConfig();
-                    _drawAllItems(t);
                     return SCREEN_NONE;
                 }
                 case SW_LEFT:
-                    _editing = false;
+                    _list.setEditing(false);
                     _loadFromConfig();
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, _list.cursor());
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -760,36 +593,30 @@ namespace SerialScreen {
         // --- Normální navigace ---
         switch (btn) {
             case SW_UP:
-                if (_cursorUp()) {
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursorDown()) {
-                    _ensureVisible();
-                    _drawAllItems(t);
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER:
                 // Readonly položky – nic
-                if (_items[_cursor].readonly) return SCREEN_NONE;
+                if (_items[_list.cursor()].readonly) return SCREEN_NONE;
 
                 // IP adresa – speciální editor
-                if (_cursor == ITEM_TCP_IP) {
+                if (_list.cursor() == ITEM_TCP_IP) {
                     _editingIp = true;
-                    _editing   = true;
+                    _list.setEditing(true);
                     _ipField   = 0;
                     memcpy(_ipOctets, gConfig.invIp, 4);
-                    _drawIpEditor(t);
+                    _list.drawRow(t, ITEM_TCP_IP);
                     return SCREEN_NONE;
                 }
 
                 // Běžná editace
-                _editing = true;
-                _drawItem(t, _cursor);
+                _list.setEditing(true);
+                _list.drawRow(t, _list.cursor());
                 return SCREEN_NONE;
 
             case SW_LEFT:
@@ -807,9 +634,7 @@ namespace SerialScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _editingIp    = false;
         _showRestart  = false;
         _needsRestart = false;
@@ -18,17 +18,25 @@
 //    CENTER  – vstup do editace / potvrzení pole / zápis do RTC
 //
 //  Datum/Čas readonly pokud NTP=on AND gWifiSta=true
+//
+//  Geometrie:
+//    Sdílený gContentSprite, seznam = ListView.
 // =============================================================
 #pragma once
 #include <Arduino.h>
+#include "Log.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "Theme.h"
 #include "Header.h"
 #include "ScreenManager.h"
+#include "Render.h"
+#include "ListView.h"
 #include "FiveWaySwitch.h"
 #include "SolarData.h"
 #include "PCF85063A.h"
+#include "TimeService.h"
+#include "RtcCalibration.h"
 
 // WiFi stav a RTC z main.cpp
 extern volatile bool gWifiSta;
@@ -37,11 +45,6 @@ extern volatile bool gNtpResync;
 
 namespace SettingScreen {
 
-    #define SET_VISIBLE   6
-    #define SET_ROW_H     26
-    #define SET_SEC_H     16
-    #define SET_START_Y   (CONTENT_Y + 4)
-
     // ---------------------------------------------------------
     //  Definice položek
     // ---------------------------------------------------------
@@ -70,9 +73,7 @@ namespace SettingScreen {
         { nullptr,        "Backlight", "80 %"       },
     };
 
-    static uint8_t  _cursor       = 0;
-    static uint8_t  _scrollOffset = 0;
-    static bool     _editing      = false;
+    static ListView _list;
 
     // Stav editace datumu/času
     static uint8_t  _dtField  = 0;   // aktivní pole (datum: 0=DD,1=MM,2=YYYY  čas: 0=HH,1=MM)
@@ -93,7 +94,7 @@ namespace SettingScreen {
     //  Načti čas z RTC do zobrazovaných hodnot
     // ---------------------------------------------------------
     static void _loadFromRTC() {
-        DateTime dt = gRTC.getTime();
+        DateTime dt = TimeService::local();
         _dtDay    = dt.day;
         _dtMonth  = dt.month;
         _dtYear   = dt.year;
@@ -120,10 +121,12 @@ namespace SettingScreen {
             dt.second = 0;  // reset sekund při ručním nastavení
         }
         if (gRTC.setTime(dt)) {
-            Serial.printf("[SET] RTC zapsano: %02d.%02d.%04d %02d:%02d\n",
+            TimeService::resync();
+            RtcCalibration::invalidate();     // ruční čas – interval driftu neplatí
+            LOGF("[SET] RTC zapsano: %02d.%02d.%04d %02d:%02d\n",
                 dt.day, dt.month, dt.year, dt.hour, dt.minute);
         } else {
-            Serial.println("[SET] RTC zapis selhal!");
+            LOGLN("[SET] RTC zapis selhal!");
         }
         _loadFromRTC();
     }
@@ -164,21 +167,21 @@ namespace SettingScreen {
                 break;
             default: break;
         }
-        Serial.printf("[SET] Uloženo: %s = %s\n",
+        LOGF("[SET] Uloženo: %s = %s\n",
             _items[idx].label, _items[idx].value);
     }
 
     // ---------------------------------------------------------
     //  Nakresli inline editaci datumu (aktivní pole podtrženo)
     // ---------------------------------------------------------
-    static void _drawDateEdit(const Theme* t, int16_t y) {
+    static void _drawDateEdit(LovyanGFX* dc, const Theme* t, int16_t y) {
         char parts[3][8];
         snprintf(parts[0], 8, "%02d", _dtDay);
         snprintf(parts[1], 8, "%02d", _dtMonth);
         snprintf(parts[2], 8, "%04d", _dtYear);
 
-        tft.fillRect(155, y, 153, SET_ROW_H, t->header);
-        tft.setFont(&fonts::Font2);
+        dc->fillRect(155, y, 153, LIST_ROW_H, t->header);
+        dc->setFont(&fonts::Font2);
 
         // X pozice polí: DD . MM . YYYY
         const int16_t xs[3] = { 160, 184, 208 };
@@ -186,18 +189,18 @@ namespace SettingScreen {
 
         for (uint8_t i = 0; i < 3; i++) {
             bool active = (_dtField == i);
-            tft.setTextColor(active ? t->accent : t->text);
-            tft.setCursor(xs[i], y + 7);
-            tft.print(parts[i]);
+            dc->setTextColor(active ? t->accent : t->text);
+            dc->setCursor(xs[i], y + 7);
+            dc->print(parts[i]);
             // Podtržení aktivního pole
             if (active) {
-                tft.fillRect(xs[i], y + SET_ROW_H - 4, ws[i], 2, t->accent);
+                dc->fillRect(xs[i], y + LIST_ROW_H - 4, ws[i], 2, t->accent);
             }
             // Tečka oddělovač
             if (i < 2) {
-                tft.setTextColor(t->dim);
-                tft.setCursor(xs[i] + ws[i], y + 7);
-                tft.print(".");
+                dc->setTextColor(t->dim);
+                dc->setCursor(xs[i] + ws[i], y + 7);
+                dc->print(".");
             }
         }
     }
@@ -205,130 +208,60 @@ namespace SettingScreen {
     // ---------------------------------------------------------
     //  Nakresli inline editaci času (aktivní pole podtrženo)
     // ---------------------------------------------------------
-    static void _drawTimeEdit(const Theme* t, int16_t y) {
+    static void _drawTimeEdit(LovyanGFX* dc, const Theme* t, int16_t y) {
         char parts[2][4];
         snprintf(parts[0], 4, "%02d", _dtHour);
         snprintf(parts[1], 4, "%02d", _dtMinute);
 
-        tft.fillRect(155, y, 153, SET_ROW_H, t->header);
-        tft.setFont(&fonts::Font2);
+        dc->fillRect(155, y, 153, LIST_ROW_H, t->header);
+        dc->setFont(&fonts::Font2);
 
         const int16_t xs[2] = { 190, 216 };
 
         for (uint8_t i = 0; i < 2; i++) {
             bool active = (_dtField == i);
-            tft.setTextColor(active ? t->accent : t->text);
-            tft.setCursor(xs[i], y + 7);
-            tft.print(parts[i]);
+            dc->setTextColor(active ? t->accent : t->text);
+            dc->setCursor(xs[i], y + 7);
+            dc->print(parts[i]);
             if (active) {
-                tft.fillRect(xs[i], y + SET_ROW_H - 4, 16, 2, t->accent);
+                dc->fillRect(xs[i], y + LIST_ROW_H - 4, 16, 2, t->accent);
             }
             if (i == 0) {
-                tft.setTextColor(t->dim);
-                tft.setCursor(xs[i] + 16, y + 7);
-                tft.print(":");
+                dc->setTextColor(t->dim);
+                dc->setCursor(xs[i] + 16, y + 7);
+                dc->print(":");
             }
         }
     }
 
     // ---------------------------------------------------------
-    //  Nakresli jednu položku na danou Y
+    //  Řádek seznamu
     // ---------------------------------------------------------
-    static void _drawItemAt(const Theme* t, uint8_t idx, int16_t y) {
+    static void _row(uint8_t idx, ListRow& r) {
         SettingItem& item = _items[idx];
-        bool active  = (idx == _cursor);
-        bool editing = (active && _editing);
-        bool dtItem  = (idx == ITEM_DATE || idx == ITEM_TIME);
-        bool rdonly  = dtItem && _dtReadonly();
-
-        // Sekce header
-        if (item.section != nullptr) {
-            tft.fillRect(0, y, 320, SET_SEC_H, t->bg);
-            tft.setFont(&fonts::Font2);
-            tft.setTextColor(t->dim);
-            tft.setCursor(16, y);
-            tft.print(item.section);
-            y += 14;
-            tft.drawFastHLine(16, y, 288, t->dim);
-            y += 2;
-        }
-
-        // Pozadí
-        if (active) {
-            tft.fillRect(8, y, 304, SET_ROW_H, t->header);
-            tft.fillRect(8, y, 3,   SET_ROW_H, t->accent);
-        } else {
-            tft.fillRect(8, y, 304, SET_ROW_H, t->bg);
-        }
-
-        // Label
-        tft.setFont(&fonts::Font2);
-        tft.setTextColor(rdonly ? t->dim : active ? t->accent : t->text);
-        tft.setCursor(20, y + 7);
-        tft.print(item.label);
-
-        // Readonly indikátor
-        if (rdonly) {
-            tft.setTextColor(t->dim);
-            tft.setTextDatum(middle_right);
-            tft.drawString("NTP", 308, y + 12);
-            tft.setTextDatum(top_left);
-            return;
-        }
-
-        // Hodnota – editace nebo statická
-        if (editing && idx == ITEM_DATE) {
-            _drawDateEdit(t, y);
-        } else if (editing && idx == ITEM_TIME) {
-            _drawTimeEdit(t, y);
-        } else if (strlen(item.value) > 0) {
-            tft.setTextColor(editing ? t->accent : t->text);
-            tft.setTextDatum(middle_right);
-            tft.drawString(item.value, 308, y + 12);
-            tft.setTextDatum(top_left);
-        }
-    }
-
-    // ---------------------------------------------------------
-    //  Překresli všechny viditelné položky
-    // ---------------------------------------------------------
-    static void _drawAllItems(const Theme* t) {
-        tft.fillRect(0, CONTENT_Y, 320, CONTENT_H, t->bg);
-        int16_t y = SET_START_Y;
-        uint8_t end = min((uint8_t)ITEM_COUNT, (uint8_t)(_scrollOffset + SET_VISIBLE));
-        for (uint8_t i = _scrollOffset; i < end; i++) {
-            _drawItemAt(t, i, y);
-            if (_items[i].section != nullptr) y += SET_SEC_H;
-            y += SET_ROW_H;
+        r.section = item.section;
+        r.label   = item.label;
+        r.value   = item.value;
+        if (idx == ITEM_DATE || idx == ITEM_TIME) {
+            if (_dtReadonly()) {
+                r.flags = LIST_READONLY;
+                r.value = "NTP";            // readonly indikátor
+            } else {
+                r.flags = LIST_CUSTOM;
+            }
         }
     }
 
-    // ---------------------------------------------------------
-    //  Překresli jednu položku (najde Y na displeji)
-    // ---------------------------------------------------------
-    static void _drawItem(const Theme* t, uint8_t idx) {
-        if (idx < _scrollOffset || idx >= _scrollOffset + SET_VISIBLE) return;
-        int16_t y = SET_START_Y;
-        for (uint8_t i = _scrollOffset; i < idx; i++) {
-            if (_items[i].section != nullptr) y += SET_SEC_H;
-            y += SET_ROW_H;
-        }
-        _drawItemAt(t, idx, y);
+    // Inline editor datumu / času v řádku
+    static void _drawEdit(LovyanGFX* dc, const Theme* t, uint8_t idx, int16_t y) {
+        if (idx == ITEM_DATE) _drawDateEdit(dc, t, y);
+        else                  _drawTimeEdit(dc, t, y);
     }
 
-    // ---------------------------------------------------------
-    //  Scroll
-    // ---------------------------------------------------------
-    static bool _ensureVisible() {
-        if (_cursor < _scrollOffset) {
-            _scrollOffset = _cursor;
-            return true;
-        }
-        if (_cursor >= _scrollOffset + SET_VISIBLE) {
-            _scrollOffset = _cursor - SET_VISIBLE + 1;
-            return true;
-        }
-        return false;
+    // Sdílený sprite z main_ui_loop
+    void setSprite(LGFX_Sprite* s) {
+        _list.begin(ITEM_COUNT, _row, _drawEdit);
+        _list.setSprite(s);
     }
 
     // ---------------------------------------------------------
@@ -347,7 +280,7 @@ namespace SettingScreen {
         tft.setTextDatum(middle_center);
         tft.drawString("UP/DN  RIGHT pole  CENTER ok  LEFT zpet", 160, FTR_Y + 13);
         tft.setTextDatum(top_left);
-        _drawAllItems(t);
+        _list.draw(t);
     }
 
     void update(const Theme* t, const DateTime& dt,
@@ -355,10 +288,10 @@ namespace SettingScreen {
                 bool alarm, const SolarData& d) {
         Header::update(t, dt, apState, staState, invState, alarm);
         // Aktualizuj čas z RTC každou sekundu pokud needitujeme
-        if (!_editing) {
+        if (!_list.editing()) {
             _loadFromRTC();
-            _drawItem(t, ITEM_DATE);
-            _drawItem(t, ITEM_TIME);
+            _list.drawRow(t, ITEM_DATE);
+            _list.drawRow(t, ITEM_TIME);
         }
     }
 
@@ -459,50 +392,51 @@ namespace SettingScreen {
     //  Obsluha vstupu
     // ---------------------------------------------------------
     Screen handleInput(const Theme* t, SwButton btn) {
-        bool dtItem   = (_cursor == ITEM_DATE || _cursor == ITEM_TIME);
-        uint8_t maxField = (_cursor == ITEM_DATE) ? 2 : 1;
+        uint8_t cur      = _list.cursor();
+        bool dtItem   = (cur == ITEM_DATE || cur == ITEM_TIME);
+        uint8_t maxField = (cur == ITEM_DATE) ? 2 : 1;
 
-        if (_editing) {
+        if (_list.editing()) {
             // --- Editace datumu / času ---
             if (dtItem) {
                 switch (btn) {
                     case SW_UP:
-                        if (_cursor == ITEM_DATE) _dateUp();
+                        if (cur == ITEM_DATE) _dateUp();
                         else                      _timeUp();
-                        _drawItem(t, _cursor);
+                        _list.drawRow(t, cur);
                         return SCREEN_NONE;
                     case SW_DOWN:
-                        if (_cursor == ITEM_DATE) _dateDown();
+                        if (cur == ITEM_DATE) _dateDown();
                         else                      _timeDown();
-                        _drawItem(t, _cursor);
+                        _list.drawRow(t, cur);
                         return SCREEN_NONE;
                     case SW_RIGHT:
                         if (_dtField < maxField) {
                             _dtField++;
-                            _drawItem(t, _cursor);
+                            _list.drawRow(t, cur);
                         }
                         return SCREEN_NONE;
                     case SW_LEFT:
                         if (_dtField > 0) {
                             _dtField--;
-                            _drawItem(t, _cursor);
+                            _list.drawRow(t, cur);
                         } else {
                             // Zruš editaci
-                            _editing = false;
+                            _list.setEditing(false);
                             _loadFromRTC();
-                            _drawItem(t, _cursor);
+                            _list.drawRow(t, cur);
                         }
                         return SCREEN_NONE;
                     case SW_CENTER:
                         if (_dtField < maxField) {
                             // Přejdi na další pole
                             _dtField++;
-                            _drawItem(t, _cursor);
+                            _list.drawRow(t, cur);
                         } else {
                             // Poslední pole – zapiš do RTC
-                            _editing = false;
-                            _saveToRTC((ItemId)_cursor);
-                            _drawItem(t, _cursor);
+                            _list.setEditing(false);
+                            _saveToRTC((ItemId)cur);
+                            _list.drawRow(t, cur);
                         }
                         return SCREEN_NONE;
                     default:
@@ -513,27 +447,27 @@ namespace SettingScreen {
             // --- Editace ostatních položek ---
             switch (btn) {
                 case SW_UP:
-                    _editUp(_cursor);
-                    _drawItem(t, _cursor);
+                    _editUp(cur);
+                    _list.drawRow(t, cur);
                     return SCREEN_NONE;
                 case SW_DOWN:
-                    _editDown(_cursor);
-                    _drawItem(t, _cursor);
+                    _editDown(cur);
+                    _list.drawRow(t, cur);
                     return SCREEN_NONE;
                 case SW_CENTER:
-                    _editing = false;
-                    _saveItem(_cursor);
+                    _list.setEditing(false);
+                    _saveItem(cur);
                     // Pokud se zapnulo NTP, spusť okamžitý sync
-                    if (_cursor == ITEM_NTP && strcmp(_items[ITEM_NTP].value, "on") == 0) {
+                    if (cur == ITEM_NTP && strcmp(_items[ITEM_NTP].value, "on") == 0) {
                         gNtpResync = true;
                     }
-                    ConfigManager::saveBlockSystem();
-                    _drawItem(t, _cursor);
+                    ConfigManager::saveAsync(BLOCK_SYSTEM_ADDR);
+                    _list.drawRow(t, cur);
                     return SCREEN_NONE;
                 case SW_LEFT:
-                    _editing = false;
+                    _list.setEditing(false);
                     _loadFromConfig();  // zahoď změny – obnov z gConfig
-                    _drawItem(t, _cursor);
+                    _list.drawRow(t, cur);
                     return SCREEN_NONE;
                 default:
                     return SCREEN_NONE;
@@ -543,27 +477,11 @@ namespace SettingScreen {
         // --- Normální navigace ---
         switch (btn) {
             case SW_UP:
-                if (_cursor > 0) {
-                    uint8_t prev = _cursor--;
-                    if (_ensureVisible()) {
-                        _drawAllItems(t);
-                    } else {
-                        _drawItem(t, prev);
-                        _drawItem(t, _cursor);
-                    }
-                }
+                _list.move(t, -1);
                 return SCREEN_NONE;
 
             case SW_DOWN:
-                if (_cursor < ITEM_COUNT - 1) {
-                    uint8_t prev = _cursor++;
-                    if (_ensureVisible()) {
-                        _drawAllItems(t);
-                    } else {
-                        _drawItem(t, prev);
-                        _drawItem(t, _cursor);
-                    }
-                }
+                _list.move(t, +1);
                 return SCREEN_NONE;
 
             case SW_CENTER:
@@ -572,8 +490,8 @@ namespace SettingScreen {
                     _loadFromRTC();
                     _dtField = 0;
                 }
-                _editing = true;
-                _drawItem(t, _cursor);
+                _list.setEditing(true);
+                _list.drawRow(t, cur);
                 return SCREEN_NONE;
 
             case SW_LEFT:
@@ -585,9 +503,7 @@ namespace SettingScreen {
     }
 
     void reset() {
-        _cursor       = 0;
-        _scrollOffset = 0;
-        _editing      = false;
+        _list.reset();
         _dtField      = 0;
     }
 
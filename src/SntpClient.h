@@ -0,0 +1,522 @@
+// =============================================================
+//  SntpClient.h – neblokující SNTP klient (stavový automat)
+//
+//  Problém: NTP.begin() + NTP.waitSet() v loop() blokovaly UI
+//  až do odpovědi serveru – zamrzlý displej, ztracené stisky
+//  a při pomalém serveru riziko 8s watchdogu.
+//
+//  Řešení: vlastní SNTP (RFC 4330) nad WiFiUDP, obsluha v loop():
+//    - až SNTP_MAX_SERVERS serverů (gConfig.ntpServer + záložní),
+//      dotazy se střídají po serverech
+//    - SNTP_SAMPLES platných vzorků, vítězí vzorek s nejmenším
+//      RTT (nejmenší zpoždění = nejmenší asymetrie cesty)
+//    - vzorky s RTT > SNTP_MAX_RTT_MS, stratum 0/16, LI=3 nebo
+//      nesouhlasícím originate timestamp se zahodí
+//    - timeout SNTP_TIMEOUT_MS na dotaz, SNTP_MAX_TRIES na kolo
+//
+//  Před zápisem se změří chyba RTC proti NTP (stav EDGE): čtení
+//  RTC těsně kolem očekávané hrany sekundy, hrana = střed mezi
+//  posledním čtením se starou a prvním s novou sekundou
+//  (nejistota ≤ SNTP_EDGE_MAX_GAP_US). Měří se přímo čip, ne
+//  TimeService – ten jede z časovače RP2350 a k RTC se
+//  dorovnává až při rozdílu celé sekundy. Výsledek dostane
+//  RtcCalibration přes onSync.
+//
+//  Výsledek se zapíše do RTC přesně na hraně sekundy (stav
+//  APPLY čeká, až zlomek sekundy NTP času přejde přes nulu)
+//  a poté TimeService::resync().
+//
+//  DNS: WiFi.hostByName() čeká v loop() až do odpovědi (a to
+//  při každém dotazu). Místo toho se na začátku kola (ST_DNS)
+//  pošlou přes lwIP dns_gethostbyname() dotazy na všechny
+//  servery najednou, odpovědi přijdou callbackem a loop() jen
+//  kontroluje, zda už jsou. Adresy se pak drží po celé kolo;
+//  server bez adresy do SNTP_DNS_TIMEOUT_MS se v kole přeskočí.
+//
+//  Diagnostika: SntpClient::status() – offset a RTT posledního
+//  syncu, server, stratum, počty úspěchů/chyb.
+//
+//  Použití:
+//    SntpClient::begin(gRTC);       // setup()
+//    SntpClient::request();         // spusť kolo (UI / periodicky)
+//    SntpClient::loop();            // loop() – Core 0
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <lwip/dns.h>
+#include <time.h>
+#include "Config.h"
+#include "PCF85063A.h"
+#include "TimeService.h"
+
+#define SNTP_PORT            123
+#define SNTP_LOCAL_PORT      2390
+#define SNTP_PACKET_SIZE     48
+#define SNTP_MAX_SERVERS     3
+#define SNTP_SAMPLES         4        // platných vzorků na kolo
+#define SNTP_MAX_TRIES       8        // odeslaných dotazů na kolo
+#define SNTP_TIMEOUT_MS      1000     // čekání na odpověď
+#define SNTP_GAP_MS          250      // mezera mezi dotazy
+#define SNTP_MAX_RTT_MS      500      // delší RTT = nepoužitelný vzorek
+#define SNTP_DNS_TIMEOUT_MS  2000     // čekání na DNS (neblokující)
+#define SNTP_APPLY_MAX_MS    1500     // čekání na hranu sekundy
+#define SNTP_APPLY_TOL_US    2000     // max. zpoždění zápisu RTC za hranou
+#define SNTP_EDGE_WINDOW_MS  40       // těsné čtení RTC kolem očekávané hrany
+#define SNTP_EDGE_MAX_GAP_US 2000     // větší rozestup čtení = hrana nepřesná
+#define SNTP_EDGE_MAX_MS     3500     // hrana RTC nenalezena → bez měření
+#define SNTP_UNIX_OFFSET     2208988800UL   // 1900-01-01 → 1970-01-01 [s]
+
+extern Config        gConfig;
+extern volatile bool gNtpOk;
+
+// Volá se po úspěšném zápisu RTC: čas zápisu [s od 2000] a chyba
+// RTC před zápisem (RTC – NTP na hraně sekundy RTC) [ms];
+// measured = false pokud se hranu nepodařilo změřit
+typedef void (*SntpSyncCb)(uint32_t localSecs, int32_t rtcErrMs, bool measured);
+
+// Diagnostika posledního kola
+struct SntpStatus {
+    bool     busy;
+    bool     lastOk;
+    uint32_t lastSyncMs;      // millis() posledního úspěšného syncu
+    int32_t  offsetMs;        // NTP – TimeService před zápisem (+ = hodiny se zpožďovaly)
+    int32_t  rtcErrMs;        // RTC – NTP na hraně sekundy RTC (+ = RTC spěchá)
+    bool     rtcMeasured;     // rtcErrMs platné
+    uint16_t rttMs;           // RTT vybraného vzorku
+    uint8_t  stratum;
+    uint8_t  samples;         // platné vzorky v posledním kole
+    uint16_t syncs;           // úspěšná kola od startu
+    uint16_t failures;        // neúspěšná kola od startu
+    char     server[32];      // server vybraného vzorku
+};
+
+namespace SntpClient {
+
+    enum State : uint8_t {
+        ST_IDLE = 0,
+        ST_DNS,         // čekej na adresy serverů (async DNS)
+        ST_SEND,        // pošli dotaz dalšímu serveru (po SNTP_GAP_MS)
+        ST_WAIT,        // čekej na odpověď / timeout
+        ST_EDGE,        // změř RTC – NTP na hraně sekundy RTC
+        ST_APPLY,       // čekej na hranu sekundy a zapiš RTC
+    };
+
+    static PCF85063A* _rtc     = nullptr;
+    static WiFiUDP    _udp;
+    static State      _state   = ST_IDLE;
+    static SntpStatus _status  = {};
+
+    static const char* _servers[SNTP_MAX_SERVERS];
+    static uint8_t     _numServers = 0;
+    static uint8_t     _srv        = 0;     // index serveru dalšího dotazu
+    static uint8_t     _tries      = 0;
+    static uint32_t    _stateMs    = 0;     // millis() vstupu do stavu
+
+    // Adresy serverů kola – plní DNS callback (kontext lwIP)
+    // (každý server má vlastní bajt stavu – callback a loop()
+    // nesdílejí read-modify-write)
+    enum : uint8_t { DNS_WAIT = 0, DNS_OK = 1, DNS_FAIL = 2 };
+    static volatile uint32_t _ip[SNTP_MAX_SERVERS];
+    static volatile uint8_t  _dns[SNTP_MAX_SERVERS];
+    static uint8_t           _round = 0;        // odliší pozdní odpovědi z minulého kola
+
+    // Rozpracovaný dotaz
+    static uint64_t    _t1Us       = 0;     // odeslání (time_us_64)
+    static uint32_t    _cookieSec  = 0;     // transmit timestamp dotazu
+    static uint32_t    _cookieFrac = 0;
+
+    // Nejlepší vzorek kola
+    static bool        _haveBest   = false;
+    static int64_t     _bestUnixUs = 0;     // NTP čas [µs od 1970] v okamžiku _bestT4Us
+    static uint64_t    _bestT4Us   = 0;
+    static uint32_t    _bestRttUs  = 0;
+    static uint8_t     _bestSrv    = 0;
+    static uint8_t     _bestStratum = 0;
+
+    // Měření hrany RTC
+    static uint32_t    _edgeSecs   = 0;     // sekunda RTC posledního čtení
+    static uint64_t    _edgePrevUs = 0;     // okamžik posledního čtení
+    static uint64_t    _edgeNextUs = 0;     // očekávaná hrana (0 = neznámá)
+
+    static SntpSyncCb  _onSync     = nullptr;
+
+    static uint32_t _rd32(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+               ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+    }
+
+    static void _wr32(uint8_t* p, uint32_t v) {
+        p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+    }
+
+    // NTP timestamp (s od 1900 + 2^-32 zlomek) → µs od 1970
+    static int64_t _ntpToUs(const uint8_t* p) {
+        uint32_t sec  = _rd32(p);
+        uint32_t frac = _rd32(p + 4);
+        return (int64_t)(sec - SNTP_UNIX_OFFSET) * 1000000LL +
+               (int64_t)(((uint64_t)frac * 1000000ULL) >> 32);
+    }
+
+    static void _enter(State s) {
+        _state   = s;
+        _stateMs = millis();
+    }
+
+    // Unix čas → lokální sekundy od 2000 (TZ z gConfig.ntpTz)
+    static uint32_t _unixToLocal(time_t t) {
+        struct tm ti;
+        localtime_r(&t, &ti);
+        DateTime dt;
+        dt.year   = ti.tm_year + 1900;
+        dt.month  = ti.tm_mon + 1;
+        dt.day    = ti.tm_mday;
+        dt.hour   = ti.tm_hour;
+        dt.minute = ti.tm_min;
+        dt.second = ti.tm_sec;
+        return dateTimeToSecs(dt);
+    }
+
+    static void _finish(bool ok) {
+        _udp.stop();
+        _status.busy   = false;
+        _status.lastOk = ok;
+        if (ok) {
+            _status.syncs++;
+            _status.lastSyncMs = millis();
+        } else {
+            _status.failures++;
+            LOGF("[NTP] Sync selhal (%u/%u vzorků, %u dotazů)\n",
+                _status.samples, SNTP_SAMPLES, _tries);
+        }
+        _enter(ST_IDLE);
+    }
+
+    // ---------------------------------------------------------
+    //  Async DNS – callback z lwIP, arg = kolo << 8 | server
+    // ---------------------------------------------------------
+    static void _dnsFound(const char*, const ip_addr_t* addr, void* arg) {
+        uint32_t a   = (uint32_t)(uintptr_t)arg;
+        uint8_t  idx = a & 0xFF;
+        if ((uint8_t)(a >> 8) != _round || idx >= SNTP_MAX_SERVERS) return;
+        if (addr) _ip[idx] = ip4_addr_get_u32(ip_2_ip4(addr));
+        _dns[idx] = addr ? DNS_OK : DNS_FAIL;
+    }
+
+    static bool _dnsWaiting() {
+        for (uint8_t i = 0; i < _numServers; i++)
+            if (_dns[i] == DNS_WAIT) return true;
+        return false;
+    }
+
+    // Pošli DNS dotazy na všechny servery kola (cache lwIP odpoví hned)
+    static void _resolve() {
+        _round++;
+        for (uint8_t i = 0; i < _numServers; i++) {
+            _ip[i]  = 0;
+            _dns[i] = DNS_WAIT;
+        }
+        for (uint8_t i = 0; i < _numServers; i++) {
+            ip_addr_t addr;
+            void* arg = (void*)(uintptr_t)(((uint32_t)_round << 8) | i);
+            err_t err = dns_gethostbyname(_servers[i], &addr, _dnsFound, arg);
+            if (err == ERR_OK) {
+                _ip[i]  = ip4_addr_get_u32(ip_2_ip4(&addr));
+                _dns[i] = DNS_OK;
+            } else if (err != ERR_INPROGRESS) {
+                _dns[i] = DNS_FAIL;
+            }
+        }
+    }
+
+    // Další server s adresou (od _srv včetně) – false pokud žádný
+    static bool _nextResolved() {
+        for (uint8_t k = 0; k < _numServers; k++) {
+            if (_dns[_srv] == DNS_OK) return true;
+            _srv = (_srv + 1) % _numServers;
+        }
+        return false;
+    }
+
+    // ---------------------------------------------------------
+    //  Odeslání dotazu
+    // ---------------------------------------------------------
+    static bool _send() {
+        IPAddress ip(_ip[_srv]);
+
+        uint8_t pkt[SNTP_PACKET_SIZE];
+        memset(pkt, 0, sizeof(pkt));
+        pkt[0] = 0x23;                      // LI=0, VN=4, Mode=3 (client)
+
+        // Transmit timestamp = cookie (server vrátí jako originate).
+        // Nemusí být skutečný čas – stačí jedinečnost.
+        _t1Us       = time_us_64();
+        _cookieSec  = (uint32_t)(_t1Us / 1000000ULL) + SNTP_UNIX_OFFSET;
+        _cookieFrac = (uint32_t)_t1Us ^ 0x5A5A5A5AUL;
+        _wr32(&pkt[40], _cookieSec);
+        _wr32(&pkt[44], _cookieFrac);
+
+        while (_udp.parsePacket() > 0) _udp.flush();    // zahoď opožděné odpovědi
+        if (!_udp.beginPacket(ip, SNTP_PORT)) return false;
+        _udp.write(pkt, sizeof(pkt));
+        return _udp.endPacket() != 0;
+    }
+
+    // ---------------------------------------------------------
+    //  Zpracování odpovědi – true pokud byl vzorek platný
+    // ---------------------------------------------------------
+    static bool _receive(uint64_t t4Us) {
+        uint8_t pkt[SNTP_PACKET_SIZE];
+        if (_udp.read(pkt, sizeof(pkt)) < SNTP_PACKET_SIZE) return false;
+
+        uint8_t li      = pkt[0] >> 6;
+        uint8_t mode    = pkt[0] & 0x07;
+        uint8_t stratum = pkt[1];
+        if (mode != 4 || li == 3 || stratum == 0 || stratum >= 16) return false;
+        if (_rd32(&pkt[24]) != _cookieSec || _rd32(&pkt[28]) != _cookieFrac) return false;
+
+        int64_t t2 = _ntpToUs(&pkt[32]);    // server přijal
+        int64_t t3 = _ntpToUs(&pkt[40]);    // server odeslal
+        int64_t rtt = (int64_t)(t4Us - _t1Us) - (t3 - t2);
+        if (rtt < 0) rtt = 0;
+        if (rtt > (int64_t)SNTP_MAX_RTT_MS * 1000) return false;
+
+        _status.samples++;
+        if (!_haveBest || (uint32_t)rtt < _bestRttUs) {
+            _haveBest    = true;
+            _bestRttUs   = (uint32_t)rtt;
+            _bestUnixUs  = t3 + rtt / 2;    // čas serveru v okamžiku t4
+            _bestT4Us    = t4Us;
+            _bestSrv     = _srv;
+            _bestStratum = stratum;
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Chyba RTC proti NTP na hraně sekundy RTC
+    // ---------------------------------------------------------
+
+    // NTP čas [µs od 2000, lokální] v okamžiku time_us_64() = us
+    static int64_t _ntpLocalUs(uint64_t us) {
+        int64_t unixUs = _bestUnixUs + (int64_t)(us - _bestT4Us);
+        return (int64_t)_unixToLocal((time_t)(unixUs / 1000000LL)) * 1000000LL
+             + unixUs % 1000000LL;
+    }
+
+    // Čtení RTC – okamžik = střed I2C transakce
+    static uint32_t _readRtc(uint64_t& atUs) {
+        uint64_t a = time_us_64();
+        uint32_t secs = dateTimeToSecs(_rtc->getTime());
+        atUs = (a + time_us_64()) / 2;
+        return secs;
+    }
+
+    static void _startEdge() {
+        _edgeSecs = _readRtc(_edgePrevUs);
+        // Odhad hrany z TimeService (kotva zarovnaná na hranu RTC)
+        uint32_t frac = (uint32_t)(TimeService::nowUs() % 1000000ULL);
+        _edgeNextUs = time_us_64() + (1000000UL - frac);
+        _status.rtcMeasured = false;
+        _enter(ST_EDGE);
+    }
+
+    static void _edge() {
+        const uint64_t half = SNTP_EDGE_WINDOW_MS * 500ULL;
+        // Daleko od očekávané hrany – loop() běží dál
+        if (_edgeNextUs && time_us_64() + half < _edgeNextUs) return;
+
+        // V okně těsné čtení (blokuje ≤ SNTP_EDGE_WINDOW_MS),
+        // bez odhadu jedno čtení na průchod loop()
+        do {
+            uint64_t at;
+            uint32_t secs = _readRtc(at);
+            if (secs != _edgeSecs) {
+                uint64_t gap  = at - _edgePrevUs;
+                uint64_t edge = _edgePrevUs + gap / 2;
+                if (secs == _edgeSecs + 1 && gap <= SNTP_EDGE_MAX_GAP_US) {
+                    int64_t err = (int64_t)secs * 1000000LL - _ntpLocalUs(edge);
+                    _status.rtcErrMs    = (int32_t)(err / 1000);
+                    _status.rtcMeasured = true;
+                    _enter(ST_APPLY);
+                    return;
+                }
+                // Hrubá hrana – další přijde o sekundu později
+                _edgeSecs   = secs;
+                _edgePrevUs = at;
+                _edgeNextUs = edge + 1000000ULL;
+                return;
+            }
+            _edgePrevUs = at;
+        } while (_edgeNextUs && time_us_64() < _edgeNextUs + half);
+
+        _edgeNextUs = 0;            // odhad nesedí – čti každý průchod
+        if (millis() - _stateMs > SNTP_EDGE_MAX_MS) {
+            LOGLN("[NTP] Hrana RTC nenalezena – bez měření chyby RTC");
+            _enter(ST_APPLY);
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Zápis do RTC na hraně sekundy
+    // ---------------------------------------------------------
+    static void _apply() {
+        uint64_t nowUs  = time_us_64();
+        int64_t  unixUs = _bestUnixUs + (int64_t)(nowUs - _bestT4Us);
+        uint32_t frac   = (uint32_t)(unixUs % 1000000LL);
+
+        // Hrana NTP sekundy do půl okna → dočkej ji přesně, ať RTC
+        // nezačne interval kalibrace se zpožděním jednoho průchodu loop()
+        if (frac >= 1000000UL - SNTP_EDGE_WINDOW_MS * 500UL) {
+            uint32_t prev = frac;
+            do {
+                prev   = frac;
+                nowUs  = time_us_64();
+                unixUs = _bestUnixUs + (int64_t)(nowUs - _bestT4Us);
+                frac   = (uint32_t)(unixUs % 1000000LL);
+            } while (frac >= prev);
+        }
+        if (frac > SNTP_APPLY_TOL_US && millis() - _stateMs < SNTP_APPLY_MAX_MS) return;
+
+        time_t   unixS   = (time_t)(unixUs / 1000000LL);
+        uint32_t localS  = _unixToLocal(unixS);
+        int64_t  ntpUs   = (int64_t)localS * 1000000LL + frac;
+        int64_t  offUs   = ntpUs - (int64_t)TimeService::nowUs();
+
+        DateTime dt = secsToDateTime(localS);
+        if (!_rtc || !_rtc->setTime(dt)) {
+            LOGLN("[NTP] Zápis RTC selhal");
+            _finish(false);
+            return;
+        }
+        TimeService::resync();
+        gNtpOk = true;
+
+        _status.offsetMs = (int32_t)(offUs / 1000);
+        _status.rttMs    = (uint16_t)(_bestRttUs / 1000);
+        _status.stratum  = _bestStratum;
+        strncpy(_status.server, _servers[_bestSrv], sizeof(_status.server) - 1);
+        _status.server[sizeof(_status.server) - 1] = '\0';
+        LOGF("[NTP] %02u:%02u:%02u  offset %ld ms  RTC %+ld ms%s  RTT %u ms  %s (stratum %u, %u vzorků)\n",
+            dt.hour, dt.minute, dt.second, (long)_status.offsetMs,
+            (long)_status.rtcErrMs, _status.rtcMeasured ? "" : " (neměřeno)",
+            _status.rttMs, _status.server, _status.stratum, _status.samples);
+        _finish(true);
+        if (_onSync) _onSync(localS, _status.rtcErrMs, _status.rtcMeasured);
+    }
+
+    // ---------------------------------------------------------
+    //  Inicializace
+    // ---------------------------------------------------------
+    void begin(PCF85063A& rtc) {
+        _rtc = &rtc;
+    }
+
+    // ---------------------------------------------------------
+    //  Spusť kolo synchronizace (běžící kolo se nepřeruší)
+    // ---------------------------------------------------------
+    bool request() {
+        if (_state != ST_IDLE) return false;
+
+        // Seznam serverů – konfigurovaný + záložní bez duplicit
+        static const char* fallback[] = { "pool.ntp.org", "time.cloudflare.com" };
+        _numServers = 0;
+        if (gConfig.ntpServer[0]) _servers[_numServers++] = gConfig.ntpServer;
+        for (uint8_t i = 0; i < 2 && _numServers < SNTP_MAX_SERVERS; i++) {
+            if (strcmp(fallback[i], gConfig.ntpServer) != 0)
+                _servers[_numServers++] = fallback[i];
+        }
+
+        if (!_udp.begin(SNTP_LOCAL_PORT)) {
+            LOGLN("[NTP] UDP socket selhal");
+            _status.failures++;
+            return false;
+        }
+        _srv            = 0;
+        _tries          = 0;
+        _haveBest       = false;
+        _status.samples = 0;
+        _status.busy    = true;
+        _resolve();
+        _enter(ST_DNS);
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Obsluha – volej z loop() (Core 0), nikdy neblokuje
+    // ---------------------------------------------------------
+    void loop() {
+        if (_state == ST_IDLE) return;
+        if (WiFi.status() != WL_CONNECTED) {
+            _finish(false);
+            return;
+        }
+        uint32_t ms = millis();
+
+        switch (_state) {
+            case ST_DNS:
+                if (_dnsWaiting() && ms - _stateMs < SNTP_DNS_TIMEOUT_MS) return;
+                for (uint8_t i = 0; i < _numServers; i++)
+                    if (_dns[i] != DNS_OK) LOGF("[NTP] DNS %s selhal\n", _servers[i]);
+                if (!_nextResolved()) {
+                    _finish(false);
+                    return;
+                }
+                _state   = ST_SEND;
+                _stateMs = ms - SNTP_GAP_MS;        // první dotaz hned
+                break;
+
+            case ST_SEND:
+                if (ms - _stateMs < SNTP_GAP_MS) return;
+                if (_status.samples >= SNTP_SAMPLES || _tries >= SNTP_MAX_TRIES) {
+                    if (_haveBest) _startEdge();
+                    else           _finish(false);
+                    return;
+                }
+                _tries++;
+                if (_send()) {
+                    _enter(ST_WAIT);
+                } else {
+                    _srv = (_srv + 1) % _numServers;
+                    _nextResolved();
+                    _enter(ST_SEND);
+                }
+                break;
+
+            case ST_WAIT: {
+                // Neplatná / opožděná odpověď → čekej dál do timeoutu
+                if (_udp.parsePacket() >= SNTP_PACKET_SIZE && _receive(time_us_64())) {
+                    _srv = (_srv + 1) % _numServers;
+                    _nextResolved();
+                    _enter(ST_SEND);
+                } else if (ms - _stateMs > SNTP_TIMEOUT_MS) {
+                    LOGF("[NTP] %s timeout\n", _servers[_srv]);
+                    _srv = (_srv + 1) % _numServers;
+                    _nextResolved();
+                    _enter(ST_SEND);
+                }
+                break;
+            }
+
+            case ST_EDGE:
+                _edge();
+                break;
+
+            case ST_APPLY:
+                _apply();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // Odběratel úspěšných syncú (kalibrace RTC)
+    void onSync(SntpSyncCb cb) { _onSync = cb; }
+
+    bool              busy()   { return _state != ST_IDLE; }
+    const SntpStatus& status() { return _status; }
+
+} // namespace SntpClient
@@ -8,12 +8,17 @@
 //
 //  Rozšíření: přidej pole do SolarData a aktualizuj
 //  SolarModel::update() v InverterDriver.h
+//
+//  Změna dat zvýší version() a zavolá onChange() callback
+//  (UI se probudí jen když je co překreslit). lastUpdateMs
+//  se za změnu nepovažuje – mění se každým pollem.
 // =============================================================
 #pragma once
 #include <Arduino.h>
 #include <FreeRTOS.h>
 #include <semphr.h>
 #include "InverterTypes.h"   // InverterData – vyplněna z Modbus tasku
+#include "HW_Config.h"       // BOILER_MAX_COUNT
 
 // =============================================================
 //  Sdílená data – plní Core 1 (Modbus), čte Core 0
@@ -46,12 +51,20 @@ struct SolarData {
     // relayOn:      relé fyzicky sepnuto řídicí logikou
     // relayHeating: teče proud = zásobník se ohřívá
     //               (odvozeno z měření změny toku fází po sepnutí)
-    bool     relayOn[10];
-    bool     relayHeating[10];
+    bool     relayOn[BOILER_MAX_COUNT];
+    bool     relayHeating[BOILER_MAX_COUNT];
+    bool     relayFault;        // zpětné čtení MCP23017 nesouhlasí (alarm)
+    uint16_t relayErrors;       // počet nesouhlasů od startu
+
+    // --- Odhad příkonu z provozu (BoilerController::_trackEdges) ---
+    // powerEstW = 0 → zatím málo vzorků
+    uint16_t powerEstW[BOILER_MAX_COUNT];
+    uint8_t  powerEstPhase[BOILER_MAX_COUNT];
+    bool     powerDrift[BOILER_MAX_COUNT];   // nesedí s Discovery
 
     // --- Elektroměry bytů [Wh] ---
     // Čítáno z pulzních vstupů IRQ (PulseCounter)
-    uint32_t apartmentWh[10];
+    uint32_t apartmentWh[BOILER_MAX_COUNT];
 
     // --- Stav měniče ---
     uint16_t invStatus;         // 0=čekám, 2=on-grid, 3=fault, 5=off-grid
@@ -59,10 +72,21 @@ struct SolarData {
 
     // --- Meta ---
     bool     valid;             // data platná (aspoň jednou přečtena)
+    bool     stale;             // hodnoty z warm-start snapshotu, ne živé
     uint32_t lastUpdateMs;      // millis() posledního úspěšného čtení
     uint8_t  errorCount;        // počet Modbus chyb za sebou
 };
 
+// Odběr spotřebiče ze změny přetoku fáze [W]
+// Fáze je kladná při dodávce → sepnutý spotřebič ji sníží, odběr
+// = fáze před − fáze po (kladný). Jediné místo znaménka pro detekci
+// plného zásobníku, recheck, hrany relé i Discovery.
+inline int32_t phaseDrawW(int32_t beforeW, int32_t afterW) { return beforeW - afterW; }
+inline float   phaseDrawW(float beforeW, float afterW)     { return beforeW - afterW; }
+
+// Callback změny dat – volá se z tasku zapisovatele, mimo mutex
+typedef void (*SolarChangeCb)(const SolarData& d);
+
 // =============================================================
 //  SolarModel – thread-safe přístup k SolarData
 // =============================================================
@@ -70,6 +94,41 @@ namespace SolarModel {
 
     static SolarData      _data   = {};
     static SemaphoreHandle_t _mutex = nullptr;
+    static volatile uint32_t _version  = 0;
+    static SolarChangeCb     _onChange = nullptr;
+
+    // Liší se zobrazitelná data? (lastUpdateMs ne)
+    static bool _differs(const SolarData& a, const SolarData& b) {
+        return a.powerPV != b.powerPV || a.powerLoad != b.powerLoad ||
+               a.powerBattery != b.powerBattery || a.powerGrid != b.powerGrid ||
+               a.phaseL1 != b.phaseL1 || a.phaseL2 != b.phaseL2 || a.phaseL3 != b.phaseL3 ||
+               a.soc != b.soc || a.soh != b.soh ||
+               a.energyPvToday != b.energyPvToday ||
+               a.energyGridToday != b.energyGridToday ||
+               a.energySoldToday != b.energySoldToday ||
+               memcmp(a.relayOn, b.relayOn, sizeof(a.relayOn)) != 0 ||
+               memcmp(a.relayHeating, b.relayHeating, sizeof(a.relayHeating)) != 0 ||
+               a.relayFault != b.relayFault || a.relayErrors != b.relayErrors ||
+               memcmp(a.powerEstW, b.powerEstW, sizeof(a.powerEstW)) != 0 ||
+               memcmp(a.powerDrift, b.powerDrift, sizeof(a.powerDrift)) != 0 ||
+               memcmp(a.apartmentWh, b.apartmentWh, sizeof(a.apartmentWh)) != 0 ||
+               a.invStatus != b.invStatus || a.invOnline != b.invOnline ||
+               a.valid != b.valid || a.stale != b.stale ||
+               a.errorCount != b.errorCount;
+    }
+
+    // Po zápisu (už bez mutexu) – snap = kopie nového stavu
+    static void _notify(bool changed, const SolarData& snap) {
+        if (!changed) return;
+        _version = _version + 1;
+        if (_onChange) _onChange(snap);
+    }
+
+    // Registrace odběratele změn (jeden – UI), volej v setup()
+    void onChange(SolarChangeCb cb) { _onChange = cb; }
+
+    // Čítač změn – levné porovnání "změnilo se něco od minula"
+    uint32_t version() { return _version; }
 
     // Inicializace – volej jednou v setup() před startem tasků
     void begin() {
@@ -95,6 +154,19 @@ namespace SolarModel {
     void updateFromInverter(const InverterData& inv) {
         if (!_mutex) return;
         if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            SolarData before = _data;
+            // Do prvního úspěšného čtení drž hodnoty ze snapshotu
+            if (!inv.valid && _data.stale) {
+                _data.invOnline    = false;
+                _data.lastUpdateMs = inv.lastUpdateMs;
+                _data.errorCount   = inv.errorCount;
+                bool      changed = _differs(before, _data);
+                SolarData snap    = _data;
+                xSemaphoreGive(_mutex);
+                _notify(changed, snap);
+                return;
+            }
+            _data.stale            = false;
             _data.powerPV          = inv.powerPV;
             _data.powerLoad        = inv.powerLoad;
             _data.powerBattery     = inv.powerBattery;
@@ -115,26 +187,74 @@ namespace SolarModel {
             _data.phaseL2 = inv.phaseL2;
             _data.phaseL3 = inv.phaseL3;
 
+            bool      changed = _differs(before, _data);
+            SolarData snap    = _data;
+            xSemaphoreGive(_mutex);
+            _notify(changed, snap);
+        }
+    }
+
+    // Warm-start – poslední známé hodnoty ze snapshotu (WarmStart.h)
+    // valid zůstává false → řízení na ně nereaguje, UI je kreslí šedě
+    void restore(const SolarData& d) {
+        if (!_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            _data           = d;
+            _data.valid     = false;
+            _data.invOnline = false;
+            _data.stale     = true;
+            SolarData snap  = _data;
             xSemaphoreGive(_mutex);
+            _notify(true, snap);
         }
     }
 
     // Aktualizuje stav relé a odvozený stav ohřevu (volá řídicí logika)
-    void updateRelays(const bool on[10], const bool heating[10]) {
+    // fault/errors – výsledek ověření zápisu do MCP23017
+    void updateRelays(const bool on[BOILER_MAX_COUNT], const bool heating[BOILER_MAX_COUNT],
+                      bool fault = false, uint16_t errors = 0) {
+        if (!_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            bool changed = memcmp(_data.relayOn, on, BOILER_MAX_COUNT * sizeof(bool)) != 0 ||
+                           memcmp(_data.relayHeating, heating, BOILER_MAX_COUNT * sizeof(bool)) != 0 ||
+                           _data.relayFault != fault || _data.relayErrors != errors;
+            memcpy(_data.relayOn,      on,      BOILER_MAX_COUNT * sizeof(bool));
+            memcpy(_data.relayHeating, heating, BOILER_MAX_COUNT * sizeof(bool));
+            _data.relayFault  = fault;
+            _data.relayErrors = errors;
+            SolarData snap = _data;
+            xSemaphoreGive(_mutex);
+            _notify(changed, snap);
+        }
+    }
+
+    // Aktualizuje odhad příkonu zásobníků (volá řídicí logika po vzorku)
+    void updatePowerEst(const uint16_t estW[BOILER_MAX_COUNT],
+                        const uint8_t  phase[BOILER_MAX_COUNT],
+                        const bool     drift[BOILER_MAX_COUNT]) {
         if (!_mutex) return;
         if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            memcpy(_data.relayOn,      on,      10 * sizeof(bool));
-            memcpy(_data.relayHeating, heating, 10 * sizeof(bool));
+            bool changed = memcmp(_data.powerEstW, estW, sizeof(_data.powerEstW)) != 0 ||
+                           memcmp(_data.powerEstPhase, phase, sizeof(_data.powerEstPhase)) != 0 ||
+                           memcmp(_data.powerDrift, drift, sizeof(_data.powerDrift)) != 0;
+            memcpy(_data.powerEstW,     estW,  sizeof(_data.powerEstW));
+            memcpy(_data.powerEstPhase, phase, sizeof(_data.powerEstPhase));
+            memcpy(_data.powerDrift,    drift, sizeof(_data.powerDrift));
+            SolarData snap = _data;
             xSemaphoreGive(_mutex);
+            _notify(changed, snap);
         }
     }
 
     // Aktualizuje odběr bytů z PulseCounter (volá Core 0 v loop)
-    void updateApartments(const uint32_t wh[10]) {
+    void updateApartments(const uint32_t wh[BOILER_MAX_COUNT]) {
         if (!_mutex) return;
         if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-            memcpy(_data.apartmentWh, wh, 10 * sizeof(uint32_t));
+            bool changed = memcmp(_data.apartmentWh, wh, BOILER_MAX_COUNT * sizeof(uint32_t)) != 0;
+            memcpy(_data.apartmentWh, wh, BOILER_MAX_COUNT * sizeof(uint32_t));
+            SolarData snap = _data;
             xSemaphoreGive(_mutex);
+            _notify(changed, snap);
         }
     }
 
@@ -142,10 +262,13 @@ namespace SolarModel {
     void updatePhases(int32_t l1, int32_t l2, int32_t l3) {
         if (!_mutex) return;
         if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            bool changed = _data.phaseL1 != l1 || _data.phaseL2 != l2 || _data.phaseL3 != l3;
             _data.phaseL1 = l1;
             _data.phaseL2 = l2;
             _data.phaseL3 = l3;
+            SolarData snap = _data;
             xSemaphoreGive(_mutex);
+            _notify(changed, snap);
         }
     }
 
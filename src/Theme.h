@@ -42,6 +42,37 @@ const Theme THEME_DARK = {
 // --- Téma: Industrial (plánováno) ---
 // const Theme THEME_INDUSTRIAL = { ... };
 
+// --- Indexy palety pro 4bit sprity (Render.h) ---
+// Paletový sprite bere barvu jako index do palety, ne RGB565.
+// Do takového spritu se kreslí přes THEME_INK (Render::ink()),
+// skutečné barvy dodá paleta sestavená z aktivního tématu.
+const Theme THEME_INK = {
+    .bg     = 0,
+    .header = 1,
+    .text   = 2,
+    .dim    = 3,
+    .ok     = 4,
+    .warn   = 5,
+    .err    = 6,
+    .accent = 7,
+    .splitline = 8
+};
+#define THEME_PALETTE_SIZE 16   // 4 bity na pixel
+
+// Paleta RGB565 tématu – pořadí odpovídá THEME_INK, zbytek = bg
+inline void themePalette(const Theme* t, uint16_t pal[THEME_PALETTE_SIZE]) {
+    pal[0] = t->bg;
+    pal[1] = t->header;
+    pal[2] = t->text;
+    pal[3] = t->dim;
+    pal[4] = t->ok;
+    pal[5] = t->warn;
+    pal[6] = t->err;
+    pal[7] = t->accent;
+    pal[8] = t->splitline;
+    for (uint8_t i = 9; i < THEME_PALETTE_SIZE; i++) pal[i] = t->bg;
+}
+
 // Počet dostupných témat
 #define THEME_COUNT 1
 const Theme* const THEMES[THEME_COUNT] = {
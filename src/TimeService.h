@@ -0,0 +1,218 @@
+// =============================================================
+//  TimeService.h – levný čas z monotónního čítače
+//
+//  Problém: BoilerController::tick() (Core 1, každé 2s),
+//  _refreshState() (UI, každou 1s) i heartbeat četly čas
+//  přímo z PCF85063A → I2C transakce, která soupeří o Wire
+//  s FRAM a MCP23017 (Wire nemá mutex).
+//
+//  Řešení: RTC se čte jen při startu, po setTime() (NTP / UI)
+//  a jednou za TIME_CHECK_MS kontrolně. Mezi tím se čas odvozuje
+//  z 64bit čítače time_us_64() (hardware timer, bez přetečení):
+//
+//      now = _baseSecs + (time_us_64() - _baseUs) / 1e6
+//
+//  Kotva (_baseSecs, _baseUs) se zarovná na hranu sekundy RTC:
+//  po resync() loop() čte RTC po TIME_ALIGN_POLL_MS, dokud se
+//  sekunda nezmění → fázová chyba < 1 poll. Při kontrole se
+//  čte jen jednou; nesouhlasí-li sekunda, zarovná se znovu.
+//
+//  Čtení je lock-free pro oba jádra (seqlock) – zapisuje jen
+//  Core 0 (loop), čtenář při souběhu zopakuje čtení kotvy.
+//
+//  Časy jsou jako všude v projektu lokální sekundy od 2000
+//  (RTC drží lokální čas, viz dateTimeToSecs()).
+//
+//  Události (minuta / hodina / půlnoc) volá loop() na Core 0
+//  pro registrované odběratele – při skoku času se přeskočí.
+//
+//  Použití:
+//    TimeService::begin(gRTC);          // setup() po gRTC.begin()
+//    TimeService::resync();             // po každém gRTC.setTime()
+//    TimeService::loop();               // loop() – Core 0
+//    uint32_t t  = TimeService::now();  // libovolné jádro
+//    DateTime dt = TimeService::local();
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include "PCF85063A.h"
+
+#define TIME_CHECK_MS        60000   // kontrolní čtení RTC
+#define TIME_ALIGN_POLL_MS   20      // perioda čtení při hledání hrany sekundy
+#define TIME_ALIGN_MAX_MS    1500    // hrana nepřišla → RTC stojí, ber jak je
+#define TIME_MAX_SUBS        4
+
+// Bitová maska událostí pro odběratele
+#define TIME_EV_MINUTE       0x01
+#define TIME_EV_HOUR         0x02
+#define TIME_EV_MIDNIGHT     0x04
+
+typedef void (*TimeEventCb)(uint8_t events, uint32_t nowSecs);
+
+namespace TimeService {
+
+    static PCF85063A*        _rtc      = nullptr;
+    static volatile uint32_t _seq      = 0;        // liché = zápis kotvy probíhá
+    static volatile uint32_t _baseSecs = 0;        // sekundy od 2000 v okamžiku _baseUs
+    static volatile uint64_t _baseUs   = 0;
+    static volatile bool     _valid    = false;    // RTC mělo platný čas
+
+    static bool     _aligning   = false;
+    static uint32_t _alignStart = 0;
+    static uint32_t _alignPoll  = 0;
+    static uint32_t _alignSecs  = 0;
+    static uint32_t _lastCheck  = 0;
+    static uint32_t _lastMinute = 0;               // now()/60 poslední události
+
+    static TimeEventCb _subs[TIME_MAX_SUBS] = {};
+    static uint8_t     _numSubs = 0;
+
+    // ---------------------------------------------------------
+    //  Zápis kotvy – jen Core 0
+    // ---------------------------------------------------------
+    static void _setBase(uint32_t secs, uint64_t us) {
+        _seq = _seq + 1;
+        __sync_synchronize();
+        _baseSecs = secs;
+        _baseUs   = us;
+        __sync_synchronize();
+        _seq = _seq + 1;
+    }
+
+    static uint32_t _readRtc() {
+        return dateTimeToSecs(_rtc->getTime());
+    }
+
+    static void _startAlign() {
+        _aligning   = true;
+        _alignStart = millis();
+        _alignPoll  = _alignStart;
+        _alignSecs  = _readRtc();
+        // Hrubá kotva hned – přesnost ±1s do nalezení hrany
+        _setBase(_alignSecs, time_us_64());
+    }
+
+    // Konzistentní kopie kotvy – čtenář opakuje, pokud zápis probíhal
+    static void _anchor(uint32_t& secs, uint64_t& us) {
+        uint32_t s1;
+        do {
+            s1 = _seq;
+            __sync_synchronize();
+            secs = _baseSecs;
+            us   = _baseUs;
+            __sync_synchronize();
+        } while ((s1 & 1) || s1 != _seq);
+    }
+
+    // ---------------------------------------------------------
+    //  Aktuální čas [s od 2000] – lock-free, libovolné jádro
+    // ---------------------------------------------------------
+    uint32_t now() {
+        uint32_t secs;
+        uint64_t us;
+        _anchor(secs, us);
+        return secs + (uint32_t)((time_us_64() - us) / 1000000ULL);
+    }
+
+    // Totéž v µs – pro měření offsetu proti NTP
+    uint64_t nowUs() {
+        uint32_t secs;
+        uint64_t us;
+        _anchor(secs, us);
+        return (uint64_t)secs * 1000000ULL + (time_us_64() - us);
+    }
+
+    DateTime local()  { return secsToDateTime(now()); }
+    bool     valid()  { return _valid; }
+
+    // Den v týdnu: 0=Ne, 1=Po … 6=So (2000-01-01 byla sobota)
+    uint8_t dayOfWeek(uint32_t secs) { return (uint8_t)((secs / 86400UL + 6) % 7); }
+    uint8_t dayOfWeek()              { return dayOfWeek(now()); }
+
+    // ---------------------------------------------------------
+    //  Inicializace – volej po gRTC.begin()
+    // ---------------------------------------------------------
+    void begin(PCF85063A& rtc) {
+        _rtc   = &rtc;
+        _valid = rtc.isValid();
+        _startAlign();
+        _lastCheck  = millis();
+        _lastMinute = _alignSecs / 60;
+    }
+
+    // ---------------------------------------------------------
+    //  Znovu načti RTC – volej po každém setTime() (NTP, UI)
+    // ---------------------------------------------------------
+    void resync() {
+        if (!_rtc) return;
+        _valid = _rtc->isValid();
+        _startAlign();
+        _lastCheck  = millis();
+        _lastMinute = _alignSecs / 60;     // skok času → bez dávky událostí
+    }
+
+    // ---------------------------------------------------------
+    //  Registrace odběratele událostí (volá se z Core 0)
+    // ---------------------------------------------------------
+    bool subscribe(TimeEventCb cb) {
+        if (_numSubs >= TIME_MAX_SUBS) return false;
+        _subs[_numSubs++] = cb;
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Periodická obsluha – volej z loop() (Core 0)
+    // ---------------------------------------------------------
+    void loop() {
+        if (!_rtc) return;
+        uint32_t ms = millis();
+
+        // Hledání hrany sekundy RTC
+        if (_aligning) {
+            if (ms - _alignPoll < TIME_ALIGN_POLL_MS) return;
+            _alignPoll = ms;
+            uint32_t s = _readRtc();
+            if (s != _alignSecs) {
+                _setBase(s, time_us_64());
+                _aligning = false;
+            } else if (ms - _alignStart > TIME_ALIGN_MAX_MS) {
+                LOGLN("[TIME] RTC sekunda se nemění – zarovnání vzdáno");
+                _aligning = false;
+            }
+            return;
+        }
+
+        // Kontrola proti RTC – jedno čtení, při rozdílu zarovnej
+        if (ms - _lastCheck >= TIME_CHECK_MS) {
+            _lastCheck = ms;
+            uint32_t rtcSecs = _readRtc();
+            uint32_t mySecs  = now();
+            if (rtcSecs != mySecs) {
+                int32_t diff = (int32_t)(mySecs - rtcSecs);
+                LOGF("[TIME] Odchylka %ld s proti RTC – zarovnávám\n", (long)diff);
+                bool jump = diff > 2 || diff < -2;
+                _startAlign();
+                if (jump) _lastMinute = _alignSecs / 60;
+                return;
+            }
+        }
+
+        // Události minuta / hodina / půlnoc
+        uint32_t t   = now();
+        uint32_t min = t / 60;
+        if ((int32_t)(min - _lastMinute) <= 0) return;     // stejná minuta / krok zpět
+        uint8_t ev = TIME_EV_MINUTE;
+        if (min % 60 == 0)   ev |= TIME_EV_HOUR;
+        if (min % 1440 == 0) ev |= TIME_EV_MIDNIGHT;
+        // Více minut najednou (blokující loop) = jedna událost,
+        // hodina/půlnoc se ale nesmí ztratit
+        if (min - _lastMinute > 1) {
+            if (min / 60   != _lastMinute / 60)   ev |= TIME_EV_HOUR;
+            if (min / 1440 != _lastMinute / 1440) ev |= TIME_EV_MIDNIGHT;
+        }
+        _lastMinute = min;
+        for (uint8_t i = 0; i < _numSubs; i++) _subs[i](ev, t);
+    }
+
+} // namespace TimeService
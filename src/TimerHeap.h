@@ -0,0 +1,118 @@
+// =============================================================
+//  TimerHeap.h – termíny událostí na 64bit monotónním čase
+//
+//  BoilerController dřív každý tick procházel všechny zásobníky
+//  a porovnával millis() s termíny (recheck, minOffTime, cooldown
+//  slotu, minOnTime). Zásobník, který jen čeká na termín, se teď
+//  "zaparkuje" v haldě a tick ho přeskočí, dokud termín nevyprší.
+//
+//  Čas: monoMs() = time_us_64() / 1000 – 64bit, nepřeteče.
+//  Dolních 32 bitů odpovídá millis() (arduino-pico odvozuje oba
+//  ze stejného čítače) → uložené millis() časy a monoMs() jdou
+//  kombinovat přes rozdíly.
+//
+//  Min-halda podle termínu, klíč = id 0 … N−1 (zásobník), každé
+//  id nejvýš jeden termín. _pos[] drží pozici v haldě →
+//  přeplánování i zrušení O(log N) bez hledání.
+//
+//  Použití:
+//    TimerHeap<BOILER_MAX_COUNT> t;
+//    t.schedule(i, monoMs() + 60000);     // nový / přeplánovaný
+//    t.cancel(i);
+//    uint8_t id;
+//    while (t.popDue(monoMs(), id)) { … }  // prošlé v pořadí termínů
+// =============================================================
+#pragma once
+#include <Arduino.h>
+
+// 64bit monotónní čas [ms] od startu
+inline uint64_t monoMs() { return time_us_64() / 1000ULL; }
+
+template <uint8_t N>
+class TimerHeap {
+public:
+    static const uint8_t NONE = 0xFF;
+
+    TimerHeap() : _size(0) {
+        memset(_pos, NONE, sizeof(_pos));
+    }
+
+    uint8_t  size()             const { return _size; }
+    bool     pending(uint8_t id) const { return id < N && _pos[id] != NONE; }
+    uint64_t at(uint8_t id)      const { return pending(id) ? _at[id] : 0; }
+
+    // Nejbližší termín (0 = prázdná halda)
+    uint64_t next() const { return _size ? _at[_heap[0]] : 0; }
+
+    // Nastav termín id – existující se přeplánuje
+    void schedule(uint8_t id, uint64_t atMs) {
+        if (id >= N) return;
+        _at[id] = atMs;
+        if (_pos[id] == NONE) {
+            _heap[_size] = id;
+            _pos[id]     = _size;
+            _size++;
+            _up(_pos[id]);
+        } else {
+            _up(_pos[id]);
+            _down(_pos[id]);
+        }
+    }
+
+    void cancel(uint8_t id) {
+        if (!pending(id)) return;
+        uint8_t p = _pos[id];
+        _size--;
+        _pos[id] = NONE;
+        if (p == _size) return;
+        _heap[p] = _heap[_size];
+        _pos[_heap[p]] = p;
+        _up(p);
+        _down(_pos[_heap[p]]);
+    }
+
+    // Vyjmi nejdřívější prošlý termín (atMs ≤ nowMs)
+    bool popDue(uint64_t nowMs, uint8_t& id) {
+        if (!_size || _at[_heap[0]] > nowMs) return false;
+        id = _heap[0];
+        cancel(id);
+        return true;
+    }
+
+    void clear() {
+        _size = 0;
+        memset(_pos, NONE, sizeof(_pos));
+    }
+
+private:
+    uint64_t _at[N];              // termín podle id
+    uint8_t  _heap[N];            // id seřazená jako min-halda
+    uint8_t  _pos[N];             // pozice id v haldě (NONE = neplánováno)
+    uint8_t  _size;
+
+    void _swap(uint8_t a, uint8_t b) {
+        uint8_t t = _heap[a]; _heap[a] = _heap[b]; _heap[b] = t;
+        _pos[_heap[a]] = a;
+        _pos[_heap[b]] = b;
+    }
+
+    void _up(uint8_t p) {
+        while (p) {
+            uint8_t parent = (p - 1) / 2;
+            if (_at[_heap[parent]] <= _at[_heap[p]]) break;
+            _swap(p, parent);
+            p = parent;
+        }
+    }
+
+    void _down(uint8_t p) {
+        for (;;) {
+            uint8_t l = 2 * p + 1, r = l + 1, m = p;
+            if (l < _size && _at[_heap[l]] < _at[_heap[m]]) m = l;
+            if (r < _size && _at[_heap[r]] < _at[_heap[m]]) m = r;
+            if (m == p) break;
+            _swap(p, m);
+            p = m;
+        }
+    }
+};
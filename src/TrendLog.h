@@ -0,0 +1,184 @@
+// =============================================================
+//  TrendLog.h – krátkodobý trend výkonů v RAM (TrendScreen)
+//
+//  PowerLog (FRAM) drží minutové průměry – na sledování, jak
+//  zásobníky reagují na mrak, je to málo. TrendLog drží v RAM
+//  posledních TREND_SAMPLES vzorků v rozlišení pollu měniče
+//  (invPollMs, výchozí 2 s → 3600 vzorků ≈ 2 h):
+//    PV, spotřeba, síť, fáze L1–L3
+//
+//  Kruhový buffer, vzorek = int16 delta proti předchozímu
+//  (6 kanálů × 2 B = 12 B/vzorek, 43 KB celkem). Absolutní
+//  hodnota nejstaršího vzorku je v _base, nejnovějšího v _last –
+//  čtení jde od bližšího konce. Delta mimo int16 se ořízne
+//  a dorovná v dalším vzorku (_last je rekonstruovaná hodnota).
+//
+//  Decimace: decimate() projde vzorky od fromSeq a po skupinách
+//  'bucket' vzorků vrátí min/max/poslední hodnotu každého kanálu
+//  (sloupec grafu). Sloupce jsou zarovnané na seq / bucket –
+//  screen může dokreslovat jen nové sloupce a posouvat graf.
+//
+//  Plnění: taskHeartbeat volá feed() s daty měniče, nový vzorek
+//  vznikne jen po novém úspěšném pollu (lastUpdateMs).
+//
+//  Použití:
+//    TrendLog::begin();                       // setup()
+//    TrendLog::feed(inv);                     // taskHeartbeat
+//    TrendLog::decimate(from, 5, cb, ctx);    // TrendScreen
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "InverterTypes.h"
+
+#define TREND_SAMPLES   3600    // 2 h při pollu 2 s
+#define TREND_CHANNELS  6
+
+enum TrendChannel : uint8_t {
+    TREND_PV   = 0,
+    TREND_LOAD = 1,
+    TREND_GRID = 2,     // + odběr, − dodávka
+    TREND_L1   = 3,     // + dodávka, − odběr
+    TREND_L2   = 4,
+    TREND_L3   = 5
+};
+
+// Jeden sloupec po decimaci [W]
+struct TrendColumn {
+    uint32_t bucket;                    // seq / bucket prvního vzorku
+    uint16_t samples;                   // vzorků ve sloupci (poslední může být neúplný)
+    int32_t  min[TREND_CHANNELS];
+    int32_t  max[TREND_CHANNELS];
+    int32_t  last[TREND_CHANNELS];      // poslední vzorek – návaznost čáry
+};
+
+// Callback decimace – volá se pod mutexem, jen kreslit do RAM
+typedef void (*TrendColumnFn)(const TrendColumn& col, void* ctx);
+
+namespace TrendLog {
+
+    static int16_t  _delta[TREND_SAMPLES][TREND_CHANNELS];
+    static int32_t  _base[TREND_CHANNELS]  = {};   // hodnota nejstaršího vzorku
+    static int32_t  _last[TREND_CHANNELS]  = {};   // hodnota nejnovějšího vzorku
+    static uint16_t _head   = 0;                   // index nejstaršího vzorku
+    static uint16_t _count  = 0;
+    static uint32_t _seq    = 0;                   // pořadí příštího vzorku
+    static uint32_t _pollMs = 0;                   // lastUpdateMs posledního vzorku
+    static SemaphoreHandle_t _mutex = nullptr;
+
+    void begin() {
+        if (!_mutex) _mutex = xSemaphoreCreateMutex();
+    }
+
+    // ---------------------------------------------------------
+    //  Přidej vzorek [W]
+    // ---------------------------------------------------------
+    void push(const int32_t v[TREND_CHANNELS]) {
+        if (!_mutex) return;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+
+        if (_count == TREND_SAMPLES) {
+            // Nejstarší vypadne – nový nejstarší = base + jeho delta
+            _head = (_head + 1) % TREND_SAMPLES;
+            _count--;
+            for (uint8_t c = 0; c < TREND_CHANNELS; c++) _base[c] += _delta[_head][c];
+        }
+
+        uint16_t slot = (_head + _count) % TREND_SAMPLES;
+        for (uint8_t c = 0; c < TREND_CHANNELS; c++) {
+            if (_count == 0) {
+                _base[c] = _last[c] = v[c];
+                _delta[slot][c] = 0;
+                continue;
+            }
+            int32_t d = constrain(v[c] - _last[c], (int32_t)-32767, (int32_t)32767);
+            _delta[slot][c] = (int16_t)d;
+            _last[c] += d;
+        }
+        _count++;
+        _seq++;
+        xSemaphoreGive(_mutex);
+    }
+
+    // Data měniče – vzorek jen po novém platném pollu
+    void feed(const InverterData& inv) {
+        if (!inv.valid || inv.lastUpdateMs == _pollMs) return;
+        _pollMs = inv.lastUpdateMs;
+        int32_t v[TREND_CHANNELS] = {
+            inv.powerPV, inv.powerLoad, inv.powerGrid,
+            inv.phaseL1, inv.phaseL2, inv.phaseL3
+        };
+        push(v);
+    }
+
+    // Pořadí příštího vzorku – změna = nová data pro graf
+    uint32_t seq()      { return _seq; }
+    uint32_t firstSeq() { return _seq - _count; }
+    uint16_t count()    { return _count; }
+
+    // ---------------------------------------------------------
+    //  Sloupce min/max po 'bucket' vzorcích od fromSeq
+    //  (zarovnáno dolů na bucket). Vrací počet sloupců.
+    // ---------------------------------------------------------
+    uint16_t decimate(uint32_t fromSeq, uint16_t bucket, TrendColumnFn cb, void* ctx) {
+        if (!_mutex || !cb || bucket == 0) return 0;
+        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) return 0;
+
+        uint32_t first = _seq - _count;
+        fromSeq = fromSeq / bucket * bucket;
+        if (fromSeq < first) fromSeq = first;
+        if (fromSeq >= _seq) {
+            xSemaphoreGive(_mutex);
+            return 0;
+        }
+
+        // Hodnota vzorku fromSeq – od bližšího konce bufferu
+        uint16_t i0 = (uint16_t)(fromSeq - first);
+        int32_t  v[TREND_CHANNELS];
+        if (i0 <= _count / 2) {
+            memcpy(v, _base, sizeof(v));
+            for (uint16_t i = 1; i <= i0; i++) {
+                const int16_t* d = _delta[(_head + i) % TREND_SAMPLES];
+                for (uint8_t c = 0; c < TREND_CHANNELS; c++) v[c] += d[c];
+            }
+        } else {
+            memcpy(v, _last, sizeof(v));
+            for (uint16_t i = _count - 1; i > i0; i--) {
+                const int16_t* d = _delta[(_head + i) % TREND_SAMPLES];
+                for (uint8_t c = 0; c < TREND_CHANNELS; c++) v[c] -= d[c];
+            }
+        }
+
+        TrendColumn col;
+        uint16_t    cols = 0;
+        col.samples = 0;
+        for (uint16_t i = i0; i < _count; i++) {
+            uint32_t s = first + i;
+            if (i > i0) {
+                const int16_t* d = _delta[(_head + i) % TREND_SAMPLES];
+                for (uint8_t c = 0; c < TREND_CHANNELS; c++) v[c] += d[c];
+            }
+            if (col.samples == 0) {
+                col.bucket = s / bucket;
+                memcpy(col.min, v, sizeof(v));
+                memcpy(col.max, v, sizeof(v));
+            } else {
+                for (uint8_t c = 0; c < TREND_CHANNELS; c++) {
+                    if (v[c] < col.min[c]) col.min[c] = v[c];
+                    if (v[c] > col.max[c]) col.max[c] = v[c];
+                }
+            }
+            col.samples++;
+            if ((s + 1) % bucket == 0 || i + 1 == _count) {
+                memcpy(col.last, v, sizeof(v));
+                cb(col, ctx);
+                cols++;
+                col.samples = 0;
+            }
+        }
+        xSemaphoreGive(_mutex);
+        return cols;
+    }
+
+} // namespace TrendLog
@@ -0,0 +1,373 @@
+// =============================================================
+//  TrendScreen.h – krátkodobý trend výkonů (TrendLog)
+//
+//  Dostupné z: Menu → Trend
+//
+//  Dva grafy přes celou šířku:
+//    horní  – PV (oranžová), spotřeba (bílá), síť (cyan, + odběr)
+//    dolní  – fáze L1 (červená), L2 (zelená), L3 (cyan), + dodávka
+//  Sloupec = TREND_COL_W px = 'bucket' vzorků (min/max čára,
+//  navázaná na poslední hodnotu předchozího sloupce – špičky
+//  z mraku nezmizí ani v 2h rozsahu).
+//
+//  Rozsah (UP/DOWN): 1 / 5 / 25 vzorků na sloupec
+//    = 144 / 720 / 3600 vzorků (při pollu 2 s ≈ 5 min / 24 min / 2 h)
+//
+//  Inkrementální kreslení: update() se podívá na TrendLog::seq().
+//  Nový vzorek ve stejném sloupci → překreslí se jen poslední
+//  sloupec. Nový sloupec → obsah grafů se ve spritu posune
+//  o sloupec doleva (memmove řádků) a dokreslí se jen nové
+//  sloupce. Celý graf se kreslí jen v draw(), při změně rozsahu
+//  a když se změní měřítko okna (špička přibyla / odjela).
+//
+//  Navigace:
+//    UP/DOWN  – rozsah
+//    LEFT     – zpět do menu
+//
+//  Geometrie:
+//    Sdílený gContentSprite (4 bity/px → sloupec 2 px = 1 bajt,
+//    posun je celé bajty). Bez spritu se kreslí přímo na tft
+//    a každý nový vzorek překreslí celý graf.
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "LGFX_ST7789V_Pico2W.h"
+#include "Theme.h"
+#include "Header.h"
+#include "ScreenManager.h"
+#include "Render.h"
+#include "FiveWaySwitch.h"
+#include "SolarData.h"
+#include "PCF85063A.h"
+#include "TrendLog.h"
+#include "Config.h"
+
+extern Config gConfig;
+
+#define TREND_COLS       144
+#define TREND_COL_W      2
+#define TREND_PLOT_X     30     // sudé – sloupec začíná na celém bajtu
+#define TREND_PLOT_A_Y   (CONTENT_Y + 28)
+#define TREND_PLOT_A_H   74
+#define TREND_PLOT_B_Y   (CONTENT_Y + 116)
+#define TREND_PLOT_B_H   70
+#define TREND_MIN_SPAN   1000   // [W] nejmenší rozsah osy Y
+#define TREND_STEP       500    // [W] zaokrouhlení rozsahu
+
+namespace TrendScreen {
+
+    static const uint16_t _buckets[] = { 1, 5, 25 };
+    static const uint8_t  _zoomCount = sizeof(_buckets) / sizeof(_buckets[0]);
+
+    // Graf = sada kanálů se společnou osou Y
+    struct Plot {
+        int16_t y, h;
+        uint8_t first, count;       // kanály TrendChannel
+        int32_t lo, hi;             // měřítko [W]
+    };
+
+    static Plot _plots[2] = {
+        { TREND_PLOT_A_Y, TREND_PLOT_A_H, TREND_PV, 3, 0, 0 },
+        { TREND_PLOT_B_Y, TREND_PLOT_B_H, TREND_L1, 3, 0, 0 },
+    };
+
+    static LGFX_Sprite* _spr        = nullptr;
+    static uint8_t      _zoom       = 1;
+    static uint32_t     _seq        = 0;    // TrendLog::seq() při posledním kreslení
+    static uint32_t     _lastBucket = 0;    // bucket posledního sloupce
+    static int32_t      _prevLast[TREND_CHANNELS] = {};   // návaznost čar
+    static bool         _havePrev   = false;
+
+    void setSprite(LGFX_Sprite* s) {
+        _spr = (s && s->getBuffer()) ? s : nullptr;
+    }
+
+    // ---------------------------------------------------------
+    //  Kreslicí plocha – sprite (indexy palety) nebo tft
+    // ---------------------------------------------------------
+    static LovyanGFX* _canvas(const Theme*& t, int16_t& dy) {
+        if (_spr) {
+            t  = Render::ink(_spr, t);
+            dy = -CONTENT_Y;
+            return _spr;
+        }
+        dy = 0;
+        return &tft;
+    }
+
+    static uint16_t _color(const Theme* t, uint8_t ch) {
+        switch (ch) {
+            case TREND_PV:   return t->warn;
+            case TREND_LOAD: return t->text;
+            case TREND_GRID: return t->accent;
+            case TREND_L1:   return t->err;
+            case TREND_L2:   return t->ok;
+            default:         return t->accent;
+        }
+    }
+
+    static uint16_t _bucket() { return _buckets[_zoom]; }
+
+    // Bucket nejlevějšího sloupce při posledním sloupci 'last'
+    static uint32_t _firstBucket(uint32_t last) {
+        return last >= TREND_COLS - 1 ? last - (TREND_COLS - 1) : 0;
+    }
+
+    static int16_t _colX(uint32_t bucket) {
+        return TREND_PLOT_X + (int16_t)(bucket - _firstBucket(_lastBucket)) * TREND_COL_W;
+    }
+
+    static int16_t _valY(const Plot& p, int32_t v) {
+        v = constrain(v, p.lo, p.hi);
+        return p.y + (int16_t)((int64_t)(p.hi - v) * (p.h - 1) / (p.hi - p.lo));
+    }
+
+    // ---------------------------------------------------------
+    //  Měřítko – min/max přes zobrazené sloupce do kopie _plots
+    // ---------------------------------------------------------
+    static void _scaleCb(const TrendColumn& c, void* ctx) {
+        Plot* plots = (Plot*)ctx;
+        for (uint8_t k = 0; k < 2; k++) {
+            Plot& p = plots[k];
+            for (uint8_t i = p.first; i < p.first + p.count; i++) {
+                if (c.min[i] < p.lo) p.lo = c.min[i];
+                if (c.max[i] > p.hi) p.hi = c.max[i];
+            }
+        }
+    }
+
+    static void _scale(uint32_t fromSeq, Plot* plots) {
+        memcpy(plots, _plots, sizeof(_plots));
+        for (uint8_t k = 0; k < 2; k++) { plots[k].lo = 0; plots[k].hi = 0; }
+        TrendLog::decimate(fromSeq, _bucket(), _scaleCb, plots);
+        for (uint8_t k = 0; k < 2; k++) {
+            // Zaokrouhli ven na TREND_STEP, nula vždy v grafu
+            Plot& p = plots[k];
+            p.hi = (p.hi + TREND_STEP - 1) / TREND_STEP * TREND_STEP;
+            p.lo = -((-p.lo + TREND_STEP - 1) / TREND_STEP * TREND_STEP);
+            if (p.hi - p.lo < TREND_MIN_SPAN) p.hi = p.lo + TREND_MIN_SPAN;
+        }
+    }
+
+    static bool _sameScale(const Plot* plots) {
+        for (uint8_t k = 0; k < 2; k++) {
+            if (plots[k].lo != _plots[k].lo || plots[k].hi != _plots[k].hi) return false;
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Jeden sloupec obou grafů
+    // ---------------------------------------------------------
+    static void _drawColumn(const TrendColumn& c, void* ctx) {
+        const Theme* t = (const Theme*)ctx;
+        int16_t      dy;
+        LovyanGFX*   dc = _canvas(t, dy);
+        int16_t      x  = _colX(c.bucket);
+
+        for (const Plot& p : _plots) {
+            dc->fillRect(x, p.y + dy, TREND_COL_W, p.h, t->bg);
+            dc->drawFastHLine(x, _valY(p, 0) + dy, TREND_COL_W, t->dim);
+            for (uint8_t i = p.first; i < p.first + p.count; i++) {
+                int32_t lo = c.min[i], hi = c.max[i];
+                if (_havePrev) {
+                    lo = min(lo, _prevLast[i]);
+                    hi = max(hi, _prevLast[i]);
+                }
+                int16_t y0 = _valY(p, hi), y1 = _valY(p, lo);
+                dc->fillRect(x, y0 + dy, TREND_COL_W, y1 - y0 + 1, _color(t, i));
+            }
+        }
+        // Návaznost jen přes dokončený sloupec – neúplný poslední
+        // se kreslí znovu s dalšími vzorky
+        if (c.bucket < _lastBucket) {
+            memcpy(_prevLast, c.last, sizeof(_prevLast));
+            _havePrev = true;
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Popisky os, legenda, rozsah
+    // ---------------------------------------------------------
+    static void _fmtKw(char* buf, size_t n, int32_t w) {
+        snprintf(buf, n, "%s%ld.%ld", w < 0 ? "-" : "",
+                 (long)(abs(w) / 1000), (long)(abs(w) % 1000 / 100));
+    }
+
+    static void _drawFrame(const Theme* t) {
+        int16_t    dy;
+        LovyanGFX* dc = _canvas(t, dy);
+        dc->fillRect(0, CONTENT_Y + dy, 320, CONTENT_H, t->bg);
+
+        // Nadpis + rozsah
+        uint32_t spanS = (uint32_t)TREND_COLS * _bucket() * gConfig.invPollMs / 1000;
+        char     span[16];
+        if (spanS >= 3600) snprintf(span, sizeof(span), "%lu h %02lu min",
+                                    (unsigned long)(spanS / 3600), (unsigned long)(spanS % 3600 / 60));
+        else               snprintf(span, sizeof(span), "%lu min", (unsigned long)((spanS + 30) / 60));
+        dc->setFont(&fonts::Font2);
+        dc->setTextColor(t->dim);
+        dc->setCursor(16, CONTENT_Y + 2 + dy);
+        dc->print("TREND");
+        dc->setTextColor(t->accent);
+        dc->setTextDatum(top_right);
+        dc->drawString(span, 312, CONTENT_Y + 2 + dy);
+        dc->setTextDatum(top_left);
+
+        // Legenda nad každým grafem
+        static const char* const names[TREND_CHANNELS] = {
+            "PV", "spotreba", "sit +odber", "L1", "L2", "L3 +dodavka"
+        };
+        dc->setFont(&fonts::Font0);
+        for (const Plot& p : _plots) {
+            int16_t lx = TREND_PLOT_X;
+            for (uint8_t i = p.first; i < p.first + p.count; i++) {
+                dc->setTextColor(_color(t, i));
+                dc->setCursor(lx, p.y - 10 + dy);
+                dc->print(names[i]);
+                lx += (strlen(names[i]) + 2) * 6;
+            }
+
+            // Osa Y – horní / spodní mez [kW]
+            char lbl[8];
+            dc->setTextColor(t->dim);
+            dc->setTextDatum(top_right);
+            _fmtKw(lbl, sizeof(lbl), p.hi);
+            dc->drawString(lbl, TREND_PLOT_X - 4, p.y + dy);
+            dc->setTextDatum(bottom_right);
+            _fmtKw(lbl, sizeof(lbl), p.lo);
+            dc->drawString(lbl, TREND_PLOT_X - 4, p.y + p.h + dy);
+            dc->setTextDatum(top_left);
+            dc->drawFastVLine(TREND_PLOT_X - 2, p.y + dy, p.h, t->dim);
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Celý graf – rámeček, měřítko, všechny sloupce
+    // ---------------------------------------------------------
+    static void _drawAll(const Theme* t) {
+        _seq        = TrendLog::seq();
+        _lastBucket = _seq ? (_seq - 1) / _bucket() : 0;
+        uint32_t from = _firstBucket(_lastBucket) * _bucket();
+
+        _scale(from, _plots);
+        _drawFrame(t);
+        _havePrev = false;
+        if (TrendLog::count() == 0) {
+            int16_t    dy;
+            const Theme* ti = t;
+            LovyanGFX* dc = _canvas(ti, dy);
+            dc->setFont(&fonts::Font2);
+            dc->setTextColor(ti->dim);
+            dc->setTextDatum(middle_center);
+            dc->drawString("Ceka na data z menice", 160, CONTENT_Y + CONTENT_H / 2 + dy);
+            dc->setTextDatum(top_left);
+        } else {
+            TrendLog::decimate(from, _bucket(), _drawColumn, (void*)t);
+        }
+        if (_spr) Render::push(_spr, 0, CONTENT_Y);
+    }
+
+    // Posuň obsah grafů o n sloupců doleva (jen sprite)
+    static void _shift(uint16_t n) {
+        uint8_t* buf    = (uint8_t*)_spr->getBuffer();
+        int32_t  bpp    = _spr->getColorDepth() & 0xFF;
+        int32_t  stride = (int32_t)_spr->width() * bpp / 8;
+        int32_t  x0     = TREND_PLOT_X * bpp / 8;
+        int32_t  step   = (int32_t)n * TREND_COL_W * bpp / 8;
+        int32_t  len    = (int32_t)TREND_COLS * TREND_COL_W * bpp / 8 - step;
+        for (const Plot& p : _plots) {
+            for (int16_t y = p.y; y < p.y + p.h; y++) {
+                uint8_t* row = buf + (int32_t)(y - CONTENT_Y) * stride + x0;
+                memmove(row, row + step, len);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------
+    //  Dokresli nové vzorky
+    // ---------------------------------------------------------
+    static void _drawNew(const Theme* t) {
+        uint32_t seq = TrendLog::seq();
+        if (seq == _seq) return;
+
+        uint32_t last = (seq - 1) / _bucket();
+        uint32_t from = _lastBucket * _bucket();     // neúplný sloupec znovu
+
+        // Měřítko okna po posunu – změna (špička přibyla nebo
+        // odjela z grafu) = celý graf znovu
+        Plot scaled[2];
+        _scale(_firstBucket(last) * _bucket(), scaled);
+
+        if (!_spr || !_sameScale(scaled) || _seq == 0 || last - _lastBucket >= TREND_COLS) {
+            _drawAll(t);
+            return;
+        }
+        // Posun jen když je graf plný – jinak sloupce přibývají vpravo
+        uint32_t oldFirst = _firstBucket(_lastBucket);
+        uint32_t newFirst = _firstBucket(last);
+        if (newFirst > oldFirst) _shift((uint16_t)(newFirst - oldFirst));
+        _lastBucket = last;
+        _seq        = seq;
+        TrendLog::decimate(from, _bucket(), _drawColumn, (void*)t);
+        Render::push(_spr, 0, CONTENT_Y);
+    }
+
+    // ==========================================================
+    //  Veřejné rozhraní
+    // ==========================================================
+
+    void draw(const Theme* t, const DateTime& dt,
+              uint8_t apState, uint8_t staState, uint8_t invState,
+              bool alarm, const SolarData& d) {
+        tft.fillScreen(t->bg);
+        Header::draw(t, dt, apState, staState, invState, alarm);
+
+        tft.fillRect(0, FTR_Y, 320, FTR_H, t->header);
+        tft.setFont(&fonts::Font2);
+        tft.setTextColor(t->dim);
+        tft.setTextDatum(middle_center);
+        tft.drawString("UP/DN rozsah  LEFT zpet", 160, FTR_Y + 13);
+        tft.setTextDatum(top_left);
+
+        _drawAll(t);
+    }
+
+    void update(const Theme* t, const DateTime& dt,
+                uint8_t apState, uint8_t staState, uint8_t invState,
+                bool alarm, const SolarData& d) {
+        Header::update(t, dt, apState, staState, invState, alarm);
+        _drawNew(t);
+    }
+
+    Screen handleInput(const Theme* t, SwButton btn) {
+        switch (btn) {
+            case SW_UP:
+                if (_zoom > 0) {
+                    _zoom--;
+                    _drawAll(t);
+                }
+                return SCREEN_NONE;
+
+            case SW_DOWN:
+                if (_zoom < _zoomCount - 1) {
+                    _zoom++;
+                    _drawAll(t);
+                }
+                return SCREEN_NONE;
+
+            case SW_LEFT:
+                return SCREEN_MENU;
+
+            default:
+                return SCREEN_NONE;
+        }
+    }
+
+    void reset() {
+        _seq        = 0;
+        _lastBucket = 0;
+    }
+
+} // namespace TrendScreen
@@ -0,0 +1,82 @@
+// =============================================================
+//  UiEvents.h – fronta událostí pro UI smyčku (Core 0)
+//
+//  Problém: uiLoop() točil gSwitch.read() dokola a každou
+//  sekundu překreslil screen, i když se SolarData nezměnila.
+//
+//  Řešení: UI čeká na frontě (UiEvents::wait) a probudí se jen
+//  na událost:
+//    UI_EV_INPUT   – hrana na pinu 5-way switche (GPIO IRQ)
+//    UI_EV_DATA    – SolarModel změnil data (onChange)
+//    UI_EV_MINUTE  – TimeService minutová událost (hodiny v záhlaví)
+//    UI_EV_ALARM   – měnič přešel do / z poruchy
+//    UI_EV_STATE   – změna WiFi (puntíky v záhlaví)
+//
+//  Události jsou bity – post() je přidá do _pending a frontou
+//  pošle jen "budíček", pokud bit ještě nečekal. Plná fronta
+//  tak nic neztratí, wait() vrátí OR všech čekajících bitů.
+//  post() je bezpečné z libovolného tasku, postFromISR() z IRQ.
+//
+//  Použití:
+//    UiEvents::begin();                       // setup() před IRQ
+//    UiEvents::post(UI_EV_DATA);              // libovolný task
+//    UiEvents::postFromISR(UI_EV_INPUT);      // ISR
+//    uint8_t ev = UiEvents::wait(timeoutMs);  // UI – blokuje
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include <queue.h>
+
+#define UI_EV_INPUT     0x01
+#define UI_EV_DATA      0x02
+#define UI_EV_MINUTE    0x04
+#define UI_EV_ALARM     0x08
+#define UI_EV_STATE     0x10
+
+#define UI_EVENT_QUEUE_LEN  16
+
+namespace UiEvents {
+
+    static QueueHandle_t    _queue   = nullptr;
+    static volatile uint8_t _pending = 0;
+
+    void begin() {
+        if (!_queue) _queue = xQueueCreate(UI_EVENT_QUEUE_LEN, sizeof(uint8_t));
+    }
+
+    // ---------------------------------------------------------
+    //  Ohlášení události – z tasku
+    // ---------------------------------------------------------
+    void post(uint8_t ev) {
+        uint8_t prev = __atomic_fetch_or(&_pending, ev, __ATOMIC_SEQ_CST);
+        if (_queue && (prev & ev) != ev) xQueueSend(_queue, &ev, 0);
+    }
+
+    // ---------------------------------------------------------
+    //  Ohlášení události – z přerušení
+    // ---------------------------------------------------------
+    void postFromISR(uint8_t ev) {
+        uint8_t prev = __atomic_fetch_or(&_pending, ev, __ATOMIC_SEQ_CST);
+        if (!_queue || (prev & ev) == ev) return;
+        BaseType_t woken = pdFALSE;
+        xQueueSendFromISR(_queue, &ev, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    // ---------------------------------------------------------
+    //  Čekej nejvýš timeoutMs na událost, vrať masku UI_EV_xxx
+    //  (0 = timeout). Volá jen UI smyčka.
+    // ---------------------------------------------------------
+    uint8_t wait(uint32_t timeoutMs) {
+        uint8_t ev;
+        if (_queue && !_pending &&
+            xQueueReceive(_queue, &ev, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+            return 0;
+        }
+        // Budíčky mohou zůstat z dřívějška – bity jsou v _pending
+        if (_queue) while (xQueueReceive(_queue, &ev, 0) == pdTRUE) {}
+        return __atomic_exchange_n(&_pending, 0, __ATOMIC_SEQ_CST);
+    }
+
+} // namespace UiEvents
@@ -0,0 +1,159 @@
+// =============================================================
+//  WarmStart.h – snapshot stavu pro rychlý start po restartu
+//
+//  Problém: po restartu (watchdog, výpadek) ukazuje MainScreen
+//  nuly, dokud se nepovede první Modbus čtení (TCP i > 10 s),
+//  a BoilerController zapomene stavy, rechecky i round-robin.
+//
+//  Řešení – dva bloky FRAM:
+//    Blok 12 (0x0200) FramSnapshot – poslední SolarData + screen,
+//             zápis každých WARM_SNAPSHOT_MS a při změně screenu
+//    Blok 7  (0x0680) FramBoilerRt ×BOILER_MAX_COUNT – BoilerRuntime,
+//             zápis při každé změně stavu (_changeState)
+//
+//  Start: restoreSolar() nahraje snapshot do SolarModel jako
+//  stale (valid = false → řízení nereaguje, UI kreslí šedě),
+//  restoreBoilers() obnoví controller PŘED jeho begin().
+//
+//  Zápis jde přes FramWriter → loop() volat POUZE z Core 0.
+//
+//  Použití:
+//    WarmStart::restoreSolar(nowSecs, rtcValid);   // setup()
+//    WarmStart::restoreBoilers(*gBoilerCtrl, nowSecs, rtcValid);
+//    WarmStart::loop(gBoilerCtrl);                  // loop()
+// =============================================================
+#pragma once
+#include <Arduino.h>
+#include "Log.h"
+#include "FramMap.h"
+#include "FramWriter.h"
+#include "SolarData.h"
+#include "BoilerController.h"
+#include "ScreenManager.h"
+#include "TimeService.h"
+
+#define WARM_SNAPSHOT_MS    30000           // periodický snapshot SolarData
+#define WARM_MAX_AGE_S      (6UL * 3600UL)  // starší snapshot se nezobrazí
+
+extern FM24CL64 gFRAM;
+
+namespace WarmStart {
+
+    static FramSnapshot _snap       = {};
+    static bool         _restored   = false;
+    static Screen       _lastScreen = SCREEN_MAIN;
+    static uint32_t     _lastSaveMs = 0;
+    static bool         _haveData   = false;    // _snap obsahuje skutečné hodnoty
+
+    // Screeny, na které se smí vrátit po startu (bez PINu)
+    static bool _screenAllowed(uint8_t s) {
+        return s == SCREEN_MAIN || s == SCREEN_MENU ||
+               s == SCREEN_HISTORY || s == SCREEN_DIAGNOSTIC;
+    }
+
+    // ---------------------------------------------------------
+    //  Obnov SolarData – volej v setup() po SolarModel::begin()
+    //  Vrací true pokud byl obnoven dost čerstvý snapshot.
+    // ---------------------------------------------------------
+    bool restoreSolar(uint32_t nowSecs, bool timeValid) {
+        if (!FramBlock::readBlock(gFRAM, BLOCK_SNAPSHOT_ADDR, BLOCK_SNAPSHOT_VER,
+                                  &_snap, sizeof(_snap))) {
+            memset(&_snap, 0, sizeof(_snap));
+            return false;
+        }
+
+        bool known = timeValid && _snap.savedAt && _snap.savedAt <= nowSecs;
+        if (known && nowSecs - _snap.savedAt > WARM_MAX_AGE_S) {
+            LOGF("[WARM] Snapshot starý %lu min – ignoruji\n",
+                (unsigned long)((nowSecs - _snap.savedAt) / 60));
+            return false;
+        }
+
+        SolarData d = {};
+        d.powerPV      = _snap.powerPV;
+        d.powerLoad    = _snap.powerLoad;
+        d.powerBattery = _snap.powerBattery;
+        d.powerGrid    = _snap.powerGrid;
+        d.phaseL1      = _snap.phaseL1;
+        d.phaseL2      = _snap.phaseL2;
+        d.phaseL3      = _snap.phaseL3;
+        d.soc          = _snap.soc;
+        d.soh          = _snap.soh;
+        d.invStatus    = _snap.invStatus;
+        // Denní energie jen pokud je snapshot z dnešního dne
+        if (known && _snap.savedAt / 86400UL == nowSecs / 86400UL) {
+            d.energyPvToday   = _snap.energyPvToday;
+            d.energyGridToday = _snap.energyGridToday;
+            d.energySoldToday = _snap.energySoldToday;
+        }
+        SolarModel::restore(d);
+
+        if (_screenAllowed(_snap.screen)) _lastScreen = (Screen)_snap.screen;
+        _restored = true;
+        _haveData = true;
+        LOGF("[WARM] Snapshot obnoven (stáří %s%lu s, screen %u)\n",
+            known ? "" : "? ",
+            known ? (unsigned long)(nowSecs - _snap.savedAt) : 0UL,
+            _lastScreen);
+        return true;
+    }
+
+    // ---------------------------------------------------------
+    //  Obnov BoilerRuntime – volej PŘED BoilerController::begin()
+    // ---------------------------------------------------------
+    bool restoreBoilers(BoilerController& ctrl, uint32_t nowSecs, bool timeValid) {
+        FramBoilerRt rt[BOILER_MAX_COUNT];
+        if (!FramBlock::readBlock(gFRAM, BLOCK_BOILRT_ADDR, BLOCK_BOILRT_VER,
+                                  rt, sizeof(rt))) return false;
+        ctrl.importRuntime(rt, nowSecs, timeValid);
+        return true;
+    }
+
+    bool   restored()   { return _restored; }
+    Screen lastScreen() { return _lastScreen; }
+
+    // ---------------------------------------------------------
+    //  Periodická obsluha – volej z loop() (Core 0)
+    // ---------------------------------------------------------
+    void loop(BoilerController* ctrl) {
+        // BoilerRuntime – při změně stavu
+        if (ctrl && ctrl->takeRuntimeDirty()) {
+            FramBoilerRt rt[BOILER_MAX_COUNT];
+            ctrl->exportRuntime(rt, TimeService::now());
+            FramWriter::submit(BLOCK_BOILRT_ADDR, BLOCK_BOILRT_VER, rt, sizeof(rt));
+        }
+
+        // SolarData + screen – periodicky nebo při změně screenu
+        Screen   scr     = ScreenManager::current();
+        bool     scrDiff = _screenAllowed(scr) && scr != _snap.screen;
+        uint32_t now     = millis();
+        if (!scrDiff && now - _lastSaveMs < WARM_SNAPSHOT_MS) return;
+        _lastSaveMs = now;
+
+        SolarData d;
+        if (SolarModel::get(d)) {
+            // Jen živá data – stale by přepsala snapshot sama sebou
+            _snap.savedAt         = TimeService::valid() ? TimeService::now() : 0;
+            _snap.powerPV         = d.powerPV;
+            _snap.powerLoad       = d.powerLoad;
+            _snap.powerBattery    = d.powerBattery;
+            _snap.powerGrid       = d.powerGrid;
+            _snap.phaseL1         = d.phaseL1;
+            _snap.phaseL2         = d.phaseL2;
+            _snap.phaseL3         = d.phaseL3;
+            _snap.soc             = d.soc;
+            _snap.soh             = d.soh;
+            _snap.energyPvToday   = d.energyPvToday;
+            _snap.energyGridToday = d.energyGridToday;
+            _snap.energySoldToday = d.energySoldToday;
+            _snap.invStatus       = d.invStatus;
+            _haveData             = true;
+        } else if (!scrDiff) {
+            return;
+        }
+        if (_screenAllowed(scr)) _snap.screen = scr;
+        if (!_haveData) return;     // zatím není co uložit
+        FramWriter::submit(BLOCK_SNAPSHOT_ADDR, BLOCK_SNAPSHOT_VER, &_snap, sizeof(_snap));
+    }
+
+} // namespace WarmStart
@@ -8,13 +8,18 @@
 #include <task.h>
 #include <WiFi.h>
 #include <Wire.h>
+#include "I2cBus.h"
 #include <LovyanGFX.hpp>
 #include "LGFX_ST7789V_Pico2W.h"
 #include "HW_Config.h"
+#include "Log.h"
 #include "Config.h"
 #include "FM24CL64.h"
-#include "MCP23017.h"
+#include "RelayBank.h"
 #include "PCF85063A.h"
+#include "TimeService.h"
+#include "SntpClient.h"
+#include "RtcCalibration.h"
 #include "FiveWaySwitch.h"
 #include "Theme.h"
 #include "ScreenManager.h"
@@ -24,12 +29,17 @@
 #include "InverterDriver.h"
 #include "BoilerConfig.h"
 #include "BoilerController.h"
+#include "PowerLog.h"
+#include "TrendLog.h"
+#include "HistoryStore.h"
+#include "ExportServer.h"
+#include "WarmStart.h"
 #include "main_ui_loop.h"
 
 #include <hardware/watchdog.h>
 
 #define FW_VERSION       "v0.0.1"
-#define WIFI_STA_TIMEOUT 30000
+#define LOOP_IDLE_MS     10      // max. spánek UI – perioda síťové části loop()
 
 // =============================================================
 //  Globalni stav
@@ -37,13 +47,14 @@
 const Theme*  gTheme     = &THEME_DARK;
 PCF85063A     gRTC;
 FM24CL64      gFRAM;
-MCP23017      gMCP;
+RelayBank     gRelays;
 FiveWaySwitch gSwitch;
 
 volatile bool gWifiSta   = false;
 volatile bool gWifiAp    = false;
 volatile bool gNtpOk     = false;
 volatile bool gNtpResync = false;
+bool          gFramOk    = false;
 
 // Merenic
 InverterDriver gInverter(gConfig, nullptr);
@@ -64,11 +75,26 @@ void taskHeartbeat(void* p) {
         InverterData inv;
         gInverter.getData(inv);
         SolarModel::updateFromInverter(inv);
-
-
-        DateTime dt = gRTC.getTime();
-        Serial.printf("[HB] %02d:%02d:%02d STA:%s AP:%s heap:%u "
-                      "INV:%s err:%u pv:%ld grid:%ld soc:%u\n",
+        TrendLog::feed(inv);
+
+        uint32_t ts = TimeService::now();
+        DateTime dt = secsToDateTime(ts);
+
+        // Minutový log výkonů (jen s platným časem)
+        if (TimeService::valid()) {
+            PowerSample ps;
+            ps.powerPV      = inv.powerPV;
+            ps.powerLoad    = inv.powerLoad;
+            ps.powerGrid    = inv.powerGrid;
+            ps.powerBattery = inv.powerBattery;
+            ps.phaseL1      = inv.phaseL1;
+            ps.phaseL2      = inv.phaseL2;
+            ps.phaseL3      = inv.phaseL3;
+            PowerLog::feed(ts, ps, inv.valid);
+        }
+        // Export po USB – výpis by rozbil přenášená data (Log::muted)
+        LOGF("[HB] %02d:%02d:%02d STA:%s AP:%s heap:%u "
+             "INV:%s err:%u pv:%ld grid:%ld soc:%u\n",
             dt.hour, dt.minute, dt.second,
             gWifiSta ? "OK" : "--",
             gWifiAp  ? "OK" : "--",
@@ -97,6 +123,14 @@ void taskBoiler(void* p) {
     }
 }
 
+// =============================================================
+//  Minutová událost TimeService – dávkový zápis historie (Core 0)
+// =============================================================
+static void onMinute(uint8_t events, uint32_t nowSecs) {
+    (void)events;                       // jen minuta – HistoryStore si hodinu/den pozná sám
+    if (TimeService::valid()) HistoryStore::loop(nowSecs);
+}
+
 // =============================================================
 //  setup()
 // =============================================================
@@ -127,15 +161,18 @@ void setup() {
     Wire.setSCL(PIN_I2C_SCL);
     Wire.begin();
     Wire.setClock(I2C_FREQ);
+    I2cBus::begin();                    // relé z Boiler tasku, FRAM/RTC z loop()
     BootScreen::print(gTheme, BOOT_OK, "I2C 400kHz");
 
     // FRAM
-    if (gFRAM.begin()) {
+    gFramOk = gFRAM.begin();
+    if (gFramOk) {
         BootScreen::print(gTheme, BOOT_OK, "FRAM 8KB");
         // Teď načti konfiguraci z FRAM (I2C už běží)
         ConfigManager::loadFromFram();
         gTheme = THEMES[gConfig.themeIndex];
         ConfigManager::print();
+        PowerLog::begin(gFRAM);
     } else {
         BootScreen::print(gTheme, BOOT_ERR, "FRAM chyba – pouzivam defaults");
         ConfigManager::print();
@@ -154,12 +191,14 @@ void setup() {
                      dt.hour, dt.minute, dt.second);
             BootScreen::print(gTheme, BOOT_WARN, buf);
         }
+        TimeService::begin(gRTC);
+        if (gFramOk) RtcCalibration::begin(gRTC);
     } else {
         BootScreen::print(gTheme, BOOT_ERR, "RTC  chyba");
     }
 
-    // MCP23017
-    if (gMCP.begin()) {
+    // MCP23017 – desky relé
+    if (gRelays.begin()) {
         BootScreen::print(gTheme, BOOT_OK, "MCP23017 rele OK");
     } else {
         BootScreen::print(gTheme, BOOT_WARN, "MCP23017 chyba – rele nedostupna");
@@ -178,7 +217,27 @@ void setup() {
         BootScreen::print(gTheme, BOOT_DISABLED, "HDO pin (casova zaloha)");
     }
 
-    // WiFi AP
+    // SolarModel + warm-start snapshot (poslední hodnoty jako stale)
+    SolarModel::begin();
+    TrendLog::begin();
+    bool     warm    = false;
+    uint32_t bootTs  = TimeService::valid() ? TimeService::now() : 0;
+    if (gFramOk) {
+        warm = WarmStart::restoreSolar(bootTs, TimeService::valid());
+        BootScreen::print(gTheme, warm ? BOOT_OK : BOOT_DISABLED,
+                          warm ? "Warm start – snapshot obnoven" : "Warm start (bez snapshotu)");
+    }
+
+    // BoilerController
+    gBoilerCtrl = new BoilerController(
+        gBoilerSys, gBoilerCfg, gBoilerRt, gRelays);
+    if (gFramOk) WarmStart::restoreBoilers(*gBoilerCtrl, bootTs, TimeService::valid());
+    gBoilerCtrl->begin();
+    snprintf(buf, sizeof(buf), "Boiler ctrl %u bytu", gConfig.numBoilers);
+    BootScreen::print(gTheme, BOOT_OK, buf);
+
+    // WiFi AP – síť se jen spustí, připojení STA a NTP dobíhají
+    // v loop(); snapshot a řízení už běží, MainScreen na síť nečeká
     if (gConfig.wifiApEn) {
         WiFi.mode(gConfig.wifiStaEn ? WIFI_AP_STA : WIFI_AP);
         WiFi.softAPConfig(
@@ -220,43 +279,38 @@ void setup() {
             );
         }
         WiFi.begin(gConfig.wifiStaSsid, gConfig.wifiStaPass);
-        gWifiSta = BootScreen::wifiSta(gTheme, gConfig.wifiStaSsid, WIFI_STA_TIMEOUT);
+        snprintf(buf, sizeof(buf), "WiFi STA %s  na pozadi", gConfig.wifiStaSsid);
+        BootScreen::print(gTheme, BOOT_WARN, buf);
     } else {
         BootScreen::print(gTheme, BOOT_DISABLED, "WiFi STA (vypnuto)");
     }
 
-    // NTP
-    if (gConfig.ntpEn && gWifiSta) {
-        Serial.print("[NTP] Sync");
-        NTP.begin(gConfig.ntpServer);
-        NTP.waitSet([]() { Serial.print("."); });
-        time_t now = time(nullptr);
-        struct tm* ti = localtime(&now);
-        Serial.printf("\n[NTP] %02d:%02d:%02d\n",
-                      ti->tm_hour, ti->tm_min, ti->tm_sec);
-        DateTime dt;
-        dt.year=ti->tm_year+1900; dt.month=ti->tm_mon+1; dt.day=ti->tm_mday;
-        dt.hour=ti->tm_hour;     dt.minute=ti->tm_min;   dt.second=ti->tm_sec;
-        gRTC.setTime(dt);
-        gNtpOk = true;
-        snprintf(buf, sizeof(buf), "NTP  %02d:%02d:%02d",
-                 ti->tm_hour, ti->tm_min, ti->tm_sec);
-        BootScreen::print(gTheme, BOOT_OK, buf);
+    // NTP – první sync hned po připojení STA (loop)
+    SntpClient::begin(gRTC);
+    if (gConfig.ntpEn && gConfig.wifiStaEn) {
+        BootScreen::print(gTheme, BOOT_WARN, "NTP  sync po pripojeni WiFi");
     } else if (!gConfig.ntpEn) {
         BootScreen::print(gTheme, BOOT_DISABLED, "NTP  (vypnuto)");
     } else {
         BootScreen::print(gTheme, BOOT_DISABLED, "NTP  (bez WiFi)");
     }
 
-    // SolarModel
-    SolarModel::begin();
+    // Dlouhodobá historie (LittleFS)
+    TimeService::subscribe(onMinute);
+    if (HistoryStore::begin()) {
+        BootScreen::print(gTheme, BOOT_OK, "Historie LittleFS");
+    } else {
+        BootScreen::print(gTheme, BOOT_WARN, "Historie – LittleFS chyba");
+    }
 
-    // BoilerController
-    gBoilerCtrl = new BoilerController(
-        gBoilerSys, gBoilerCfg, gBoilerRt, gMCP, gRTC);
-    gBoilerCtrl->begin();
-    snprintf(buf, sizeof(buf), "Boiler ctrl %u bytu", gConfig.numBoilers);
-    BootScreen::print(gTheme, BOOT_OK, buf);
+    // Export historie – HTTP jen s WiFi, USB příkaz vždy
+    if (gWifiAp || gConfig.wifiStaEn) {
+        ExportServer::begin();
+        snprintf(buf, sizeof(buf), "Export HTTP :%u /export", EXPORT_HTTP_PORT);
+        BootScreen::print(gTheme, BOOT_OK, buf);
+    } else {
+        BootScreen::print(gTheme, BOOT_DISABLED, "Export HTTP (bez WiFi)");
+    }
 
     // Tasky – spusť AŽ PO WiFi (ověřeno funkční na Pico 2W)
     xTaskCreate(taskHeartbeat, "HB",     2048, nullptr,      3, nullptr);
@@ -269,12 +323,13 @@ void setup() {
     // Watchdog
     watchdog_enable(8000, true);
 
-    delay(1500);
-
-    // Logo screen
-    ScreenManager::set(SCREEN_LOGO);
-    LogoScreen::draw(gTheme, FW_VERSION);
-    delay(2000);
+    // Logo screen – při warm startu přeskoč (data jsou hned k dispozici)
+    if (!warm) {
+        delay(1500);
+        ScreenManager::set(SCREEN_LOGO);
+        LogoScreen::draw(gTheme, FW_VERSION);
+        delay(2000);
+    }
 
     // UI
     uiSetup();
@@ -286,60 +341,59 @@ void setup() {
 //  loop()
 // =============================================================
 void loop() {
-    uiLoop();
-
-    static uint32_t lastReconnect = 0;
+    TimeService::loop();
+    // UI spí do události; při NTP měření / exportu / dávce historie
+    // jen proběhne
+    bool busy = SntpClient::busy() || ExportServer::busy() || HistoryStore::busy();
+    uiLoop(busy ? 0 : LOOP_IDLE_MS);
+    ExportServer::loop();
+    if (gFramOk) PowerLog::pump();       // minuty z HB tasku → FRAM (Core 0)
+    HistoryStore::poll();                // dávka historie – 1 hodina / průchod
+    if (gFramOk) WarmStart::loop(gBoilerCtrl);
+    // powerW navržený odhadem z provozu (Core 1) → gBoilerCfg + Blok 6
+    if (gBoilerCtrl && gBoilerCtrl->applyPowerUpdates() && gFramOk)
+        ConfigManager::saveAsync(BLOCK_BOILCFG_ADDR);
+
+    static uint32_t lastReconnect = millis();   // WiFi.begin() proběhl v setup()
     static uint32_t lastNtpResync = 0;
     uint32_t now = millis();
 
+    // WiFi STA připojeno (po startu i reconnectu) → hned NTP sync
+    if (gConfig.wifiStaEn && !gWifiSta && WiFi.status() == WL_CONNECTED) {
+        gWifiSta = true;
+        if (gConfig.ntpEn) gNtpResync = true;
+        UiEvents::post(UI_EV_STATE);
+        LOGF("[WiFi] STA pripojeno: %s\n",
+                      WiFi.localIP().toString().c_str());
+    }
+
     // WiFi STA reconnect každých 30s
     if (gConfig.wifiStaEn && now - lastReconnect > 30000) {
         lastReconnect = now;
         if (WiFi.status() != WL_CONNECTED) {
             if (gWifiSta) {
-                Serial.println("[WiFi] Spojeni ztraceno, reconnect...");
+                LOGLN("[WiFi] Spojeni ztraceno, reconnect...");
                 gWifiSta = false;
+                UiEvents::post(UI_EV_STATE);
             }
             WiFi.disconnect();
             WiFi.begin(gConfig.wifiStaSsid, gConfig.wifiStaPass);
-        } else if (!gWifiSta) {
-            gWifiSta = true;
-            Serial.printf("[WiFi] Reconnect OK: %s\n",
-                          WiFi.localIP().toString().c_str());
         }
     }
 
-    // Okamžitý NTP sync z UI
+    // Okamžitý NTP sync (z UI / po připojení STA)
     if (gNtpResync && gWifiSta) {
         gNtpResync    = false;
         lastNtpResync = now;
-        Serial.print("[NTP] Sync z UI");
-        NTP.begin(gConfig.ntpServer);
-        NTP.waitSet([]() { Serial.print("."); });
-        time_t t = time(nullptr);
-        struct tm* ti = localtime(&t);
-        Serial.printf("\n[NTP] %02d:%02d:%02d\n",
-                      ti->tm_hour, ti->tm_min, ti->tm_sec);
-        DateTime dt;
-        dt.year=ti->tm_year+1900; dt.month=ti->tm_mon+1; dt.day=ti->tm_mday;
-        dt.hour=ti->tm_hour;     dt.minute=ti->tm_min;   dt.second=ti->tm_sec;
-        gRTC.setTime(dt);
+        LOGLN("[NTP] Sync na vyzadani");
+        SntpClient::request();
     }
 
     // Periodický NTP resync
     if (gConfig.ntpEn && gWifiSta &&
         now - lastNtpResync > gConfig.ntpResyncSec * 1000UL) {
         lastNtpResync = now;
-        Serial.print("[NTP] Resync");
-        NTP.begin(gConfig.ntpServer);
-        NTP.waitSet([]() { Serial.print("."); });
-        time_t t = time(nullptr);
-        struct tm* ti = localtime(&t);
-        Serial.printf("\n[NTP] %02d:%02d:%02d\n",
-                      ti->tm_hour, ti->tm_min, ti->tm_sec);
-        DateTime dt;
-        dt.year=ti->tm_year+1900; dt.month=ti->tm_mon+1; dt.day=ti->tm_mday;
-        dt.hour=ti->tm_hour;     dt.minute=ti->tm_min;   dt.second=ti->tm_sec;
-        gRTC.setTime(dt);
+        SntpClient::request();
     }
+    SntpClient::loop();
 }
@@ -2,14 +2,21 @@
 //  main_ui_loop.h – UI smyčka ACU RP (Core 0)
 //
 //  Vlož do main.cpp a zavolej:
-//    uiSetup() v setup()
-//    uiLoop()  v loop()
+//    uiSetup()          v setup()
+//    uiLoop(maxWaitMs)  v loop()
+//
+//  uiLoop() je řízený událostmi (UiEvents.h): blokuje na frontě
+//  nejvýš maxWaitMs (rozpočet síťové části loop()) a probudí se
+//  na stisk switche (GPIO IRQ), změnu SolarData, minutu,
+//  alarm nebo změnu WiFi. update() screenu běží jen po události
+//  – periodicky jen screeny s hodnotami mimo SolarData
+//  (_tickMs()). Core 0 mezitím spí.
 //
 //  Předpoklady v main.cpp:
 //    extern LGFX tft;
 //    FiveWaySwitch    gSwitch;
 //    extern PCF85063A gRTC;
-//    MCP23017         gMCP;
+//    RelayBank        gRelays;
 //    BoilerConfig     gBoilerCfg[BOILER_MAX_COUNT];
 //    BoilerSystem     gBoilerSys;
 //    SolarModel::begin() voláno před startem tasků
@@ -20,9 +27,13 @@
 #include "SolarData.h"
 #include "Theme.h"
 #include "PCF85063A.h"
+#include "TimeService.h"
 #include "FiveWaySwitch.h"
-#include "MCP23017.h"
+#include "RelayBank.h"
 #include "BoilerConfig.h"
+#include "WarmStart.h"
+#include "Render.h"
+#include "UiEvents.h"
 
 // Všechny screeny
 #include "MainScreen.h"
@@ -39,6 +50,7 @@
 #include "SerialScreen.h"
 #include "InverterScreen.h"
 #include "MqttScreen.h"
+#include "TrendScreen.h"
 
 // =============================================================
 //  Extern reference na globální proměnné z main.cpp
@@ -48,7 +60,7 @@ extern PCF85063A          gRTC;
 extern volatile bool      gWifiSta;
 extern volatile bool      gWifiAp;
 extern FiveWaySwitch      gSwitch;
-extern MCP23017           gMCP;
+extern RelayBank          gRelays;
 extern BoilerConfig       gBoilerCfg[BOILER_MAX_COUNT];
 extern BoilerSystem       gBoilerSys;
 
@@ -60,6 +72,16 @@ static uint8_t gDotAP  = DOT_OFF;
 static uint8_t gDotSTA = DOT_OFF;
 static uint8_t gDotINV = DOT_OFF;
 
+// Periody bez události [ms]
+#define UI_TICK_LIVE_MS     1000    // screeny s hodnotami mimo SolarData
+#define UI_TICK_DISC_MS     100     // Discovery – vlastní časování měření
+#define UI_TICK_ALARM_MS    500     // blikání alarmu v záhlaví
+#define UI_TICK_BADGE_MS    100     // dobíhající štítek ukládání
+#define UI_INPUT_POLL_MS    10      // polling switche, dokud je něco stisknuto
+
+static uint32_t gUI_lastTick  = 0;
+static bool     gUI_lastAlarm = false;  // poslední alarm ohlášený z onChange
+
 // =============================================================
 //  Sdílený sprite pro obsah screenů (320 × CONTENT_H px = 117 KB)
 //  Alokuje se jednou v uiSetup(). Screeny si ho půjčují přes
@@ -80,7 +102,7 @@ static void _doSwitch(Screen next) {
         case SCREEN_UDP:        UdPScreen::reset();        break;
         case SCREEN_DISCOVERY:
             DiscoveryScreen::reset();
-            DiscoveryScreen::begin(gMCP, gBoilerCfg, gBoilerSys.numBoilers);
+            DiscoveryScreen::begin(gRelays, gBoilerCfg, gBoilerSys.numBoilers);
             break;
         case SCREEN_CONTROL: ControlScreen::reset(); break;
         case SCREEN_BOILER_DETAIL:
@@ -99,6 +121,9 @@ static void _doSwitch(Screen next) {
         case SCREEN_MQTT:
             MqttScreen::reset();
             break;
+        case SCREEN_TREND:
+            TrendScreen::reset();
+            break;
         default: break;
     }
     ScreenManager::switchTo(next);
@@ -109,6 +134,8 @@ static void _doSwitch(Screen next) {
 // =============================================================
 static void _drawCurrent() {
     Screen cur = ScreenManager::current();
+    Render::setTheme(gTheme);   // paleta spritů podle aktivního tématu
+    Render::invalidateAll();    // draw() maže displej → sprity celé znovu
 
     switch (cur) {
         case SCREEN_MAIN:
@@ -169,6 +196,10 @@ static void _drawCurrent() {
             MqttScreen::draw(gTheme, gUI_dt,
                 gDotAP, gDotSTA, gDotINV, gAlarm, gUI_data);
             break;
+        case SCREEN_TREND:
+            TrendScreen::draw(gTheme, gUI_dt,
+                gDotAP, gDotSTA, gDotINV, gAlarm, gUI_data);
+            break;
         default:
             break;
     }
@@ -240,6 +271,10 @@ static void _updateCurrent() {
             MqttScreen::update(gTheme, gUI_dt,
                 gDotAP, gDotSTA, gDotINV, gAlarm, gUI_data);
             break;
+        case SCREEN_TREND:
+            TrendScreen::update(gTheme, gUI_dt,
+                gDotAP, gDotSTA, gDotINV, gAlarm, gUI_data);
+            break;
         default:
             break;
     }
@@ -254,6 +289,14 @@ static void _handleInput(SwButton btn) {
     Screen next = SCREEN_NONE;
     Screen cur  = ScreenManager::current();
 
+    // Dlouhý CENTER = domů. Neuložené editace zahodí reset()
+    // screenu při příštím vstupu; běžící Discovery si odchod
+    // řídí sama.
+    if (btn == SW_CENTER_LONG && cur > SCREEN_MAIN && cur != SCREEN_DISCOVERY) {
+        ScreenManager::replaceTo(SCREEN_MAIN);
+        return;
+    }
+
     switch (cur) {
         case SCREEN_MAIN:
             next = MainScreen::handleInput(btn);
@@ -297,6 +340,9 @@ static void _handleInput(SwButton btn) {
         case SCREEN_MQTT:
             next = MqttScreen::handleInput(gTheme, btn);
             break;
+        case SCREEN_TREND:
+            next = TrendScreen::handleInput(gTheme, btn);
+            break;
         default:
             break;
     }
@@ -311,12 +357,59 @@ static void _handleInput(SwButton btn) {
 // =============================================================
 static void _refreshState() {
     SolarModel::get(gUI_data);
-    gUI_dt  = gRTC.getTime();
+    gUI_dt  = TimeService::local();
 
     gDotSTA = gWifiSta ? DOT_OK : DOT_OFF;
     gDotAP  = gWifiAp  ? DOT_OK : DOT_OFF;
     gDotINV = gUI_data.invOnline ? DOT_OK : DOT_ERROR;
-    gAlarm  = (gUI_data.invStatus == 3);
+    gAlarm  = (gUI_data.invStatus == 3) || gUI_data.relayFault;
+}
+
+// =============================================================
+//  Zdroje událostí
+// =============================================================
+
+// SolarModel změnil data – volá task zapisovatele (HB / Boiler)
+static void _onSolarChange(const SolarData& d) {
+    bool    alarm = (d.invStatus == 3) || d.relayFault;
+    uint8_t ev    = UI_EV_DATA;
+    if (alarm != gUI_lastAlarm) {
+        gUI_lastAlarm = alarm;
+        ev |= UI_EV_ALARM;
+    }
+    UiEvents::post(ev);
+}
+
+// TimeService minuta – hodiny v záhlaví (Core 0, loop)
+static void _onTimeEvent(uint8_t events, uint32_t nowSecs) {
+    (void)events;                       // záhlaví se překreslí každou minutu,
+    (void)nowSecs;                      // čas si screen čte z TimeService
+    UiEvents::post(UI_EV_MINUTE);
+}
+
+// Hrana na pinu switche – snímek pinů už je ve frontě
+// FiveWaySwitch, tady jen probudit UI
+static void _onSwitchIrq() {
+    UiEvents::postFromISR(UI_EV_INPUT);
+}
+
+// ---------------------------------------------------------
+//  Perioda update() bez události – 0 = jen na události
+// ---------------------------------------------------------
+static uint16_t _tickMs(Screen s) {
+    uint16_t tick = 0;
+    switch (s) {
+        case SCREEN_DISCOVERY:  tick = UI_TICK_DISC_MS; break;  // měření běží v update()
+        case SCREEN_DIAGNOSTIC:                                 // uptime, stáří dat
+        case SCREEN_SETTING:                                    // běžící hodiny
+        case SCREEN_MQTT:                                       // stav spojení
+        case SCREEN_TREND:      tick = UI_TICK_LIVE_MS; break;  // nový vzorek i beze změny dat
+        default: break;
+    }
+    // Blikání alarmu v záhlaví
+    if (gAlarm && s >= SCREEN_MAIN && (tick == 0 || tick > UI_TICK_ALARM_MS))
+        tick = UI_TICK_ALARM_MS;
+    return tick;
 }
 
 // =============================================================
@@ -327,47 +420,97 @@ void uiSetup() {
     HistoryScreen::loadFromFRAM();
 
     // Alokuj sdílený sprite pro obsah screenů
+    // 4 bity/px s paletou tématu – 29 KB místo 117 KB
+    gContentSprite.setColorDepth(4);
     void* ok = gContentSprite.createSprite(320, CONTENT_H);
     Serial.printf("[UI] content sprite alloc %s (%u KB)\n",
         ok ? "OK" : "FAIL",
-        (unsigned)(320 * CONTENT_H * 2 / 1024));
+        (unsigned)(320 * CONTENT_H / 2 / 1024));
+    if (ok) Render::attach(&gContentSprite, gTheme);
 
     // Předej sprite screenům
+    SettingScreen::setSprite(&gContentSprite);
     ControlScreen::setSprite(&gContentSprite);
     NetworkScreen::setSprite(&gContentSprite);
     SerialScreen::setSprite(&gContentSprite);
     InverterScreen::setSprite(&gContentSprite);
     MqttScreen::setSprite(&gContentSprite);
+    TrendScreen::setSprite(&gContentSprite);
 
     ScreenManager::replaceTo(SCREEN_MAIN);
+    // Warm start – vrať se na poslední prohlížecí screen (zpět = MAIN)
+    if (WarmStart::lastScreen() != SCREEN_MAIN) _doSwitch(WarmStart::lastScreen());
     _refreshState();
     _drawCurrent();
 
+    // Zdroje událostí
+    UiEvents::begin();
+    SolarModel::onChange(_onSolarChange);
+    TimeService::subscribe(_onTimeEvent);
+    gSwitch.attachIrq(_onSwitchIrq);
+
     Serial.println("[UI] Setup OK");
 }
 
 // =============================================================
 //  uiLoop() – hlavní smyčka UI, volej v loop()
+//  Blokuje nejvýš maxWaitMs, dokud nepřijde událost.
 // =============================================================
-void uiLoop() {
-    // 1. Vstup ze switche
-    SwButton btn = gSwitch.read();
-    _handleInput(btn);
+void uiLoop(uint32_t maxWaitMs) {
+    // 1. Jak dlouho smíme spát
+    Screen   cur  = ScreenManager::current();
+    uint32_t now  = millis();
+    uint32_t wait = maxWaitMs;
+    uint16_t tick = _tickMs(cur);
+    if (tick) {
+        uint32_t el = now - gUI_lastTick;
+        wait = min(wait, el >= tick ? (uint32_t)0 : (uint32_t)(tick - el));
+    }
+    bool held = gSwitch.anyPressed();
+    if (held) wait = min(wait, (uint32_t)UI_INPUT_POLL_MS);
+    if (FramWriter::busy())                          wait = 0;
+    else if (FramWriter::state() != FRAMW_IDLE)      wait = min(wait, (uint32_t)UI_TICK_BADGE_MS);
+    if (ScreenManager::needDraw())                   wait = 0;
+
+    uint8_t ev = UiEvents::wait(wait);
 
-    // 2. Překresli při změně screenu
+    // 2. Vstup ze switche – po hraně, nebo dokud se drží
+    //    (uvolnění, auto-repeat, dlouhý stisk)
+    if ((ev & UI_EV_INPUT) || held) {
+        SwButton btn;
+        while ((btn = gSwitch.read()) != SW_NONE) {
+            uint32_t t0 = micros();
+            _handleInput(btn);
+            Render::endFrame(ScreenManager::current(), micros() - t0);
+        }
+    }
+
+    // Odložené zápisy do FRAM (po částech, max ~1.5 ms) + štítek
+    FramWriter::pump();
+    if (ScreenManager::current() >= SCREEN_MAIN) Header::updateSaveBadge(gTheme);
+
+    // 3. Překresli při změně screenu
     if (ScreenManager::needDraw()) {
+        uint32_t t0 = micros();
         _refreshState();
         _drawCurrent();
+        gUI_lastTick = millis();
+        Render::endFrame(ScreenManager::current(), micros() - t0);
         return;
     }
 
-    // 3. Periodický update 1× za sekundu
-    // Discovery screen má vlastní časování – update voláme vždy
-    if (ScreenManager::current() == SCREEN_DISCOVERY) {
-        _refreshState();
-        _updateCurrent();
-    } else if (ScreenManager::shouldUpdate()) {
-        _refreshState();
-        _updateCurrent();
-    }
-}
\ No newline at end of file
+    // 4. Update jen po události (data, minuta, alarm, WiFi)
+    //    nebo po uplynutí periody screenu
+    cur  = ScreenManager::current();
+    tick = _tickMs(cur);
+    now  = millis();
+    bool due = tick && now - gUI_lastTick >= tick;
+    if (!due && !(ev & (UI_EV_DATA | UI_EV_MINUTE | UI_EV_ALARM | UI_EV_STATE))) return;
+    if (due) gUI_lastTick = now;
+
+    uint32_t t0 = micros();
+    _refreshState();
+    _updateCurrent();
+    // Discovery volá update() po 100 ms – do statistik jen skutečné snímky
+    if (cur != SCREEN_DISCOVERY || ev) Render::endFrame(cur, micros() - t0);
+}